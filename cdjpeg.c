@@ -14,6 +14,14 @@
 
 #include "cdjpeg.h"             /* Common decls for cjpeg/djpeg applications */
 #include <ctype.h>              /* to declare isupper(), tolower() */
+#ifdef _WIN32
+#include <time.h>               /* to declare clock() */
+#else
+#include <signal.h>             /* to declare signal() */
+#include <sys/time.h>           /* to declare gettimeofday() */
+#include <sys/wait.h>           /* to declare wait() */
+#include <unistd.h>             /* to declare fork(), pipe(), read(), write() */
+#endif
 #ifdef USE_SETMODE
 #include <fcntl.h>              /* to declare setmode()'s parameter macros */
 /* If you have setmode() but not <io.h>, just delete this line: */
@@ -154,3 +162,329 @@ write_stdout(void)
 #endif
   return output_file;
 }
+
+
+/*
+ * Batch mode: convert each pair of files listed in a manifest file.
+ *
+ * Each line of the manifest names an input file and an output file,
+ * separated by a tab or, if the line contains no tab, by whitespace.  Blank
+ * lines and lines beginning with # are ignored.
+ */
+
+#define MAX_MANIFEST_LINE  4096 /* longest allowable manifest line */
+
+typedef struct {
+  char *infilename;
+  char *outfilename;
+} batch_entry;
+
+typedef struct {
+  unsigned long converted;      /* number of files successfully converted */
+  unsigned long failed;         /* number of files that could not be */
+  double input_bytes;           /* total size of the converted input files */
+  double output_bytes;          /* total size of the output files */
+  double pixels;                /* total number of pixels processed */
+} batch_stats;
+
+
+LOCAL(double)
+get_time(void)
+/* Return the current wall-clock time in seconds */
+{
+#ifdef _WIN32
+  /* The Microsoft C library's clock() measures wall-clock time. */
+  return (double)clock() / (double)CLOCKS_PER_SEC;
+#else
+  struct timeval tv;
+
+  if (gettimeofday(&tv, NULL) < 0)
+    return 0.0;
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.;
+#endif
+}
+
+
+METHODDEF(void)
+batch_error_exit(j_common_ptr cinfo)
+/* Report the error along with the file name, then abandon the file */
+{
+  cd_batch_ptr batch = (cd_batch_ptr)cinfo->client_data;
+  char buffer[JMSG_LENGTH_MAX];
+
+  (*cinfo->err->format_message) (cinfo, buffer);
+  fprintf(stderr, "%s: %s: %s\n", batch->progname, batch->infilename, buffer);
+  longjmp(batch->setjmp_buffer, 1);
+}
+
+
+LOCAL(char *)
+copy_string(const char *progname, const char *str)
+{
+  char *copy = (char *)malloc(strlen(str) + 1);
+
+  if (copy == NULL) {
+    fprintf(stderr, "%s: memory allocation failure\n", progname);
+    exit(EXIT_FAILURE);
+  }
+  strcpy(copy, str);
+  return copy;
+}
+
+
+LOCAL(batch_entry *)
+read_manifest(const char *progname, const char *manifest, int *num_entries)
+{
+  FILE *file;
+  char line[MAX_MANIFEST_LINE + 2];
+  char *infilename, *outfilename, *end;
+  batch_entry *entries = NULL;
+  int max_entries = 0, line_number = 0;
+  size_t len;
+
+  if ((file = fopen(manifest, "r")) == NULL) {
+    fprintf(stderr, "%s: can't open %s\n", progname, manifest);
+    exit(EXIT_FAILURE);
+  }
+
+  *num_entries = 0;
+  while (fgets(line, (int)sizeof(line), file) != NULL) {
+    line_number++;
+    len = strlen(line);
+    if (len > MAX_MANIFEST_LINE) {
+      fprintf(stderr, "%s: %s line %d is too long\n", progname, manifest,
+              line_number);
+      exit(EXIT_FAILURE);
+    }
+    /* Strip the line terminator and any trailing whitespace */
+    while (len > 0 && isspace((unsigned char)line[len - 1]))
+      line[--len] = '\0';
+    infilename = line;
+    while (*infilename == ' ')
+      infilename++;
+    if (*infilename == '\0' || *infilename == '#')
+      continue;
+
+    if ((end = strchr(infilename, '\t')) != NULL) {
+      outfilename = end + 1;
+    } else {
+      end = infilename + strcspn(infilename, " ");
+      outfilename = end;
+      while (*outfilename == ' ')
+        outfilename++;
+    }
+    if (*end == '\0' || *outfilename == '\0' || strchr(outfilename, '\t')) {
+      fprintf(stderr,
+              "%s: %s line %d must name one input and one output file\n",
+              progname, manifest, line_number);
+      exit(EXIT_FAILURE);
+    }
+    *end = '\0';
+
+    if (*num_entries == max_entries) {
+      max_entries = max_entries ? max_entries * 2 : 64;
+      entries = (batch_entry *)realloc(entries,
+                                       max_entries * sizeof(batch_entry));
+      if (entries == NULL) {
+        fprintf(stderr, "%s: memory allocation failure\n", progname);
+        exit(EXIT_FAILURE);
+      }
+    }
+    entries[*num_entries].infilename = copy_string(progname, infilename);
+    entries[*num_entries].outfilename = copy_string(progname, outfilename);
+    (*num_entries)++;
+  }
+
+  fclose(file);
+  return entries;
+}
+
+
+LOCAL(void)
+convert_entry(cd_batch_ptr batch, batch_entry *entry, batch_stats *stats)
+{
+  FILE *input_file;
+  FILE *output_file;
+  long input_size;
+  boolean success;
+  int i;
+
+  if ((input_file = fopen(entry->infilename, READ_BINARY)) == NULL) {
+    fprintf(stderr, "%s: can't open %s\n", batch->progname,
+            entry->infilename);
+    stats->failed++;
+    return;
+  }
+  if ((output_file = fopen(entry->outfilename, WRITE_BINARY)) == NULL) {
+    fprintf(stderr, "%s: can't open %s\n", batch->progname,
+            entry->outfilename);
+    fclose(input_file);
+    stats->failed++;
+    return;
+  }
+  batch->infilename = entry->infilename;
+  batch->pixels = 0.;
+  if (setjmp(batch->setjmp_buffer))
+    success = FALSE;
+  else
+    success = (*batch->convert) (batch, input_file, output_file);
+
+  if (success) {
+    stats->converted++;
+    /* The size is measured here rather than before setjmp(), since a local
+       variable that is modified before setjmp() may be clobbered by
+       longjmp(). */
+    if (fseek(input_file, 0, SEEK_END) == 0 &&
+        (input_size = ftell(input_file)) > 0)
+      stats->input_bytes += (double)input_size;
+    stats->output_bytes += (double)ftell(output_file);
+    stats->pixels += batch->pixels;
+  } else {
+    /* Return the JPEG objects to an idle state for the next file */
+    for (i = 0; i < batch->num_objects; i++)
+      jpeg_abort(batch->objects[i]);
+    stats->failed++;
+  }
+
+  fclose(input_file);
+  fclose(output_file);
+}
+
+
+#ifndef _WIN32
+
+LOCAL(int)
+run_workers(cd_batch_ptr batch, batch_entry *entries, int num_entries,
+            int num_jobs, batch_stats *stats)
+/* Convert the files using num_jobs worker processes.  Returns the number of
+ * workers that were successfully started.
+ */
+{
+  int task_pipe[2], result_pipe[2];
+  int index, num_workers = 0;
+  batch_stats worker_stats;
+
+  if (pipe(task_pipe) < 0)
+    return 0;
+  if (pipe(result_pipe) < 0) {
+    close(task_pipe[0]);
+    close(task_pipe[1]);
+    return 0;
+  }
+  /* Don't let the workers inherit (and re-emit) buffered output */
+  fflush(stdout);
+  fflush(stderr);
+
+  for (; num_workers < num_jobs; num_workers++) {
+    pid_t pid = fork();
+
+    if (pid < 0)
+      break;
+    if (pid == 0) {
+      /* Worker: convert the files whose indexes arrive through the task
+       * pipe, then send our statistics back through the result pipe.
+       */
+      close(task_pipe[1]);
+      close(result_pipe[0]);
+      memset(&worker_stats, 0, sizeof(worker_stats));
+      while (read(task_pipe[0], &index, sizeof(index)) == sizeof(index))
+        convert_entry(batch, &entries[index], &worker_stats);
+      if (write(result_pipe[1], &worker_stats, sizeof(worker_stats)) !=
+          sizeof(worker_stats))
+        exit(EXIT_FAILURE);
+      exit(EXIT_SUCCESS);
+    }
+  }
+  close(task_pipe[0]);
+  close(result_pipe[1]);
+
+  if (num_workers > 0) {
+    /* Hand out the files one at a time, so that the load stays balanced even
+     * if some files take much longer to convert than others.  (Writes this
+     * small are atomic, and the workers read one index at a time.)
+     */
+    signal(SIGPIPE, SIG_IGN);
+    for (index = 0; index < num_entries; index++) {
+      if (write(task_pipe[1], &index, sizeof(index)) != sizeof(index))
+        break;
+    }
+  }
+  close(task_pipe[1]);
+
+  while (read(result_pipe[0], &worker_stats, sizeof(worker_stats)) ==
+         sizeof(worker_stats)) {
+    stats->converted += worker_stats.converted;
+    stats->failed += worker_stats.failed;
+    stats->input_bytes += worker_stats.input_bytes;
+    stats->output_bytes += worker_stats.output_bytes;
+    stats->pixels += worker_stats.pixels;
+  }
+  close(result_pipe[0]);
+  while (wait(NULL) > 0);
+
+  /* Files that were handed to a worker that died are counted as failures. */
+  if (num_workers > 0)
+    stats->failed = num_entries - stats->converted;
+  return num_workers;
+}
+
+#endif
+
+
+GLOBAL(int)
+process_batch(cd_batch_ptr batch, const char *progname, const char *manifest,
+              int num_jobs)
+/* Convert each pair of files listed in manifest, using num_jobs worker
+ * processes if possible, and report the aggregate throughput.  Returns the
+ * program's exit status.
+ */
+{
+  batch_entry *entries;
+  int num_entries, i;
+  batch_stats stats;
+  double elapsed;
+
+  batch->progname = progname;
+  for (i = 0; i < batch->num_objects; i++) {
+    batch->objects[i]->err->error_exit = batch_error_exit;
+    batch->objects[i]->client_data = (void *)batch;
+  }
+
+  entries = read_manifest(progname, manifest, &num_entries);
+  memset(&stats, 0, sizeof(stats));
+  if (num_jobs > num_entries)
+    num_jobs = num_entries;
+
+  elapsed = get_time();
+#ifndef _WIN32
+  if (num_jobs > 1)
+    num_jobs = run_workers(batch, entries, num_entries, num_jobs, &stats);
+  if (num_jobs <= 1)
+#endif
+  {
+    num_jobs = 1;
+    for (i = 0; i < num_entries; i++)
+      convert_entry(batch, &entries[i], &stats);
+  }
+  elapsed = get_time() - elapsed;
+
+  fprintf(stderr,
+          "%s: %lu files converted, %lu failed, in %.3f seconds (%d %s)\n",
+          progname, stats.converted, stats.failed, elapsed, num_jobs,
+          num_jobs == 1 ? "job" : "jobs");
+  if (elapsed > 0.)
+    fprintf(stderr,
+            "%s: %.2f files/sec, %.2f Megapixels/sec, %.2f MB/sec in, "
+            "%.2f MB/sec out\n", progname, (double)stats.converted / elapsed,
+            stats.pixels / 1000000. / elapsed,
+            stats.input_bytes / 1000000. / elapsed,
+            stats.output_bytes / 1000000. / elapsed);
+
+  for (i = 0; i < num_entries; i++) {
+    free(entries[i].infilename);
+    free(entries[i].outfilename);
+  }
+  free(entries);
+
+  return (stats.failed ? EXIT_FAILURE : EXIT_SUCCESS);
+}
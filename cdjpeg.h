@@ -19,6 +19,7 @@
 #include "jpeglib.h"
 #include "jerror.h"             /* get library error codes too */
 #include "cderror.h"            /* get application-specific error codes */
+#include <setjmp.h>             /* for batch-mode error recovery */
 
 
 /*
@@ -101,6 +102,46 @@ struct cdjpeg_progress_mgr {
 typedef struct cdjpeg_progress_mgr *cd_progress_ptr;
 
 
+/*
+ * Batch mode lets cjpeg, djpeg, and jpegtran convert a list of files using a
+ * single set of JPEG objects (and, optionally, several worker processes), so
+ * the cost of starting the program and initializing the library is paid only
+ * once rather than once per file.  The application fills in the public
+ * fields of this structure and calls process_batch(), which opens each pair
+ * of files and calls convert().  Errors raised through the JPEG objects'
+ * error handlers abort only the file being converted.
+ */
+
+typedef struct cdjpeg_batch_struct *cd_batch_ptr;
+
+struct cdjpeg_batch_struct {
+  /* Convert input_file to output_file.  Returns FALSE if the file could not
+   * be converted for a reason that was not reported through the JPEG error
+   * handler (the routine is responsible for printing a message in that
+   * case.)  Should set pixels to the number of pixels processed.
+   */
+  boolean (*convert) (cd_batch_ptr batch, FILE *input_file,
+                      FILE *output_file);
+
+  /* JPEG objects used by convert().  process_batch() redirects their error
+   * handlers and aborts them after a failed conversion.
+   */
+  j_common_ptr objects[2];
+  int num_objects;
+
+  /* Command line, so that convert() can re-parse the switches */
+  int argc;
+  char **argv;
+
+  double pixels;                /* set by convert() */
+
+  /* The remaining fields are private to process_batch() */
+  const char *progname;
+  const char *infilename;       /* name of file being converted */
+  jmp_buf setjmp_buffer;        /* for return to process_batch() */
+};
+
+
 /* Module selection routines for I/O modules. */
 
 EXTERN(cjpeg_source_ptr) jinit_read_bmp(j_compress_ptr cinfo,
@@ -136,6 +177,8 @@ EXTERN(void) end_progress_monitor(j_common_ptr cinfo);
 EXTERN(boolean) keymatch(char *arg, const char *keyword, int minchars);
 EXTERN(FILE *) read_stdin(void);
 EXTERN(FILE *) write_stdout(void);
+EXTERN(int) process_batch(cd_batch_ptr batch, const char *progname,
+                          const char *manifest, int num_jobs);
 
 /* miscellaneous useful macros */
 
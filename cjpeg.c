@@ -134,6 +134,8 @@ select_file_type(j_compress_ptr cinfo, FILE *infile)
 static const char *progname;    /* program name for error messages */
 static char *icc_filename;      /* for -icc switch */
 static char *outfilename;       /* for -outfile switch */
+static char *batchfilename;     /* for -batch switch */
+static int num_jobs;            /* for -jobs switch */
 boolean memdst;                 /* for -memdst switch */
 boolean report;                 /* for -report switch */
 boolean strict;                 /* for -strict switch */
@@ -143,6 +145,12 @@ boolean strict;                 /* for -strict switch */
 
 #include <setjmp.h>
 
+/* If set, the input image is read from this buffer (using fmemopen()) rather
+   than from a file, which spares the fuzz target a round trip through the
+   filesystem. */
+static const unsigned char *fuzz_inbuffer;
+static size_t fuzz_insize;
+
 struct my_error_mgr {
   struct jpeg_error_mgr pub;
   jmp_buf setjmp_buffer;
@@ -226,6 +234,8 @@ usage(void)
 #endif
   fprintf(stderr, "  -maxmemory N   Maximum memory to use (in kbytes)\n");
   fprintf(stderr, "  -outfile name  Specify name for output file\n");
+  fprintf(stderr, "  -batch FILE    Convert each pair of input/output files listed in FILE\n");
+  fprintf(stderr, "  -jobs N        Use N worker processes with -batch\n");
 #if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
   fprintf(stderr, "  -memdst        Compress to memory instead of file (useful for benchmarking)\n");
 #endif
@@ -274,6 +284,8 @@ parse_switches(j_compress_ptr cinfo, int argc, char **argv,
   is_targa = FALSE;
   icc_filename = NULL;
   outfilename = NULL;
+  batchfilename = NULL;
+  num_jobs = 1;
   memdst = FALSE;
   report = FALSE;
   strict = FALSE;
@@ -307,6 +319,12 @@ parse_switches(j_compress_ptr cinfo, int argc, char **argv,
       /* Force baseline-compatible output (8-bit quantizer values). */
       force_baseline = TRUE;
 
+    } else if (keymatch(arg, "batch", 3)) {
+      /* Convert the files listed in a manifest. */
+      if (++argn >= argc)       /* advance to next argument */
+        usage();
+      batchfilename = argv[argn];
+
     } else if (keymatch(arg, "dct", 2)) {
       /* Select DCT algorithm. */
       if (++argn >= argc)       /* advance to next argument */
@@ -355,6 +373,13 @@ parse_switches(j_compress_ptr cinfo, int argc, char **argv,
         usage();
       icc_filename = argv[argn];
 
+    } else if (keymatch(arg, "jobs", 1)) {
+      /* Number of worker processes for batch mode. */
+      if (++argn >= argc)       /* advance to next argument */
+        usage();
+      if (sscanf(argv[argn], "%d", &num_jobs) != 1 || num_jobs < 1)
+        usage();
+
     } else if (keymatch(arg, "maxmemory", 3)) {
       /* Maximum memory in Kb (or Mb with 'm'). */
       long lval;
@@ -548,6 +573,42 @@ my_emit_message(j_common_ptr cinfo, int msg_level)
 }
 
 
+/*
+ * Batch mode: compress one file using the compression object that
+ * process_batch() is reusing for every file in the batch.
+ */
+
+METHODDEF(boolean)
+compress_file(cd_batch_ptr batch, FILE *input_file, FILE *output_file)
+{
+  j_compress_ptr cinfo = (j_compress_ptr)batch->objects[0];
+  cjpeg_source_ptr src_mgr;
+  JDIMENSION num_scanlines;
+
+  /* Restore the default parameters, since the previous file changed them */
+  cinfo->in_color_space = JCS_RGB; /* arbitrary guess */
+  jpeg_set_defaults(cinfo);
+
+  src_mgr = select_file_type(cinfo, input_file);
+  src_mgr->input_file = input_file;
+  (*src_mgr->start_input) (cinfo, src_mgr);
+  jpeg_default_colorspace(cinfo);
+  parse_switches(cinfo, batch->argc, batch->argv, 0, TRUE);
+  jpeg_stdio_dest(cinfo, output_file);
+
+  jpeg_start_compress(cinfo, TRUE);
+  while (cinfo->next_scanline < cinfo->image_height) {
+    num_scanlines = (*src_mgr->get_pixel_rows) (cinfo, src_mgr);
+    (void)jpeg_write_scanlines(cinfo, src_mgr->buffer, num_scanlines);
+  }
+  (*src_mgr->finish_input) (cinfo, src_mgr);
+  jpeg_finish_compress(cinfo);
+
+  batch->pixels = (double)cinfo->image_width * cinfo->image_height;
+  return TRUE;
+}
+
+
 /*
  * The main program.
  */
@@ -606,6 +667,26 @@ main(int argc, char **argv)
   if (strict)
     jerr.emit_message = my_emit_message;
 
+  if (batchfilename != NULL) {
+    struct cdjpeg_batch_struct batch;
+    int status;
+
+    if (file_index < argc || outfilename != NULL || icc_filename != NULL ||
+        memdst || report) {
+      fprintf(stderr, "%s: -batch cannot be combined with file names, -outfile, -icc, -memdst, or -report\n",
+              progname);
+      usage();
+    }
+    batch.convert = compress_file;
+    batch.objects[0] = (j_common_ptr)&cinfo;
+    batch.num_objects = 1;
+    batch.argc = argc;
+    batch.argv = argv;
+    status = process_batch(&batch, progname, batchfilename, num_jobs);
+    jpeg_destroy_compress(&cinfo);
+    return status;
+  }
+
 #ifdef TWO_FILE_COMMANDLINE
   if (!memdst) {
     /* Must have either -outfile switch or explicit output file name */
@@ -633,6 +714,15 @@ main(int argc, char **argv)
 #endif /* TWO_FILE_COMMANDLINE */
 
   /* Open the input file. */
+#ifdef CJPEG_FUZZER
+  if (fuzz_inbuffer != NULL) {
+    if ((input_file = fmemopen((void *)fuzz_inbuffer, fuzz_insize,
+                               READ_BINARY)) == NULL) {
+      jpeg_destroy_compress(&cinfo);
+      return EXIT_FAILURE;
+    }
+  } else
+#endif
   if (file_index < argc) {
     if ((input_file = fopen(argv[file_index], READ_BINARY)) == NULL) {
       fprintf(stderr, "%s: can't open %s\n", progname, argv[file_index]);
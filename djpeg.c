@@ -87,6 +87,8 @@ static const char *progname;    /* program name for error messages */
 static char *icc_filename;      /* for -icc switch */
 JDIMENSION max_scans;           /* for -maxscans switch */
 static char *outfilename;       /* for -outfile switch */
+static char *batchfilename;     /* for -batch switch */
+static int num_jobs;            /* for -jobs switch */
 boolean memsrc;                 /* for -memsrc switch */
 boolean report;                 /* for -report switch */
 boolean skip, crop;
@@ -165,6 +167,8 @@ usage(void)
   fprintf(stderr, "  -maxmemory N   Maximum memory to use (in kbytes)\n");
   fprintf(stderr, "  -maxscans N    Maximum number of scans to allow in input file\n");
   fprintf(stderr, "  -outfile name  Specify name for output file\n");
+  fprintf(stderr, "  -batch FILE    Convert each pair of input/output files listed in FILE\n");
+  fprintf(stderr, "  -jobs N        Use N worker processes with -batch\n");
 #if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
   fprintf(stderr, "  -memsrc        Load input file into memory before decompressing\n");
 #endif
@@ -175,6 +179,10 @@ usage(void)
   fprintf(stderr, "  -strict        Treat all warnings as fatal\n");
   fprintf(stderr, "  -verbose  or  -debug   Emit debug output\n");
   fprintf(stderr, "  -version       Print version information and exit\n");
+  fprintf(stderr, "Snapshot benchmark harness switches (must precede all other switches):\n");
+  fprintf(stderr, "  --compare      Compare the snapshot/restore loop with fork(), fresh exec, and\n");
+  fprintf(stderr, "                 in-process baselines, and print a table of the results\n");
+  fprintf(stderr, "  --once         Decompress the image once, without the harness\n");
   exit(EXIT_FAILURE);
 }
 
@@ -199,6 +207,8 @@ parse_switches(j_decompress_ptr cinfo, int argc, char **argv,
   icc_filename = NULL;
   max_scans = 0;
   outfilename = NULL;
+  batchfilename = NULL;
+  num_jobs = 1;
   memsrc = FALSE;
   report = FALSE;
   skip = FALSE;
@@ -224,6 +234,12 @@ parse_switches(j_decompress_ptr cinfo, int argc, char **argv,
       /* BMP output format (Windows flavor). */
       requested_fmt = FMT_BMP;
 
+    } else if (keymatch(arg, "batch", 3)) {
+      /* Convert the files listed in a manifest. */
+      if (++argn >= argc)       /* advance to next argument */
+        usage();
+      batchfilename = argv[argn];
+
     } else if (keymatch(arg, "colors", 1) || keymatch(arg, "colours", 1) ||
                keymatch(arg, "quantize", 1) || keymatch(arg, "quantise", 1)) {
       /* Do color quantization. */
@@ -319,6 +335,13 @@ parse_switches(j_decompress_ptr cinfo, int argc, char **argv,
       icc_filename = argv[argn];
       jpeg_save_markers(cinfo, JPEG_APP0 + 2, 0xFFFF);
 
+    } else if (keymatch(arg, "jobs", 1)) {
+      /* Number of worker processes for batch mode. */
+      if (++argn >= argc)       /* advance to next argument */
+        usage();
+      if (sscanf(argv[argn], "%d", &num_jobs) != 1 || num_jobs < 1)
+        usage();
+
     } else if (keymatch(arg, "map", 3)) {
       /* Quantize to a color map taken from an input file. */
       if (++argn >= argc)       /* advance to next argument */
@@ -521,6 +544,70 @@ my_emit_message(j_common_ptr cinfo, int msg_level)
 }
 
 
+/*
+ * Batch mode: decompress one file using the decompression object that
+ * process_batch() is reusing for every file in the batch.
+ */
+
+METHODDEF(boolean)
+decompress_file(cd_batch_ptr batch, FILE *input_file, FILE *output_file)
+{
+  j_decompress_ptr cinfo = (j_decompress_ptr)batch->objects[0];
+  djpeg_dest_ptr dest_mgr = NULL;
+  JDIMENSION num_scanlines;
+
+  jpeg_stdio_src(cinfo, input_file);
+  (void)jpeg_read_header(cinfo, TRUE);
+  parse_switches(cinfo, batch->argc, batch->argv, 0, TRUE);
+
+  switch (requested_fmt) {
+#ifdef BMP_SUPPORTED
+  case FMT_BMP:
+    dest_mgr = jinit_write_bmp(cinfo, FALSE, TRUE);
+    break;
+  case FMT_OS2:
+    dest_mgr = jinit_write_bmp(cinfo, TRUE, TRUE);
+    break;
+#endif
+#ifdef GIF_SUPPORTED
+  case FMT_GIF:
+    dest_mgr = jinit_write_gif(cinfo, TRUE);
+    break;
+  case FMT_GIF0:
+    dest_mgr = jinit_write_gif(cinfo, FALSE);
+    break;
+#endif
+#ifdef PPM_SUPPORTED
+  case FMT_PPM:
+    dest_mgr = jinit_write_ppm(cinfo);
+    break;
+#endif
+#ifdef TARGA_SUPPORTED
+  case FMT_TARGA:
+    dest_mgr = jinit_write_targa(cinfo);
+    break;
+#endif
+  default:
+    ERREXIT(cinfo, JERR_UNSUPPORTED_FORMAT);
+    break;
+  }
+  dest_mgr->output_file = output_file;
+
+  (void)jpeg_start_decompress(cinfo);
+  (*dest_mgr->start_output) (cinfo, dest_mgr);
+  while (cinfo->output_scanline < cinfo->output_height) {
+    num_scanlines = jpeg_read_scanlines(cinfo, dest_mgr->buffer,
+                                        dest_mgr->buffer_height);
+    (*dest_mgr->put_pixel_rows) (cinfo, dest_mgr, num_scanlines);
+  }
+  (*dest_mgr->finish_output) (cinfo, dest_mgr);
+  (void)jpeg_finish_decompress(cinfo);
+
+  batch->pixels = (double)cinfo->output_width * cinfo->output_height;
+  return TRUE;
+}
+
+
 /*
  * The main program.
  */
@@ -575,6 +662,26 @@ target_main(int argc, char **argv)
   if (strict)
     jerr.emit_message = my_emit_message;
 
+  if (batchfilename != NULL) {
+    struct cdjpeg_batch_struct batch;
+    int status;
+
+    if (file_index < argc || outfilename != NULL || icc_filename != NULL ||
+        memsrc || report || max_scans != 0 || skip || crop) {
+      fprintf(stderr, "%s: -batch cannot be combined with file names, -outfile, -icc, -memsrc, -report, -maxscans, -skip, or -crop\n",
+              progname);
+      usage();
+    }
+    batch.convert = decompress_file;
+    batch.objects[0] = (j_common_ptr)&cinfo;
+    batch.num_objects = 1;
+    batch.argc = argc;
+    batch.argv = argv;
+    status = process_batch(&batch, progname, batchfilename, num_jobs);
+    jpeg_destroy_decompress(&cinfo);
+    return status;
+  }
+
 #ifdef TWO_FILE_COMMANDLINE
   /* Must have either -outfile switch or explicit output file name */
   if (outfilename == NULL) {
@@ -1148,6 +1255,7 @@ void pmparser_print(procmaps_struct* map, int order){
 #include <sys/ioctl.h>  // ioctl
 #include <pthread.h>
 #include <poll.h>
+#include <sys/wait.h>   // waitpid
 
 #include "../pmparser.h"
 
@@ -1470,9 +1578,217 @@ void restore_pages()
     }
 }
 
+// Comparison mode: "djpeg --compare <djpeg args>" runs the same input and argv
+// under each of the execution strategies below and prints a single table, so
+// the numbers can be regenerated whenever the kernel changes.
+//   uffd:    the snapshot/restore loop that main() normally runs
+//   fork:    fork() per iteration, running the target in the child
+//   exec:    fork() + exec of this binary with --once per iteration
+//   inproc:  re-running the target in-process without restoring anything
+// The baselines run before the snapshot is taken, and inproc runs in a child
+// so that the state it leaves behind doesn't end up in the snapshot.
+
+#ifndef COMPARE_ITERS
+#define COMPARE_ITERS 1000
+#endif
+
+enum { MODE_UFFD, MODE_FORK, MODE_EXEC, MODE_INPROC, N_MODES };
+
+static const char *mode_names[N_MODES] = {
+    "uffd snapshot/restore", "fork() per iteration", "fresh exec",
+    "in-process, no restore"
+};
+
+typedef struct {
+    int iters;          // iterations that ran
+    int failures;       // iterations where the target returned nonzero
+    uint64_t total_ns;
+    uint64_t min_ns;
+} compare_result_t;
+
+// writeignored so that the uffd loop doesn't roll them back
+__attribute__((section(".writeignored"))) int compare_mode = 0;
+__attribute__((section(".writeignored"))) compare_result_t compare_results[N_MODES];
+__attribute__((section(".writeignored"))) uint64_t restore_ns = 0;
+__attribute__((section(".writeignored"))) size_t first_iter_pages = 0;
+
+static uint64_t ns_between(struct timespec *end, struct timespec *start)
+{
+    return (uint64_t)(end->tv_sec - start->tv_sec) * 1000000000ULL +
+           end->tv_nsec - start->tv_nsec;
+}
+
+static uint64_t ns_since(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ns_between(&end, start);
+}
+
+static void record_iter(compare_result_t *res, uint64_t ns, int ret)
+{
+    if (res->iters == 0 || ns < res->min_ns) {
+        res->min_ns = ns;
+    }
+    res->iters++;
+    res->total_ns += ns;
+    if (ret != 0) {
+        res->failures++;
+    }
+}
+
+// returns the child's exit status, or -1 if it didn't exit normally
+static int wait_child(pid_t pid)
+{
+    int status;
+
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            perror("waitpid");
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void run_fork(int argc, char **argv)
+{
+    for (int i = 0; i < COMPARE_ITERS; i++) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        // don't let the child inherit (and flush again) our buffered output
+        fflush(NULL);
+        pid_t pid = fork();
+        if (pid == 0) {
+            int ret = target_main(argc, argv);
+            fflush(NULL);
+            _exit(ret);
+        }
+        int ret = wait_child(pid);
+
+        record_iter(&compare_results[MODE_FORK], ns_since(&start), ret);
+    }
+}
+
+static void run_exec(int argc, char **argv)
+{
+    char *exec_argv[argc + 2];
+
+    exec_argv[0] = argv[0];
+    exec_argv[1] = "--once";
+    for (int i = 1; i < argc; i++) {
+        exec_argv[i + 1] = argv[i];
+    }
+    exec_argv[argc + 1] = NULL;
+
+    for (int i = 0; i < COMPARE_ITERS; i++) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        fflush(NULL);
+        pid_t pid = fork();
+        if (pid == 0) {
+            execv("/proc/self/exe", exec_argv);
+            _exit(127);
+        }
+        int ret = wait_child(pid);
+
+        record_iter(&compare_results[MODE_EXEC], ns_since(&start), ret);
+    }
+}
+
+static void run_inproc(int argc, char **argv)
+{
+    int pipefd[2];
+
+    if (pipe(pipefd) == -1) {
+        perror("pipe");
+        return;
+    }
+
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        compare_result_t res = {0};
+
+        close(pipefd[0]);
+        for (int i = 0; i < COMPARE_ITERS; i++) {
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+
+            int ret = target_main(argc, argv);
+
+            record_iter(&res, ns_since(&start), ret);
+        }
+        fflush(NULL);
+        if (write(pipefd[1], &res, sizeof(res)) != sizeof(res)) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+
+    // if the target exit()s (e.g. on a corrupt input) the child never reports
+    // back, and this mode shows up as n/a
+    close(pipefd[1]);
+    if (read(pipefd[0], &compare_results[MODE_INPROC], sizeof(compare_result_t)) != sizeof(compare_result_t)) {
+        memset(&compare_results[MODE_INPROC], 0, sizeof(compare_result_t));
+    }
+    close(pipefd[0]);
+    wait_child(pid);
+}
+
+static void report_compare(void)
+{
+    compare_result_t *uffd_res = &compare_results[MODE_UFFD];
+
+    printf("%-24s %8s %12s %12s %12s %8s\n", "Mode", "Iters", "Iters/sec",
+           "Mean (us)", "Min (us)", "Failed");
+    for (int m = 0; m < N_MODES; m++) {
+        compare_result_t *res = &compare_results[m];
+
+        if (res->iters == 0 || res->total_ns == 0) {
+            printf("%-24s %8s\n", mode_names[m], "n/a");
+            continue;
+        }
+        printf("%-24s %8d %12.1f %12.2f %12.2f %8d\n", mode_names[m],
+               res->iters, res->iters * 1e9 / res->total_ns,
+               res->total_ns / 1e3 / res->iters, res->min_ns / 1e3,
+               res->failures);
+    }
+
+    // write protection is dropped from a page on its first write and never
+    // re-armed, so every page recorded so far gets restored on every iteration
+    printf("\nuffd dirty pages: %zu in the first iteration, %zu (%zu KiB) restored per iteration\n",
+           first_iter_pages, n_pages, n_pages * PAGE_SIZE / 1024);
+    if (uffd_res->iters > 0 && uffd_res->total_ns > 0) {
+        printf("uffd restore cost: %.2f us per iteration (%.1f%% of the iteration time)\n",
+               restore_ns / 1e3 / uffd_res->iters,
+               restore_ns * 100.0 / uffd_res->total_ns);
+    }
+}
+
 __attribute__((noinline)) int nowrite_main(int argc, char **argv)
 {
     // Now in the "safe" stack which won't be write monitored
+    if (argc > 1 && !strcmp(argv[1], "--compare")) {
+        compare_mode = 1;
+        argv[1] = argv[0];
+        argc--;
+        argv++;
+
+        redirect_stdout();
+        setaffinity(3);
+
+        run_fork(argc, argv);
+        run_exec(argc, argv);
+        run_inproc(argc, argv);
+    }
+
     if (load_maps()) {
         return 1;
     }
@@ -1491,31 +1807,54 @@ __attribute__((noinline)) int nowrite_main(int argc, char **argv)
     pthread_mutex_lock(&uffd_ready_lock);
     pthread_cond_wait(&uffd_ready, &uffd_ready_lock);
 
-    redirect_stdout();
-    setaffinity(3);
+    if (!compare_mode) {
+        redirect_stdout();
+        setaffinity(3);
+    }
 
-    for (int i = 0; i < ITERS; i++) {
-        struct timespec start, end;
+    int iters = compare_mode ? COMPARE_ITERS : ITERS;
+    for (int i = 0; i < iters; i++) {
+        struct timespec start, end, restore_start;
         clock_gettime(CLOCK_MONOTONIC, &start);
 
         swap_target_stack();
-        target_main(argc, argv);
+        int ret = target_main(argc, argv);
         swap_target_stack();
 
+        clock_gettime(CLOCK_MONOTONIC, &restore_start);
         restore_pages();
 
         clock_gettime(CLOCK_MONOTONIC, &end);
-        times[i] = timespecDiff(&end, &start);
+        if (compare_mode) {
+            record_iter(&compare_results[MODE_UFFD], ns_between(&end, &start), ret);
+            restore_ns += ns_between(&end, &restore_start);
+            if (i == 0) {
+                first_iter_pages = n_pages;
+            }
+        } else {
+            times[i] = timespecDiff(&end, &start);
+        }
     }
 
     dup2(stdout_fd, STDOUT_FILENO);
-    report_times();
+    if (compare_mode) {
+        report_compare();
+    } else {
+        report_times();
+    }
 
     return 0;
 }
 
 int main(int argc, char **argv)
 {
+    // "--once" just runs the target, without the harness.  The fresh exec
+    // baseline in compare mode uses it.
+    if (argc > 1 && !strcmp(argv[1], "--once")) {
+        argv[1] = argv[0];
+        return target_main(argc - 1, argv + 1);
+    }
+
     // pivot only saves rsp, so go another function deep so rbp relative stack vars are also on the writeignored stack.
     save_target_stack_and_pivot();
 
@@ -38,12 +38,11 @@ extern "C" {
 #undef CJPEG_FUZZER
 
 #include <stdint.h>
-#include <unistd.h>
+#include "fuzz_select.h"
 
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 {
-  char filename[FILENAME_MAX] = { 0 };
   char *argv1[] = {
     (char *)"cjpeg", (char *)"-dct", (char *)"float", (char *)"-memdst",
     (char *)"-optimize", (char *)"-quality", (char *)"100,99,98",
@@ -56,7 +55,7 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
     (char *)"-sample", (char *)"2x2", (char *)"-smooth", (char *)"50",
     (char *)"-targa", NULL
   };
-  int fd = -1;
+  unsigned int sel;
 #if defined(__has_feature) && __has_feature(memory_sanitizer)
   char env[18] = "JSIMD_FORCENONE=1";
 
@@ -65,25 +64,35 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   putenv(env);
 #endif
 
-  snprintf(filename, FILENAME_MAX, "/tmp/libjpeg-turbo_cjpeg_fuzz.XXXXXX");
-  if ((fd = mkstemp(filename)) < 0 || write(fd, data, size) < 0)
-    goto bailout;
+  /* Rather than running cjpeg once for each combination of options, select a
+     single combination.  Without -targa, cjpeg detects the input file format
+     from the first byte of the input, so the default combination (which is
+     used for the unmodified seed images) does not include -targa. */
+  sel = fuzz_select(&data, &size);
+  if (size < 1)
+    return 0;
 
-  argv1[12] = argv2[13] = filename;
+  /* Read the input image directly from the fuzzer's buffer. */
+  fuzz_inbuffer = data;
+  fuzz_insize = size;
 
-  cjpeg_main(13, argv1);
-  cjpeg_main(14, argv2);
-
-  argv1[12] = argv2[13] = NULL;
-  argv1[11] = argv2[12] = filename;
-
-  cjpeg_main(12, argv1);
-  cjpeg_main(13, argv2);
-
-bailout:
-  if (fd >= 0) {
-    close(fd);
-    if (strlen(filename) > 0) unlink(filename);
+  switch (sel % 4) {
+  case 0:
+    argv1[11] = NULL;
+    cjpeg_main(11, argv1);
+    break;
+  case 1:
+    argv2[12] = NULL;
+    cjpeg_main(12, argv2);
+    break;
+  case 2:
+    cjpeg_main(12, argv1);
+    break;
+  default:
+    cjpeg_main(13, argv2);
   }
+
+  fuzz_inbuffer = NULL;
+  fuzz_insize = 0;
   return 0;
 }
@@ -31,7 +31,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
-#include <unistd.h>
+#include "fuzz_select.h"
 
 
 #define NUMTESTS  7
@@ -50,8 +50,9 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 {
   tjhandle handle = NULL;
   unsigned char *srcBuf = NULL, *dstBuf = NULL;
-  int width = 0, height = 0, fd = -1, i, ti;
-  char filename[FILENAME_MAX] = { 0 };
+  int width = 0, height = 0, i, ti, pf, flags = TJFLAG_FUZZING, sum = 0;
+  unsigned long dstSize = 0, maxBufSize;
+  unsigned int sel;
   struct test tests[NUMTESTS] = {
     { TJPF_RGB, TJSAMP_444, 100 },
     { TJPF_BGR, TJSAMP_422, 90 },
@@ -69,65 +70,49 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   putenv(env);
 #endif
 
-  snprintf(filename, FILENAME_MAX, "/tmp/libjpeg-turbo_compress_fuzz.XXXXXX");
-  if ((fd = mkstemp(filename)) < 0 || write(fd, data, size) < 0)
+  /* Rather than compressing the image once for each configuration, select a
+     single configuration (test parameters and flags). */
+  sel = fuzz_select(&data, &size);
+  if (size < 1 || (handle = tjInitCompress()) == NULL)
     goto bailout;
 
-  if ((handle = tjInitCompress()) == NULL)
+  ti = sel % NUMTESTS;
+  pf = tests[ti].pf;
+  sel /= NUMTESTS;
+  if (sel & 1) flags |= TJFLAG_BOTTOMUP;
+  if (sel & 2) flags |= TJFLAG_ACCURATEDCT;
+  if (sel & 4) flags |= TJFLAG_PROGRESSIVE;
+  if (!(sel & 8)) flags |= TJFLAG_NOREALLOC;
+
+  /* tjLoadImageFromMemory() refuses to load images larger than 1 Megapixel
+     when FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION is defined (yes, that's a
+     dirty hack), so we don't need to check the width and height here. */
+  if ((srcBuf = tjLoadImageFromMemory(data, size, &width, 1, &height, &pf,
+                                      flags)) == NULL)
     goto bailout;
 
-  for (ti = 0; ti < NUMTESTS; ti++) {
-    int flags = TJFLAG_FUZZING, sum = 0, pf = tests[ti].pf;
-    unsigned long dstSize = 0, maxBufSize;
-
-    /* Test non-default compression options on specific iterations. */
-    if (ti == 0)
-      flags |= TJFLAG_BOTTOMUP | TJFLAG_ACCURATEDCT;
-    else if (ti == 1)
-      flags |= TJFLAG_PROGRESSIVE;
-    if (ti != 2)
-      flags |= TJFLAG_NOREALLOC;
-
-    /* tjLoadImage() refuses to load images larger than 1 Megapixel when
-       FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION is defined (yes, that's a dirty
-       hack), so we don't need to check the width and height here. */
-    if ((srcBuf = tjLoadImage(filename, &width, 1, &height, &pf,
-                              flags)) == NULL)
-      continue;
-
-    maxBufSize = tjBufSize(width, height, tests[ti].subsamp);
-    if (flags & TJFLAG_NOREALLOC) {
-      if ((dstBuf = (unsigned char *)malloc(maxBufSize)) == NULL)
-        goto bailout;
-    } else
-      dstBuf = NULL;
-
-    if (tjCompress2(handle, srcBuf, width, 0, height, pf, &dstBuf, &dstSize,
-                    tests[ti].subsamp, tests[ti].quality, flags) == 0) {
-      /* Touch all of the output pixels in order to catch uninitialized reads
-         when using MemorySanitizer. */
-      for (i = 0; i < dstSize; i++)
-        sum += dstBuf[i];
-    }
-
-    free(dstBuf);
-    dstBuf = NULL;
-    tjFree(srcBuf);
-    srcBuf = NULL;
-
-    /* Prevent the code above from being optimized out.  This test should never
-       be true, but the compiler doesn't know that. */
-    if (sum > 255 * maxBufSize)
+  maxBufSize = tjBufSize(width, height, tests[ti].subsamp);
+  if (flags & TJFLAG_NOREALLOC) {
+    if ((dstBuf = (unsigned char *)malloc(maxBufSize)) == NULL)
       goto bailout;
   }
 
+  if (tjCompress2(handle, srcBuf, width, 0, height, pf, &dstBuf, &dstSize,
+                  tests[ti].subsamp, tests[ti].quality, flags) == 0) {
+    /* Touch all of the output pixels in order to catch uninitialized reads
+       when using MemorySanitizer. */
+    for (i = 0; i < dstSize; i++)
+      sum += dstBuf[i];
+  }
+
+  /* Prevent the code above from being optimized out.  This test should never
+     be true, but the compiler doesn't know that. */
+  if (sum > 255 * maxBufSize)
+    goto bailout;
+
 bailout:
   free(dstBuf);
   tjFree(srcBuf);
-  if (fd >= 0) {
-    close(fd);
-    if (strlen(filename) > 0) unlink(filename);
-  }
   if (handle) tjDestroy(handle);
   return 0;
 }
@@ -31,7 +31,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
-#include <unistd.h>
+#include "fuzz_select.h"
 
 
 #define NUMTESTS  6
@@ -50,8 +50,10 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 {
   tjhandle handle = NULL;
   unsigned char *srcBuf = NULL, *dstBuf = NULL, *yuvBuf = NULL;
-  int width = 0, height = 0, fd = -1, i, ti;
-  char filename[FILENAME_MAX] = { 0 };
+  int width = 0, height = 0, i, ti, pf;
+  int flags = TJFLAG_FUZZING | TJFLAG_NOREALLOC, sum = 0;
+  unsigned long dstSize = 0, maxBufSize;
+  unsigned int sel;
   struct test tests[NUMTESTS] = {
     { TJPF_XBGR, TJSAMP_444, 100 },
     { TJPF_XRGB, TJSAMP_422, 90 },
@@ -69,80 +71,61 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
      MemorySanitizer. */
   putenv(simdEnv);
 #endif
+
+  /* Rather than compressing the image once for each configuration, select a
+     single configuration (test parameters, flags, and entropy coding
+     options). */
+  sel = fuzz_select(&data, &size);
+  if (size < 1 || (handle = tjInitCompress()) == NULL)
+    goto bailout;
+
+  ti = sel % NUMTESTS;
+  pf = tests[ti].pf;
+  sel /= NUMTESTS;
+  if (sel & 1) flags |= TJFLAG_BOTTOMUP;
+  if (sel & 2) flags |= TJFLAG_ACCURATEDCT;
+  if (sel & 4) flags |= TJFLAG_PROGRESSIVE;
+  if (sel & 8)
+    arithEnv[14] = '1';
+  if (sel & 16)
+    restartEnv[11] = '2';
   putenv(arithEnv);
   putenv(restartEnv);
 
-  snprintf(filename, FILENAME_MAX, "/tmp/libjpeg-turbo_compress_yuv_fuzz.XXXXXX");
-  if ((fd = mkstemp(filename)) < 0 || write(fd, data, size) < 0)
+  /* tjLoadImageFromMemory() refuses to load images larger than 1 Megapixel
+     when FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION is defined (yes, that's a
+     dirty hack), so we don't need to check the width and height here. */
+  if ((srcBuf = tjLoadImageFromMemory(data, size, &width, 1, &height, &pf,
+                                      flags)) == NULL)
     goto bailout;
 
-  if ((handle = tjInitCompress()) == NULL)
+  maxBufSize = tjBufSize(width, height, tests[ti].subsamp);
+  if ((dstBuf = (unsigned char *)malloc(maxBufSize)) == NULL)
+    goto bailout;
+  if ((yuvBuf =
+       (unsigned char *)malloc(tjBufSizeYUV2(width, 1, height,
+                                             tests[ti].subsamp))) == NULL)
     goto bailout;
 
-  for (ti = 0; ti < NUMTESTS; ti++) {
-    int flags = TJFLAG_FUZZING | TJFLAG_NOREALLOC, sum = 0, pf = tests[ti].pf;
-    unsigned long dstSize = 0, maxBufSize;
-
-    /* Test non-default compression options on specific iterations. */
-    if (ti == 0)
-      flags |= TJFLAG_BOTTOMUP | TJFLAG_ACCURATEDCT;
-    else if (ti == 1 || ti == 3)
-      flags |= TJFLAG_PROGRESSIVE;
-    if (ti == 2 || ti == 3)
-      arithEnv[14] = '1';
-    else
-      arithEnv[14] = '0';
-    if (ti == 1 || ti == 2)
-      restartEnv[11] = '2';
-    else
-      restartEnv[11] = '0';
-
-    /* tjLoadImage() refuses to load images larger than 1 Megapixel when
-       FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION is defined (yes, that's a dirty
-       hack), so we don't need to check the width and height here. */
-    if ((srcBuf = tjLoadImage(filename, &width, 1, &height, &pf,
-                              flags)) == NULL)
-      continue;
-
-    maxBufSize = tjBufSize(width, height, tests[ti].subsamp);
-    if ((dstBuf = (unsigned char *)malloc(maxBufSize)) == NULL)
-      goto bailout;
-    if ((yuvBuf =
-         (unsigned char *)malloc(tjBufSizeYUV2(width, 1, height,
-                                               tests[ti].subsamp))) == NULL)
-      goto bailout;
-
-    if (tjEncodeYUV3(handle, srcBuf, width, 0, height, pf, yuvBuf, 1,
-                     tests[ti].subsamp, flags) == 0 &&
-        tjCompressFromYUV(handle, yuvBuf, width, 1, height, tests[ti].subsamp,
-                          &dstBuf, &dstSize, tests[ti].quality, flags) == 0) {
-      /* Touch all of the output pixels in order to catch uninitialized reads
-         when using MemorySanitizer. */
-      for (i = 0; i < dstSize; i++)
-        sum += dstBuf[i];
-    }
-
-    free(dstBuf);
-    dstBuf = NULL;
-    free(yuvBuf);
-    yuvBuf = NULL;
-    tjFree(srcBuf);
-    srcBuf = NULL;
-
-    /* Prevent the code above from being optimized out.  This test should never
-       be true, but the compiler doesn't know that. */
-    if (sum > 255 * maxBufSize)
-      goto bailout;
+  if (tjEncodeYUV3(handle, srcBuf, width, 0, height, pf, yuvBuf, 1,
+                   tests[ti].subsamp, flags) == 0 &&
+      tjCompressFromYUV(handle, yuvBuf, width, 1, height, tests[ti].subsamp,
+                        &dstBuf, &dstSize, tests[ti].quality, flags) == 0) {
+    /* Touch all of the output pixels in order to catch uninitialized reads
+       when using MemorySanitizer. */
+    for (i = 0; i < dstSize; i++)
+      sum += dstBuf[i];
   }
 
+  /* Prevent the code above from being optimized out.  This test should never
+     be true, but the compiler doesn't know that. */
+  if (sum > 255 * maxBufSize)
+    goto bailout;
+
 bailout:
   free(dstBuf);
   free(yuvBuf);
   tjFree(srcBuf);
-  if (fd >= 0) {
-    close(fd);
-    if (strlen(filename) > 0) unlink(filename);
-  }
   if (handle) tjDestroy(handle);
   return 0;
 }
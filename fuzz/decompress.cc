@@ -29,21 +29,38 @@
 #include <turbojpeg.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include "fuzz_select.h"
+#ifdef FUZZ_COST_MODE
+#include "fuzz_cost.h"
+#endif
 
 
 #define NUMPF  4
+#define NUMSF  8
 
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 {
   tjhandle handle = NULL;
   unsigned char *dstBuf = NULL;
-  int width = 0, height = 0, jpegSubsamp, jpegColorspace, pfi;
+  int width = 0, height = 0, jpegSubsamp, jpegColorspace, pf, w, h, i;
+  int flags = TJFLAG_LIMITRESOURCES, sum = 0;
+  unsigned int sel;
+#ifdef FUZZ_COST_MODE
+  /* The whole input, including the selector, is saved by fuzz_cost_end(). */
+  const uint8_t *input = data;
+  size_t inputSize = size;
+#endif
   /* TJPF_RGB-TJPF_BGR share the same code paths, as do TJPF_RGBX-TJPF_XRGB and
      TJPF_RGBA-TJPF_ARGB.  Thus, the pixel formats below should be the minimum
      necessary to achieve full coverage. */
   enum TJPF pixelFormats[NUMPF] =
     { TJPF_RGB, TJPF_BGRX, TJPF_GRAY, TJPF_CMYK };
+  /* IDCT scaling factors that exercise distinct code paths */
+  tjscalingfactor scalingFactors[NUMSF] = {
+    { 1, 1 }, { 1, 2 }, { 1, 4 }, { 1, 8 }, { 3, 8 }, { 5, 8 }, { 3, 4 },
+    { 7, 8 }
+  };
 #if defined(__has_feature) && __has_feature(memory_sanitizer)
   char env[18] = "JSIMD_FORCENONE=1";
 
@@ -52,6 +69,9 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   putenv(env);
 #endif
 
+  /* Rather than decompressing the image once for each configuration, select a
+     single configuration (pixel format, flags, and scaling factor). */
+  sel = fuzz_select(&data, &size);
   if ((handle = tjInitDecompress()) == NULL)
     goto bailout;
 
@@ -67,38 +87,40 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   if (width < 1 || height < 1 || (uint64_t)width * height > 1048576)
     goto bailout;
 
-  for (pfi = 0; pfi < NUMPF; pfi++) {
-    int pf = pixelFormats[pfi], flags = TJFLAG_LIMITSCANS, i, sum = 0;
-    int w = width, h = height;
-
-    /* Test non-default decompression options on the first iteration. */
-    if (pfi == 0)
-      flags |= TJFLAG_BOTTOMUP | TJFLAG_FASTUPSAMPLE | TJFLAG_FASTDCT;
-    /* Test IDCT scaling on the second iteration. */
-    else if (pfi == 1) {
-      w = (width + 1) / 2;
-      h = (height + 1) / 2;
-    }
+  pf = pixelFormats[sel % NUMPF];
+  sel /= NUMPF;
+  if (sel & 1) flags |= TJFLAG_BOTTOMUP;
+  if (sel & 2) flags |= TJFLAG_FASTUPSAMPLE;
+  if (sel & 4) flags |= TJFLAG_FASTDCT;
+  w = TJSCALED(width, scalingFactors[(sel >> 3) % NUMSF]);
+  h = TJSCALED(height, scalingFactors[(sel >> 3) % NUMSF]);
 
-    if ((dstBuf = (unsigned char *)malloc(w * h * tjPixelSize[pf])) == NULL)
-      goto bailout;
-
-    if (tjDecompress2(handle, data, size, dstBuf, w, 0, h, pf, flags) == 0) {
-      /* Touch all of the output pixels in order to catch uninitialized reads
-         when using MemorySanitizer. */
-      for (i = 0; i < w * h * tjPixelSize[pf]; i++)
-        sum += dstBuf[i];
-    }
+  if ((dstBuf = (unsigned char *)malloc(w * h * tjPixelSize[pf])) == NULL)
+    goto bailout;
 
-    free(dstBuf);
-    dstBuf = NULL;
+#ifdef FUZZ_COST_MODE
+  fuzz_cost_begin();
+#endif
+  i = tjDecompress2(handle, data, size, dstBuf, w, 0, h, pf, flags);
+#ifdef FUZZ_COST_MODE
+  /* The entropy decoder and the IDCT process every block in the image
+     regardless of the scaling factor, so the cost is measured against the
+     size of the JPEG image rather than the size of the output image. */
+  fuzz_cost_end(input, inputSize, (uint64_t)width * height);
+#endif
 
-    /* Prevent the code above from being optimized out.  This test should never
-       be true, but the compiler doesn't know that. */
-    if (sum > 255 * 1048576 * tjPixelSize[pf])
-      goto bailout;
+  if (i == 0) {
+    /* Touch all of the output pixels in order to catch uninitialized reads
+       when using MemorySanitizer. */
+    for (i = 0; i < w * h * tjPixelSize[pf]; i++)
+      sum += dstBuf[i];
   }
 
+  /* Prevent the code above from being optimized out.  This test should never
+     be true, but the compiler doesn't know that. */
+  if (sum > 255 * 1048576 * tjPixelSize[pf])
+    goto bailout;
+
 bailout:
   free(dstBuf);
   if (handle) tjDestroy(handle);
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This fuzz target uses the libjpeg API to decompress JPEG images in
+   buffered-image mode, which exercises jpeg_consume_input(),
+   jpeg_start_output(), and jpeg_finish_output() as well as interblock
+   smoothing (which is only applied to intermediate output passes of
+   progressive images.)
+
+   If FUZZ_FAST_MODE is defined, then the target performs at most two output
+   passes (the first scan and the final image) and does not read back the
+   output pixels.  That mode is intended for snapshot-based fuzzers and for
+   maximizing exec/s, at the expense of coverage of the intermediate output
+   passes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include "fuzz_select.h"
+
+
+#define NUMCS  3
+
+
+struct fuzzer_error_mgr {
+  struct jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+};
+
+
+static void my_error_exit(j_common_ptr cinfo)
+{
+  struct fuzzer_error_mgr *myerr = (struct fuzzer_error_mgr *)cinfo->err;
+
+  longjmp(myerr->setjmp_buffer, 1);
+}
+
+
+static void my_emit_message(j_common_ptr cinfo, int msg_level)
+{
+  if (msg_level < 0)
+    cinfo->err->num_warnings++;
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  struct jpeg_decompress_struct cinfo;
+  struct fuzzer_error_mgr myerr;
+  JSAMPARRAY buffer;
+  unsigned int sel, row_stride, sum = 0;
+  int pass = 0;
+  J_COLOR_SPACE colorSpaces[NUMCS] = { JCS_RGB, JCS_GRAYSCALE, JCS_EXT_BGRX };
+#if defined(__has_feature) && __has_feature(memory_sanitizer)
+  char env[18] = "JSIMD_FORCENONE=1";
+
+  /* The libjpeg-turbo SIMD extensions produce false positives with
+     MemorySanitizer. */
+  putenv(env);
+#endif
+
+  /* Select the decompression parameters. */
+  sel = fuzz_select(&data, &size);
+  if (size < 1)
+    return 0;
+
+  cinfo.err = jpeg_std_error(&myerr.pub);
+  myerr.pub.error_exit = my_error_exit;
+  myerr.pub.emit_message = my_emit_message;
+
+  if (setjmp(myerr.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return 0;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  /* Reject images larger than 1 Megapixel, and limit the number of scans and
+     the entropy decoding work, as with TJFLAG_LIMITRESOURCES. */
+  jpeg_set_decompress_limits(&cinfo, 1048576, 500, 0, 100);
+  jpeg_mem_src(&cinfo, data, size);
+  jpeg_read_header(&cinfo, TRUE);
+
+  if (cinfo.jpeg_color_space != JCS_CMYK &&
+      cinfo.jpeg_color_space != JCS_YCCK)
+    cinfo.out_color_space = colorSpaces[sel % NUMCS];
+  sel /= NUMCS;
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = 1 << (sel & 3);
+  cinfo.do_fancy_upsampling = (sel & 4) ? FALSE : TRUE;
+  cinfo.dct_method = (sel & 8) ? JDCT_IFAST : JDCT_ISLOW;
+  cinfo.do_block_smoothing = (sel & 16) ? FALSE : TRUE;
+  cinfo.buffered_image = TRUE;
+
+  jpeg_start_decompress(&cinfo);
+
+  row_stride = cinfo.output_width * cinfo.output_components;
+  buffer = (*cinfo.mem->alloc_sarray)
+    ((j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, cinfo.rec_outbuf_height);
+
+  do {
+    int ret;
+
+    /* Absorb any input that is already available.  With a memory source, this
+       reads all remaining scans on the first pass if (sel & 32), which makes
+       the first output pass the final one.  Otherwise, it reads up to the next
+       scan. */
+    do {
+      ret = jpeg_consume_input(&cinfo);
+    } while (ret != JPEG_SUSPENDED && ret != JPEG_REACHED_EOI &&
+             (ret != JPEG_REACHED_SOS || (sel & 32)));
+
+#ifdef FUZZ_FAST_MODE
+    /* Skip all intermediate output passes other than the first. */
+    if (pass > 0 && !jpeg_input_complete(&cinfo))
+      continue;
+#endif
+
+    jpeg_start_output(&cinfo, cinfo.input_scan_number);
+    /* Toggle interblock smoothing for the next output pass. */
+    if (sel & 64)
+      cinfo.do_block_smoothing = !cinfo.do_block_smoothing;
+    while (cinfo.output_scanline < cinfo.output_height) {
+      JDIMENSION nlines = jpeg_read_scanlines(&cinfo, buffer,
+                                              cinfo.rec_outbuf_height);
+
+#ifndef FUZZ_FAST_MODE
+      int i;
+
+      /* Touch all of the output pixels in order to catch uninitialized reads
+         when using MemorySanitizer. */
+      for (JDIMENSION row = 0; row < nlines; row++)
+        for (i = 0; i < (int)row_stride; i++)
+          sum += buffer[row][i];
+#else
+      (void)nlines;
+#endif
+    }
+    jpeg_finish_output(&cinfo);
+    pass++;
+  } while (!jpeg_input_complete(&cinfo));
+
+  jpeg_finish_decompress(&cinfo);
+
+  /* Prevent the code above from being optimized out.  This test should never
+     be true, but the compiler doesn't know that. */
+  if (sum > 255U * 1048576U * 4U)
+    goto bailout;
+
+bailout:
+  jpeg_destroy_decompress(&cinfo);
+  return 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This fuzz target uses the libjpeg API to decompress a region of each JPEG
+   image with jpeg_crop_scanline() and a random sequence of
+   jpeg_read_scanlines() and jpeg_skip_scanlines() calls.  The crop window and
+   the read/skip sequence, as well as the scaling factor, upsampling method
+   (including merged upsampling), and IDCT algorithm, are derived from the
+   selector (see fuzz_select.h).  The target aborts if jpeg_skip_scanlines()
+   skips a different number of lines than requested.
+
+   If FUZZ_FULL_DECODE is defined, then the target does not crop the image and
+   reads the lines that it would otherwise skip.  Comparing the exec/s of
+   decompress_crop_bench and decompress_crop_full_bench on the same corpus
+   gives the cost of a cropped/partial decode relative to a full decode. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include "fuzz_select.h"
+
+
+#define NUMCS  3
+
+
+struct fuzzer_error_mgr {
+  struct jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+};
+
+
+static void my_error_exit(j_common_ptr cinfo)
+{
+  struct fuzzer_error_mgr *myerr = (struct fuzzer_error_mgr *)cinfo->err;
+
+  longjmp(myerr->setjmp_buffer, 1);
+}
+
+
+static void my_emit_message(j_common_ptr cinfo, int msg_level)
+{
+  if (msg_level < 0)
+    cinfo->err->num_warnings++;
+}
+
+
+static unsigned int nextRandom(unsigned int *state)
+{
+  /* xorshift32 */
+  unsigned int x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  struct jpeg_decompress_struct cinfo;
+  struct fuzzer_error_mgr myerr;
+  JSAMPARRAY buffer;
+  unsigned int sel, row_stride, sum = 0, x;
+  JDIMENSION lines;
+  size_t i;
+  J_COLOR_SPACE colorSpaces[NUMCS] = { JCS_RGB, JCS_GRAYSCALE, JCS_EXT_BGRX };
+#if defined(__has_feature) && __has_feature(memory_sanitizer)
+  char env[18] = "JSIMD_FORCENONE=1";
+
+  /* The libjpeg-turbo SIMD extensions produce false positives with
+     MemorySanitizer. */
+  putenv(env);
+#endif
+
+  sel = fuzz_select(&data, &size);
+  if (size < 1)
+    return 0;
+
+  cinfo.err = jpeg_std_error(&myerr.pub);
+  myerr.pub.error_exit = my_error_exit;
+  myerr.pub.emit_message = my_emit_message;
+
+  if (setjmp(myerr.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return 0;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  /* Reject images larger than 1 Megapixel, and limit the number of scans and
+     the entropy decoding work, as with TJFLAG_LIMITRESOURCES. */
+  jpeg_set_decompress_limits(&cinfo, 1048576, 500, 0, 100);
+  jpeg_mem_src(&cinfo, data, size);
+  jpeg_read_header(&cinfo, TRUE);
+
+  /* Derive the decompression parameters from the selector, and seed the
+     pseudo-random generator for the crop window and the read/skip sequence
+     with it.  Disabling fancy upsampling enables merged upsampling for h2v1
+     and h2v2 images with RGB output. */
+  x = sel | 1;
+  nextRandom(&x);
+  if (cinfo.jpeg_color_space != JCS_CMYK &&
+      cinfo.jpeg_color_space != JCS_YCCK)
+    cinfo.out_color_space = colorSpaces[sel % NUMCS];
+  sel /= NUMCS;
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = 1 << (sel & 3);
+  cinfo.do_fancy_upsampling = (sel & 4) ? FALSE : TRUE;
+  cinfo.dct_method = (sel & 8) ? JDCT_IFAST : JDCT_ISLOW;
+
+  jpeg_start_decompress(&cinfo);
+
+#ifndef FUZZ_FULL_DECODE
+  {
+    JDIMENSION xoffset = x % cinfo.output_width,
+      width = 1 + (x >> 12) % (cinfo.output_width - xoffset);
+
+    jpeg_crop_scanline(&cinfo, &xoffset, &width);
+    if (width != cinfo.output_width)
+      abort();
+  }
+#endif
+
+  row_stride = cinfo.output_width * cinfo.output_components;
+  buffer = (*cinfo.mem->alloc_sarray)
+    ((j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, cinfo.rec_outbuf_height);
+
+  while (cinfo.output_scanline < cinfo.output_height) {
+    nextRandom(&x);
+
+    /* Usually read or skip a few lines, which may or may not cross iMCU row
+       boundaries, but occasionally read or skip a large part of the image. */
+    lines = 1 + (x >> 2) % ((x & 0x30) ? 40 : cinfo.output_height);
+
+#ifndef FUZZ_FULL_DECODE
+    if (x & 1) {
+      JDIMENSION scanline = cinfo.output_scanline, skipped;
+
+      if (scanline + lines > cinfo.output_height)
+        lines = cinfo.output_height - scanline;
+      skipped = jpeg_skip_scanlines(&cinfo, lines);
+      if (skipped != lines || cinfo.output_scanline != scanline + lines)
+        abort();
+      continue;
+    }
+#endif
+
+    while (lines > 0 && cinfo.output_scanline < cinfo.output_height) {
+      JDIMENSION maxLines = (JDIMENSION)cinfo.rec_outbuf_height < lines ?
+                            (JDIMENSION)cinfo.rec_outbuf_height : lines;
+      JDIMENSION nlines = jpeg_read_scanlines(&cinfo, buffer, maxLines);
+
+      if (nlines == 0)
+        goto bailout;
+      /* The upsampler must never return lines past the bottom of the image. */
+      if (cinfo.output_scanline > cinfo.output_height)
+        abort();
+      /* Touch all of the output pixels in order to catch uninitialized reads
+         when using MemorySanitizer. */
+      for (JDIMENSION row = 0; row < nlines; row++)
+        for (i = 0; i < row_stride; i++)
+          sum += buffer[row][i];
+      lines -= nlines;
+    }
+  }
+
+  jpeg_finish_decompress(&cinfo);
+
+  /* Prevent the code above from being optimized out.  This test should never
+     be true, but the compiler doesn't know that. */
+  if (sum > 255U * 1048576U * 4U)
+    goto bailout;
+
+bailout:
+  jpeg_destroy_decompress(&cinfo);
+  return 0;
+}
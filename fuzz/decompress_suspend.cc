@@ -0,0 +1,314 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This fuzz target uses the libjpeg API to decompress JPEG images from a
+   suspending data source, which makes the input available in small chunks and
+   returns FALSE from fill_input_buffer() whenever the decompressor has
+   consumed all of the available data.  That exercises the suspension and
+   resumption paths in the marker reader, the input controller, and the
+   Huffman entropy decoder, none of which are reachable with a memory source.
+   (The arithmetic entropy decoder does not support suspension, so entropy-
+   coded segments in arithmetic-coded images are never split, but the markers
+   between them are.) */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <jerror.h>
+#include "fuzz_select.h"
+
+
+#define NUMCS  3
+
+
+struct fuzzer_error_mgr {
+  struct jpeg_error_mgr pub;
+  jmp_buf setjmp_buffer;
+};
+
+
+struct suspending_source_mgr {
+  struct jpeg_source_mgr pub;
+  const uint8_t *data;          /* entire input */
+  size_t size;                  /* size of input */
+  size_t avail;                 /* number of bytes made available so far */
+  unsigned int state;           /* pseudo-random state for chunk sizes */
+  unsigned int maxChunk;        /* maximum number of bytes to add at once */
+  boolean wholeSegments;        /* TRUE=never split entropy-coded segments */
+};
+
+
+static void my_error_exit(j_common_ptr cinfo)
+{
+  struct fuzzer_error_mgr *myerr = (struct fuzzer_error_mgr *)cinfo->err;
+
+  longjmp(myerr->setjmp_buffer, 1);
+}
+
+
+static void my_emit_message(j_common_ptr cinfo, int msg_level)
+{
+  if (msg_level < 0)
+    cinfo->err->num_warnings++;
+}
+
+
+static void init_source(j_decompress_ptr cinfo)
+{
+}
+
+
+static boolean fill_input_buffer(j_decompress_ptr cinfo)
+{
+  struct suspending_source_mgr *src =
+    (struct suspending_source_mgr *)cinfo->src;
+  static const JOCTET mybuffer[4] = {
+    (JOCTET)0xFF, (JOCTET)JPEG_EOI, 0, 0
+  };
+
+  /* Suspend until the driver makes more data available. */
+  if (src->avail < src->size)
+    return FALSE;
+
+  /* All of the input has been consumed, so insert a fake EOI marker, as
+     jpeg_mem_src() does. */
+  WARNMS(cinfo, JWRN_JPEG_EOF);
+  src->pub.next_input_byte = mybuffer;
+  src->pub.bytes_in_buffer = 2;
+  return TRUE;
+}
+
+
+static void skip_input_data(j_decompress_ptr cinfo, long num_bytes)
+{
+  struct suspending_source_mgr *src =
+    (struct suspending_source_mgr *)cinfo->src;
+  size_t offset;
+
+  if (num_bytes <= 0) return;
+  if ((size_t)num_bytes <= src->pub.bytes_in_buffer) {
+    src->pub.next_input_byte += num_bytes;
+    src->pub.bytes_in_buffer -= num_bytes;
+    return;
+  }
+
+  /* Skip past the available data.  Since the entire input is in memory, we
+     can simply advance the read pointer, and the driver will make at least
+     that much data available before resuming. */
+  if (src->pub.next_input_byte < src->data ||
+      src->pub.next_input_byte > src->data + src->size)
+    offset = src->size;             /* Pointing to the fake EOI marker */
+  else
+    offset = src->pub.next_input_byte - src->data;
+  if ((size_t)num_bytes > src->size - offset) offset = src->size;
+  else offset += num_bytes;
+  src->pub.next_input_byte = src->data + offset;
+  src->pub.bytes_in_buffer = src->avail > offset ? src->avail - offset : 0;
+}
+
+
+static void term_source(j_decompress_ptr cinfo)
+{
+}
+
+
+/* Return the offset just past the next marker (other than a restart marker)
+   at or following the given offset. */
+
+static size_t next_marker_end(const uint8_t *data, size_t size, size_t offset)
+{
+  while (offset < size) {
+    if (data[offset++] != 0xFF) continue;
+    while (offset < size && data[offset] == 0xFF) offset++;
+    if (offset < size && data[offset] != 0 &&
+        (data[offset] < 0xD0 || data[offset] > 0xD7))
+      return offset + 1;
+  }
+  return size;
+}
+
+
+/* Make another chunk of the input available to the decompressor.  This is
+   called only after the decompressor suspends. */
+
+static void feed(j_decompress_ptr cinfo)
+{
+  struct suspending_source_mgr *src =
+    (struct suspending_source_mgr *)cinfo->src;
+  size_t offset;
+  unsigned int x = src->state;
+
+  /* The decompressor never suspends once it has reached the fake EOI marker,
+     but be safe. */
+  if (src->pub.next_input_byte < src->data ||
+      src->pub.next_input_byte > src->data + src->size)
+    return;
+  offset = src->pub.next_input_byte - src->data;
+
+  /* xorshift32 */
+  x ^= x << 13;  x ^= x >> 17;  x ^= x << 5;
+  src->state = x;
+
+  if (src->avail < offset) src->avail = offset;
+  src->avail += x % src->maxChunk + 1;
+  if (src->avail > src->size) src->avail = src->size;
+  /* The arithmetic entropy decoder cannot suspend, so make the remainder of
+     any entropy-coded segment (along with the marker that terminates it)
+     available all at once.  Marker segments are still split. */
+  if (src->wholeSegments && src->avail < src->size &&
+      src->data[src->avail] != 0xFF)
+    src->avail = next_marker_end(src->data, src->size, src->avail);
+  src->pub.bytes_in_buffer = src->avail - offset;
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  struct jpeg_decompress_struct cinfo;
+  struct fuzzer_error_mgr myerr;
+  struct suspending_source_mgr src;
+  JSAMPARRAY buffer;
+  unsigned int sel, row_stride, sum = 0;
+  int i;
+  J_COLOR_SPACE colorSpaces[NUMCS] = { JCS_RGB, JCS_GRAYSCALE, JCS_EXT_BGRX };
+  unsigned int maxChunks[4] = { 1, 16, 256, 4096 };
+#if defined(__has_feature) && __has_feature(memory_sanitizer)
+  char env[18] = "JSIMD_FORCENONE=1";
+
+  /* The libjpeg-turbo SIMD extensions produce false positives with
+     MemorySanitizer. */
+  putenv(env);
+#endif
+
+  /* Select the chunk sizes and decompression parameters. */
+  sel = fuzz_select(&data, &size);
+  if (size < 1)
+    return 0;
+
+  cinfo.err = jpeg_std_error(&myerr.pub);
+  myerr.pub.error_exit = my_error_exit;
+  myerr.pub.emit_message = my_emit_message;
+
+  if (setjmp(myerr.setjmp_buffer)) {
+    jpeg_destroy_decompress(&cinfo);
+    return 0;
+  }
+
+  jpeg_create_decompress(&cinfo);
+  /* Reject images larger than 1 Megapixel, and limit the number of scans and
+     the entropy decoding work, as with TJFLAG_LIMITRESOURCES. */
+  jpeg_set_decompress_limits(&cinfo, 1048576, 500, 0, 100);
+
+  src.pub.init_source = init_source;
+  src.pub.fill_input_buffer = fill_input_buffer;
+  src.pub.skip_input_data = skip_input_data;
+  src.pub.resync_to_restart = jpeg_resync_to_restart;
+  src.pub.term_source = term_source;
+  src.pub.next_input_byte = data;
+  src.pub.bytes_in_buffer = 0;
+  src.data = data;
+  src.size = size;
+  src.avail = 0;
+  src.state = sel | 0x100;
+  src.maxChunk = maxChunks[sel & 3];
+  src.wholeSegments = FALSE;
+  cinfo.src = &src.pub;
+  sel >>= 2;
+
+  while (jpeg_read_header(&cinfo, TRUE) == JPEG_SUSPENDED)
+    feed(&cinfo);
+  if (cinfo.arith_code) {
+    src.wholeSegments = TRUE;
+    feed(&cinfo);
+  }
+
+  if (cinfo.jpeg_color_space != JCS_CMYK &&
+      cinfo.jpeg_color_space != JCS_YCCK)
+    cinfo.out_color_space = colorSpaces[sel % NUMCS];
+  sel /= NUMCS;
+  cinfo.do_fancy_upsampling = (sel & 1) ? FALSE : TRUE;
+  cinfo.dct_method = (sel & 2) ? JDCT_IFAST : JDCT_ISLOW;
+  cinfo.buffered_image = (sel & 4) ? TRUE : FALSE;
+
+  while (!jpeg_start_decompress(&cinfo))
+    feed(&cinfo);
+
+  row_stride = cinfo.output_width * cinfo.output_components;
+  buffer = (*cinfo.mem->alloc_sarray)
+    ((j_common_ptr)&cinfo, JPOOL_IMAGE, row_stride, cinfo.rec_outbuf_height);
+
+  do {
+    if (cinfo.buffered_image) {
+      int ret;
+
+      /* Absorb the next scan, which exercises jpeg_consume_input()'s
+         suspension paths. */
+      do {
+        if ((ret = jpeg_consume_input(&cinfo)) == JPEG_SUSPENDED)
+          feed(&cinfo);
+      } while (ret != JPEG_REACHED_EOI && ret != JPEG_REACHED_SOS);
+
+      while (!jpeg_start_output(&cinfo, cinfo.input_scan_number))
+        feed(&cinfo);
+    }
+
+    while (cinfo.output_scanline < cinfo.output_height) {
+      JDIMENSION nlines = jpeg_read_scanlines(&cinfo, buffer,
+                                              cinfo.rec_outbuf_height);
+
+      if (nlines == 0) {
+        feed(&cinfo);
+        continue;
+      }
+      /* Touch all of the output pixels in order to catch uninitialized reads
+         when using MemorySanitizer. */
+      for (JDIMENSION row = 0; row < nlines; row++)
+        for (i = 0; i < (int)row_stride; i++)
+          sum += buffer[row][i];
+    }
+
+    if (cinfo.buffered_image) {
+      while (!jpeg_finish_output(&cinfo))
+        feed(&cinfo);
+    }
+  } while (cinfo.buffered_image && !jpeg_input_complete(&cinfo));
+
+  while (!jpeg_finish_decompress(&cinfo))
+    feed(&cinfo);
+
+  /* Prevent the code above from being optimized out.  This test should never
+     be true, but the compiler doesn't know that. */
+  if (sum > 255U * 1048576U * 4U)
+    goto bailout;
+
+bailout:
+  jpeg_destroy_decompress(&cinfo);
+  return 0;
+}
@@ -29,21 +29,30 @@
 #include <turbojpeg.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include "fuzz_select.h"
 
 
 #define NUMPF  3
+#define NUMSF  8
 
 
 extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 {
   tjhandle handle = NULL;
   unsigned char *dstBuf = NULL, *yuvBuf = NULL;
-  int width = 0, height = 0, jpegSubsamp, jpegColorspace, pfi;
+  int width = 0, height = 0, jpegSubsamp, jpegColorspace, pf, w, h, i;
+  int flags = TJFLAG_LIMITRESOURCES, sum = 0;
+  unsigned int sel;
   /* TJPF_RGB-TJPF_BGR share the same code paths, as do TJPF_RGBX-TJPF_XRGB and
      TJPF_RGBA-TJPF_ARGB.  Thus, the pixel formats below should be the minimum
      necessary to achieve full coverage. */
   enum TJPF pixelFormats[NUMPF] =
     { TJPF_BGR, TJPF_XRGB, TJPF_GRAY };
+  /* IDCT scaling factors that exercise distinct code paths */
+  tjscalingfactor scalingFactors[NUMSF] = {
+    { 1, 1 }, { 1, 2 }, { 1, 4 }, { 1, 8 }, { 3, 8 }, { 5, 8 }, { 3, 4 },
+    { 7, 8 }
+  };
 #if defined(__has_feature) && __has_feature(memory_sanitizer)
   char env[18] = "JSIMD_FORCENONE=1";
 
@@ -52,6 +61,9 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   putenv(env);
 #endif
 
+  /* Rather than decompressing the image once for each configuration, select a
+     single configuration (pixel format, flags, and scaling factor). */
+  sel = fuzz_select(&data, &size);
   if ((handle = tjInitDecompress()) == NULL)
     goto bailout;
 
@@ -64,45 +76,34 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   if (width < 1 || height < 1 || (uint64_t)width * height > 1048576)
     goto bailout;
 
-  for (pfi = 0; pfi < NUMPF; pfi++) {
-    int pf = pixelFormats[pfi], flags = TJFLAG_LIMITSCANS, i, sum = 0;
-    int w = width, h = height;
+  pf = pixelFormats[sel % NUMPF];
+  sel /= NUMPF;
+  if (sel & 1) flags |= TJFLAG_BOTTOMUP;
+  if (sel & 2) flags |= TJFLAG_FASTUPSAMPLE;
+  if (sel & 4) flags |= TJFLAG_FASTDCT;
+  w = TJSCALED(width, scalingFactors[(sel >> 3) % NUMSF]);
+  h = TJSCALED(height, scalingFactors[(sel >> 3) % NUMSF]);
 
-    /* Test non-default decompression options on the first iteration. */
-    if (pfi == 0)
-      flags |= TJFLAG_BOTTOMUP | TJFLAG_FASTUPSAMPLE | TJFLAG_FASTDCT;
-    /* Test IDCT scaling on the second iteration. */
-    else if (pfi == 1) {
-      w = (width + 3) / 4;
-      h = (height + 3) / 4;
-    }
-
-    if ((dstBuf = (unsigned char *)malloc(w * h * tjPixelSize[pf])) == NULL)
-      goto bailout;
-    if ((yuvBuf =
-         (unsigned char *)malloc(tjBufSizeYUV2(w, 1, h, jpegSubsamp))) == NULL)
-      goto bailout;
-
-    if (tjDecompressToYUV2(handle, data, size, yuvBuf, w, 1, h, flags) == 0 &&
-        tjDecodeYUV(handle, yuvBuf, 1, jpegSubsamp, dstBuf, w, 0, h, pf,
-                    flags) == 0) {
-      /* Touch all of the output pixels in order to catch uninitialized reads
-         when using MemorySanitizer. */
-      for (i = 0; i < w * h * tjPixelSize[pf]; i++)
-        sum += dstBuf[i];
-    }
-
-    free(dstBuf);
-    dstBuf = NULL;
-    free(yuvBuf);
-    yuvBuf = NULL;
+  if ((dstBuf = (unsigned char *)malloc(w * h * tjPixelSize[pf])) == NULL)
+    goto bailout;
+  if ((yuvBuf =
+       (unsigned char *)malloc(tjBufSizeYUV2(w, 1, h, jpegSubsamp))) == NULL)
+    goto bailout;
 
-    /* Prevent the code above from being optimized out.  This test should never
-       be true, but the compiler doesn't know that. */
-    if (sum > 255 * 1048576 * tjPixelSize[pf])
-      goto bailout;
+  if (tjDecompressToYUV2(handle, data, size, yuvBuf, w, 1, h, flags) == 0 &&
+      tjDecodeYUV(handle, yuvBuf, 1, jpegSubsamp, dstBuf, w, 0, h, pf,
+                  flags) == 0) {
+    /* Touch all of the output pixels in order to catch uninitialized reads
+       when using MemorySanitizer. */
+    for (i = 0; i < w * h * tjPixelSize[pf]; i++)
+      sum += dstBuf[i];
   }
 
+  /* Prevent the code above from being optimized out.  This test should never
+     be true, but the compiler doesn't know that. */
+  if (sum > 255 * 1048576 * tjPixelSize[pf])
+    goto bailout;
+
 bailout:
   free(dstBuf);
   free(yuvBuf);
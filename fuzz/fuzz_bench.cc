@@ -0,0 +1,340 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This program measures the performance of a fuzz target on a corpus without
+   requiring a fuzzing engine, so it can be used to compare the cost of fuzz
+   target configurations, and to benchmark the library against the fuzzing
+   corpora, on any platform.  It memory-maps each input in the corpus and calls
+   LLVMFuzzerTestOneInput() on each input in turn.
+
+   By default, the corpus is repeated until the requested amount of time has
+   elapsed, and the throughput (exec/s) is reported.  If -iterations is
+   specified, then each input is replayed a fixed number of times (following
+   one or more untimed warmup runs), and the time per execution is reported
+   for each input as well as for the corpus as a whole.
+
+   If -threads is specified, then the inputs are replayed concurrently by the
+   specified number of threads.  The fuzz target must be thread-safe.  Targets
+   that call putenv() for each input are not, because the library reads the
+   environment with getenv().  That includes compress_yuv (which sets
+   TJ_ARITHMETIC and TJ_RESTART) and every target built with MemorySanitizer
+   (which sets JSIMD_FORCENONE.)  The cjpeg target, which keeps its state in
+   static variables, and the FUZZ_COST_MODE targets, which measure the cost of
+   each input, are not thread-safe either.  This program refuses
+   to use more than one thread with those targets.  (Different targets can be
+   run concurrently by running multiple instances of this program.)
+
+   NOTE: Unlike a fuzzing engine, this program does not copy each input into a
+   buffer of exactly the right size, so it cannot detect buffer overruns that
+   read past the end of the input. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+/* CMakeLists.txt defines FUZZ_BENCH_SINGLE_THREAD for targets that are not
+   thread-safe. */
+#if defined(FUZZ_BENCH_SINGLE_THREAD) || defined(FUZZ_COST_MODE) || \
+  (defined(__has_feature) && __has_feature(memory_sanitizer))
+#define THREAD_SAFE  0
+#else
+#define THREAD_SAFE  1
+#endif
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv)
+  __attribute__((weak));
+
+
+struct input {
+  char *name;
+  uint8_t *data;                /* memory-mapped input, or emptyInput */
+  size_t size;
+  double time;                  /* seconds per execution (-iterations) */
+};
+
+static struct input *inputs = NULL;
+static int numInputs = 0, maxInputs = 0;
+static uint8_t emptyInput[1] = { 0 };
+
+static double benchTime = 5.0;
+static int iterations = 0, warmup = 1;
+static int nextInput = 0;
+
+
+static double getTime(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 0.000000001;
+}
+
+
+static int loadFile(const char *filename)
+{
+  int fd = -1;
+  struct stat st;
+  uint8_t *data = emptyInput;
+  char *name = NULL;
+
+  if ((fd = open(filename, O_RDONLY)) < 0 || fstat(fd, &st) < 0)
+    goto bailout;
+  if (st.st_size > 0 &&
+      (data = (uint8_t *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd,
+                              0)) == MAP_FAILED) {
+    data = emptyInput;
+    goto bailout;
+  }
+  close(fd);  fd = -1;
+  if ((name = strdup(filename)) == NULL)
+    goto bailout;
+
+  if (numInputs >= maxInputs) {
+    struct input *newInputs;
+
+    maxInputs = maxInputs ? maxInputs * 2 : 64;
+    if ((newInputs = (struct input *)realloc(inputs, maxInputs *
+                                             sizeof(struct input))) == NULL)
+      goto bailout;
+    inputs = newInputs;
+  }
+  inputs[numInputs].name = name;
+  inputs[numInputs].data = data;
+  inputs[numInputs].size = st.st_size;
+  inputs[numInputs++].time = 0.0;
+  return 0;
+
+bailout:
+  fprintf(stderr, "Could not read %s\n", filename);
+  if (fd >= 0) close(fd);
+  if (data != emptyInput) munmap(data, st.st_size);
+  free(name);
+  return -1;
+}
+
+
+static int loadPath(const char *path)
+{
+  struct stat st;
+  DIR *dir;
+  struct dirent *entry;
+  char filename[FILENAME_MAX];
+
+  if (stat(path, &st) < 0) {
+    fprintf(stderr, "Could not stat %s\n", path);
+    return -1;
+  }
+  if (!S_ISDIR(st.st_mode))
+    return loadFile(path);
+
+  if ((dir = opendir(path)) == NULL) {
+    fprintf(stderr, "Could not open directory %s\n", path);
+    return -1;
+  }
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') continue;
+    snprintf(filename, FILENAME_MAX, "%s/%s", path, entry->d_name);
+    if (stat(filename, &st) == 0 && S_ISREG(st.st_mode) &&
+        loadFile(filename) < 0) {
+      closedir(dir);
+      return -1;
+    }
+  }
+  closedir(dir);
+  return 0;
+}
+
+
+static int compareInputs(const void *arg1, const void *arg2)
+{
+  return strcmp(((const struct input *)arg1)->name,
+                ((const struct input *)arg2)->name);
+}
+
+
+/* Thread function for -iterations: replay the next unclaimed input until all
+   inputs have been replayed. */
+
+static void *replayInputs(void *arg)
+{
+  int i, j;
+
+  while ((i = __atomic_fetch_add(&nextInput, 1, __ATOMIC_RELAXED)) <
+         numInputs) {
+    double start;
+
+    for (j = 0; j < warmup; j++)
+      LLVMFuzzerTestOneInput(inputs[i].data, inputs[i].size);
+    start = getTime();
+    for (j = 0; j < iterations; j++)
+      LLVMFuzzerTestOneInput(inputs[i].data, inputs[i].size);
+    inputs[i].time = (getTime() - start) / (double)iterations;
+  }
+  return NULL;
+}
+
+
+/* Thread function for -time: repeat the corpus until the requested amount of
+   time has elapsed, and return the number of executions. */
+
+static void *repeatCorpus(void *arg)
+{
+  unsigned long long *execs = (unsigned long long *)arg;
+  double start = getTime();
+  int i;
+
+  do {
+    for (i = 0; i < numInputs; i++)
+      LLVMFuzzerTestOneInput(inputs[i].data, inputs[i].size);
+    *execs += numInputs;
+  } while (getTime() - start < benchTime);
+  return NULL;
+}
+
+
+static void usage(char *progName)
+{
+  printf("USAGE: %s [options] <file or directory> [...]\n\n", progName);
+  printf("Run the fuzz target on each input in the corpus, and report its performance.\n\n");
+  printf("Options:\n");
+  printf("-time <t> = Repeat the corpus for at least <t> seconds (default = 5.0), and\n");
+  printf("     report the number of execs per second.\n");
+  printf("-iterations <n> = Instead, run the fuzz target <n> times on each input, and\n");
+  printf("     report the time per exec for each input and for the whole corpus.\n");
+  printf("-warmup <w> = With -iterations, run the fuzz target <w> untimed times on each\n");
+  printf("     input before timing it (default = 1)\n");
+  printf("-threads <n> = Replay the inputs using <n> concurrent threads (default = 1).\n");
+  printf("     The fuzz target must be thread-safe.\n");
+  exit(1);
+}
+
+
+int main(int argc, char **argv)
+{
+  double start, elapsed, total = 0.0;
+  unsigned long long execs = 0, bytes = 0, *threadExecs = NULL;
+  pthread_t *threads = NULL;
+  int numThreads = 1, i;
+
+  if (LLVMFuzzerInitialize)
+    LLVMFuzzerInitialize(&argc, &argv);
+
+  for (i = 1; i < argc; i++) {
+    if (!strcasecmp(argv[i], "-time") && i < argc - 1) {
+      double tempd = atof(argv[++i]);
+
+      if (tempd > 0.0) benchTime = tempd;
+      else usage(argv[0]);
+    } else if (!strcasecmp(argv[i], "-iterations") && i < argc - 1) {
+      if ((iterations = atoi(argv[++i])) < 1) usage(argv[0]);
+    } else if (!strcasecmp(argv[i], "-warmup") && i < argc - 1) {
+      if ((warmup = atoi(argv[++i])) < 0) usage(argv[0]);
+    } else if (!strcasecmp(argv[i], "-threads") && i < argc - 1) {
+      if ((numThreads = atoi(argv[++i])) < 1) usage(argv[0]);
+    } else if (argv[i][0] == '-')
+      usage(argv[0]);
+    else if (loadPath(argv[i]) < 0)
+      return 1;
+  }
+  if (numInputs < 1) usage(argv[0]);
+  if (numThreads > 1 && !THREAD_SAFE) {
+    fprintf(stderr, "ERROR: This fuzz target is not thread-safe, so -threads cannot be\n");
+    fprintf(stderr, "       greater than 1.\n");
+    return 1;
+  }
+  qsort(inputs, numInputs, sizeof(struct input), compareInputs);
+  for (i = 0; i < numInputs; i++)
+    bytes += inputs[i].size;
+
+  if ((threads = (pthread_t *)malloc(numThreads * sizeof(pthread_t))) ==
+      NULL ||
+      (threadExecs = (unsigned long long *)calloc(numThreads,
+                                                  sizeof(unsigned long long))) ==
+      NULL) {
+    fprintf(stderr, "Memory allocation failure\n");
+    return 1;
+  }
+
+  start = getTime();
+  for (i = 0; i < numThreads; i++) {
+    if (pthread_create(&threads[i], NULL,
+                       iterations ? replayInputs : repeatCorpus,
+                       &threadExecs[i]) != 0) {
+      fprintf(stderr, "Could not create thread\n");
+      return 1;
+    }
+  }
+  for (i = 0; i < numThreads; i++) {
+    pthread_join(threads[i], NULL);
+    execs += threadExecs[i];
+  }
+  elapsed = getTime() - start;
+
+  if (iterations) {
+    /* Report the time per exec for each input, and the sum of those times
+       (the time it takes one thread to replay the corpus once.) */
+    for (i = 0; i < numInputs; i++) {
+      printf("%s: %lu bytes, %f ms/exec\n", inputs[i].name,
+             (unsigned long)inputs[i].size, inputs[i].time * 1000.);
+      total += inputs[i].time;
+    }
+    printf("%d inputs, %d iterations (+ %d warmup) in %f s using %d thread(s)\n",
+           numInputs, iterations, warmup, elapsed, numThreads);
+    printf("%f ms per corpus replay\n", total * 1000.);
+    printf("%f exec/s, %f MB/s per thread\n", (double)numInputs / total,
+           (double)bytes / 1000000. / total);
+  } else {
+    bytes *= execs / numInputs;
+    printf("%d inputs, %llu execs in %f s using %d thread(s)\n", numInputs,
+           execs, elapsed, numThreads);
+    printf("%f exec/s, %f MB/s\n", (double)execs / elapsed,
+           (double)bytes / 1000000. / elapsed);
+  }
+
+  for (i = 0; i < numInputs; i++) {
+    if (inputs[i].data != emptyInput)
+      munmap(inputs[i].data, inputs[i].size);
+    free(inputs[i].name);
+  }
+  free(inputs);
+  free(threads);
+  free(threadExecs);
+  return 0;
+}
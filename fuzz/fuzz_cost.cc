@@ -0,0 +1,175 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This file implements the cost measurement for the performance-regression
+   variants of the fuzz targets.  See fuzz_cost.h. */
+
+#include "fuzz_cost.h"
+#include "fuzz_select.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+
+/* Number of cost-per-byte buckets (4 per power of 2) */
+#define NUM_BUCKETS  256
+
+/* libFuzzer treats any nonzero counter in this section as a coverage feature,
+   so an input that reaches a new level of cost per byte is added to the
+   corpus.  Other fuzzing engines ignore the section.  The array is global so
+   that the compiler cannot discard the stores to it. */
+#ifdef __linux__
+__attribute__((section("__libfuzzer_extra_counters")))
+#endif
+uint8_t fuzz_cost_counters[NUM_BUCKETS];
+
+static int initialized = 0, perfFd = -1;
+static const char *unitName = "ns", *corpusDir = NULL;
+static double limit = FUZZ_COST_DEFAULT_LIMIT_NS;
+static unsigned long long base = FUZZ_COST_DEFAULT_BASE_NS;
+static double maxCostPerByte = 0.0;
+static struct timespec startTime;
+
+
+static void init(void)
+{
+  char *env;
+
+  initialized = 1;
+
+#ifdef __linux__
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof(struct perf_event_attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(struct perf_event_attr);
+  attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  perfFd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  if (perfFd >= 0) {
+    unitName = "instructions";
+    limit = FUZZ_COST_DEFAULT_LIMIT;
+    base = FUZZ_COST_DEFAULT_BASE;
+  }
+#endif
+
+  if ((env = getenv("FUZZ_COST_LIMIT")) != NULL && strlen(env) > 0)
+    limit = atof(env);
+  if ((env = getenv("FUZZ_COST_BASE")) != NULL && strlen(env) > 0)
+    base = strtoull(env, NULL, 10);
+  if ((env = getenv("FUZZ_COST_CORPUS")) != NULL && strlen(env) > 0)
+    corpusDir = env;
+}
+
+
+void fuzz_cost_begin(void)
+{
+  if (!initialized) init();
+
+#ifdef __linux__
+  if (perfFd >= 0) {
+    ioctl(perfFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(perfFd, PERF_EVENT_IOC_ENABLE, 0);
+    return;
+  }
+#endif
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &startTime);
+}
+
+
+static unsigned long long getCost(void)
+{
+  struct timespec endTime;
+
+#ifdef __linux__
+  if (perfFd >= 0) {
+    unsigned long long count = 0;
+
+    ioctl(perfFd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(perfFd, &count, sizeof(count)) != sizeof(count))
+      return 0;
+    return count;
+  }
+#endif
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &endTime);
+  return (unsigned long long)(endTime.tv_sec - startTime.tv_sec) *
+         1000000000ULL + endTime.tv_nsec - startTime.tv_nsec;
+}
+
+
+static void saveInput(const uint8_t *data, size_t size,
+                      unsigned long long costPerByte)
+{
+  char filename[FILENAME_MAX];
+  FILE *file;
+
+  snprintf(filename, FILENAME_MAX, "%s/cost-%llu-%08x", corpusDir,
+           costPerByte, fuzz_hash(data, size));
+  if ((file = fopen(filename, "wb")) == NULL) {
+    fprintf(stderr, "FUZZ_COST: Could not write %s\n", filename);
+    return;
+  }
+  if (size > 0 && fwrite(data, size, 1, file) < 1)
+    fprintf(stderr, "FUZZ_COST: Could not write %s\n", filename);
+  fclose(file);
+}
+
+
+void fuzz_cost_end(const uint8_t *data, size_t size, uint64_t pixels)
+{
+  unsigned long long cost = getCost();
+  double costPerByte = (double)cost / (double)(size ? size : 1);
+  int bucket = (int)(4.0 * log2(costPerByte + 1.0));
+
+  if (bucket >= NUM_BUCKETS) bucket = NUM_BUCKETS - 1;
+  fuzz_cost_counters[bucket] = 1;
+
+  if (costPerByte > maxCostPerByte) {
+    maxCostPerByte = costPerByte;
+    if (corpusDir)
+      saveInput(data, size, (unsigned long long)costPerByte);
+  }
+
+  if (limit > 0.0 && (double)cost > (double)base + limit * (double)pixels) {
+    fprintf(stderr,
+            "==%d== ERROR: FUZZ_COST: %llu %s for %llu pixels exceeds the limit of %llu + %g per pixel\n",
+            (int)getpid(), cost, unitName, (unsigned long long)pixels, base,
+            limit);
+    abort();
+  }
+}
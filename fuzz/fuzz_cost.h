@@ -0,0 +1,67 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Cost measurement for the performance-regression variants of the fuzz
+   targets (FUZZ_COST_MODE)
+
+   A target calls fuzz_cost_begin() before and fuzz_cost_end() after the
+   operation whose cost should be measured.  The cost is the number of
+   user-space instructions retired, as counted by perf_event_open(), or the
+   thread CPU time in nanoseconds if hardware performance counters are
+   unavailable.  fuzz_cost_end() then:
+
+   - marks a coverage counter for the input's cost per input byte (in
+     quarter-octave buckets), so that libFuzzer keeps the inputs that reach
+     each new level of cost per byte in its corpus,
+
+   - writes the input to the directory specified in the FUZZ_COST_CORPUS
+     environment variable (if any) whenever its cost per byte is higher than
+     that of any previous input, and
+
+   - reports the input and calls abort() if its cost exceeds
+     FUZZ_COST_BASE + FUZZ_COST_LIMIT * pixels, where pixels is the number of
+     pixels that the operation processed.  The defaults are given below. */
+
+#ifndef __FUZZ_COST_H__
+#define __FUZZ_COST_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Defaults for instructions retired */
+#define FUZZ_COST_DEFAULT_LIMIT  5000     /* per pixel */
+#define FUZZ_COST_DEFAULT_BASE   5000000  /* per input */
+
+/* Defaults for CPU time in nanoseconds */
+#define FUZZ_COST_DEFAULT_LIMIT_NS  2000
+#define FUZZ_COST_DEFAULT_BASE_NS   2000000
+
+void fuzz_cost_begin(void);
+void fuzz_cost_end(const uint8_t *data, size_t size, uint64_t pixels);
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Configuration selector for the fuzz targets
+
+   Rather than processing each input once for each configuration, the fuzz
+   targets process it once with a single configuration chosen by a selector.
+   An input can carry the selector in an optional prefix:
+
+     FUZZ_SELECTOR_TAG, followed by the selector as a 32-bit big-endian value
+
+   fuzz_select() strips the prefix from the input, so the remainder of the
+   input is passed to the library unchanged, and returns the selector.  Inputs
+   without the prefix, including the seed corpora (which consist of unmodified
+   image files), use selector 0.  The tag cannot begin a JPEG, BMP, GIF, or
+   PPM file.  (It can begin a Targa file with a 254-byte image ID, but such a
+   file is simply decoded with a different configuration.)  Since the selector
+   is kept separate from the image data, mutating the image does not change
+   the configuration, and mutating the selector does not change the image.
+   jpeg_mutator.cc mutates the selector explicitly.
+
+   fuzz_hash() is a general-purpose hash (FNV-1a) of the input, for targets
+   that need to identify an input. */
+
+#ifndef __FUZZ_SELECT_H__
+#define __FUZZ_SELECT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FUZZ_SELECTOR_TAG  0xFE
+/* Size of the selector prefix, including the tag */
+#define FUZZ_SELECTOR_SIZE  5
+
+
+static inline unsigned int fuzz_select(const uint8_t **data, size_t *size)
+{
+  const uint8_t *p = *data;
+
+  if (*size < FUZZ_SELECTOR_SIZE || p[0] != FUZZ_SELECTOR_TAG)
+    return 0;
+  *data += FUZZ_SELECTOR_SIZE;
+  *size -= FUZZ_SELECTOR_SIZE;
+  return ((unsigned int)p[1] << 24) | ((unsigned int)p[2] << 16) |
+         ((unsigned int)p[3] << 8) | p[4];
+}
+
+
+static inline unsigned int fuzz_hash(const uint8_t *data, size_t size)
+{
+  unsigned int hash = 2166136261U;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    hash = (hash ^ data[i]) * 16777619U;
+  return hash;
+}
+
+#endif
@@ -0,0 +1,439 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This is a structure-aware custom mutator for the fuzz targets that consume
+   JPEG images.  Byte-level mutations of a JPEG image usually corrupt the
+   marker framing, so most of them are rejected by the marker parser before
+   they reach the entropy decoders.  This mutator instead splits the image into
+   marker segments and entropy-coded segments, mutates one of them (or the
+   order of the segments) with some knowledge of its contents, and then
+   re-serializes the image with valid framing.  It also mutates the selector
+   prefix (see fuzz_select.h) separately from the image. */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "fuzz_select.h"
+
+
+#define MAX_SEGMENTS  256
+/* Maximum size of a marker segment payload (the length field is 16 bits and
+   includes itself.) */
+#define MAX_PAYLOAD  65533
+
+#define M_SOF0  0xC0
+#define M_DHT   0xC4
+#define M_SOI   0xD8
+#define M_EOI   0xD9
+#define M_SOS   0xDA
+#define M_DQT   0xDB
+#define M_DRI   0xDD
+/* Pseudo-markers used to identify entropy-coded segments and unparseable
+   data */
+#define M_ECS   0
+#define M_RAW   -1
+
+#define IS_RST(m)  ((m) >= 0xD0 && (m) <= 0xD7)
+#define IS_SOF(m) \
+  ((m) >= M_SOF0 && (m) <= 0xCF && (m) != M_DHT && (m) != 0xC8 && \
+   (m) != 0xCC)
+/* Markers that have no length field or payload */
+#define IS_STANDALONE(m)  ((m) == 0x01 || ((m) >= 0xD0 && (m) <= M_EOI))
+
+
+struct segment {
+  int marker;
+  const uint8_t *data;
+  size_t length;
+};
+
+
+/* libFuzzer provides LLVMFuzzerMutate(), but other fuzzing engines that
+   support LLVMFuzzerCustomMutator() may not. */
+extern "C" size_t LLVMFuzzerMutate(uint8_t *data, size_t size, size_t maxSize)
+  __attribute__((weak));
+
+
+static unsigned int nextRandom(unsigned int *state)
+{
+  /* xorshift32 */
+  unsigned int x = *state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+
+static size_t mutateBytes(uint8_t *data, size_t size, size_t maxSize,
+                          unsigned int *state)
+{
+  size_t i, n;
+
+  if (LLVMFuzzerMutate)
+    return LLVMFuzzerMutate(data, size, maxSize);
+
+  if (size == 0) return 0;
+  n = nextRandom(state) % 4 + 1;
+  for (i = 0; i < n; i++)
+    data[nextRandom(state) % size] ^= (uint8_t)(1 << (nextRandom(state) % 8));
+  return size;
+}
+
+
+/* Split a JPEG image into segments.  Returns the number of segments, or -1 if
+   the image does not begin with an SOI marker.  Any data that cannot be
+   parsed (including any data following the EOI marker) is returned as a
+   trailing raw segment so that it is preserved. */
+
+static int parseJPEG(const uint8_t *data, size_t size, struct segment *segs)
+{
+  size_t pos = 2;
+  int n = 0;
+
+  if (size < 2 || data[0] != 0xFF || data[1] != M_SOI)
+    return -1;
+
+  while (pos < size && n < MAX_SEGMENTS - 1) {
+    int marker;
+    size_t start;
+
+    if (data[pos] != 0xFF) break;
+    /* Return any fill bytes as a raw segment, so that they are preserved. */
+    start = pos;
+    while (pos + 1 < size && data[pos + 1] == 0xFF) pos++;
+    if (pos > start) {
+      segs[n].marker = M_RAW;  segs[n].data = &data[start];
+      segs[n++].length = pos - start;
+      if (n >= MAX_SEGMENTS - 1) break;
+    }
+    if (pos + 1 >= size || data[pos + 1] == 0) break;
+    marker = data[pos + 1];
+
+    if (IS_STANDALONE(marker)) {
+      segs[n].marker = marker;  segs[n].data = &data[pos + 2];
+      segs[n++].length = 0;
+      pos += 2;
+      if (marker == M_EOI) break;
+      continue;
+    }
+
+    if (pos + 4 > size) break;
+    start = ((size_t)data[pos + 2] << 8) | data[pos + 3];
+    if (start < 2 || pos + 2 + start > size) break;
+    segs[n].marker = marker;  segs[n].data = &data[pos + 4];
+    segs[n++].length = start - 2;
+    pos += 2 + start;
+
+    if (marker == M_SOS && n < MAX_SEGMENTS - 1) {
+      /* The entropy-coded segment extends to the next marker other than a
+         restart marker. */
+      start = pos;
+      while (pos < size) {
+        if (data[pos] == 0xFF && pos + 1 < size && data[pos + 1] != 0 &&
+            !IS_RST(data[pos + 1]))
+          break;
+        pos++;
+      }
+      if (pos > start) {
+        segs[n].marker = M_ECS;  segs[n].data = &data[start];
+        segs[n++].length = pos - start;
+      }
+    }
+  }
+
+  if (pos < size) {
+    segs[n].marker = M_RAW;  segs[n].data = &data[pos];
+    segs[n++].length = size - pos;
+  }
+  return n;
+}
+
+
+/* Serialize the segments into buf.  Returns the size of the image, or 0 if it
+   would exceed maxSize.  Serializing the segments returned by parseJPEG()
+   reproduces the original image byte-for-byte. */
+
+static size_t serializeJPEG(const struct segment *segs, int n, uint8_t *buf,
+                            size_t maxSize)
+{
+  size_t pos = 0, i;
+  int s;
+
+#define PUT(b) { \
+  if (pos >= maxSize) return 0; \
+  buf[pos++] = (uint8_t)(b); \
+}
+
+  PUT(0xFF);  PUT(M_SOI);
+  for (s = 0; s < n; s++) {
+    if (segs[s].marker == M_RAW) {
+      if (pos + segs[s].length > maxSize) return 0;
+      memcpy(&buf[pos], segs[s].data, segs[s].length);
+      pos += segs[s].length;
+      continue;
+    } else if (segs[s].marker == M_ECS) {
+      /* Re-stuff any 0xFF bytes that a mutation may have introduced, so that
+         the segment is still parsed as entropy-coded data.  A 0xFF byte at
+         the end of the image cannot be mistaken for a marker prefix, so it is
+         left alone.  (parseJPEG() only returns an entropy-coded segment that
+         ends with 0xFF if the segment extends to the end of the image.)  Thus,
+         this is a no-op for unmodified segments. */
+      for (i = 0; i < segs[s].length; i++) {
+        PUT(segs[s].data[i]);
+        if (segs[s].data[i] == 0xFF &&
+            (i + 1 >= segs[s].length ? s + 1 < n :
+             (segs[s].data[i + 1] != 0 && !IS_RST(segs[s].data[i + 1]))))
+          PUT(0);
+      }
+      continue;
+    }
+    PUT(0xFF);  PUT(segs[s].marker);
+    if (IS_STANDALONE(segs[s].marker)) continue;
+    PUT((segs[s].length + 2) >> 8);  PUT((segs[s].length + 2) & 0xFF);
+    if (pos + segs[s].length > maxSize) return 0;
+    memcpy(&buf[pos], segs[s].data, segs[s].length);
+    pos += segs[s].length;
+  }
+  return pos;
+
+#undef PUT
+}
+
+
+/* The following functions mutate the payload of a particular marker segment
+   in place, returning the new length of the payload.  Each makes one targeted
+   change that keeps the segment syntactically plausible, so that the marker
+   parser accepts it and the change is exercised by the decoder. */
+
+static size_t mutateSOF(uint8_t *p, size_t len, unsigned int *state)
+{
+  unsigned int r = nextRandom(state);
+  int nc;
+
+  if (len < 6) return len;
+  nc = p[5];
+  if ((size_t)(6 + nc * 3) > len) nc = (int)((len - 6) / 3);
+
+  switch (r % 5) {
+  case 0:
+    p[0] = (r >> 8) % 2 ? 12 : 8;                  /* Data precision */
+    break;
+  case 1:                                          /* Image height */
+  case 2: {                                        /* Image width */
+    unsigned int dim = (r >> 8) % 1024 + 1;
+
+    p[(r % 5) * 2 - 1] = dim >> 8;  p[(r % 5) * 2] = dim & 0xFF;
+    break;
+  }
+  case 3:                                          /* Sampling factors */
+    if (nc > 0)
+      p[6 + ((r >> 8) % nc) * 3 + 1] =
+        (uint8_t)((((r >> 16) % 4 + 1) << 4) | ((r >> 24) % 4 + 1));
+    break;
+  default:                                         /* Quant. table selector */
+    if (nc > 0)
+      p[6 + ((r >> 8) % nc) * 3 + 2] = (uint8_t)((r >> 16) % 4);
+  }
+  return len;
+}
+
+
+static size_t mutateDHT(uint8_t *p, size_t len, unsigned int *state)
+{
+  unsigned int r = nextRandom(state);
+  size_t count = 0;
+  int i;
+
+  if (len < 17) return len;
+  for (i = 1; i <= 16; i++) count += p[i];
+
+  switch (r % 3) {
+  case 0:                                          /* Table class and ID */
+    p[0] = (uint8_t)((((r >> 8) % 2) << 4) | ((r >> 16) % 4));
+    break;
+  case 1: {
+    /* Move a code from one length to another without changing the number of
+       symbols, which changes the shape of the Huffman tree. */
+    int from = (r >> 8) % 16 + 1, to = (r >> 16) % 16 + 1;
+
+    if (p[from] > 0 && p[to] < 255) { p[from]--;  p[to]++; }
+    break;
+  }
+  default:                                         /* Symbol value */
+    if (count > 0 && 17 + count <= len)
+      p[17 + (r >> 8) % count] = (uint8_t)(r >> 16);
+  }
+  return len;
+}
+
+
+static size_t mutateDQT(uint8_t *p, size_t len, unsigned int *state)
+{
+  unsigned int r = nextRandom(state);
+
+  if (len < 65) return len;
+  if (r % 4 == 0)                                  /* Table ID */
+    p[0] = (uint8_t)((p[0] & 0xF0) | ((r >> 8) % 4));
+  else                                             /* Table entry */
+    p[1 + (r >> 8) % 64] = (uint8_t)(r >> 16);
+  return len;
+}
+
+
+static size_t mutateSOS(uint8_t *p, size_t len, unsigned int *state)
+{
+  unsigned int r = nextRandom(state);
+  int ns;
+
+  if (len < 1) return len;
+  ns = p[0];
+  if ((size_t)(1 + ns * 2 + 3) > len) return len;
+
+  switch (r % 5) {
+  case 0:                                          /* Ss */
+    p[1 + ns * 2] = (uint8_t)((r >> 8) % 64);
+    break;
+  case 1:                                          /* Se */
+    p[2 + ns * 2] = (uint8_t)((r >> 8) % 64);
+    break;
+  case 2:                                          /* Ah and Al */
+    p[3 + ns * 2] = (uint8_t)((((r >> 8) % 14) << 4) | ((r >> 16) % 14));
+    break;
+  case 3:                                          /* Table selectors */
+    if (ns > 0)
+      p[2 + ((r >> 8) % ns) * 2] =
+        (uint8_t)((((r >> 16) % 4) << 4) | ((r >> 24) % 4));
+    break;
+  default:                                         /* Component selector */
+    if (ns > 0)
+      p[1 + ((r >> 8) % ns) * 2] = (uint8_t)((r >> 16) % 4 + 1);
+  }
+  return len;
+}
+
+
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size,
+                                          size_t maxSize, unsigned int seed)
+{
+  struct segment segs[MAX_SEGMENTS];
+  uint8_t *buf = NULL, *payload = NULL;
+  const uint8_t *jpegBuf = data;
+  unsigned int state = seed ? seed : 1, sel;
+  size_t jpegSize = size, newSize = 0, prefixSize;
+  int n, s, t;
+
+  sel = fuzz_select(&jpegBuf, &jpegSize);
+  prefixSize = size - jpegSize;
+  if ((n = parseJPEG(jpegBuf, jpegSize, segs)) <= 0)
+    return mutateBytes(data, size, maxSize, &state);
+
+  s = nextRandom(&state) % n;
+  switch (nextRandom(&state) % 8) {
+  case 0:                                          /* Delete a segment */
+    if (n > 1) {
+      memmove(&segs[s], &segs[s + 1], (n - s - 1) * sizeof(struct segment));
+      n--;
+    }
+    break;
+  case 1:                                          /* Duplicate a segment */
+    if (n < MAX_SEGMENTS) {
+      memmove(&segs[s + 1], &segs[s], (n - s) * sizeof(struct segment));
+      n++;
+    }
+    break;
+  case 2: {                                        /* Swap two segments */
+    struct segment tmp = segs[s];
+
+    t = nextRandom(&state) % n;
+    segs[s] = segs[t];  segs[t] = tmp;
+    break;
+  }
+  case 3:                                          /* Mutate the selector */
+    sel = nextRandom(&state);
+    prefixSize = FUZZ_SELECTOR_SIZE;
+    break;
+  default: {                                       /* Mutate a segment */
+    size_t cap = segs[s].marker <= M_ECS ? maxSize : MAX_PAYLOAD, len;
+    int m = segs[s].marker;
+
+    if (IS_STANDALONE(m)) {
+      /* Standalone markers have no payload, so mutate the restart marker
+         sequence instead. */
+      if (IS_RST(m)) segs[s].marker = 0xD0 + nextRandom(&state) % 8;
+      break;
+    }
+    if (segs[s].length > cap || (payload = (uint8_t *)malloc(cap)) == NULL)
+      break;
+    memcpy(payload, segs[s].data, segs[s].length);
+    len = segs[s].length;
+
+    if (IS_SOF(m) && nextRandom(&state) % 4 == 0) {
+      /* Switch between baseline, extended, progressive, lossless, and
+         arithmetic coding processes. */
+      static const int sofMarkers[] =
+        { 0xC0, 0xC1, 0xC2, 0xC3, 0xC9, 0xCA, 0xCB };
+
+      segs[s].marker = sofMarkers[nextRandom(&state) % 7];
+    } else if (IS_SOF(m) && nextRandom(&state) % 2)
+      len = mutateSOF(payload, len, &state);
+    else if (m == M_DHT && nextRandom(&state) % 2)
+      len = mutateDHT(payload, len, &state);
+    else if (m == M_DQT && nextRandom(&state) % 2)
+      len = mutateDQT(payload, len, &state);
+    else if (m == M_SOS && nextRandom(&state) % 2)
+      len = mutateSOS(payload, len, &state);
+    else if (m == M_DRI && len == 2) {
+      unsigned int interval = nextRandom(&state) % 17;
+
+      payload[0] = interval >> 8;  payload[1] = interval & 0xFF;
+    } else
+      len = mutateBytes(payload, len, cap, &state);
+
+    segs[s].data = payload;  segs[s].length = len;
+  }
+  }
+
+  if (prefixSize <= maxSize && (buf = (uint8_t *)malloc(maxSize)) != NULL &&
+      (newSize = serializeJPEG(segs, n, buf + prefixSize,
+                               maxSize - prefixSize)) > 0) {
+    if (prefixSize) {
+      buf[0] = FUZZ_SELECTOR_TAG;
+      buf[1] = (uint8_t)(sel >> 24);  buf[2] = (uint8_t)(sel >> 16);
+      buf[3] = (uint8_t)(sel >> 8);  buf[4] = (uint8_t)sel;
+    }
+    newSize += prefixSize;
+    memcpy(data, buf, newSize);
+  } else
+    newSize = mutateBytes(data, size, maxSize, &state);
+
+  free(buf);
+  free(payload);
+  return newSize;
+}
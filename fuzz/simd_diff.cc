@@ -0,0 +1,174 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* This fuzz target checks that the SIMD extensions produce the same results as
+   the C code.  It decompresses each JPEG image with and without SIMD
+   instructions and aborts if the decompressed images differ.  It then
+   compresses the decompressed image with and without SIMD instructions
+   (including the SIMD Huffman encoder) and aborts if the JPEG images differ.
+
+   Only the configurations in which the SIMD extensions are bit-exact with the
+   C code are tested: the accurate integer and fast integer DCT/IDCT
+   algorithms, full-size decompression, and the scaled IDCTs that have SIMD
+   implementations (1/2 and 1/4.)  The SIMD floating point DCT/IDCT algorithms
+   round differently than the C versions (see FLOATTEST in CMakeLists.txt), so
+   they are not tested.  The SIMD tier used for comparison (TJSIMD_BASE or
+   TJSIMD_ALL) is chosen by the selector (see fuzz_select.h), so that both the
+   base and AVX2 kernels are tested on CPUs that support AVX2. */
+
+#include <turbojpeg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "fuzz_select.h"
+
+
+#define NUMPF  4
+#define NUMSF  3
+
+
+/* Decompression or compression succeeded, possibly with warnings.  (A fatal
+   error clears any preceding warnings, so TJERR_WARNING is never reported for
+   a failed operation.) */
+#define SUCCEEDED(handle, retval) \
+  ((retval) == 0 || tjGetErrorCode(handle) == TJERR_WARNING)
+
+
+static void mismatch(const char *op, int tier, int pf, int flags,
+                     const char *detail)
+{
+  fprintf(stderr,
+          "SIMD mismatch: %s with SIMD tier %d, pixel format %d, flags 0x%x: %s\n",
+          op, tier, pf, flags, detail);
+  abort();
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  tjhandle handle = NULL, chandle = NULL;
+  unsigned char *dstBuf[2] = { NULL, NULL }, *jpegBuf[2] = { NULL, NULL };
+  unsigned long jpegSize[2] = { 0, 0 };
+  int width = 0, height = 0, jpegSubsamp, jpegColorspace, pf, w, h, tier;
+  int flags = TJFLAG_LIMITRESOURCES, subsamp, retval[2], ok[2], i;
+  unsigned int sel;
+  size_t dstSize;
+  enum TJPF pixelFormats[NUMPF] =
+    { TJPF_RGB, TJPF_BGRX, TJPF_GRAY, TJPF_CMYK };
+  /* Full-size decompression and the scaling factors that use SIMD IDCTs */
+  tjscalingfactor scalingFactors[NUMSF] = { { 1, 1 }, { 1, 2 }, { 1, 4 } };
+#if defined(__has_feature) && __has_feature(memory_sanitizer)
+  char env[18] = "JSIMD_FORCENONE=1";
+
+  /* The libjpeg-turbo SIMD extensions produce false positives with
+     MemorySanitizer.  (This makes the target a no-op, but it still checks the
+     C code for uninitialized reads.) */
+  putenv(env);
+#endif
+
+  /* Select a single configuration (SIMD tier, pixel format, flags, and
+     scaling factor). */
+  sel = fuzz_select(&data, &size);
+  if ((handle = tjInitDecompress()) == NULL ||
+      (chandle = tjInitCompress()) == NULL)
+    goto bailout;
+
+  tjDecompressHeader3(handle, data, size, &width, &height, &jpegSubsamp,
+                      &jpegColorspace);
+
+  /* Ignore 0-pixel images and images larger than 1 Megapixel. */
+  if (width < 1 || height < 1 || (uint64_t)width * height > 1048576)
+    goto bailout;
+
+  tier = (sel & 1) ? TJSIMD_BASE : TJSIMD_ALL;
+  sel >>= 1;
+  pf = pixelFormats[sel % NUMPF];
+  sel /= NUMPF;
+  if (sel & 1) flags |= TJFLAG_FASTUPSAMPLE;
+  if (sel & 2) flags |= TJFLAG_FASTDCT;
+  if (sel & 4) flags |= TJFLAG_PROGRESSIVE;
+  sel >>= 3;
+  w = TJSCALED(width, scalingFactors[sel % NUMSF]);
+  h = TJSCALED(height, scalingFactors[sel % NUMSF]);
+
+  /* Decompress the image using the C code (index 0) and the SIMD extensions
+     (index 1.)  The decompressor stops at the first error, but not at
+     warnings, so the output is complete (and comparable) in both cases.  The
+     buffers are zeroed so that the comparison is deterministic even if the
+     decompressor leaves some of the pixels unwritten. */
+  dstSize = (size_t)w * h * tjPixelSize[pf];
+  for (i = 0; i < 2; i++) {
+    if ((dstBuf[i] = (unsigned char *)calloc(dstSize, 1)) == NULL)
+      goto bailout;
+    if (tjSetSIMDTier(handle, i ? tier : TJSIMD_NONE, i) < 0)
+      goto bailout;
+    retval[i] = tjDecompress2(handle, data, size, dstBuf[i], w, 0, h, pf,
+                              flags);
+    ok[i] = SUCCEEDED(handle, retval[i]);
+  }
+  if (ok[0] != ok[1])
+    mismatch("decompression", tier, pf, flags, "return values differ");
+  if (!ok[0])
+    goto bailout;
+  if (memcmp(dstBuf[0], dstBuf[1], dstSize))
+    mismatch("decompression", tier, pf, flags, "pixels differ");
+
+  /* Compress the decompressed image using the C code and the SIMD extensions.
+     The compressor cannot generate a color JPEG image from a grayscale
+     source image. */
+  if (pf == TJPF_GRAY || jpegSubsamp < 0 || jpegSubsamp >= TJ_NUMSAMP)
+    subsamp = TJSAMP_GRAY;
+  else
+    subsamp = jpegSubsamp;
+  if (pf == TJPF_CMYK && subsamp == TJSAMP_GRAY)
+    subsamp = TJSAMP_444;
+  for (i = 0; i < 2; i++) {
+    if (tjSetSIMDTier(chandle, i ? tier : TJSIMD_NONE, i) < 0)
+      goto bailout;
+    retval[i] = tjCompress2(chandle, dstBuf[0], w, 0, h, pf, &jpegBuf[i],
+                            &jpegSize[i], subsamp, 90, flags);
+    ok[i] = SUCCEEDED(chandle, retval[i]);
+  }
+  if (ok[0] != ok[1])
+    mismatch("compression", tier, pf, flags, "return values differ");
+  if (!ok[0])
+    goto bailout;
+  if (jpegSize[0] != jpegSize[1] ||
+      memcmp(jpegBuf[0], jpegBuf[1], jpegSize[0]))
+    mismatch("compression", tier, pf, flags, "JPEG images differ");
+
+bailout:
+  for (i = 0; i < 2; i++) {
+    free(dstBuf[i]);
+    tjFree(jpegBuf[i]);
+  }
+  if (chandle) tjDestroy(chandle);
+  if (handle) tjDestroy(handle);
+  return 0;
+}
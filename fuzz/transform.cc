@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include "fuzz_select.h"
 
 
 #define NUMXFORMS  3
@@ -50,6 +51,10 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   putenv(env);
 #endif
 
+  /* This target performs every transform on each input, so it ignores the
+     selector.  (The custom mutator may add one, since it is shared with the
+     targets that do not.) */
+  fuzz_select(&data, &size);
   if ((handle = tjInitTransform()) == NULL)
     goto bailout;
 
@@ -95,7 +100,7 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   maxBufSize = tjBufSize(width, height, jpegSubsamp);
 
   if (tjTransform(handle, data, size, NUMXFORMS, dstBufs, dstSizes, transforms,
-                  TJFLAG_LIMITSCANS | TJFLAG_NOREALLOC) == 0) {
+                  TJFLAG_LIMITRESOURCES | TJFLAG_NOREALLOC) == 0) {
     /* Touch all of the output pixels in order to catch uninitialized reads
        when using MemorySanitizer. */
     for (t = 0; t < NUMXFORMS; t++) {
@@ -117,7 +122,7 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
   dstSizes[0] = 0;
 
   if (tjTransform(handle, data, size, 1, dstBufs, dstSizes, transforms,
-                  TJFLAG_LIMITSCANS) == 0) {
+                  TJFLAG_LIMITRESOURCES) == 0) {
     int sum = 0;
 
     for (i = 0; i < dstSizes[0]; i++)
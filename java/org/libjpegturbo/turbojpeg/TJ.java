@@ -448,12 +448,20 @@ public final class TJ {
    * <a href="https://libjpeg-turbo.org/pmwiki/uploads/About/TwoIssueswiththeJPEGStandard.pdf" target="_blank">this report</a>.
    */
   public static final int FLAG_LIMITSCANS    = 32768;
+  /**
+   * Limit the resources that the decompression and transform operations will
+   * consume.  When this flag is specified, the default TurboJPEG resource
+   * limits (500 scans and 100 passes' worth of entropy decoding work) are
+   * enforced, and the decompression and transform operations throw an error
+   * with error code {@link #ERR_LIMIT} if a JPEG image exceeds them.
+   */
+  public static final int FLAG_LIMITRESOURCES = 131072;
 
 
   /**
    * The number of error codes
    */
-  public static final int NUMERR = 2;
+  public static final int NUMERR = 3;
   /**
    * The error was non-fatal and recoverable, but the image may still be
    * corrupt.
@@ -468,6 +476,11 @@ public final class TJ {
    * The error was fatal and non-recoverable.
    */
   public static final int ERR_FATAL = 1;
+  /**
+   * The error was fatal, because the JPEG image exceeded one of the resource
+   * limits enabled by {@link #FLAG_LIMITRESOURCES}.
+   */
+  public static final int ERR_LIMIT = 2;
 
 
   /**
@@ -81,12 +81,16 @@ extern "C" {
 #define org_libjpegturbo_turbojpeg_TJ_FLAG_PROGRESSIVE 16384L
 #undef org_libjpegturbo_turbojpeg_TJ_FLAG_LIMITSCANS
 #define org_libjpegturbo_turbojpeg_TJ_FLAG_LIMITSCANS 32768L
+#undef org_libjpegturbo_turbojpeg_TJ_FLAG_LIMITRESOURCES
+#define org_libjpegturbo_turbojpeg_TJ_FLAG_LIMITRESOURCES 131072L
 #undef org_libjpegturbo_turbojpeg_TJ_NUMERR
-#define org_libjpegturbo_turbojpeg_TJ_NUMERR 2L
+#define org_libjpegturbo_turbojpeg_TJ_NUMERR 3L
 #undef org_libjpegturbo_turbojpeg_TJ_ERR_WARNING
 #define org_libjpegturbo_turbojpeg_TJ_ERR_WARNING 0L
 #undef org_libjpegturbo_turbojpeg_TJ_ERR_FATAL
 #define org_libjpegturbo_turbojpeg_TJ_ERR_FATAL 1L
+#undef org_libjpegturbo_turbojpeg_TJ_ERR_LIMIT
+#define org_libjpegturbo_turbojpeg_TJ_ERR_LIMIT 2L
 /*
  * Class:     org_libjpegturbo_turbojpeg_TJ
  * Method:    bufSize
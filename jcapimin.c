@@ -23,6 +23,8 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jcmaster.h"
+#include "jstages.h"
 
 
 /*
@@ -92,6 +94,15 @@ jpeg_CreateCompress(j_compress_ptr cinfo, int version, size_t structsize)
 
   /* OK, I'm ready */
   cinfo->global_state = CSTATE_START;
+
+  /* The master struct is used to store extension parameters, so we allocate it
+   * here.
+   */
+  cinfo->master = (struct jpeg_comp_master *)
+    (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_PERMANENT,
+                                sizeof(my_comp_master));
+  memset(cinfo->master, 0, sizeof(my_comp_master));
+  jsimd_init_table(&cinfo->master->simd, JSIMD_TIER_ALL, TRUE);
 }
 
 
@@ -189,8 +200,12 @@ jpeg_finish_compress(j_compress_ptr cinfo)
     (*cinfo->master->finish_pass) (cinfo);
   }
   /* Write EOI, do final cleanup */
+  JSTAGE_BEGIN(cinfo->master->stage_timer, JSTAGE_MARKERS);
   (*cinfo->marker->write_file_trailer) (cinfo);
+  JSTAGE_END(cinfo->master->stage_timer);
+  JSTAGE_BEGIN(cinfo->master->stage_timer, JSTAGE_IO);
   (*cinfo->dest->term_destination) (cinfo);
+  JSTAGE_END(cinfo->master->stage_timer);
   /* We can use jpeg_abort to release memory and reset global_state */
   jpeg_abort((j_common_ptr)cinfo);
 }
@@ -22,6 +22,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jstages.h"
 
 
 /* Expanded entropy encoder object for arithmetic encoding. */
@@ -126,7 +127,7 @@ emit_byte(int val, j_compress_ptr cinfo)
 
   *dest->next_output_byte++ = (JOCTET)val;
   if (--dest->free_in_buffer == 0)
-    if (!(*dest->empty_output_buffer) (cinfo))
+    if (!jstage_empty_output_buffer(cinfo))
       ERREXIT(cinfo, JERR_CANT_SUSPEND);
 }
 
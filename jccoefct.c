@@ -16,6 +16,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jstages.h"
 
 
 /* We use a full-image coefficient buffer when doing Huffman optimization,
@@ -147,6 +148,8 @@ compress_data(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
   int blkn, bi, ci, yindex, yoffset, blockcnt;
   JDIMENSION ypos, xpos;
   jpeg_component_info *compptr;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
+  boolean encoded;
 
   /* Loop to write as much as one whole iMCU row */
   for (yoffset = coef->MCU_vert_offset; yoffset < coef->MCU_rows_per_iMCU_row;
@@ -162,6 +165,7 @@ compress_data(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
        * data, viz: all zeroes in the AC entries, DC entries equal to previous
        * block's DC value.  (Thanks to Thomas Kinsman for this idea.)
        */
+      JSTAGE_BEGIN(timer, JSTAGE_DCT);
       blkn = 0;
       for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
         compptr = cinfo->cur_comp_info[ci];
@@ -198,10 +202,14 @@ compress_data(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
           ypos += DCTSIZE;
         }
       }
+      JSTAGE_END(timer);
       /* Try to write the MCU.  In event of a suspension failure, we will
        * re-DCT the MCU on restart (a bit inefficient, could be fixed...)
        */
-      if (!(*cinfo->entropy->encode_mcu) (cinfo, coef->MCU_buffer)) {
+      JSTAGE_BEGIN(timer, JSTAGE_ENTROPY);
+      encoded = (*cinfo->entropy->encode_mcu) (cinfo, coef->MCU_buffer);
+      JSTAGE_END(timer);
+      if (!encoded) {
         /* Suspension forced; update state counters and exit */
         coef->MCU_vert_offset = yoffset;
         coef->mcu_ctr = MCU_col_num;
@@ -252,6 +260,7 @@ compress_first_pass(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
   jpeg_component_info *compptr;
   JBLOCKARRAY buffer;
   JBLOCKROW thisblockrow, lastblockrow;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
 
   for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
        ci++, compptr++) {
@@ -279,10 +288,12 @@ compress_first_pass(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
      */
     for (block_row = 0; block_row < block_rows; block_row++) {
       thisblockrow = buffer[block_row];
+      JSTAGE_BEGIN(timer, JSTAGE_DCT);
       (*cinfo->fdct->forward_DCT) (cinfo, compptr,
                                    input_buf[ci], thisblockrow,
                                    (JDIMENSION)(block_row * DCTSIZE),
                                    (JDIMENSION)0, blocks_across);
+      JSTAGE_END(timer);
       if (ndummy > 0) {
         /* Create dummy blocks at the right edge of the image. */
         thisblockrow += blocks_across; /* => first dummy block */
@@ -347,6 +358,8 @@ compress_output(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
   JBLOCKARRAY buffer[MAX_COMPS_IN_SCAN];
   JBLOCKROW buffer_ptr;
   jpeg_component_info *compptr;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
+  boolean encoded;
 
   /* Align the virtual buffers for the components used in this scan.
    * NB: during first pass, this is safe only because the buffers will
@@ -378,7 +391,10 @@ compress_output(j_compress_ptr cinfo, JSAMPIMAGE input_buf)
         }
       }
       /* Try to write the MCU. */
-      if (!(*cinfo->entropy->encode_mcu) (cinfo, coef->MCU_buffer)) {
+      JSTAGE_BEGIN(timer, JSTAGE_ENTROPY);
+      encoded = (*cinfo->entropy->encode_mcu) (cinfo, coef->MCU_buffer);
+      JSTAGE_END(timer);
+      if (!encoded) {
         /* Suspension forced; update state counters and exit */
         coef->MCU_vert_offset = yoffset;
         coef->mcu_ctr = MCU_col_num;
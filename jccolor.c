@@ -26,6 +26,9 @@ typedef struct {
 
   /* Private state for RGB->YCC conversion */
   JLONG *rgb_ycc_tab;           /* => table for RGB to YCbCr conversion */
+
+  /* SIMD kernel for the input pixel format, if simd_convert is in use */
+  jsimd_rgb_convert_ptr simd_kernel;
 } my_color_converter;
 
 typedef my_color_converter *my_cconvert_ptr;
@@ -507,6 +510,22 @@ null_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf, JSAMPIMAGE output_buf,
 }
 
 
+/*
+ * Convert some rows of samples to the JPEG colorspace using the SIMD kernel
+ * that jinit_color_converter() selected for the input pixel format.
+ */
+
+METHODDEF(void)
+simd_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf, JSAMPIMAGE output_buf,
+             JDIMENSION output_row, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr)cinfo->cconvert;
+
+  (*cconvert->simd_kernel) (cinfo->image_width, input_buf, output_buf,
+                            output_row, num_rows);
+}
+
+
 /*
  * Empty method for start_pass.
  */
@@ -591,8 +610,10 @@ jinit_color_converter(j_compress_ptr cinfo)
              cinfo->in_color_space == JCS_EXT_BGRA ||
              cinfo->in_color_space == JCS_EXT_ABGR ||
              cinfo->in_color_space == JCS_EXT_ARGB) {
-      if (jsimd_can_rgb_gray())
-        cconvert->pub.color_convert = jsimd_rgb_gray_convert;
+      cconvert->simd_kernel =
+        cinfo->master->simd.rgb_gray[cinfo->in_color_space];
+      if (cconvert->simd_kernel)
+        cconvert->pub.color_convert = simd_convert;
       else {
         cconvert->pub.start_pass = rgb_ycc_start;
         cconvert->pub.color_convert = rgb_gray_convert;
@@ -611,8 +632,8 @@ jinit_color_converter(j_compress_ptr cinfo)
         rgb_blue[cinfo->in_color_space] == 2 &&
         rgb_pixelsize[cinfo->in_color_space] == 3) {
 #if defined(__mips__)
-      if (jsimd_c_can_null_convert())
-        cconvert->pub.color_convert = jsimd_c_null_convert;
+      if (cinfo->master->simd.c_null_convert)
+        cconvert->pub.color_convert = cinfo->master->simd.c_null_convert;
       else
 #endif
         cconvert->pub.color_convert = null_convert;
@@ -646,16 +667,18 @@ jinit_color_converter(j_compress_ptr cinfo)
         cinfo->in_color_space == JCS_EXT_BGRA ||
         cinfo->in_color_space == JCS_EXT_ABGR ||
         cinfo->in_color_space == JCS_EXT_ARGB) {
-      if (jsimd_can_rgb_ycc())
-        cconvert->pub.color_convert = jsimd_rgb_ycc_convert;
+      cconvert->simd_kernel =
+        cinfo->master->simd.rgb_ycc[cinfo->in_color_space];
+      if (cconvert->simd_kernel)
+        cconvert->pub.color_convert = simd_convert;
       else {
         cconvert->pub.start_pass = rgb_ycc_start;
         cconvert->pub.color_convert = rgb_ycc_convert;
       }
     } else if (cinfo->in_color_space == JCS_YCbCr) {
 #if defined(__mips__)
-      if (jsimd_c_can_null_convert())
-        cconvert->pub.color_convert = jsimd_c_null_convert;
+      if (cinfo->master->simd.c_null_convert)
+        cconvert->pub.color_convert = cinfo->master->simd.c_null_convert;
       else
 #endif
         cconvert->pub.color_convert = null_convert;
@@ -668,8 +691,8 @@ jinit_color_converter(j_compress_ptr cinfo)
       ERREXIT(cinfo, JERR_BAD_J_COLORSPACE);
     if (cinfo->in_color_space == JCS_CMYK) {
 #if defined(__mips__)
-      if (jsimd_c_can_null_convert())
-        cconvert->pub.color_convert = jsimd_c_null_convert;
+      if (cinfo->master->simd.c_null_convert)
+        cconvert->pub.color_convert = cinfo->master->simd.c_null_convert;
       else
 #endif
         cconvert->pub.color_convert = null_convert;
@@ -685,8 +708,8 @@ jinit_color_converter(j_compress_ptr cinfo)
       cconvert->pub.color_convert = cmyk_ycck_convert;
     } else if (cinfo->in_color_space == JCS_YCCK) {
 #if defined(__mips__)
-      if (jsimd_c_can_null_convert())
-        cconvert->pub.color_convert = jsimd_c_null_convert;
+      if (cinfo->master->simd.c_null_convert)
+        cconvert->pub.color_convert = cinfo->master->simd.c_null_convert;
       else
 #endif
         cconvert->pub.color_convert = null_convert;
@@ -699,8 +722,8 @@ jinit_color_converter(j_compress_ptr cinfo)
         cinfo->num_components != cinfo->input_components)
       ERREXIT(cinfo, JERR_CONVERSION_NOTIMPL);
 #if defined(__mips__)
-    if (jsimd_c_can_null_convert())
-      cconvert->pub.color_convert = jsimd_c_null_convert;
+    if (cinfo->master->simd.c_null_convert)
+      cconvert->pub.color_convert = cinfo->master->simd.c_null_convert;
     else
 #endif
       cconvert->pub.color_convert = null_convert;
@@ -20,7 +20,6 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jdct.h"               /* Private declarations for DCT subsystem */
-#include "jsimddct.h"
 
 
 /* Private subobject for this module */
@@ -266,7 +265,7 @@ start_pass_fdctmgr(j_compress_ptr cinfo)
       for (i = 0; i < DCTSIZE2; i++) {
 #if BITS_IN_JSAMPLE == 8
         if (!compute_reciprocal(qtbl->quantval[i] << 3, &dtbl[i]) &&
-            fdct->quantize == jsimd_quantize)
+            fdct->quantize != quantize)
           fdct->quantize = quantize;
 #else
         dtbl[i] = ((DCTELEM)qtbl->quantval[i]) << 3;
@@ -309,7 +308,7 @@ start_pass_fdctmgr(j_compress_ptr cinfo)
                 DESCALE(MULTIPLY16V16((JLONG)qtbl->quantval[i],
                                       (JLONG)aanscales[i]),
                         CONST_BITS - 3), &dtbl[i]) &&
-              fdct->quantize == jsimd_quantize)
+              fdct->quantize != quantize)
             fdct->quantize = quantize;
 #else
           dtbl[i] = (DCTELEM)
@@ -633,8 +632,8 @@ jinit_forward_dct(j_compress_ptr cinfo)
 #ifdef DCT_ISLOW_SUPPORTED
   case JDCT_ISLOW:
     fdct->pub.forward_DCT = forward_DCT;
-    if (jsimd_can_fdct_islow())
-      fdct->dct = jsimd_fdct_islow;
+    if (cinfo->master->simd.fdct_islow)
+      fdct->dct = (forward_DCT_method_ptr)cinfo->master->simd.fdct_islow;
     else
       fdct->dct = jpeg_fdct_islow;
     break;
@@ -642,8 +641,8 @@ jinit_forward_dct(j_compress_ptr cinfo)
 #ifdef DCT_IFAST_SUPPORTED
   case JDCT_IFAST:
     fdct->pub.forward_DCT = forward_DCT;
-    if (jsimd_can_fdct_ifast())
-      fdct->dct = jsimd_fdct_ifast;
+    if (cinfo->master->simd.fdct_ifast)
+      fdct->dct = (forward_DCT_method_ptr)cinfo->master->simd.fdct_ifast;
     else
       fdct->dct = jpeg_fdct_ifast;
     break;
@@ -651,8 +650,8 @@ jinit_forward_dct(j_compress_ptr cinfo)
 #ifdef DCT_FLOAT_SUPPORTED
   case JDCT_FLOAT:
     fdct->pub.forward_DCT = forward_DCT_float;
-    if (jsimd_can_fdct_float())
-      fdct->float_dct = jsimd_fdct_float;
+    if (cinfo->master->simd.fdct_float)
+      fdct->float_dct = (float_DCT_method_ptr)cinfo->master->simd.fdct_float;
     else
       fdct->float_dct = jpeg_fdct_float;
     break;
@@ -671,24 +670,26 @@ jinit_forward_dct(j_compress_ptr cinfo)
   case JDCT_IFAST:
 #endif
 #if defined(DCT_ISLOW_SUPPORTED) || defined(DCT_IFAST_SUPPORTED)
-    if (jsimd_can_convsamp())
-      fdct->convsamp = jsimd_convsamp;
+    if (cinfo->master->simd.convsamp)
+      fdct->convsamp = (convsamp_method_ptr)cinfo->master->simd.convsamp;
     else
       fdct->convsamp = convsamp;
-    if (jsimd_can_quantize())
-      fdct->quantize = jsimd_quantize;
+    if (cinfo->master->simd.quantize)
+      fdct->quantize = (quantize_method_ptr)cinfo->master->simd.quantize;
     else
       fdct->quantize = quantize;
     break;
 #endif
 #ifdef DCT_FLOAT_SUPPORTED
   case JDCT_FLOAT:
-    if (jsimd_can_convsamp_float())
-      fdct->float_convsamp = jsimd_convsamp_float;
+    if (cinfo->master->simd.convsamp_float)
+      fdct->float_convsamp =
+        (float_convsamp_method_ptr)cinfo->master->simd.convsamp_float;
     else
       fdct->float_convsamp = convsamp_float;
-    if (jsimd_can_quantize_float())
-      fdct->float_quantize = jsimd_quantize_float;
+    if (cinfo->master->simd.quantize_float)
+      fdct->float_quantize =
+        (float_quantize_method_ptr)cinfo->master->simd.quantize_float;
     else
       fdct->float_quantize = quantize_float;
     break;
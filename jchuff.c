@@ -27,6 +27,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jsimd.h"
+#include "jstages.h"
 #include <limits.h>
 
 /*
@@ -108,6 +109,12 @@ typedef struct {
   int last_dc_val[MAX_COMPS_IN_SCAN];   /* last DC coef for each component */
 } savable_state;
 
+/* SIMD implementation of encode_one_block() (see jsimd_init_table()) */
+typedef JOCTET *(*simd_encode_one_block_ptr) (void *state, JOCTET *buffer,
+                                              JCOEFPTR block, int last_dc_val,
+                                              c_derived_tbl *dctbl,
+                                              c_derived_tbl *actbl);
+
 typedef struct {
   struct jpeg_entropy_encoder pub; /* public fields */
 
@@ -126,7 +133,7 @@ typedef struct {
   long *ac_count_ptrs[NUM_HUFF_TBLS];
 #endif
 
-  int simd;
+  simd_encode_one_block_ptr simd; /* SIMD kernel, or NULL if not in use */
 } huff_entropy_encoder;
 
 typedef huff_entropy_encoder *huff_entropy_ptr;
@@ -179,7 +186,8 @@ start_pass_huff(j_compress_ptr cinfo, boolean gather_statistics)
     entropy->pub.finish_pass = finish_pass_huff;
   }
 
-  entropy->simd = jsimd_can_huff_encode_one_block();
+  entropy->simd =
+    (simd_encode_one_block_ptr)cinfo->master->simd.huff_encode_one_block;
 
   for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
     compptr = cinfo->cur_comp_info[ci];
@@ -351,7 +359,7 @@ dump_buffer(working_state *state)
 {
   struct jpeg_destination_mgr *dest = state->cinfo->dest;
 
-  if (!(*dest->empty_output_buffer) (state->cinfo))
+  if (!jstage_empty_output_buffer(state->cinfo))
     return FALSE;
   /* After a successful buffer dump, must reset buffer pointers */
   state->next_output_byte = dest->next_output_byte;
@@ -547,13 +555,13 @@ LOCAL(boolean)
 encode_one_block_simd(working_state *state, JCOEFPTR block, int last_dc_val,
                       c_derived_tbl *dctbl, c_derived_tbl *actbl)
 {
+  huff_entropy_ptr entropy = (huff_entropy_ptr)state->cinfo->entropy;
   JOCTET _buffer[BUFSIZE], *buffer;
   int localbuf = 0;
 
   LOAD_BUFFER()
 
-  buffer = jsimd_huff_encode_one_block(state, buffer, block, last_dc_val,
-                                       dctbl, actbl);
+  buffer = (*entropy->simd) (state, buffer, block, last_dc_val, dctbl, actbl);
 
   STORE_BUFFER()
 
@@ -694,7 +702,7 @@ encode_mcu_huff(j_compress_ptr cinfo, JBLOCKROW *MCU_data)
   state.free_in_buffer = cinfo->dest->free_in_buffer;
   state.cur = entropy->saved;
   state.cinfo = cinfo;
-  state.simd = entropy->simd;
+  state.simd = (entropy->simd != NULL);
 
   /* Emit restart marker if needed */
   if (cinfo->restart_interval) {
@@ -764,7 +772,7 @@ finish_pass_huff(j_compress_ptr cinfo)
   state.free_in_buffer = cinfo->dest->free_in_buffer;
   state.cur = entropy->saved;
   state.cinfo = cinfo;
-  state.simd = entropy->simd;
+  state.simd = (entropy->simd != NULL);
 
   /* Flush out the last data */
   if (!flush_bits(&state))
@@ -22,6 +22,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jpegcomp.h"
+#include "jstages.h"
 
 
 /*
@@ -76,5 +77,7 @@ jinit_compress_master(j_compress_ptr cinfo)
    * Frame and scan headers are postponed till later.
    * This lets application insert special markers after the SOI.
    */
+  JSTAGE_BEGIN(cinfo->master->stage_timer, JSTAGE_MARKERS);
   (*cinfo->marker->write_file_header) (cinfo);
+  JSTAGE_END(cinfo->master->stage_timer);
 }
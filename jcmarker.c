@@ -16,6 +16,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jpegcomp.h"
+#include "jstages.h"
 
 
 typedef enum {                  /* JPEG marker codes */
@@ -117,7 +118,7 @@ emit_byte(j_compress_ptr cinfo, int val)
 
   *(dest->next_output_byte)++ = (JOCTET)val;
   if (--dest->free_in_buffer == 0) {
-    if (!(*dest->empty_output_buffer) (cinfo))
+    if (!jstage_empty_output_buffer(cinfo))
       ERREXIT(cinfo, JERR_CANT_SUSPEND);
   }
 }
@@ -19,38 +19,8 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jpegcomp.h"
-
-
-/* Private state */
-
-typedef enum {
-  main_pass,                    /* input data, also do first output step */
-  huff_opt_pass,                /* Huffman code optimization pass */
-  output_pass                   /* data output pass */
-} c_pass_type;
-
-typedef struct {
-  struct jpeg_comp_master pub;  /* public fields */
-
-  c_pass_type pass_type;        /* the type of the current pass */
-
-  int pass_number;              /* # of passes completed */
-  int total_passes;             /* total # of passes needed */
-
-  int scan_number;              /* current index in scan_info[] */
-
-  /*
-   * This is here so we can add libjpeg-turbo version/build information to the
-   * global string table without introducing a new global symbol.  Adding this
-   * information to the global string table allows one to examine a binary
-   * object and determine which version of libjpeg-turbo it was built from or
-   * linked against.
-   */
-  const char *jpeg_version;
-
-} my_comp_master;
-
-typedef my_comp_master *my_master_ptr;
+#include "jcmaster.h"
+#include "jstages.h"
 
 
 /*
@@ -503,9 +473,11 @@ prepare_for_pass(j_compress_ptr cinfo)
     (*cinfo->entropy->start_pass) (cinfo, FALSE);
     (*cinfo->coef->start_pass) (cinfo, JBUF_CRANK_DEST);
     /* We emit frame/scan headers now */
+    JSTAGE_BEGIN(master->pub.stage_timer, JSTAGE_MARKERS);
     if (master->scan_number == 0)
       (*cinfo->marker->write_frame_header) (cinfo);
     (*cinfo->marker->write_scan_header) (cinfo);
+    JSTAGE_END(master->pub.stage_timer);
     master->pub.call_pass_startup = FALSE;
     break;
   default:
@@ -537,8 +509,10 @@ pass_startup(j_compress_ptr cinfo)
 {
   cinfo->master->call_pass_startup = FALSE; /* reset flag so call only once */
 
+  JSTAGE_BEGIN(cinfo->master->stage_timer, JSTAGE_MARKERS);
   (*cinfo->marker->write_frame_header) (cinfo);
   (*cinfo->marker->write_scan_header) (cinfo);
+  JSTAGE_END(cinfo->master->stage_timer);
 }
 
 
@@ -554,7 +528,9 @@ finish_pass_master(j_compress_ptr cinfo)
   /* The entropy coder always needs an end-of-pass call,
    * either to analyze statistics or to flush its output buffer.
    */
+  JSTAGE_BEGIN(master->pub.stage_timer, JSTAGE_ENTROPY);
   (*cinfo->entropy->finish_pass) (cinfo);
+  JSTAGE_END(master->pub.stage_timer);
 
   /* Update state for next pass */
   switch (master->pass_type) {
@@ -589,12 +565,8 @@ finish_pass_master(j_compress_ptr cinfo)
 GLOBAL(void)
 jinit_c_master_control(j_compress_ptr cinfo, boolean transcode_only)
 {
-  my_master_ptr master;
+  my_master_ptr master = (my_master_ptr)cinfo->master;
 
-  master = (my_master_ptr)
-    (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
-                                sizeof(my_comp_master));
-  cinfo->master = (struct jpeg_comp_master *)master;
   master->pub.prepare_for_pass = prepare_for_pass;
   master->pub.pass_startup = pass_startup;
   master->pub.finish_pass = finish_pass_master;
@@ -107,3 +107,33 @@ jpeg_alloc_huff_table(j_common_ptr cinfo)
   tbl->sent_table = FALSE;      /* make sure this is false in any new table */
   return tbl;
 }
+
+
+/*
+ * Restrict the SIMD instruction sets that a compression or decompression
+ * object can use.  This rebuilds the object's SIMD kernel table, which the
+ * modules consult when they select their methods, so it must be called before
+ * compression or decompression starts.  Out-of-range tiers are clamped to
+ * the nearest valid tier.
+ */
+
+GLOBAL(void)
+jpeg_set_simd_tier(j_common_ptr cinfo, int tier, boolean huffman)
+{
+  if (tier < JSIMD_TIER_NONE)
+    tier = JSIMD_TIER_NONE;
+  if (tier > JSIMD_TIER_ALL)
+    tier = JSIMD_TIER_ALL;
+
+  if (cinfo->is_decompressor) {
+    if (cinfo->global_state < DSTATE_START ||
+        cinfo->global_state > DSTATE_READY)
+      ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+    jsimd_init_table(&((j_decompress_ptr)cinfo)->master->simd, tier,
+                     huffman);
+  } else {
+    if (cinfo->global_state != CSTATE_START)
+      ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+    jsimd_init_table(&((j_compress_ptr)cinfo)->master->simd, tier, huffman);
+  }
+}
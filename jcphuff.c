@@ -22,6 +22,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jsimd.h"
+#include "jstages.h"
 #include <limits.h>
 
 #ifdef HAVE_INTRIN_H
@@ -223,8 +224,9 @@ start_pass_phuff(j_compress_ptr cinfo, boolean gather_statistics)
       entropy->pub.encode_mcu = encode_mcu_DC_first;
     else
       entropy->pub.encode_mcu = encode_mcu_AC_first;
-    if (jsimd_can_encode_mcu_AC_first_prepare())
-      entropy->AC_first_prepare = jsimd_encode_mcu_AC_first_prepare;
+    if (cinfo->master->simd.encode_mcu_AC_first_prepare)
+      entropy->AC_first_prepare =
+        cinfo->master->simd.encode_mcu_AC_first_prepare;
     else
       entropy->AC_first_prepare = encode_mcu_AC_first_prepare;
   } else {
@@ -232,8 +234,9 @@ start_pass_phuff(j_compress_ptr cinfo, boolean gather_statistics)
       entropy->pub.encode_mcu = encode_mcu_DC_refine;
     else {
       entropy->pub.encode_mcu = encode_mcu_AC_refine;
-      if (jsimd_can_encode_mcu_AC_refine_prepare())
-        entropy->AC_refine_prepare = jsimd_encode_mcu_AC_refine_prepare;
+      if (cinfo->master->simd.encode_mcu_AC_refine_prepare)
+        entropy->AC_refine_prepare =
+          cinfo->master->simd.encode_mcu_AC_refine_prepare;
       else
         entropy->AC_refine_prepare = encode_mcu_AC_refine_prepare;
       /* AC refinement needs a correction bit buffer */
@@ -316,7 +319,7 @@ dump_buffer(phuff_entropy_ptr entropy)
 {
   struct jpeg_destination_mgr *dest = entropy->cinfo->dest;
 
-  if (!(*dest->empty_output_buffer) (entropy->cinfo))
+  if (!jstage_empty_output_buffer(entropy->cinfo))
     ERREXIT(entropy->cinfo, JERR_CANT_SUSPEND);
   /* After a successful buffer dump, must reset buffer pointers */
   entropy->next_output_byte = dest->next_output_byte;
@@ -20,6 +20,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jstages.h"
 
 
 /* At present, jcsample.c can request context rows only for smoothing.
@@ -137,6 +138,7 @@ pre_process_data(j_compress_ptr cinfo, JSAMPARRAY input_buf,
   int numrows, ci;
   JDIMENSION inrows;
   jpeg_component_info *compptr;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
 
   while (*in_row_ctr < in_rows_avail &&
          *out_row_group_ctr < out_row_groups_avail) {
@@ -144,10 +146,12 @@ pre_process_data(j_compress_ptr cinfo, JSAMPARRAY input_buf,
     inrows = in_rows_avail - *in_row_ctr;
     numrows = cinfo->max_v_samp_factor - prep->next_buf_row;
     numrows = (int)MIN((JDIMENSION)numrows, inrows);
+    JSTAGE_BEGIN(timer, JSTAGE_COLOR);
     (*cinfo->cconvert->color_convert) (cinfo, input_buf + *in_row_ctr,
                                        prep->color_buf,
                                        (JDIMENSION)prep->next_buf_row,
                                        numrows);
+    JSTAGE_END(timer);
     *in_row_ctr += numrows;
     prep->next_buf_row += numrows;
     prep->rows_to_go -= numrows;
@@ -162,9 +166,11 @@ pre_process_data(j_compress_ptr cinfo, JSAMPARRAY input_buf,
     }
     /* If we've filled the conversion buffer, empty it. */
     if (prep->next_buf_row == cinfo->max_v_samp_factor) {
+      JSTAGE_BEGIN(timer, JSTAGE_SAMPLE);
       (*cinfo->downsample->downsample) (cinfo,
                                         prep->color_buf, (JDIMENSION)0,
                                         output_buf, *out_row_group_ctr);
+      JSTAGE_END(timer);
       prep->next_buf_row = 0;
       (*out_row_group_ctr)++;
     }
@@ -201,6 +207,7 @@ pre_process_context(j_compress_ptr cinfo, JSAMPARRAY input_buf,
   int numrows, ci;
   int buf_height = cinfo->max_v_samp_factor * 3;
   JDIMENSION inrows;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
 
   while (*out_row_group_ctr < out_row_groups_avail) {
     if (*in_row_ctr < in_rows_avail) {
@@ -208,10 +215,12 @@ pre_process_context(j_compress_ptr cinfo, JSAMPARRAY input_buf,
       inrows = in_rows_avail - *in_row_ctr;
       numrows = prep->next_buf_stop - prep->next_buf_row;
       numrows = (int)MIN((JDIMENSION)numrows, inrows);
+      JSTAGE_BEGIN(timer, JSTAGE_COLOR);
       (*cinfo->cconvert->color_convert) (cinfo, input_buf + *in_row_ctr,
                                          prep->color_buf,
                                          (JDIMENSION)prep->next_buf_row,
                                          numrows);
+      JSTAGE_END(timer);
       /* Pad at top of image, if first time through */
       if (prep->rows_to_go == cinfo->image_height) {
         for (ci = 0; ci < cinfo->num_components; ci++) {
@@ -240,9 +249,11 @@ pre_process_context(j_compress_ptr cinfo, JSAMPARRAY input_buf,
     }
     /* If we've gotten enough data, downsample a row group. */
     if (prep->next_buf_row == prep->next_buf_stop) {
+      JSTAGE_BEGIN(timer, JSTAGE_SAMPLE);
       (*cinfo->downsample->downsample) (cinfo, prep->color_buf,
                                         (JDIMENSION)prep->this_row_group,
                                         output_buf, *out_row_group_ctr);
+      JSTAGE_END(timer);
       (*out_row_group_ctr)++;
       /* Advance pointers with wraparound as necessary. */
       prep->this_row_group += cinfo->max_v_samp_factor;
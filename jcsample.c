@@ -53,27 +53,10 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jcsample.h"
 #include "jsimd.h"
 
 
-/* Pointer to routine to downsample a single component */
-typedef void (*downsample1_ptr) (j_compress_ptr cinfo,
-                                 jpeg_component_info *compptr,
-                                 JSAMPARRAY input_data,
-                                 JSAMPARRAY output_data);
-
-/* Private subobject */
-
-typedef struct {
-  struct jpeg_downsampler pub;  /* public fields */
-
-  /* Downsampling method pointers, one per component */
-  downsample1_ptr methods[MAX_COMPONENTS];
-} my_downsampler;
-
-typedef my_downsampler *my_downsample_ptr;
-
-
 /*
  * Initialize for a downsampling pass.
  */
@@ -484,8 +467,8 @@ jinit_downsampler(j_compress_ptr cinfo)
     } else if (compptr->h_samp_factor * 2 == cinfo->max_h_samp_factor &&
                compptr->v_samp_factor == cinfo->max_v_samp_factor) {
       smoothok = FALSE;
-      if (jsimd_can_h2v1_downsample())
-        downsample->methods[ci] = jsimd_h2v1_downsample;
+      if (cinfo->master->simd.h2v1_downsample)
+        downsample->methods[ci] = cinfo->master->simd.h2v1_downsample;
       else
         downsample->methods[ci] = h2v1_downsample;
     } else if (compptr->h_samp_factor * 2 == cinfo->max_h_samp_factor &&
@@ -493,8 +476,8 @@ jinit_downsampler(j_compress_ptr cinfo)
 #ifdef INPUT_SMOOTHING_SUPPORTED
       if (cinfo->smoothing_factor) {
 #if defined(__mips__)
-        if (jsimd_can_h2v2_smooth_downsample())
-          downsample->methods[ci] = jsimd_h2v2_smooth_downsample;
+        if (cinfo->master->simd.h2v2_smooth_downsample)
+          downsample->methods[ci] = cinfo->master->simd.h2v2_smooth_downsample;
         else
 #endif
           downsample->methods[ci] = h2v2_smooth_downsample;
@@ -502,8 +485,8 @@ jinit_downsampler(j_compress_ptr cinfo)
       } else
 #endif
       {
-        if (jsimd_can_h2v2_downsample())
-          downsample->methods[ci] = jsimd_h2v2_downsample;
+        if (cinfo->master->simd.h2v2_downsample)
+          downsample->methods[ci] = cinfo->master->simd.h2v2_downsample;
         else
           downsample->methods[ci] = h2v2_downsample;
       }
@@ -18,6 +18,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jpegcomp.h"
+#include "jstages.h"
 
 
 /* Forward declarations */
@@ -204,7 +205,9 @@ transencode_master_selection(j_compress_ptr cinfo,
    * Frame and scan headers are postponed till later.
    * This lets application insert special markers after the SOI.
    */
+  JSTAGE_BEGIN(cinfo->master->stage_timer, JSTAGE_MARKERS);
   (*cinfo->marker->write_file_header) (cinfo);
+  JSTAGE_END(cinfo->master->stage_timer);
 }
 
 
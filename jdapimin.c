@@ -92,6 +92,7 @@ jpeg_CreateDecompress(j_decompress_ptr cinfo, int version, size_t structsize)
     (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_PERMANENT,
                                 sizeof(my_decomp_master));
   memset(cinfo->master, 0, sizeof(my_decomp_master));
+  jsimd_init_table(&cinfo->master->simd, JSIMD_TIER_ALL, TRUE);
 }
 
 
@@ -118,6 +119,27 @@ jpeg_abort_decompress(j_decompress_ptr cinfo)
 }
 
 
+/*
+ * Limit the resources that decompressing an image can consume.  The limits
+ * are checked by the input controller and the coefficient controller, so they
+ * must be set before the header is read.
+ */
+
+GLOBAL(void)
+jpeg_set_decompress_limits(j_decompress_ptr cinfo, unsigned long max_pixels,
+                           int max_scans, unsigned long max_coef_memory,
+                           int max_decode_passes)
+{
+  if (cinfo->global_state != DSTATE_START)
+    ERREXIT1(cinfo, JERR_BAD_STATE, cinfo->global_state);
+
+  cinfo->master->max_pixels = max_pixels;
+  cinfo->master->max_scans = max_scans;
+  cinfo->master->max_coef_memory = max_coef_memory;
+  cinfo->master->max_decode_passes = max_decode_passes;
+}
+
+
 /*
  * Set default decompression parameters.
  */
@@ -384,12 +384,25 @@ increment_simple_rowgroup_ctr(j_decompress_ptr cinfo, JDIMENSION rows)
   JDIMENSION rows_left;
   my_main_ptr main_ptr = (my_main_ptr)cinfo->main;
   my_master_ptr master = (my_master_ptr)cinfo->master;
+  my_upsample_ptr upsample = (my_upsample_ptr)cinfo->upsample;
 
   if (master->using_merged_upsample && cinfo->max_v_samp_factor == 2) {
     read_and_discard_scanlines(cinfo, rows);
     return;
   }
 
+  /* If the upsampler has returned only some of the rows in the current row
+   * group, then read the rest of them, so that the skip starts on a row group
+   * boundary.
+   */
+  rows_left = (cinfo->max_v_samp_factor -
+               cinfo->output_scanline % cinfo->max_v_samp_factor) %
+              cinfo->max_v_samp_factor;
+  if (rows_left > rows)
+    rows_left = rows;
+  read_and_discard_scanlines(cinfo, rows_left);
+  rows -= rows_left;
+
   /* Increment the counter to the next row group after the skipped rows. */
   main_ptr->rowgroup_ctr += rows / cinfo->max_v_samp_factor;
 
@@ -398,6 +411,8 @@ increment_simple_rowgroup_ctr(j_decompress_ptr cinfo, JDIMENSION rows)
    */
   rows_left = rows % cinfo->max_v_samp_factor;
   cinfo->output_scanline += rows - rows_left;
+  if (!master->using_merged_upsample)
+    upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
 
   read_and_discard_scanlines(cinfo, rows_left);
 }
@@ -498,6 +513,15 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
     if (num_lines < lines_left_in_iMCU_row) {
       increment_simple_rowgroup_ctr(cinfo, num_lines);
       return num_lines;
+    } else if (!main_ptr->buffer_full && lines_left_in_iMCU_row > 0) {
+      /* A previous call skipped part of the current iMCU row without reading
+       * it into the main buffer, so the iMCU row has not been decoded yet.
+       * Back up to the start of the iMCU row, and skip it along with the full
+       * iMCU rows below.
+       */
+      cinfo->output_scanline -= lines_per_iMCU_row - lines_left_in_iMCU_row;
+      lines_after_iMCU_row += lines_per_iMCU_row;
+      main_ptr->rowgroup_ctr = 0;
     } else {
       cinfo->output_scanline += lines_left_in_iMCU_row;
       main_ptr->buffer_full = FALSE;
@@ -506,6 +530,20 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
         upsample->next_row_out = cinfo->max_v_samp_factor;
         upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
       }
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+      else if (cinfo->max_v_samp_factor == 2) {
+        /* If the merged upsampler is holding a spare row, then that row
+         * belongs to the row group that we just skipped.  Discard it, or the
+         * upsampler will return it in place of the first row of the next iMCU
+         * row, and the main controller will fall one row behind.
+         */
+        my_merged_upsample_ptr merged =
+          (my_merged_upsample_ptr)cinfo->upsample;
+
+        merged->spare_full = FALSE;
+        merged->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+      }
+#endif
     }
   }
 
@@ -542,6 +580,11 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
     }
     if (!master->using_merged_upsample)
       upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+    else
+      ((my_merged_upsample_ptr)cinfo->upsample)->rows_to_go =
+        cinfo->output_height - cinfo->output_scanline;
+#endif
     return num_lines;
   }
 
@@ -586,6 +629,11 @@ jpeg_skip_scanlines(j_decompress_ptr cinfo, JDIMENSION num_lines)
    */
   if (!master->using_merged_upsample)
     upsample->rows_to_go = cinfo->output_height - cinfo->output_scanline;
+#ifdef UPSAMPLE_MERGING_SUPPORTED
+  else
+    ((my_merged_upsample_ptr)cinfo->upsample)->rows_to_go =
+      cinfo->output_height - cinfo->output_scanline;
+#endif
 
   /* Always skip the requested number of lines. */
   return num_lines;
@@ -22,6 +22,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jstages.h"
 
 
 #define NEG_1  ((unsigned int)-1)
@@ -77,7 +78,7 @@ get_byte(j_decompress_ptr cinfo)
   struct jpeg_source_mgr *src = cinfo->src;
 
   if (src->bytes_in_buffer == 0)
-    if (!(*src->fill_input_buffer) (cinfo))
+    if (!jstage_fill_input_buffer(cinfo))
       ERREXIT(cinfo, JERR_CANT_SUSPEND);
   src->bytes_in_buffer--;
   return *src->next_input_byte++;
@@ -22,6 +22,7 @@
 #include "jinclude.h"
 #include "jdcoefct.h"
 #include "jpegcomp.h"
+#include "jstages.h"
 
 
 /* Forward declarations */
@@ -93,6 +94,8 @@ decompress_onepass(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
   JDIMENSION start_col, output_col;
   jpeg_component_info *compptr;
   inverse_DCT_method_ptr inverse_DCT;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
+  boolean decoded;
 
   /* Loop to process as much as one whole iMCU row */
   for (yoffset = coef->MCU_vert_offset; yoffset < coef->MCU_rows_per_iMCU_row;
@@ -104,7 +107,10 @@ decompress_onepass(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
                 (size_t)(cinfo->blocks_in_MCU * sizeof(JBLOCK)));
       if (!cinfo->entropy->insufficient_data)
         cinfo->master->last_good_iMCU_row = cinfo->input_iMCU_row;
-      if (!(*cinfo->entropy->decode_mcu) (cinfo, coef->MCU_buffer)) {
+      JSTAGE_BEGIN(timer, JSTAGE_ENTROPY);
+      decoded = (*cinfo->entropy->decode_mcu) (cinfo, coef->MCU_buffer);
+      JSTAGE_END(timer);
+      if (!decoded) {
         /* Suspension forced; update state counters and exit */
         coef->MCU_vert_offset = yoffset;
         coef->MCU_ctr = MCU_col_num;
@@ -121,6 +127,7 @@ decompress_onepass(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
          * incremented past them!).  Note the inner loop relies on having
          * allocated the MCU_buffer[] blocks sequentially.
          */
+        JSTAGE_BEGIN(timer, JSTAGE_DCT);
         blkn = 0;               /* index of current DCT block within MCU */
         for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
           compptr = cinfo->cur_comp_info[ci];
@@ -151,6 +158,7 @@ decompress_onepass(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
             output_ptr += compptr->_DCT_scaled_size;
           }
         }
+        JSTAGE_END(timer);
       }
     }
     /* Completed an MCU row, but perhaps not an iMCU row */
@@ -198,6 +206,8 @@ consume_data(j_decompress_ptr cinfo)
   JBLOCKARRAY buffer[MAX_COMPS_IN_SCAN];
   JBLOCKROW buffer_ptr;
   jpeg_component_info *compptr;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
+  boolean decoded;
 
   /* Align the virtual buffers for the components used in this scan. */
   for (ci = 0; ci < cinfo->comps_in_scan; ci++) {
@@ -232,7 +242,10 @@ consume_data(j_decompress_ptr cinfo)
       if (!cinfo->entropy->insufficient_data)
         cinfo->master->last_good_iMCU_row = cinfo->input_iMCU_row;
       /* Try to fetch the MCU. */
-      if (!(*cinfo->entropy->decode_mcu) (cinfo, coef->MCU_buffer)) {
+      JSTAGE_BEGIN(timer, JSTAGE_ENTROPY);
+      decoded = (*cinfo->entropy->decode_mcu) (cinfo, coef->MCU_buffer);
+      JSTAGE_END(timer);
+      if (!decoded) {
         /* Suspension forced; update state counters and exit */
         coef->MCU_vert_offset = yoffset;
         coef->MCU_ctr = MCU_col_num;
@@ -274,6 +287,7 @@ decompress_data(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
   JDIMENSION output_col;
   jpeg_component_info *compptr;
   inverse_DCT_method_ptr inverse_DCT;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
 
   /* Force some input to be done if we are getting ahead of the input. */
   while (cinfo->input_scan_number < cinfo->output_scan_number ||
@@ -284,6 +298,7 @@ decompress_data(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
   }
 
   /* OK, output from the virtual arrays. */
+  JSTAGE_BEGIN(timer, JSTAGE_DCT);
   for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
        ci++, compptr++) {
     /* Don't bother to IDCT an uninteresting component. */
@@ -318,6 +333,7 @@ decompress_data(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
       output_ptr += compptr->_DCT_scaled_size;
     }
   }
+  JSTAGE_END(timer);
 
   if (++(cinfo->output_iMCU_row) < cinfo->total_iMCU_rows)
     return JPEG_ROW_COMPLETED;
@@ -447,6 +463,7 @@ decompress_smooth_data(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
       DC13, DC14, DC15, DC16, DC17, DC18, DC19, DC20, DC21, DC22, DC23, DC24,
       DC25;
   int Al, pred;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
 
   /* Keep a local variable to avoid looking it up more than once */
   workspace = coef->workspace;
@@ -469,6 +486,7 @@ decompress_smooth_data(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
   }
 
   /* OK, output from the virtual arrays. */
+  JSTAGE_BEGIN(timer, JSTAGE_DCT);
   for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
        ci++, compptr++) {
     /* Don't bother to IDCT an uninteresting component. */
@@ -796,6 +814,7 @@ decompress_smooth_data(j_decompress_ptr cinfo, JSAMPIMAGE output_buf)
       output_ptr += compptr->_DCT_scaled_size;
     }
   }
+  JSTAGE_END(timer);
 
   if (++(cinfo->output_iMCU_row) < cinfo->total_iMCU_rows)
     return JPEG_ROW_COMPLETED;
@@ -832,9 +851,14 @@ jinit_d_coef_controller(j_decompress_ptr cinfo, boolean need_full_buffer)
     /* Note we ask for a pre-zeroed array. */
     int ci, access_rows;
     jpeg_component_info *compptr;
+    unsigned long total_blocks = 0;
 
     for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
          ci++, compptr++) {
+      total_blocks += (unsigned long)jround_up((long)compptr->width_in_blocks,
+                                               (long)compptr->h_samp_factor) *
+                      jround_up((long)compptr->height_in_blocks,
+                                (long)compptr->v_samp_factor);
       access_rows = compptr->v_samp_factor;
 #ifdef BLOCK_SMOOTHING_SUPPORTED
       /* If block smoothing could be used, need a bigger window */
@@ -849,6 +873,13 @@ jinit_d_coef_controller(j_decompress_ptr cinfo, boolean need_full_buffer)
                                (long)compptr->v_samp_factor),
          (JDIMENSION)access_rows);
     }
+    /* The virtual arrays are not realized until jpeg_start_decompress() or
+     * jpeg_read_coefficients() calls realize_virt_arrays(), so enforcing the
+     * memory limit here prevents them from being allocated.
+     */
+    if (cinfo->master->max_coef_memory > 0 &&
+        total_blocks > cinfo->master->max_coef_memory / sizeof(JBLOCK))
+      ERREXIT(cinfo, JERR_COEF_MEMORY_LIMIT);
     coef->pub.consume_data = consume_data;
     coef->pub.decompress_data = decompress_data;
     coef->pub.coef_arrays = coef->whole_image; /* link to virtual arrays */
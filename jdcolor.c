@@ -33,6 +33,9 @@ typedef struct {
 
   /* Private state for RGB->Y conversion */
   JLONG *rgb_y_tab;             /* => table for RGB to Y conversion */
+
+  /* SIMD kernel for the output pixel format, if simd_convert is in use */
+  jsimd_ycc_convert_ptr simd_kernel;
 } my_color_deconverter;
 
 typedef my_color_deconverter *my_cconvert_ptr;
@@ -717,6 +720,22 @@ gray_rgb565D_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 }
 
 
+/*
+ * Convert some rows of samples to the output colorspace using the SIMD kernel
+ * that jinit_color_deconverter() selected for the output pixel format.
+ */
+
+METHODDEF(void)
+simd_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf, JDIMENSION input_row,
+             JSAMPARRAY output_buf, int num_rows)
+{
+  my_cconvert_ptr cconvert = (my_cconvert_ptr)cinfo->cconvert;
+
+  (*cconvert->simd_kernel) (cinfo->output_width, input_buf, input_row,
+                            output_buf, num_rows);
+}
+
+
 /*
  * Empty method for start_pass.
  */
@@ -803,8 +822,10 @@ jinit_color_deconverter(j_decompress_ptr cinfo)
   case JCS_EXT_ARGB:
     cinfo->out_color_components = rgb_pixelsize[cinfo->out_color_space];
     if (cinfo->jpeg_color_space == JCS_YCbCr) {
-      if (jsimd_can_ycc_rgb())
-        cconvert->pub.color_convert = jsimd_ycc_rgb_convert;
+      cconvert->simd_kernel =
+        cinfo->master->simd.ycc_rgb[cinfo->out_color_space];
+      if (cconvert->simd_kernel)
+        cconvert->pub.color_convert = simd_convert;
       else {
         cconvert->pub.color_convert = ycc_rgb_convert;
         build_ycc_rgb_table(cinfo);
@@ -827,8 +848,8 @@ jinit_color_deconverter(j_decompress_ptr cinfo)
     cinfo->out_color_components = 3;
     if (cinfo->dither_mode == JDITHER_NONE) {
       if (cinfo->jpeg_color_space == JCS_YCbCr) {
-        if (jsimd_can_ycc_rgb565())
-          cconvert->pub.color_convert = jsimd_ycc_rgb565_convert;
+        if (cinfo->master->simd.ycc_rgb565)
+          cconvert->pub.color_convert = cinfo->master->simd.ycc_rgb565;
         else {
           cconvert->pub.color_convert = ycc_rgb565_convert;
           build_ycc_rgb_table(cinfo);
@@ -113,8 +113,8 @@ start_pass(j_decompress_ptr cinfo)
       method = JDCT_ISLOW;      /* jidctred uses islow-style table */
       break;
     case 2:
-      if (jsimd_can_idct_2x2())
-        method_ptr = jsimd_idct_2x2;
+      if (cinfo->master->simd.idct_2x2)
+        method_ptr = cinfo->master->simd.idct_2x2;
       else
         method_ptr = jpeg_idct_2x2;
       method = JDCT_ISLOW;      /* jidctred uses islow-style table */
@@ -124,8 +124,8 @@ start_pass(j_decompress_ptr cinfo)
       method = JDCT_ISLOW;      /* jidctint uses islow-style table */
       break;
     case 4:
-      if (jsimd_can_idct_4x4())
-        method_ptr = jsimd_idct_4x4;
+      if (cinfo->master->simd.idct_4x4)
+        method_ptr = cinfo->master->simd.idct_4x4;
       else
         method_ptr = jpeg_idct_4x4;
       method = JDCT_ISLOW;      /* jidctred uses islow-style table */
@@ -136,8 +136,8 @@ start_pass(j_decompress_ptr cinfo)
       break;
     case 6:
 #if defined(__mips__)
-      if (jsimd_can_idct_6x6())
-        method_ptr = jsimd_idct_6x6;
+      if (cinfo->master->simd.idct_6x6)
+        method_ptr = cinfo->master->simd.idct_6x6;
       else
 #endif
       method_ptr = jpeg_idct_6x6;
@@ -152,8 +152,8 @@ start_pass(j_decompress_ptr cinfo)
       switch (cinfo->dct_method) {
 #ifdef DCT_ISLOW_SUPPORTED
       case JDCT_ISLOW:
-        if (jsimd_can_idct_islow())
-          method_ptr = jsimd_idct_islow;
+        if (cinfo->master->simd.idct_islow)
+          method_ptr = cinfo->master->simd.idct_islow;
         else
           method_ptr = jpeg_idct_islow;
         method = JDCT_ISLOW;
@@ -161,8 +161,8 @@ start_pass(j_decompress_ptr cinfo)
 #endif
 #ifdef DCT_IFAST_SUPPORTED
       case JDCT_IFAST:
-        if (jsimd_can_idct_ifast())
-          method_ptr = jsimd_idct_ifast;
+        if (cinfo->master->simd.idct_ifast)
+          method_ptr = cinfo->master->simd.idct_ifast;
         else
           method_ptr = jpeg_idct_ifast;
         method = JDCT_IFAST;
@@ -170,8 +170,8 @@ start_pass(j_decompress_ptr cinfo)
 #endif
 #ifdef DCT_FLOAT_SUPPORTED
       case JDCT_FLOAT:
-        if (jsimd_can_idct_float())
-          method_ptr = jsimd_idct_float;
+        if (cinfo->master->simd.idct_float)
+          method_ptr = cinfo->master->simd.idct_float;
         else
           method_ptr = jpeg_idct_float;
         method = JDCT_FLOAT;
@@ -197,8 +197,8 @@ start_pass(j_decompress_ptr cinfo)
       break;
     case 12:
 #if defined(__mips__)
-      if (jsimd_can_idct_12x12())
-        method_ptr = jsimd_idct_12x12;
+      if (cinfo->master->simd.idct_12x12)
+        method_ptr = cinfo->master->simd.idct_12x12;
       else
 #endif
       method_ptr = jpeg_idct_12x12;
@@ -26,6 +26,7 @@
 #include "jpeglib.h"
 #include "jdhuff.h"             /* Declarations shared with jdphuff.c */
 #include "jpegcomp.h"
+#include "jstages.h"
 #include "jstdhuff.c"
 
 
@@ -302,7 +303,7 @@ jpeg_fill_bit_buffer(bitread_working_state *state,
 
       /* Attempt to read a byte */
       if (bytes_in_buffer == 0) {
-        if (!(*cinfo->src->fill_input_buffer) (cinfo))
+        if (!jstage_fill_input_buffer(cinfo))
           return FALSE;
         next_input_byte = cinfo->src->next_input_byte;
         bytes_in_buffer = cinfo->src->bytes_in_buffer;
@@ -319,7 +320,7 @@ jpeg_fill_bit_buffer(bitread_working_state *state,
          */
         do {
           if (bytes_in_buffer == 0) {
-            if (!(*cinfo->src->fill_input_buffer) (cinfo))
+            if (!jstage_fill_input_buffer(cinfo))
               return FALSE;
             next_input_byte = cinfo->src->next_input_byte;
             bytes_in_buffer = cinfo->src->bytes_in_buffer;
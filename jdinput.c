@@ -19,6 +19,7 @@
 #include "jinclude.h"
 #include "jpeglib.h"
 #include "jpegcomp.h"
+#include "jstages.h"
 
 
 /* Private state */
@@ -27,6 +28,11 @@ typedef struct {
   struct jpeg_input_controller pub; /* public fields */
 
   boolean inheaders;            /* TRUE until first SOS is reached */
+
+  /* Entropy decoding work (see jpeg_set_decompress_limits()) */
+  unsigned long image_blocks;   /* # of DCT blocks in all components */
+  unsigned long decode_blocks;  /* # of blocks decoded, mod image_blocks */
+  int decode_passes;            /* # of whole passes over the image decoded */
 } my_input_controller;
 
 typedef my_input_controller *my_inputctl_ptr;
@@ -44,6 +50,7 @@ LOCAL(void)
 initial_setup(j_decompress_ptr cinfo)
 /* Called once, when first SOS marker is reached */
 {
+  my_inputctl_ptr inputctl = (my_inputctl_ptr)cinfo->inputctl;
   int ci;
   jpeg_component_info *compptr;
 
@@ -52,6 +59,14 @@ initial_setup(j_decompress_ptr cinfo)
       (long)cinfo->image_width > (long)JPEG_MAX_DIMENSION)
     ERREXIT1(cinfo, JERR_IMAGE_TOO_BIG, (unsigned int)JPEG_MAX_DIMENSION);
 
+  /* ... or bigger than the application wants me to handle.  The product can't
+   * overflow, since JPEG_MAX_DIMENSION * JPEG_MAX_DIMENSION < 2^32.
+   */
+  if (cinfo->master->max_pixels > 0 &&
+      (unsigned long)cinfo->image_width * cinfo->image_height >
+      cinfo->master->max_pixels)
+    ERREXIT(cinfo, JERR_PIXEL_LIMIT);
+
   /* For now, precision must match compiled-in value... */
   if (cinfo->data_precision != BITS_IN_JSAMPLE)
     ERREXIT1(cinfo, JERR_BAD_PRECISION, cinfo->data_precision);
@@ -94,6 +109,7 @@ initial_setup(j_decompress_ptr cinfo)
 #endif
 
   /* Compute dimensions of components */
+  inputctl->image_blocks = 0;
   for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
        ci++, compptr++) {
 #if JPEG_LIB_VERSION >= 70
@@ -108,6 +124,14 @@ initial_setup(j_decompress_ptr cinfo)
     compptr->height_in_blocks = (JDIMENSION)
       jdiv_round_up((long)cinfo->image_height * (long)compptr->v_samp_factor,
                     (long)(cinfo->max_v_samp_factor * DCTSIZE));
+    /* Count the dummy blocks in the last MCU column and row as well, so that
+     * an interleaved scan always amounts to exactly one pass over the image.
+     */
+    inputctl->image_blocks +=
+      (unsigned long)jround_up((long)compptr->width_in_blocks,
+                               (long)compptr->h_samp_factor) *
+      jround_up((long)compptr->height_in_blocks,
+                (long)compptr->v_samp_factor);
     /* Set the first and last MCU columns to decompress from multi-scan images.
      * By default, decompress all of the MCU columns.
      */
@@ -140,6 +164,49 @@ initial_setup(j_decompress_ptr cinfo)
     cinfo->inputctl->has_multiple_scans = TRUE;
   else
     cinfo->inputctl->has_multiple_scans = FALSE;
+
+  inputctl->decode_blocks = 0;
+  inputctl->decode_passes = 0;
+}
+
+
+/*
+ * Enforce the limits on the number of scans and the amount of entropy decoding
+ * work (see jpeg_set_decompress_limits()) before a scan is decoded.  The work
+ * is counted in DCT blocks, since the entropy decoder processes every block in
+ * a scan whether or not the scan contains any data for it.  Thus, a
+ * progressive image with many scans is rejected before the decoder spends any
+ * time on the excess scans.
+ */
+
+LOCAL(void)
+check_scan_limits(j_decompress_ptr cinfo)
+{
+  my_inputctl_ptr inputctl = (my_inputctl_ptr)cinfo->inputctl;
+  unsigned long scan_blocks;
+
+  if (cinfo->master->max_scans > 0 &&
+      cinfo->input_scan_number > cinfo->master->max_scans)
+    ERREXIT1(cinfo, JERR_SCAN_LIMIT, cinfo->master->max_scans);
+
+  if (cinfo->master->max_decode_passes > 0) {
+    /* Neither of these can overflow, since the number of blocks in a scan and
+     * the number of blocks in the image are both less than
+     * MAX_COMPONENTS * (JPEG_MAX_DIMENSION / DCTSIZE + 1)^2 < 2^30.
+     */
+    scan_blocks = (unsigned long)cinfo->MCUs_per_row *
+                  cinfo->MCU_rows_in_scan * cinfo->blocks_in_MCU;
+    inputctl->decode_passes += (int)(scan_blocks / inputctl->image_blocks);
+    inputctl->decode_blocks += scan_blocks % inputctl->image_blocks;
+    if (inputctl->decode_blocks >= inputctl->image_blocks) {
+      inputctl->decode_blocks -= inputctl->image_blocks;
+      inputctl->decode_passes++;
+    }
+    if (inputctl->decode_passes > cinfo->master->max_decode_passes ||
+        (inputctl->decode_passes == cinfo->master->max_decode_passes &&
+         inputctl->decode_blocks > 0))
+      ERREXIT1(cinfo, JERR_DECODE_LIMIT, cinfo->master->max_decode_passes);
+  }
 }
 
 
@@ -281,6 +348,7 @@ METHODDEF(void)
 start_input_pass(j_decompress_ptr cinfo)
 {
   per_scan_setup(cinfo);
+  check_scan_limits(cinfo);
   latch_quant_tables(cinfo);
   (*cinfo->entropy->start_pass) (cinfo);
   (*cinfo->coef->start_input_pass) (cinfo);
@@ -320,7 +388,9 @@ consume_markers(j_decompress_ptr cinfo)
   if (inputctl->pub.eoi_reached) /* After hitting EOI, read no further */
     return JPEG_REACHED_EOI;
 
+  JSTAGE_BEGIN(cinfo->master->stage_timer, JSTAGE_MARKERS);
   val = (*cinfo->marker->read_markers) (cinfo);
+  JSTAGE_END(cinfo->master->stage_timer);
 
   switch (val) {
   case JPEG_REACHED_SOS:        /* Found SOS */
@@ -18,6 +18,7 @@
 #define JPEG_INTERNALS
 #include "jinclude.h"
 #include "jpeglib.h"
+#include "jstages.h"
 
 
 typedef enum {                  /* JPEG marker codes */
@@ -140,7 +141,7 @@ typedef my_marker_reader *my_marker_ptr;
  */
 #define MAKE_BYTE_AVAIL(cinfo, action) \
   if (bytes_in_buffer == 0) { \
-    if (!(*datasrc->fill_input_buffer) (cinfo)) \
+    if (!jstage_fill_input_buffer(cinfo)) \
       { action; } \
     INPUT_RELOAD(cinfo); \
   }
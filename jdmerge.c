@@ -42,6 +42,7 @@
 #include "jpeglib.h"
 #include "jdmerge.h"
 #include "jsimd.h"
+#include "jstages.h"
 
 #ifdef UPSAMPLE_MERGING_SUPPORTED
 
@@ -228,6 +229,7 @@ merged_2v_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
   JSAMPROW work_ptrs[2];
   JDIMENSION num_rows;          /* number of rows returned to caller */
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
 
   if (upsample->spare_full) {
     /* If we have a spare row saved from a previous cycle, just return it. */
@@ -257,7 +259,9 @@ merged_2v_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
       upsample->spare_full = TRUE;
     }
     /* Now do the upsampling. */
+    JSTAGE_BEGIN(timer, JSTAGE_COLOR);
     (*upsample->upmethod) (cinfo, input_buf, *in_row_group_ctr, work_ptrs);
+    JSTAGE_END(timer);
   }
 
   /* Adjust counts */
@@ -277,10 +281,13 @@ merged_1v_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 /* 1:1 vertical sampling case: much easier, never need a spare row. */
 {
   my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)cinfo->upsample;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
 
   /* Just do the upsampling. */
+  JSTAGE_BEGIN(timer, JSTAGE_COLOR);
   (*upsample->upmethod) (cinfo, input_buf, *in_row_group_ctr,
                          output_buf + *out_row_ctr);
+  JSTAGE_END(timer);
   /* Adjust counts */
   (*out_row_ctr)++;
   (*in_row_group_ctr)++;
@@ -549,8 +556,8 @@ jinit_merged_upsampler(j_decompress_ptr cinfo)
 
   if (cinfo->max_v_samp_factor == 2) {
     upsample->pub.upsample = merged_2v_upsample;
-    if (jsimd_can_h2v2_merged_upsample())
-      upsample->upmethod = jsimd_h2v2_merged_upsample;
+    if (cinfo->master->simd.h2v2_merged_upsample)
+      upsample->upmethod = cinfo->master->simd.h2v2_merged_upsample;
     else
       upsample->upmethod = h2v2_merged_upsample;
     if (cinfo->out_color_space == JCS_RGB565) {
@@ -566,8 +573,8 @@ jinit_merged_upsampler(j_decompress_ptr cinfo)
                 (size_t)(upsample->out_row_width * sizeof(JSAMPLE)));
   } else {
     upsample->pub.upsample = merged_1v_upsample;
-    if (jsimd_can_h2v1_merged_upsample())
-      upsample->upmethod = jsimd_h2v1_merged_upsample;
+    if (cinfo->master->simd.h2v1_merged_upsample)
+      upsample->upmethod = cinfo->master->simd.h2v1_merged_upsample;
     else
       upsample->upmethod = h2v1_merged_upsample;
     if (cinfo->out_color_space == JCS_RGB565) {
@@ -28,6 +28,7 @@
 #include "jinclude.h"
 #include "jdsample.h"
 #include "jsimd.h"
+#include "jstages.h"
 #include "jpegcomp.h"
 
 
@@ -66,9 +67,11 @@ sep_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   int ci;
   jpeg_component_info *compptr;
   JDIMENSION num_rows;
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
 
   /* Fill the conversion buffer, if it's empty */
   if (upsample->next_row_out >= cinfo->max_v_samp_factor) {
+    JSTAGE_BEGIN(timer, JSTAGE_SAMPLE);
     for (ci = 0, compptr = cinfo->comp_info; ci < cinfo->num_components;
          ci++, compptr++) {
       /* Invoke per-component upsample method.  Notice we pass a POINTER
@@ -78,6 +81,7 @@ sep_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
         input_buf[ci] + (*in_row_group_ctr * upsample->rowgroup_height[ci]),
         upsample->color_buf + ci);
     }
+    JSTAGE_END(timer);
     upsample->next_row_out = 0;
   }
 
@@ -95,9 +99,11 @@ sep_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   if (num_rows > out_rows_avail)
     num_rows = out_rows_avail;
 
+  JSTAGE_BEGIN(timer, JSTAGE_COLOR);
   (*cinfo->cconvert->color_convert) (cinfo, upsample->color_buf,
                                      (JDIMENSION)upsample->next_row_out,
                                      output_buf + *out_row_ctr, (int)num_rows);
+  JSTAGE_END(timer);
 
   /* Adjust counts */
   *out_row_ctr += num_rows;
@@ -464,13 +470,13 @@ jinit_upsampler(j_decompress_ptr cinfo)
     } else if (h_in_group * 2 == h_out_group && v_in_group == v_out_group) {
       /* Special cases for 2h1v upsampling */
       if (do_fancy && compptr->downsampled_width > 2) {
-        if (jsimd_can_h2v1_fancy_upsample())
-          upsample->methods[ci] = jsimd_h2v1_fancy_upsample;
+        if (cinfo->master->simd.h2v1_fancy_upsample)
+          upsample->methods[ci] = cinfo->master->simd.h2v1_fancy_upsample;
         else
           upsample->methods[ci] = h2v1_fancy_upsample;
       } else {
-        if (jsimd_can_h2v1_upsample())
-          upsample->methods[ci] = jsimd_h2v1_upsample;
+        if (cinfo->master->simd.h2v1_upsample)
+          upsample->methods[ci] = cinfo->master->simd.h2v1_upsample;
         else
           upsample->methods[ci] = h2v1_upsample;
       }
@@ -479,8 +485,8 @@ jinit_upsampler(j_decompress_ptr cinfo)
       /* Non-fancy upsampling is handled by the generic method */
 #if defined(__arm__) || defined(__aarch64__) || \
     defined(_M_ARM) || defined(_M_ARM64)
-      if (jsimd_can_h1v2_fancy_upsample())
-        upsample->methods[ci] = jsimd_h1v2_fancy_upsample;
+      if (cinfo->master->simd.h1v2_fancy_upsample)
+        upsample->methods[ci] = cinfo->master->simd.h1v2_fancy_upsample;
       else
 #endif
         upsample->methods[ci] = h1v2_fancy_upsample;
@@ -489,14 +495,14 @@ jinit_upsampler(j_decompress_ptr cinfo)
                v_in_group * 2 == v_out_group) {
       /* Special cases for 2h2v upsampling */
       if (do_fancy && compptr->downsampled_width > 2) {
-        if (jsimd_can_h2v2_fancy_upsample())
-          upsample->methods[ci] = jsimd_h2v2_fancy_upsample;
+        if (cinfo->master->simd.h2v2_fancy_upsample)
+          upsample->methods[ci] = cinfo->master->simd.h2v2_fancy_upsample;
         else
           upsample->methods[ci] = h2v2_fancy_upsample;
         upsample->pub.need_context_rows = TRUE;
       } else {
-        if (jsimd_can_h2v2_upsample())
-          upsample->methods[ci] = jsimd_h2v2_upsample;
+        if (cinfo->master->simd.h2v2_upsample)
+          upsample->methods[ci] = cinfo->master->simd.h2v2_upsample;
         else
           upsample->methods[ci] = h2v2_upsample;
       }
@@ -504,8 +510,8 @@ jinit_upsampler(j_decompress_ptr cinfo)
                (v_out_group % v_in_group) == 0) {
       /* Generic integral-factors upsampling method */
 #if defined(__mips__)
-      if (jsimd_can_int_upsample())
-        upsample->methods[ci] = jsimd_int_upsample;
+      if (cinfo->master->simd.int_upsample)
+        upsample->methods[ci] = cinfo->master->simd.int_upsample;
       else
 #endif
         upsample->methods[ci] = int_upsample;
@@ -211,6 +211,11 @@ JMESSAGE(JWRN_BOGUS_ICC, "Corrupt JPEG data: bad ICC marker")
 JMESSAGE(JERR_BAD_DROP_SAMPLING,
          "Component index %d: mismatching sampling ratio %d:%d, %d:%d, %c")
 #endif
+JMESSAGE(JERR_PIXEL_LIMIT, "Image exceeds the limit on the number of pixels")
+JMESSAGE(JERR_SCAN_LIMIT, "JPEG image has more than %d scans")
+JMESSAGE(JERR_COEF_MEMORY_LIMIT, "Coefficient buffer exceeds the memory limit")
+JMESSAGE(JERR_DECODE_LIMIT,
+         "Entropy decoding exceeds the limit of %d passes over the image")
 
 #ifdef JMAKE_ENUM_LIST
 
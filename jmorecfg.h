@@ -359,10 +359,12 @@ static const int rgb_pixelsize[JPEG_NUMCS] = {
 /* On some machines (notably 68000 series) "int" is 32 bits, but multiplying
  * two 16-bit shorts is faster than multiplying two ints.  Define MULTIPLIER
  * as short on such a machine.  MULTIPLIER must be at least 16 bits wide.
+ * With 12-bit samples, quantization table entries may not fit in 16 bits, so
+ * MULTIPLIER is int even when the SIMD extensions are enabled.
  */
 
 #ifndef MULTIPLIER
-#ifndef WITH_SIMD
+#if !defined(WITH_SIMD) || BITS_IN_JSAMPLE != 8
 #define MULTIPLIER  int         /* type for fastest integer multiply */
 #else
 #define MULTIPLIER  short       /* prefer 16-bit with SIMD for parellelism */
@@ -71,6 +71,80 @@ typedef size_t JUINTPTR;
 
 /* Declarations for compression modules */
 
+/* SIMD kernel table.  jsimd_init_table() fills this in when the object is
+ * created (and again if its SIMD tier is changed), based on the CPU, the
+ * JSIMD_FORCE* environment variables, and the object's SIMD tier.  Each entry
+ * is the SIMD implementation (see jsimd.h and jsimddct.h) that the modules
+ * should install as their method, or NULL if the C implementation must be
+ * used.  The entries are fully resolved, so the kernels need not re-examine
+ * the tier or the pixel format on every call.  The color conversion kernels
+ * are indexed by J_COLOR_SPACE and take the image width rather than the
+ * object.  The forward DCT, quantization, and Huffman encoding kernels are
+ * cast to a generic function pointer type, since their method types are
+ * private to the modules that use them.
+ */
+typedef void (*jsimd_kernel_ptr) (void);
+typedef void (*jsimd_rgb_convert_ptr) (JDIMENSION img_width,
+                                       JSAMPARRAY input_buf,
+                                       JSAMPIMAGE output_buf,
+                                       JDIMENSION output_row, int num_rows);
+typedef void (*jsimd_ycc_convert_ptr) (JDIMENSION out_width,
+                                       JSAMPIMAGE input_buf,
+                                       JDIMENSION input_row,
+                                       JSAMPARRAY output_buf, int num_rows);
+typedef void (*jsimd_downsample_ptr) (j_compress_ptr cinfo,
+                                      jpeg_component_info *compptr,
+                                      JSAMPARRAY input_data,
+                                      JSAMPARRAY output_data);
+typedef void (*jsimd_upsample_ptr) (j_decompress_ptr cinfo,
+                                    jpeg_component_info *compptr,
+                                    JSAMPARRAY input_data,
+                                    JSAMPARRAY *output_data_ptr);
+typedef void (*jsimd_merged_upsample_ptr) (j_decompress_ptr cinfo,
+                                           JSAMPIMAGE input_buf,
+                                           JDIMENSION in_row_group_ctr,
+                                           JSAMPARRAY output_buf);
+typedef void (*jsimd_idct_ptr) (j_decompress_ptr cinfo,
+                                jpeg_component_info *compptr,
+                                JCOEFPTR coef_block, JSAMPARRAY output_buf,
+                                JDIMENSION output_col);
+
+struct jpeg_simd_table {
+  unsigned int support;         /* instruction sets allowed (arch-specific) */
+  /* Color conversion */
+  jsimd_rgb_convert_ptr rgb_ycc[JPEG_NUMCS], rgb_gray[JPEG_NUMCS];
+  jsimd_ycc_convert_ptr ycc_rgb[JPEG_NUMCS];
+  void (*ycc_rgb565) (j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
+                      JDIMENSION input_row, JSAMPARRAY output_buf,
+                      int num_rows);
+  void (*c_null_convert) (j_compress_ptr cinfo, JSAMPARRAY input_buf,
+                          JSAMPIMAGE output_buf, JDIMENSION output_row,
+                          int num_rows);
+  /* Downsampling and upsampling */
+  jsimd_downsample_ptr h2v1_downsample, h2v2_downsample;
+  jsimd_downsample_ptr h2v2_smooth_downsample;
+  jsimd_upsample_ptr h2v1_upsample, h2v2_upsample, int_upsample;
+  jsimd_upsample_ptr h2v1_fancy_upsample, h2v2_fancy_upsample;
+  jsimd_upsample_ptr h1v2_fancy_upsample;
+  jsimd_merged_upsample_ptr h2v1_merged_upsample, h2v2_merged_upsample;
+  /* Forward DCT and quantization */
+  jsimd_kernel_ptr convsamp, convsamp_float, quantize, quantize_float;
+  jsimd_kernel_ptr fdct_islow, fdct_ifast, fdct_float;
+  /* Inverse DCT */
+  jsimd_idct_ptr idct_2x2, idct_4x4, idct_6x6, idct_12x12;
+  jsimd_idct_ptr idct_islow, idct_ifast, idct_float;
+  /* Entropy encoding */
+  jsimd_kernel_ptr huff_encode_one_block;
+  void (*encode_mcu_AC_first_prepare) (const JCOEF *block,
+                                       const int *jpeg_natural_order_start,
+                                       int Sl, int Al, JCOEF *values,
+                                       size_t *zerobits);
+  int (*encode_mcu_AC_refine_prepare) (const JCOEF *block,
+                                       const int *jpeg_natural_order_start,
+                                       int Sl, int Al, JCOEF *absvalues,
+                                       size_t *bits);
+};
+
 /* Master control module */
 struct jpeg_comp_master {
   void (*prepare_for_pass) (j_compress_ptr cinfo);
@@ -80,6 +154,12 @@ struct jpeg_comp_master {
   /* State variables made visible to other modules */
   boolean call_pass_startup;    /* True if pass_startup must be called */
   boolean is_last_pass;         /* True during last pass */
+
+  /* Per-stage timing (see jstages.h), or NULL if disabled */
+  struct jpeg_stage_timer *stage_timer;
+
+  /* SIMD kernels that this object may use */
+  struct jpeg_simd_table simd;
 };
 
 /* Main buffer control (downsampled-data buffer) */
@@ -174,6 +254,18 @@ struct jpeg_decomp_master {
 
   /* Last iMCU row that was successfully decoded */
   JDIMENSION last_good_iMCU_row;
+
+  /* Per-stage timing (see jstages.h), or NULL if disabled */
+  struct jpeg_stage_timer *stage_timer;
+
+  /* SIMD kernels that this object may use */
+  struct jpeg_simd_table simd;
+
+  /* Resource limits (see jpeg_set_decompress_limits()), or 0 if unlimited */
+  unsigned long max_pixels;     /* max. image width * height */
+  int max_scans;                /* max. number of scans */
+  unsigned long max_coef_memory; /* max. bytes in full-image coef. buffer */
+  int max_decode_passes;        /* max. blocks decoded / blocks in image */
 };
 
 /* Input control module */
@@ -355,6 +447,9 @@ EXTERN(void) jinit_2pass_quantizer(j_decompress_ptr cinfo);
 EXTERN(void) jinit_merged_upsampler(j_decompress_ptr cinfo);
 /* Memory manager initialization */
 EXTERN(void) jinit_memory_mgr(j_common_ptr cinfo);
+/* SIMD kernel table initialization (jsimd_none.c or simd/<arch>/jsimd.c) */
+EXTERN(void) jsimd_init_table(struct jpeg_simd_table *table, int tier,
+                              boolean huffman);
 
 /* Utility routines in jutils.c */
 EXTERN(long) jdiv_round_up(long a, long b);
@@ -1059,6 +1059,35 @@ EXTERN(void) jpeg_abort_decompress(j_decompress_ptr cinfo);
 EXTERN(void) jpeg_abort(j_common_ptr cinfo);
 EXTERN(void) jpeg_destroy(j_common_ptr cinfo);
 
+/* Restrict the SIMD instruction sets that a JPEG object can use.  This must be
+ * called before jpeg_start_compress() or jpeg_start_decompress().  The
+ * setting applies only to the given object, so objects used by different
+ * threads can have different settings.  The JSIMD_FORCE* environment
+ * variables still restrict the instruction sets used by all objects.
+ */
+#define JSIMD_TIER_NONE  0      /* Use only the C implementations */
+#define JSIMD_TIER_BASE  1      /* Use SIMD, but not AVX2 (x86) */
+#define JSIMD_TIER_ALL   2      /* Use all SIMD instruction sets (default) */
+
+EXTERN(void) jpeg_set_simd_tier(j_common_ptr cinfo, int tier,
+                                boolean huffman);
+
+/* Limit the resources that decompressing a JPEG image can consume.  This must
+ * be called before jpeg_read_header(), and the limits apply to all subsequent
+ * images decompressed with the object.  A limit of 0 means "no limit."
+ * max_decode_passes limits the total number of DCT blocks that the entropy
+ * decoder processes in all scans, as a multiple of the number of blocks in
+ * the image, which bounds the CPU time that a progressive image with many
+ * scans can consume.  Exceeding a limit causes a fatal error
+ * (JERR_PIXEL_LIMIT, JERR_SCAN_LIMIT, JERR_COEF_MEMORY_LIMIT, or
+ * JERR_DECODE_LIMIT.)
+ */
+EXTERN(void) jpeg_set_decompress_limits(j_decompress_ptr cinfo,
+                                        unsigned long max_pixels,
+                                        int max_scans,
+                                        unsigned long max_coef_memory,
+                                        int max_decode_passes);
+
 /* Default restart-marker-resync procedure for use by data source modules */
 EXTERN(boolean) jpeg_resync_to_restart(j_decompress_ptr cinfo, int desired);
 
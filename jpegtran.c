@@ -38,6 +38,8 @@ static char *icc_filename;      /* for -icc switch */
 JDIMENSION max_scans;           /* for -maxscans switch */
 static char *outfilename;       /* for -outfile switch */
 static char *dropfilename;      /* for -drop switch */
+static char *batchfilename;     /* for -batch switch */
+static int num_jobs;            /* for -jobs switch */
 boolean report;                 /* for -report switch */
 boolean strict;                 /* for -strict switch */
 static JCOPY_OPTION copyoption; /* -copy switch */
@@ -91,6 +93,8 @@ usage(void)
   fprintf(stderr, "  -maxmemory N   Maximum memory to use (in kbytes)\n");
   fprintf(stderr, "  -maxscans N    Maximum number of scans to allow in input file\n");
   fprintf(stderr, "  -outfile name  Specify name for output file\n");
+  fprintf(stderr, "  -batch FILE    Transform each pair of input/output files listed in FILE\n");
+  fprintf(stderr, "  -jobs N        Use N worker processes with -batch\n");
   fprintf(stderr, "  -report        Report transformation progress\n");
   fprintf(stderr, "  -strict        Treat all warnings as fatal\n");
   fprintf(stderr, "  -verbose  or  -debug   Emit debug output\n");
@@ -148,6 +152,8 @@ parse_switches(j_compress_ptr cinfo, int argc, char **argv,
   icc_filename = NULL;
   max_scans = 0;
   outfilename = NULL;
+  batchfilename = NULL;
+  num_jobs = 1;
   report = FALSE;
   strict = FALSE;
   copyoption = JCOPYOPT_DEFAULT;
@@ -183,6 +189,12 @@ parse_switches(j_compress_ptr cinfo, int argc, char **argv,
       exit(EXIT_FAILURE);
 #endif
 
+    } else if (keymatch(arg, "batch", 3)) {
+      /* Transform the files listed in a manifest. */
+      if (++argn >= argc)       /* advance to next argument */
+        usage();
+      batchfilename = argv[argn];
+
     } else if (keymatch(arg, "copy", 2)) {
       /* Select which extra markers to copy. */
       if (++argn >= argc)       /* advance to next argument */
@@ -279,6 +291,13 @@ parse_switches(j_compress_ptr cinfo, int argc, char **argv,
         usage();
       icc_filename = argv[argn];
 
+    } else if (keymatch(arg, "jobs", 1)) {
+      /* Number of worker processes for batch mode. */
+      if (++argn >= argc)       /* advance to next argument */
+        usage();
+      if (sscanf(argv[argn], "%d", &num_jobs) != 1 || num_jobs < 1)
+        usage();
+
     } else if (keymatch(arg, "maxmemory", 3)) {
       /* Maximum memory in Kb (or Mb with 'm'). */
       long lval;
@@ -446,6 +465,61 @@ my_emit_message(j_common_ptr cinfo, int msg_level)
 }
 
 
+/*
+ * Batch mode: transform one file using the decompression and compression
+ * objects that process_batch() is reusing for every file in the batch.
+ */
+
+METHODDEF(boolean)
+transform_file(cd_batch_ptr batch, FILE *input_file, FILE *output_file)
+{
+  j_decompress_ptr srcinfo = (j_decompress_ptr)batch->objects[0];
+  j_compress_ptr dstinfo = (j_compress_ptr)batch->objects[1];
+  jvirt_barray_ptr *src_coef_arrays;
+  jvirt_barray_ptr *dst_coef_arrays;
+
+  /* Restore the transform options, since the previous file changed them */
+  parse_switches(dstinfo, batch->argc, batch->argv, 0, FALSE);
+
+  jpeg_stdio_src(srcinfo, input_file);
+  jcopy_markers_setup(srcinfo, copyoption);
+  (void)jpeg_read_header(srcinfo, TRUE);
+
+#if TRANSFORMS_SUPPORTED
+  if (!jtransform_request_workspace(srcinfo, &transformoption)) {
+    fprintf(stderr, "%s: %s: transformation is not perfect\n", progname,
+            batch->infilename);
+    return FALSE;
+  }
+#endif
+
+  src_coef_arrays = jpeg_read_coefficients(srcinfo);
+  jpeg_copy_critical_parameters(srcinfo, dstinfo);
+#if TRANSFORMS_SUPPORTED
+  dst_coef_arrays = jtransform_adjust_parameters(srcinfo, dstinfo,
+                                                 src_coef_arrays,
+                                                 &transformoption);
+#else
+  dst_coef_arrays = src_coef_arrays;
+#endif
+
+  parse_switches(dstinfo, batch->argc, batch->argv, 0, TRUE);
+  jpeg_stdio_dest(dstinfo, output_file);
+  jpeg_write_coefficients(dstinfo, dst_coef_arrays);
+  jcopy_markers_execute(srcinfo, dstinfo, copyoption);
+#if TRANSFORMS_SUPPORTED
+  jtransform_execute_transformation(srcinfo, dstinfo, src_coef_arrays,
+                                    &transformoption);
+#endif
+
+  jpeg_finish_compress(dstinfo);
+  (void)jpeg_finish_decompress(srcinfo);
+
+  batch->pixels = (double)dstinfo->image_width * dstinfo->image_height;
+  return TRUE;
+}
+
+
 /*
  * The main program.
  */
@@ -499,6 +573,28 @@ main(int argc, char **argv)
   if (strict)
     jsrcerr.emit_message = my_emit_message;
 
+  if (batchfilename != NULL) {
+    struct cdjpeg_batch_struct batch;
+    int status;
+
+    if (file_index < argc || outfilename != NULL || icc_filename != NULL ||
+        dropfilename != NULL || report || max_scans != 0) {
+      fprintf(stderr, "%s: -batch cannot be combined with file names, -outfile, -icc, -drop, -report, or -maxscans\n",
+              progname);
+      usage();
+    }
+    batch.convert = transform_file;
+    batch.objects[0] = (j_common_ptr)&srcinfo;
+    batch.objects[1] = (j_common_ptr)&dstinfo;
+    batch.num_objects = 2;
+    batch.argc = argc;
+    batch.argv = argv;
+    status = process_batch(&batch, progname, batchfilename, num_jobs);
+    jpeg_destroy_compress(&dstinfo);
+    jpeg_destroy_decompress(&srcinfo);
+    return status;
+  }
+
 #ifdef TWO_FILE_COMMANDLINE
   /* Must have either -outfile switch or explicit output file name */
   if (outfilename == NULL) {
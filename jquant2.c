@@ -99,11 +99,10 @@ static const int c_scales[3] = { R_SCALE, G_SCALE, B_SCALE };
  * (In the second pass the histogram space is re-used for pixel mapping data;
  * in that capacity, each cell must be able to store zero to the number of
  * desired colors.  16 bits/cell is plenty for that too.)
- * Since the JPEG code is intended to run in small memory model on 80x86
- * machines, we can't just allocate the histogram in one chunk.  Instead
- * of a true 3-D array, we use a row of pointers to 2-D arrays.  Each
- * pointer corresponds to a C0 value (typically 2^5 = 32 pointers) and
- * each 2-D array has 2^6*2^5 = 2048 or 2^6*2^6 = 4096 entries.
+ * The histogram is allocated in one chunk, so the per-pixel loops can index
+ * it directly using HIST_OFFSET().  The colormap selection code instead uses
+ * a row of pointers to 2-D arrays, one per C0 value (typically 2^5 = 32
+ * pointers), each of which has 2^6*2^5 = 2048 entries.
  */
 
 #define MAXNUMCOLORS  (MAXJSAMPLE + 1) /* maximum size of colormap */
@@ -125,6 +124,14 @@ static const int c_scales[3] = { R_SCALE, G_SCALE, B_SCALE };
 #define C1_SHIFT  (BITS_IN_JSAMPLE - HIST_C1_BITS)
 #define C2_SHIFT  (BITS_IN_JSAMPLE - HIST_C2_BITS)
 
+/* Offset of the histogram cell containing pixel value v0/v1/v2 within the
+ * contiguous histogram array.  The three terms are independent, so they can
+ * be computed in parallel.
+ */
+#define HIST_OFFSET(v0, v1, v2) \
+  ((((v0) >> C0_SHIFT) << (HIST_C1_BITS + HIST_C2_BITS)) + \
+   (((v1) >> C1_SHIFT) << HIST_C2_BITS) + ((v2) >> C2_SHIFT))
+
 
 typedef UINT16 histcell;        /* histogram cell; prefer an unsigned type */
 
@@ -178,6 +185,7 @@ typedef struct {
 
   /* Variables for accumulating image statistics */
   hist3d histogram;             /* pointer to the histogram */
+  histptr histogram_base;       /* the same cells, as one contiguous array */
 
   boolean needs_zeroed;         /* TRUE if next pass must zero histogram */
 
@@ -206,7 +214,7 @@ prescan_quantize(j_decompress_ptr cinfo, JSAMPARRAY input_buf,
   my_cquantize_ptr cquantize = (my_cquantize_ptr)cinfo->cquantize;
   register JSAMPROW ptr;
   register histptr histp;
-  register hist3d histogram = cquantize->histogram;
+  register histptr histogram_base = cquantize->histogram_base;
   int row;
   JDIMENSION col;
   JDIMENSION width = cinfo->output_width;
@@ -215,9 +223,7 @@ prescan_quantize(j_decompress_ptr cinfo, JSAMPARRAY input_buf,
     ptr = input_buf[row];
     for (col = width; col > 0; col--) {
       /* get pixel value and index into the histogram */
-      histp = &histogram[ptr[0] >> C0_SHIFT]
-                        [ptr[1] >> C1_SHIFT]
-                        [ptr[2] >> C2_SHIFT];
+      histp = histogram_base + HIST_OFFSET(ptr[0], ptr[1], ptr[2]);
       /* increment, check for overflow and undo increment if so. */
       if (++(*histp) <= 0)
         (*histp)--;
@@ -636,9 +642,14 @@ find_nearby_colors(j_decompress_ptr cinfo, int minc0, int minc1, int minc2,
   int numcolors = cinfo->actual_number_of_colors;
   int maxc0, maxc1, maxc2;
   int centerc0, centerc1, centerc2;
+  int c0_scale = C0_SCALE, c1_scale = C1_SCALE, c2_scale = C2_SCALE;
+  JSAMPROW colormap0 = cinfo->colormap[0];
+  JSAMPROW colormap1 = cinfo->colormap[1];
+  JSAMPROW colormap2 = cinfo->colormap[2];
   int i, x, ncolors;
-  JLONG minmaxdist, min_dist, max_dist, tdist;
-  JLONG mindist[MAXNUMCOLORS];  /* min distance to colormap entry i */
+  /* Squared distances fit in an int even with 12-bit samples. */
+  int minmaxdist, min_dist, max_dist, tdist;
+  int mindist[MAXNUMCOLORS];    /* min distance to colormap entry i */
 
   /* Compute true coordinates of update box's upper corner and center.
    * Actually we compute the coordinates of the center of the upper-corner
@@ -661,80 +672,36 @@ find_nearby_colors(j_decompress_ptr cinfo, int minc0, int minc1, int minc2,
    * We save the minimum distance for each color in mindist[];
    * only the smallest maximum distance is of interest.
    */
-  minmaxdist = 0x7FFFFFFFL;
+  minmaxdist = 0x7FFFFFFF;
 
   for (i = 0; i < numcolors; i++) {
-    /* We compute the squared-c0-distance term, then add in the other two. */
-    x = cinfo->colormap[0][i];
-    if (x < minc0) {
-      tdist = (x - minc0) * C0_SCALE;
-      min_dist = tdist * tdist;
-      tdist = (x - maxc0) * C0_SCALE;
-      max_dist = tdist * tdist;
-    } else if (x > maxc0) {
-      tdist = (x - maxc0) * C0_SCALE;
-      min_dist = tdist * tdist;
-      tdist = (x - minc0) * C0_SCALE;
-      max_dist = tdist * tdist;
-    } else {
-      /* within cell range so no contribution to min_dist */
-      min_dist = 0;
-      if (x <= centerc0) {
-        tdist = (x - maxc0) * C0_SCALE;
-        max_dist = tdist * tdist;
-      } else {
-        tdist = (x - minc0) * C0_SCALE;
-        max_dist = tdist * tdist;
-      }
-    }
-
-    x = cinfo->colormap[1][i];
-    if (x < minc1) {
-      tdist = (x - minc1) * C1_SCALE;
-      min_dist += tdist * tdist;
-      tdist = (x - maxc1) * C1_SCALE;
-      max_dist += tdist * tdist;
-    } else if (x > maxc1) {
-      tdist = (x - maxc1) * C1_SCALE;
-      min_dist += tdist * tdist;
-      tdist = (x - minc1) * C1_SCALE;
-      max_dist += tdist * tdist;
-    } else {
-      /* within cell range so no contribution to min_dist */
-      if (x <= centerc1) {
-        tdist = (x - maxc1) * C1_SCALE;
-        max_dist += tdist * tdist;
-      } else {
-        tdist = (x - minc1) * C1_SCALE;
-        max_dist += tdist * tdist;
-      }
-    }
-
-    x = cinfo->colormap[2][i];
-    if (x < minc2) {
-      tdist = (x - minc2) * C2_SCALE;
-      min_dist += tdist * tdist;
-      tdist = (x - maxc2) * C2_SCALE;
-      max_dist += tdist * tdist;
-    } else if (x > maxc2) {
-      tdist = (x - maxc2) * C2_SCALE;
-      min_dist += tdist * tdist;
-      tdist = (x - minc2) * C2_SCALE;
-      max_dist += tdist * tdist;
-    } else {
-      /* within cell range so no contribution to min_dist */
-      if (x <= centerc2) {
-        tdist = (x - maxc2) * C2_SCALE;
-        max_dist += tdist * tdist;
-      } else {
-        tdist = (x - minc2) * C2_SCALE;
-        max_dist += tdist * tdist;
-      }
-    }
+    /* We compute the squared-c0-distance term, then add in the other two.
+     * The nearest point of the box along each axis is the near edge (or the
+     * color itself, if it lies within the range), and the farthest point is
+     * whichever edge is on the other side of the center.  The selections are
+     * written as conditional expressions rather than branches so that the
+     * compiler can vectorize this loop.
+     */
+    x = colormap0[i];
+    tdist = (x < minc0 ? x - minc0 : (x > maxc0 ? x - maxc0 : 0)) * c0_scale;
+    min_dist = tdist * tdist;
+    tdist = (x <= centerc0 ? x - maxc0 : x - minc0) * c0_scale;
+    max_dist = tdist * tdist;
+
+    x = colormap1[i];
+    tdist = (x < minc1 ? x - minc1 : (x > maxc1 ? x - maxc1 : 0)) * c1_scale;
+    min_dist += tdist * tdist;
+    tdist = (x <= centerc1 ? x - maxc1 : x - minc1) * c1_scale;
+    max_dist += tdist * tdist;
+
+    x = colormap2[i];
+    tdist = (x < minc2 ? x - minc2 : (x > maxc2 ? x - maxc2 : 0)) * c2_scale;
+    min_dist += tdist * tdist;
+    tdist = (x <= centerc2 ? x - maxc2 : x - minc2) * c2_scale;
+    max_dist += tdist * tdist;
 
     mindist[i] = min_dist;      /* save away the results */
-    if (max_dist < minmaxdist)
-      minmaxdist = max_dist;
+    minmaxdist = (max_dist < minmaxdist ? max_dist : minmaxdist);
   }
 
   /* Now we know that no cell in the update box is more than minmaxdist
@@ -762,20 +729,26 @@ find_best_colors(j_decompress_ptr cinfo, int minc0, int minc1, int minc2,
 {
   int ic0, ic1, ic2;
   int i, icolor;
-  register JLONG *bptr;         /* pointer into bestdist[] array */
-  JSAMPLE *cptr;                /* pointer into bestcolor[] array */
-  JLONG dist0, dist1;           /* initial distance values */
-  register JLONG dist2;         /* current distance in inner loop */
-  JLONG xx0, xx1;               /* distance increments */
-  register JLONG xx2;
-  JLONG inc0, inc1, inc2;       /* initial values for increments */
-  /* This array holds the distance to the nearest-so-far color for each cell */
-  JLONG bestdist[BOX_C0_ELEMS * BOX_C1_ELEMS * BOX_C2_ELEMS];
+  register int *bptr;           /* pointer into bestdist[] array */
+  register int *cptr;           /* pointer into bestcode[] array */
+  int dist0, dist1;             /* initial distance values */
+  int xx0, xx1, xx2;            /* distance increments */
+  int inc0, inc1, inc2;         /* initial values for increments */
+  /* The C2 terms of the distance from the current color to each cell */
+  int dist2[BOX_C2_ELEMS];
+  /* These arrays hold the distance to the nearest-so-far color for each cell,
+   * and that color's index.  The worst-case squared distance, even with 12-bit
+   * samples, fits in an int, so using int rather than JLONG and JSAMPLE lets
+   * the compiler process a whole row of cells with SIMD instructions.
+   */
+  int bestdist[BOX_C0_ELEMS * BOX_C1_ELEMS * BOX_C2_ELEMS];
+  int bestcode[BOX_C0_ELEMS * BOX_C1_ELEMS * BOX_C2_ELEMS];
 
   /* Initialize best-distance for each cell of the update box */
-  bptr = bestdist;
-  for (i = BOX_C0_ELEMS * BOX_C1_ELEMS * BOX_C2_ELEMS - 1; i >= 0; i--)
-    *bptr++ = 0x7FFFFFFFL;
+  for (i = 0; i < BOX_C0_ELEMS * BOX_C1_ELEMS * BOX_C2_ELEMS; i++) {
+    bestdist[i] = 0x7FFFFFFF;
+    bestcode[i] = 0;
+  }
 
   /* For each color selected by find_nearby_colors,
    * compute its distance to the center of each cell in the box.
@@ -789,37 +762,43 @@ find_best_colors(j_decompress_ptr cinfo, int minc0, int minc1, int minc2,
 
   for (i = 0; i < numcolors; i++) {
     icolor = colorlist[i];
-    /* Compute (square of) distance from minc0/c1/c2 to this color */
+    /* Compute (square of) distance from minc0/c1/c2 to this color.  The C2
+     * term is kept separately, since it is the same for every row of cells.
+     */
     inc0 = (minc0 - cinfo->colormap[0][icolor]) * C0_SCALE;
     dist0 = inc0 * inc0;
     inc1 = (minc1 - cinfo->colormap[1][icolor]) * C1_SCALE;
     dist0 += inc1 * inc1;
     inc2 = (minc2 - cinfo->colormap[2][icolor]) * C2_SCALE;
-    dist0 += inc2 * inc2;
+    dist2[0] = inc2 * inc2;
     /* Form the initial difference increments */
     inc0 = inc0 * (2 * STEP_C0) + STEP_C0 * STEP_C0;
     inc1 = inc1 * (2 * STEP_C1) + STEP_C1 * STEP_C1;
     inc2 = inc2 * (2 * STEP_C2) + STEP_C2 * STEP_C2;
+    /* Tabulate the C2 terms per Thomas method */
+    xx2 = inc2;
+    for (ic2 = 1; ic2 < BOX_C2_ELEMS; ic2++) {
+      dist2[ic2] = dist2[ic2 - 1] + xx2;
+      xx2 += 2 * STEP_C2 * STEP_C2;
+    }
     /* Now loop over all cells in box, updating distance per Thomas method */
     bptr = bestdist;
-    cptr = bestcolor;
+    cptr = bestcode;
     xx0 = inc0;
     for (ic0 = BOX_C0_ELEMS - 1; ic0 >= 0; ic0--) {
       dist1 = dist0;
       xx1 = inc1;
       for (ic1 = BOX_C1_ELEMS - 1; ic1 >= 0; ic1--) {
-        dist2 = dist1;
-        xx2 = inc2;
-        for (ic2 = BOX_C2_ELEMS - 1; ic2 >= 0; ic2--) {
-          if (dist2 < *bptr) {
-            *bptr = dist2;
-            *cptr = (JSAMPLE)icolor;
-          }
-          dist2 += xx2;
-          xx2 += 2 * STEP_C2 * STEP_C2;
-          bptr++;
-          cptr++;
+        /* This loop is branchless so that it can be vectorized. */
+        for (ic2 = 0; ic2 < BOX_C2_ELEMS; ic2++) {
+          int dist = dist1 + dist2[ic2];
+          int closer = dist < bptr[ic2];
+
+          bptr[ic2] = closer ? dist : bptr[ic2];
+          cptr[ic2] = closer ? icolor : cptr[ic2];
         }
+        bptr += BOX_C2_ELEMS;
+        cptr += BOX_C2_ELEMS;
         dist1 += xx1;
         xx1 += 2 * STEP_C1 * STEP_C1;
       }
@@ -827,6 +806,9 @@ find_best_colors(j_decompress_ptr cinfo, int minc0, int minc1, int minc2,
       xx0 += 2 * STEP_C0 * STEP_C0;
     }
   }
+
+  for (i = 0; i < BOX_C0_ELEMS * BOX_C1_ELEMS * BOX_C2_ELEMS; i++)
+    bestcolor[i] = (JSAMPLE)bestcode[i];
 }
 
 
@@ -896,10 +878,9 @@ pass2_no_dither(j_decompress_ptr cinfo, JSAMPARRAY input_buf,
 /* This version performs no dithering */
 {
   my_cquantize_ptr cquantize = (my_cquantize_ptr)cinfo->cquantize;
-  hist3d histogram = cquantize->histogram;
+  histptr histogram_base = cquantize->histogram_base;
   register JSAMPROW inptr, outptr;
   register histptr cachep;
-  register int c0, c1, c2;
   int row;
   JDIMENSION col;
   JDIMENSION width = cinfo->output_width;
@@ -909,14 +890,13 @@ pass2_no_dither(j_decompress_ptr cinfo, JSAMPARRAY input_buf,
     outptr = output_buf[row];
     for (col = width; col > 0; col--) {
       /* get pixel value and index into the cache */
-      c0 = (*inptr++) >> C0_SHIFT;
-      c1 = (*inptr++) >> C1_SHIFT;
-      c2 = (*inptr++) >> C2_SHIFT;
-      cachep = &histogram[c0][c1][c2];
+      cachep = histogram_base + HIST_OFFSET(inptr[0], inptr[1], inptr[2]);
       /* If we have not seen this color before, find nearest colormap entry */
       /* and update the cache */
       if (*cachep == 0)
-        fill_inverse_cmap(cinfo, c0, c1, c2);
+        fill_inverse_cmap(cinfo, inptr[0] >> C0_SHIFT, inptr[1] >> C1_SHIFT,
+                          inptr[2] >> C2_SHIFT);
+      inptr += 3;
       /* Now emit the colormap index for this cell */
       *outptr++ = (JSAMPLE)(*cachep - 1);
     }
@@ -930,7 +910,7 @@ pass2_fs_dither(j_decompress_ptr cinfo, JSAMPARRAY input_buf,
 /* This version performs Floyd-Steinberg dithering */
 {
   my_cquantize_ptr cquantize = (my_cquantize_ptr)cinfo->cquantize;
-  hist3d histogram = cquantize->histogram;
+  histptr histogram_base = cquantize->histogram_base;
   register LOCFSERROR cur0, cur1, cur2; /* current error or pixel value */
   LOCFSERROR belowerr0, belowerr1, belowerr2; /* error for pixel below cur */
   LOCFSERROR bpreverr0, bpreverr1, bpreverr2; /* error for below/prev col */
@@ -1003,8 +983,7 @@ pass2_fs_dither(j_decompress_ptr cinfo, JSAMPARRAY input_buf,
       cur1 = range_limit[cur1];
       cur2 = range_limit[cur2];
       /* Index into the cache with adjusted pixel value */
-      cachep =
-        &histogram[cur0 >> C0_SHIFT][cur1 >> C1_SHIFT][cur2 >> C2_SHIFT];
+      cachep = histogram_base + HIST_OFFSET(cur0, cur1, cur2);
       /* If we have not seen this color before, find nearest colormap */
       /* entry and update the cache */
       if (*cachep == 0)
@@ -1141,7 +1120,6 @@ METHODDEF(void)
 start_pass_2_quant(j_decompress_ptr cinfo, boolean is_pre_scan)
 {
   my_cquantize_ptr cquantize = (my_cquantize_ptr)cinfo->cquantize;
-  hist3d histogram = cquantize->histogram;
   int i;
 
   /* Only F-S dithering or no dithering is supported. */
@@ -1187,10 +1165,8 @@ start_pass_2_quant(j_decompress_ptr cinfo, boolean is_pre_scan)
   }
   /* Zero the histogram or inverse color map, if necessary */
   if (cquantize->needs_zeroed) {
-    for (i = 0; i < HIST_C0_ELEMS; i++) {
-      jzero_far((void *)histogram[i],
-                HIST_C1_ELEMS * HIST_C2_ELEMS * sizeof(histcell));
-    }
+    jzero_far((void *)cquantize->histogram_base,
+              HIST_C0_ELEMS * HIST_C1_ELEMS * HIST_C2_ELEMS * sizeof(histcell));
     cquantize->needs_zeroed = FALSE;
   }
 }
@@ -1236,11 +1212,12 @@ jinit_2pass_quantizer(j_decompress_ptr cinfo)
   /* Allocate the histogram/inverse colormap storage */
   cquantize->histogram = (hist3d)(*cinfo->mem->alloc_small)
     ((j_common_ptr)cinfo, JPOOL_IMAGE, HIST_C0_ELEMS * sizeof(hist2d));
-  for (i = 0; i < HIST_C0_ELEMS; i++) {
-    cquantize->histogram[i] = (hist2d)(*cinfo->mem->alloc_large)
-      ((j_common_ptr)cinfo, JPOOL_IMAGE,
-       HIST_C1_ELEMS * HIST_C2_ELEMS * sizeof(histcell));
-  }
+  cquantize->histogram_base = (histptr)(*cinfo->mem->alloc_large)
+    ((j_common_ptr)cinfo, JPOOL_IMAGE,
+     HIST_C0_ELEMS * HIST_C1_ELEMS * HIST_C2_ELEMS * sizeof(histcell));
+  for (i = 0; i < HIST_C0_ELEMS; i++)
+    cquantize->histogram[i] = (hist2d)(cquantize->histogram_base +
+                                       i * HIST_C1_ELEMS * HIST_C2_ELEMS);
   cquantize->needs_zeroed = TRUE; /* histogram is garbage now */
 
   /* Allocate storage for the completed colormap, if required.
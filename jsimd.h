@@ -14,21 +14,24 @@
 
 #include "jchuff.h"             /* Declarations shared with jcphuff.c */
 
-EXTERN(int) jsimd_can_rgb_ycc(void);
-EXTERN(int) jsimd_can_rgb_gray(void);
-EXTERN(int) jsimd_can_ycc_rgb(void);
-EXTERN(int) jsimd_can_ycc_rgb565(void);
-EXTERN(int) jsimd_c_can_null_convert(void);
+/* Fill in the color conversion kernels for the extended RGB pixel formats.
+ * The kernel names are formed by pasting the pixel format between prefix and
+ * suffix (for instance, jsimd_ ## extrgbx ## _ycc_convert_sse2.)  The caller
+ * fills in the JCS_RGB entry.
+ */
+#define JSIMD_SET_RGB_KERNELS(kernels, prefix, suffix)  do { \
+  (kernels)[JCS_EXT_RGB] = prefix##extrgb##suffix; \
+  (kernels)[JCS_EXT_RGBX] = (kernels)[JCS_EXT_RGBA] = \
+    prefix##extrgbx##suffix; \
+  (kernels)[JCS_EXT_BGR] = prefix##extbgr##suffix; \
+  (kernels)[JCS_EXT_BGRX] = (kernels)[JCS_EXT_BGRA] = \
+    prefix##extbgrx##suffix; \
+  (kernels)[JCS_EXT_XBGR] = (kernels)[JCS_EXT_ABGR] = \
+    prefix##extxbgr##suffix; \
+  (kernels)[JCS_EXT_XRGB] = (kernels)[JCS_EXT_ARGB] = \
+    prefix##extxrgb##suffix; \
+} while (0)
 
-EXTERN(void) jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                                   JSAMPIMAGE output_buf,
-                                   JDIMENSION output_row, int num_rows);
-EXTERN(void) jsimd_rgb_gray_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                                    JSAMPIMAGE output_buf,
-                                    JDIMENSION output_row, int num_rows);
-EXTERN(void) jsimd_ycc_rgb_convert(j_decompress_ptr cinfo,
-                                   JSAMPIMAGE input_buf, JDIMENSION input_row,
-                                   JSAMPARRAY output_buf, int num_rows);
 EXTERN(void) jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo,
                                       JSAMPIMAGE input_buf,
                                       JDIMENSION input_row,
@@ -37,16 +40,11 @@ EXTERN(void) jsimd_c_null_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
                                   JSAMPIMAGE output_buf, JDIMENSION output_row,
                                   int num_rows);
 
-EXTERN(int) jsimd_can_h2v2_downsample(void);
-EXTERN(int) jsimd_can_h2v1_downsample(void);
-
 EXTERN(void) jsimd_h2v2_downsample(j_compress_ptr cinfo,
                                    jpeg_component_info *compptr,
                                    JSAMPARRAY input_data,
                                    JSAMPARRAY output_data);
 
-EXTERN(int) jsimd_can_h2v2_smooth_downsample(void);
-
 EXTERN(void) jsimd_h2v2_smooth_downsample(j_compress_ptr cinfo,
                                           jpeg_component_info *compptr,
                                           JSAMPARRAY input_data,
@@ -57,10 +55,6 @@ EXTERN(void) jsimd_h2v1_downsample(j_compress_ptr cinfo,
                                    JSAMPARRAY input_data,
                                    JSAMPARRAY output_data);
 
-EXTERN(int) jsimd_can_h2v2_upsample(void);
-EXTERN(int) jsimd_can_h2v1_upsample(void);
-EXTERN(int) jsimd_can_int_upsample(void);
-
 EXTERN(void) jsimd_h2v2_upsample(j_decompress_ptr cinfo,
                                  jpeg_component_info *compptr,
                                  JSAMPARRAY input_data,
@@ -74,10 +68,6 @@ EXTERN(void) jsimd_int_upsample(j_decompress_ptr cinfo,
                                 JSAMPARRAY input_data,
                                 JSAMPARRAY *output_data_ptr);
 
-EXTERN(int) jsimd_can_h2v2_fancy_upsample(void);
-EXTERN(int) jsimd_can_h2v1_fancy_upsample(void);
-EXTERN(int) jsimd_can_h1v2_fancy_upsample(void);
-
 EXTERN(void) jsimd_h2v2_fancy_upsample(j_decompress_ptr cinfo,
                                        jpeg_component_info *compptr,
                                        JSAMPARRAY input_data,
@@ -91,9 +81,6 @@ EXTERN(void) jsimd_h1v2_fancy_upsample(j_decompress_ptr cinfo,
                                        JSAMPARRAY input_data,
                                        JSAMPARRAY *output_data_ptr);
 
-EXTERN(int) jsimd_can_h2v2_merged_upsample(void);
-EXTERN(int) jsimd_can_h2v1_merged_upsample(void);
-
 EXTERN(void) jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo,
                                         JSAMPIMAGE input_buf,
                                         JDIMENSION in_row_group_ctr,
@@ -103,21 +90,15 @@ EXTERN(void) jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo,
                                         JDIMENSION in_row_group_ctr,
                                         JSAMPARRAY output_buf);
 
-EXTERN(int) jsimd_can_huff_encode_one_block(void);
-
 EXTERN(JOCTET *) jsimd_huff_encode_one_block(void *state, JOCTET *buffer,
                                              JCOEFPTR block, int last_dc_val,
                                              c_derived_tbl *dctbl,
                                              c_derived_tbl *actbl);
 
-EXTERN(int) jsimd_can_encode_mcu_AC_first_prepare(void);
-
 EXTERN(void) jsimd_encode_mcu_AC_first_prepare
   (const JCOEF *block, const int *jpeg_natural_order_start, int Sl, int Al,
    JCOEF *values, size_t *zerobits);
 
-EXTERN(int) jsimd_can_encode_mcu_AC_refine_prepare(void);
-
 EXTERN(int) jsimd_encode_mcu_AC_refine_prepare
   (const JCOEF *block, const int *jpeg_natural_order_start, int Sl, int Al,
    JCOEF *absvalues, size_t *bits);
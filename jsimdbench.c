@@ -0,0 +1,880 @@
+/*
+ * jsimdbench.c
+ *
+ * libjpeg-turbo Modifications:
+ * Copyright (C) 2022, D. R. Commander.
+ * For conditions of distribution and use, see the accompanying README.ijg
+ * file.
+ *
+ * This program measures the performance of the individual DCT, color
+ * conversion, resampling, and Huffman encoding kernels in isolation.  Each
+ * kernel is called through the method pointer that the library selected for
+ * it, so the program measures the SIMD implementation if one is available and
+ * the C implementation otherwise.  The JSIMD_FORCE* environment variables
+ * (JSIMD_FORCENONE, JSIMD_FORCESSE2, JSIMD_FORCEAVX2, etc.) can be used to
+ * compare the SIMD instruction set extensions against each other and against
+ * C on the same data, and the -simdtier option can be used to measure the
+ * effect of jpeg_set_simd_tier().
+ *
+ * The input data are derived from a real JPEG image: the IDCT and Huffman
+ * encoding kernels process the image's quantized DCT coefficients, and the
+ * other kernels process its pixels or planes.
+ */
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jpegcomp.h"
+#include "jdct.h"
+#include "jdmaster.h"
+#include "jdsample.h"
+#include "jdmerge.h"
+#include "jcsample.h"
+#include "jsimd.h"
+#include "jsimddct.h"
+#include "jstages.h"
+#include "tjutil.h"
+
+
+#define PAD_SAMPLES  128                /* SIMD kernels may write past the
+                                           end of a row */
+
+static double benchTime = 0.5;
+static int simdTier = JSIMD_TIER_ALL;
+
+
+/* Input data shared by all kernels */
+
+typedef struct {
+  unsigned char *jpegBuf;               /* original JPEG image */
+  unsigned long jpegSize;
+  JDIMENSION width, height;
+  JBLOCKARRAY coefRows;                 /* luminance DCT coefficients */
+  JBLOCKROW coefBuf;
+  JDIMENSION widthInBlocks, heightInBlocks;
+  JSAMPARRAY rgbRows;                   /* RGB pixels */
+  JSAMPARRAY planes[3];                 /* full-size Y, Cb, and Cr planes */
+} bench_data;
+
+/* Arguments to a kernel */
+
+typedef struct {
+  bench_data *data;
+  j_decompress_ptr dinfo;
+  j_compress_ptr cinfo;
+  int ci;                               /* component index */
+  JSAMPARRAY inRows, outRows;
+  JSAMPIMAGE inPlanes, outPlanes;
+  JBLOCKROW outBlocks;
+  JDIMENSION numRows;
+} bench_args;
+
+
+static JSAMPARRAY alloc_rows(JDIMENSION width, JDIMENSION height)
+/* Allocate an array of padded sample rows with one extra row of context above
+ * and below it, and return a pointer to the first real row.  The context rows
+ * replicate the first and last real row, once the caller fills them in.
+ */
+{
+  JSAMPARRAY rows;
+  JSAMPROW buf;
+  size_t pitch = (size_t)width + PAD_SAMPLES;
+  JDIMENSION i;
+
+  rows = (JSAMPARRAY)malloc(sizeof(JSAMPROW) * (height + 2));
+  buf = (JSAMPROW)calloc(pitch * height, sizeof(JSAMPLE));
+  if (rows == NULL || buf == NULL) {
+    fprintf(stderr, "Memory allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < height; i++)
+    rows[i + 1] = buf + pitch * i;
+  rows[0] = rows[1];
+  rows[height + 1] = rows[height];
+  return rows + 1;
+}
+
+
+static void free_rows(JSAMPARRAY rows)
+{
+  if (rows == NULL) return;
+  free(rows[0]);
+  free(rows - 1);
+}
+
+
+static JSAMPARRAY downsample_plane(JSAMPARRAY plane, JDIMENSION width,
+                                   JDIMENSION height, int h_factor,
+                                   int v_factor)
+/* Box-filter a full-size plane to produce realistic downsampled input */
+{
+  JDIMENSION out_width = (width + h_factor - 1) / h_factor;
+  JDIMENSION out_height = (height + v_factor - 1) / v_factor;
+  JSAMPARRAY rows = alloc_rows(out_width, out_height);
+  JDIMENSION row, col;
+
+  for (row = 0; row < out_height; row++) {
+    for (col = 0; col < out_width; col++) {
+      int sum = 0, n = 0, y, x;
+
+      for (y = 0; y < v_factor; y++) {
+        for (x = 0; x < h_factor; x++) {
+          JDIMENSION r = MIN(row * v_factor + y, height - 1);
+          JDIMENSION c = MIN(col * h_factor + x, width - 1);
+
+          sum += plane[r][c];
+          n++;
+        }
+      }
+      rows[row][col] = (JSAMPLE)((sum + n / 2) / n);
+    }
+  }
+  return rows;
+}
+
+
+/*
+ * Decompression setup
+ */
+
+static j_decompress_ptr create_decompressor(bench_data *data,
+                                            J_DCT_METHOD dct_method,
+                                            unsigned int scale_denom,
+                                            J_COLOR_SPACE out_color_space,
+                                            boolean do_fancy_upsampling,
+                                            unsigned char *jpegBuf,
+                                            unsigned long jpegSize)
+/* Create a decompressor and start decompression, so that its method pointers
+ * are initialized.  The decompressor is never used to read scanlines.
+ */
+{
+  j_decompress_ptr dinfo;
+  struct jpeg_error_mgr *jerr;
+
+  dinfo = (j_decompress_ptr)malloc(sizeof(struct jpeg_decompress_struct));
+  jerr = (struct jpeg_error_mgr *)malloc(sizeof(struct jpeg_error_mgr));
+  if (dinfo == NULL || jerr == NULL) {
+    fprintf(stderr, "Memory allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+  dinfo->err = jpeg_std_error(jerr);
+  jpeg_create_decompress(dinfo);
+  jpeg_set_simd_tier((j_common_ptr)dinfo, simdTier, TRUE);
+  jpeg_mem_src(dinfo, jpegBuf ? jpegBuf : data->jpegBuf,
+               jpegBuf ? jpegSize : data->jpegSize);
+  jpeg_read_header(dinfo, TRUE);
+  dinfo->dct_method = dct_method;
+  dinfo->scale_num = 1;
+  dinfo->scale_denom = scale_denom;
+  dinfo->out_color_space = out_color_space;
+  dinfo->do_fancy_upsampling = do_fancy_upsampling;
+  jpeg_start_decompress(dinfo);
+  return dinfo;
+}
+
+
+static void destroy_decompressor(j_decompress_ptr dinfo)
+{
+  struct jpeg_error_mgr *jerr = dinfo->err;
+
+  jpeg_destroy_decompress(dinfo);
+  free(dinfo);
+  free(jerr);
+}
+
+
+/*
+ * Compression setup
+ */
+
+static JOCTET discard_buffer[4096];
+
+static void init_discard_destination(j_compress_ptr cinfo)
+{
+  cinfo->dest->next_output_byte = discard_buffer;
+  cinfo->dest->free_in_buffer = sizeof(discard_buffer);
+}
+
+static boolean empty_discard_buffer(j_compress_ptr cinfo)
+{
+  init_discard_destination(cinfo);
+  return TRUE;
+}
+
+static void term_discard_destination(j_compress_ptr cinfo)
+{
+}
+
+
+static j_compress_ptr create_compressor(bench_data *data,
+                                        J_COLOR_SPACE in_color_space,
+                                        J_DCT_METHOD dct_method,
+                                        int h_samp, int v_samp,
+                                        int smoothing_factor)
+/* Create a compressor that discards its output and start compression, so
+ * that its method pointers are initialized
+ */
+{
+  j_compress_ptr cinfo;
+  struct jpeg_error_mgr *jerr;
+  struct jpeg_destination_mgr *dest;
+
+  cinfo = (j_compress_ptr)malloc(sizeof(struct jpeg_compress_struct));
+  jerr = (struct jpeg_error_mgr *)malloc(sizeof(struct jpeg_error_mgr));
+  dest = (struct jpeg_destination_mgr *)
+    malloc(sizeof(struct jpeg_destination_mgr));
+  if (cinfo == NULL || jerr == NULL || dest == NULL) {
+    fprintf(stderr, "Memory allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+  cinfo->err = jpeg_std_error(jerr);
+  jpeg_create_compress(cinfo);
+  jpeg_set_simd_tier((j_common_ptr)cinfo, simdTier, TRUE);
+  dest->init_destination = init_discard_destination;
+  dest->empty_output_buffer = empty_discard_buffer;
+  dest->term_destination = term_discard_destination;
+  cinfo->dest = dest;
+  cinfo->image_width = data->width;
+  cinfo->image_height = data->height;
+  cinfo->input_components = in_color_space == JCS_GRAYSCALE ? 1 : 3;
+  cinfo->in_color_space = in_color_space;
+  jpeg_set_defaults(cinfo);
+  jpeg_set_quality(cinfo, 95, TRUE);
+  cinfo->dct_method = dct_method;
+  cinfo->smoothing_factor = smoothing_factor;
+  if (in_color_space != JCS_GRAYSCALE) {
+    cinfo->comp_info[0].h_samp_factor = h_samp;
+    cinfo->comp_info[0].v_samp_factor = v_samp;
+  }
+  jpeg_start_compress(cinfo, TRUE);
+  return cinfo;
+}
+
+
+static void destroy_compressor(j_compress_ptr cinfo)
+{
+  struct jpeg_error_mgr *jerr = cinfo->err;
+  struct jpeg_destination_mgr *dest = cinfo->dest;
+
+  jpeg_destroy_compress(cinfo);
+  free(cinfo);
+  free(jerr);
+  free(dest);
+}
+
+
+static unsigned char *compress_image(bench_data *data, int h_samp,
+                                     int v_samp, unsigned long *jpegSize)
+/* Compress the RGB image with the given luminance sampling factors, in order
+ * to set up a decompressor for a particular upsampling method
+ */
+{
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  unsigned char *jpegBuf = NULL;
+
+  *jpegSize = 0;
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+  jpeg_mem_dest(&cinfo, &jpegBuf, jpegSize);
+  cinfo.image_width = data->width;
+  cinfo.image_height = data->height;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, 95, TRUE);
+  cinfo.comp_info[0].h_samp_factor = h_samp;
+  cinfo.comp_info[0].v_samp_factor = v_samp;
+  jpeg_start_compress(&cinfo, TRUE);
+  jpeg_write_scanlines(&cinfo, data->rgbRows, data->height);
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  return jpegBuf;
+}
+
+
+/*
+ * Kernels.  Each one processes the whole image once.
+ */
+
+static void run_idct(bench_args *args)
+{
+  j_decompress_ptr dinfo = args->dinfo;
+  jpeg_component_info *compptr = &dinfo->comp_info[0];
+  inverse_DCT_method_ptr inverse_DCT = dinfo->idct->inverse_DCT[0];
+  int size = compptr->_DCT_scaled_size;
+  JDIMENSION row, col;
+
+  for (row = 0; row < args->data->heightInBlocks; row++) {
+    JBLOCKROW blocks = args->data->coefRows[row];
+
+    for (col = 0; col < args->data->widthInBlocks; col++)
+      (*inverse_DCT) (dinfo, compptr, (JCOEFPTR)blocks[col], args->outRows,
+                      col * size);
+  }
+}
+
+
+static void run_color_deconvert(bench_args *args)
+{
+  (*args->dinfo->cconvert->color_convert) (args->dinfo, args->inPlanes, 0,
+                                           args->outRows,
+                                           (int)args->numRows);
+}
+
+
+static void run_upsample(bench_args *args)
+{
+  j_decompress_ptr dinfo = args->dinfo;
+  my_upsample_ptr upsample = (my_upsample_ptr)dinfo->upsample;
+  jpeg_component_info *compptr = &dinfo->comp_info[args->ci];
+  JSAMPARRAY outRows = args->outRows;
+  JDIMENSION row;
+
+  for (row = 0; row < args->numRows; row++)
+    (*upsample->methods[args->ci]) (dinfo, compptr, args->inRows + row,
+                                    &outRows);
+}
+
+
+static void run_merged_upsample(bench_args *args)
+{
+  j_decompress_ptr dinfo = args->dinfo;
+  my_merged_upsample_ptr upsample = (my_merged_upsample_ptr)dinfo->upsample;
+  JDIMENSION row;
+
+  for (row = 0; row < args->numRows; row++)
+    (*upsample->upmethod) (dinfo, args->inPlanes, row, args->outRows);
+}
+
+
+static void run_color_convert(bench_args *args)
+{
+  (*args->cinfo->cconvert->color_convert) (args->cinfo, args->inRows,
+                                           args->outPlanes, 0,
+                                           (int)args->numRows);
+}
+
+
+static void run_downsample(bench_args *args)
+{
+  j_compress_ptr cinfo = args->cinfo;
+  my_downsample_ptr downsample = (my_downsample_ptr)cinfo->downsample;
+  jpeg_component_info *compptr = &cinfo->comp_info[args->ci];
+  JDIMENSION row;
+
+  for (row = 0; row < args->numRows; row += cinfo->max_v_samp_factor)
+    (*downsample->methods[args->ci]) (cinfo, compptr, args->inRows + row,
+                                      args->outRows);
+}
+
+
+static void run_fdct(bench_args *args)
+{
+  j_compress_ptr cinfo = args->cinfo;
+  JDIMENSION row;
+
+  for (row = 0; row < args->data->heightInBlocks; row++)
+    (*cinfo->fdct->forward_DCT) (cinfo, &cinfo->comp_info[0],
+                                 args->inRows + row * DCTSIZE,
+                                 args->outBlocks, 0, 0,
+                                 args->data->widthInBlocks);
+}
+
+
+static void run_huff_encode(bench_args *args)
+{
+  j_compress_ptr cinfo = args->cinfo;
+  JDIMENSION row, col;
+
+  for (row = 0; row < args->data->heightInBlocks; row++) {
+    JBLOCKROW blocks = args->data->coefRows[row];
+
+    for (col = 0; col < args->data->widthInBlocks; col++) {
+      JBLOCKROW MCU_data[1];
+
+      MCU_data[0] = blocks + col;
+      (*cinfo->entropy->encode_mcu) (cinfo, MCU_data);
+    }
+  }
+}
+
+
+static void run_kernel(const char *name, int simd, void (*kernel)(bench_args *),
+                       bench_args *args, double units, const char *unit)
+/* Run a kernel repeatedly for the benchmark time, and report the minimum and
+ * mean number of cycles per unit of work
+ */
+{
+  unsigned long long best = 0, total = 0;
+  double start, elapsed;
+  int runs = 0;
+
+  (*kernel) (args);                     /* warm up the caches */
+
+  start = getTime();
+  do {
+    unsigned long long begin = jstage_counter(), cycles;
+
+    (*kernel) (args);
+    cycles = jstage_counter() - begin;
+    if (runs == 0 || cycles < best) best = cycles;
+    total += cycles;
+    runs++;
+    elapsed = getTime() - start;
+  } while (elapsed < benchTime);
+
+  printf("%-24s %-5s %10.2f %10.2f %10.2f  %s\n", name, simd ? "SIMD" : "C",
+         (double)best / units, (double)total / (double)runs / units,
+         units * (double)runs / elapsed / 1000000., unit);
+}
+
+
+/*
+ * Benchmarks
+ */
+
+static void bench_idct(bench_data *data, const char *name, int simd,
+                       J_DCT_METHOD dct_method, unsigned int scale_denom)
+{
+  bench_args args;
+
+  memset(&args, 0, sizeof(args));
+  args.data = data;
+  args.dinfo = create_decompressor(data, dct_method, scale_denom, JCS_RGB,
+                                   TRUE, NULL, 0);
+  args.outRows = alloc_rows(data->widthInBlocks * DCTSIZE, DCTSIZE);
+  run_kernel(name, simd, run_idct, &args,
+             (double)data->widthInBlocks * data->heightInBlocks, "blocks");
+  free_rows(args.outRows);
+  destroy_decompressor(args.dinfo);
+}
+
+
+static void bench_color_deconvert(bench_data *data)
+{
+  bench_args args;
+
+  memset(&args, 0, sizeof(args));
+  args.data = data;
+  args.dinfo = create_decompressor(data, JDCT_ISLOW, 1, JCS_RGB, TRUE, NULL,
+                                   0);
+  args.inPlanes = data->planes;
+  args.outRows = alloc_rows(data->width * 3, data->height);
+  args.numRows = data->height;
+  run_kernel("ycc_rgb_convert",
+             args.dinfo->master->simd.ycc_rgb[JCS_RGB] != NULL,
+             run_color_deconvert, &args, (double)data->width * data->height,
+             "pixels");
+  free_rows(args.outRows);
+  destroy_decompressor(args.dinfo);
+}
+
+
+static void bench_upsample(bench_data *data, const char *name, int simd,
+                           int h_samp, int v_samp, boolean fancy)
+{
+  bench_args args;
+  unsigned char *jpegBuf;
+  unsigned long jpegSize;
+  jpeg_component_info *compptr;
+
+  memset(&args, 0, sizeof(args));
+  args.data = data;
+  jpegBuf = compress_image(data, h_samp, v_samp, &jpegSize);
+  /* Decompress to YCbCr, so that the library does not select merged
+     upsampling */
+  args.dinfo = create_decompressor(data, JDCT_ISLOW, 1, JCS_YCbCr, fancy,
+                                   jpegBuf, jpegSize);
+  args.ci = 1;
+  compptr = &args.dinfo->comp_info[1];
+  args.numRows = compptr->downsampled_height;
+  args.inRows = downsample_plane(data->planes[1], data->width, data->height,
+                                 h_samp, v_samp);
+  args.outRows = alloc_rows(args.dinfo->output_width,
+                            args.dinfo->max_v_samp_factor);
+  run_kernel(name, simd, run_upsample, &args,
+             (double)args.dinfo->output_width * args.numRows *
+             args.dinfo->max_v_samp_factor, "pixels");
+  free_rows(args.inRows);
+  free_rows(args.outRows);
+  destroy_decompressor(args.dinfo);
+  free(jpegBuf);
+}
+
+
+static void bench_merged_upsample(bench_data *data, const char *name,
+                                  int simd, int v_samp)
+{
+  bench_args args;
+  JSAMPARRAY planes[3];
+  unsigned char *jpegBuf;
+  unsigned long jpegSize;
+
+  memset(&args, 0, sizeof(args));
+  args.data = data;
+  jpegBuf = compress_image(data, 2, v_samp, &jpegSize);
+  args.dinfo = create_decompressor(data, JDCT_ISLOW, 1, JCS_RGB, FALSE,
+                                   jpegBuf, jpegSize);
+  if (!((my_master_ptr)args.dinfo->master)->using_merged_upsample) {
+    printf("%-24s (merged upsampling not supported in this build)\n", name);
+    destroy_decompressor(args.dinfo);
+    free(jpegBuf);
+    return;
+  }
+  planes[0] = data->planes[0];
+  planes[1] = downsample_plane(data->planes[1], data->width, data->height, 2,
+                               v_samp);
+  planes[2] = downsample_plane(data->planes[2], data->width, data->height, 2,
+                               v_samp);
+  args.inPlanes = planes;
+  args.numRows = data->height / v_samp;
+  args.outRows = alloc_rows(data->width * 3, v_samp);
+  run_kernel(name, simd, run_merged_upsample, &args,
+             (double)data->width * args.numRows * v_samp, "pixels");
+  free_rows(planes[1]);
+  free_rows(planes[2]);
+  free_rows(args.outRows);
+  destroy_decompressor(args.dinfo);
+  free(jpegBuf);
+}
+
+
+static void bench_color_convert(bench_data *data)
+{
+  bench_args args;
+  JSAMPARRAY planes[3];
+  int ci;
+
+  memset(&args, 0, sizeof(args));
+  args.data = data;
+  args.cinfo = create_compressor(data, JCS_RGB, JDCT_ISLOW, 2, 2, 0);
+  for (ci = 0; ci < 3; ci++)
+    planes[ci] = alloc_rows(data->width, data->height);
+  args.inRows = data->rgbRows;
+  args.outPlanes = planes;
+  args.numRows = data->height;
+  run_kernel("rgb_ycc_convert",
+             args.cinfo->master->simd.rgb_ycc[JCS_RGB] != NULL,
+             run_color_convert, &args, (double)data->width * data->height,
+             "pixels");
+  for (ci = 0; ci < 3; ci++)
+    free_rows(planes[ci]);
+  destroy_compressor(args.cinfo);
+}
+
+
+static void bench_downsample(bench_data *data, const char *name, int simd,
+                             int h_samp, int v_samp, int smoothing_factor)
+{
+  bench_args args;
+  JDIMENSION numRows;
+
+  memset(&args, 0, sizeof(args));
+  args.data = data;
+  args.cinfo = create_compressor(data, JCS_RGB, JDCT_ISLOW, h_samp, v_samp,
+                                 smoothing_factor);
+  args.ci = 1;
+  /* Process only whole row groups.  The input rows are padded, since the
+     downsampler expands the right edge of its input. */
+  numRows = data->height - data->height % v_samp;
+  args.numRows = numRows;
+  args.inRows = data->planes[1];
+  args.outRows = alloc_rows(args.cinfo->comp_info[1].width_in_blocks *
+                            DCTSIZE, 1);
+  run_kernel(name, simd, run_downsample, &args,
+             (double)data->width * numRows, "pixels");
+  free_rows(args.outRows);
+  destroy_compressor(args.cinfo);
+}
+
+
+static void bench_fdct(bench_data *data, const char *name, int simd,
+                       J_DCT_METHOD dct_method)
+{
+  bench_args args;
+
+  memset(&args, 0, sizeof(args));
+  args.data = data;
+  args.cinfo = create_compressor(data, JCS_GRAYSCALE, dct_method, 1, 1, 0);
+  args.inRows = data->planes[0];
+  if ((args.outBlocks = (JBLOCKROW)malloc(sizeof(JBLOCK) *
+                                          data->widthInBlocks)) == NULL) {
+    fprintf(stderr, "Memory allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+  run_kernel(name, simd, run_fdct, &args,
+             (double)data->widthInBlocks * data->heightInBlocks, "blocks");
+  free(args.outBlocks);
+  destroy_compressor(args.cinfo);
+}
+
+
+static void bench_huff_encode(bench_data *data)
+{
+  bench_args args;
+
+  memset(&args, 0, sizeof(args));
+  args.data = data;
+  args.cinfo = create_compressor(data, JCS_GRAYSCALE, JDCT_ISLOW, 1, 1, 0);
+  run_kernel("huff_encode_one_block",
+             args.cinfo->master->simd.huff_encode_one_block != NULL,
+             run_huff_encode, &args,
+             (double)data->widthInBlocks * data->heightInBlocks, "blocks");
+  destroy_compressor(args.cinfo);
+}
+
+
+/*
+ * Input data setup
+ */
+
+static void load_image(bench_data *data, const char *filename)
+{
+  struct jpeg_decompress_struct dinfo;
+  struct jpeg_error_mgr jerr;
+  jvirt_barray_ptr *coef_arrays;
+  JSAMPARRAY yccRows;
+  FILE *file;
+  long size;
+  JDIMENSION row, col;
+  int ci;
+
+  if ((file = fopen(filename, "rb")) == NULL ||
+      fseek(file, 0, SEEK_END) < 0 || (size = ftell(file)) <= 0 ||
+      fseek(file, 0, SEEK_SET) < 0) {
+    fprintf(stderr, "Could not open %s\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  data->jpegSize = (unsigned long)size;
+  if ((data->jpegBuf = (unsigned char *)malloc(data->jpegSize)) == NULL ||
+      fread(data->jpegBuf, data->jpegSize, 1, file) < 1) {
+    fprintf(stderr, "Could not read %s\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  fclose(file);
+
+  dinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_decompress(&dinfo);
+
+  /* Copy the luminance coefficients */
+  jpeg_mem_src(&dinfo, data->jpegBuf, data->jpegSize);
+  jpeg_read_header(&dinfo, TRUE);
+  if (dinfo.num_components != 3 || dinfo.jpeg_color_space != JCS_YCbCr) {
+    fprintf(stderr, "%s is not a YCbCr JPEG image\n", filename);
+    exit(EXIT_FAILURE);
+  }
+  coef_arrays = jpeg_read_coefficients(&dinfo);
+  data->widthInBlocks = dinfo.comp_info[0].width_in_blocks;
+  data->heightInBlocks = dinfo.comp_info[0].height_in_blocks;
+  data->coefBuf = (JBLOCKROW)malloc(sizeof(JBLOCK) * data->widthInBlocks *
+                                    data->heightInBlocks);
+  data->coefRows = (JBLOCKARRAY)malloc(sizeof(JBLOCKROW) *
+                                       data->heightInBlocks);
+  if (data->coefBuf == NULL || data->coefRows == NULL) {
+    fprintf(stderr, "Memory allocation failure\n");
+    exit(EXIT_FAILURE);
+  }
+  for (row = 0; row < data->heightInBlocks; row++) {
+    JBLOCKARRAY src = (*dinfo.mem->access_virt_barray)
+      ((j_common_ptr)&dinfo, coef_arrays[0], row, 1, FALSE);
+
+    data->coefRows[row] = data->coefBuf + row * data->widthInBlocks;
+    memcpy(data->coefRows[row], src[0],
+           sizeof(JBLOCK) * data->widthInBlocks);
+  }
+  jpeg_finish_decompress(&dinfo);
+
+  /* Decompress the image to RGB */
+  jpeg_mem_src(&dinfo, data->jpegBuf, data->jpegSize);
+  jpeg_read_header(&dinfo, TRUE);
+  dinfo.out_color_space = JCS_RGB;
+  jpeg_start_decompress(&dinfo);
+  data->width = dinfo.output_width;
+  data->height = dinfo.output_height;
+  data->rgbRows = alloc_rows(data->width * 3, data->height);
+  while (dinfo.output_scanline < dinfo.output_height)
+    jpeg_read_scanlines(&dinfo, data->rgbRows + dinfo.output_scanline,
+                        dinfo.output_height - dinfo.output_scanline);
+  jpeg_finish_decompress(&dinfo);
+
+  /* Decompress the image to YCbCr and split it into full-size planes.  The
+     luminance plane is padded to a multiple of the block size, because the
+     forward DCT reads whole blocks. */
+  jpeg_mem_src(&dinfo, data->jpegBuf, data->jpegSize);
+  jpeg_read_header(&dinfo, TRUE);
+  dinfo.out_color_space = JCS_YCbCr;
+  jpeg_start_decompress(&dinfo);
+  yccRows = alloc_rows(data->width * 3, data->height);
+  while (dinfo.output_scanline < dinfo.output_height)
+    jpeg_read_scanlines(&dinfo, yccRows + dinfo.output_scanline,
+                        dinfo.output_height - dinfo.output_scanline);
+  jpeg_finish_decompress(&dinfo);
+  jpeg_destroy_decompress(&dinfo);
+
+  for (ci = 0; ci < 3; ci++) {
+    data->planes[ci] = alloc_rows(data->widthInBlocks * DCTSIZE,
+                                  MAX(data->height,
+                                      data->heightInBlocks * DCTSIZE));
+    for (row = 0; row < data->heightInBlocks * DCTSIZE; row++) {
+      JSAMPROW inptr = yccRows[MIN(row, data->height - 1)];
+      JSAMPROW outptr = data->planes[ci][row];
+
+      for (col = 0; col < data->widthInBlocks * DCTSIZE; col++)
+        outptr[col] = inptr[MIN(col, data->width - 1) * 3 + ci];
+    }
+  }
+  free_rows(yccRows);
+}
+
+
+static void usage(const char *progname)
+{
+  fprintf(stderr, "USAGE: %s [-benchtime <t>] [-simdtier <tier>] <YCbCr JPEG image>\n\n",
+          progname);
+  fprintf(stderr, "Measure the performance of the individual SIMD kernels (or their C\n");
+  fprintf(stderr, "equivalents) using data derived from the given JPEG image.  The kernels\n");
+  fprintf(stderr, "are selected the same way as in the library, so the JSIMD_FORCE*\n");
+  fprintf(stderr, "environment variables can be used to select the instruction set.\n\n");
+  fprintf(stderr, "-benchtime <t> = Run each kernel for at least <t> seconds (default = 0.5)\n");
+  fprintf(stderr, "-simdtier none|base|all = Restrict the SIMD instruction sets that the kernels\n");
+  fprintf(stderr, "     can use (see jpeg_set_simd_tier()).  base excludes AVX2.  (default = all)\n");
+  exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char *argv[])
+{
+  bench_data data;
+  j_compress_ptr cinfo;
+  j_decompress_ptr dinfo;
+  struct jpeg_simd_table csimd, dsimd;
+  char *filename = NULL;
+  const char *env;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-benchtime") && i < argc - 1) {
+      benchTime = atof(argv[++i]);
+      if (benchTime <= 0.0) usage(argv[0]);
+    } else if (!strcmp(argv[i], "-simdtier") && i < argc - 1) {
+      i++;
+      if (!strcmp(argv[i], "none"))
+        simdTier = JSIMD_TIER_NONE;
+      else if (!strcmp(argv[i], "base"))
+        simdTier = JSIMD_TIER_BASE;
+      else if (!strcmp(argv[i], "all"))
+        simdTier = JSIMD_TIER_ALL;
+      else
+        usage(argv[0]);
+    } else if (argv[i][0] == '-' || filename != NULL)
+      usage(argv[0]);
+    else
+      filename = argv[i];
+  }
+  if (filename == NULL) usage(argv[0]);
+
+  memset(&data, 0, sizeof(data));
+  load_image(&data, filename);
+
+  printf("Image: %s (%u x %u, %u x %u luminance blocks)\n", filename,
+         data.width, data.height, data.widthInBlocks, data.heightInBlocks);
+  printf("SIMD environment:");
+  if ((env = getenv("JSIMD_FORCENONE")) != NULL && !strcmp(env, "1"))
+    printf(" JSIMD_FORCENONE");
+  else {
+    static const char *vars[] = {
+      "JSIMD_FORCEMMX", "JSIMD_FORCE3DNOW", "JSIMD_FORCESSE",
+      "JSIMD_FORCESSE2", "JSIMD_FORCEAVX2", "JSIMD_FORCEDSPR2",
+      "JSIMD_FORCENEON", "JSIMD_FORCEALTIVEC", "JSIMD_FORCEMMI"
+    };
+    int found = 0;
+
+    for (i = 0; i < (int)(sizeof(vars) / sizeof(vars[0])); i++) {
+      if ((env = getenv(vars[i])) != NULL && !strcmp(env, "1")) {
+        printf(" %s", vars[i]);
+        found = 1;
+      }
+    }
+    if (!found) printf(" (default)");
+  }
+  printf("\n");
+  printf("SIMD tier: %s\n", simdTier == JSIMD_TIER_NONE ? "none" :
+         simdTier == JSIMD_TIER_BASE ? "base" : "all");
+  printf("Cycle counter: %s\n\n",
+#if (defined(_MSC_VER) && defined(HAVE_INTRIN_H) && \
+     (defined(_M_IX86) || defined(_M_X64))) || \
+    (defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
+         "TSC"
+#elif defined(__GNUC__) && defined(__aarch64__)
+         "CNTVCT_EL0"
+#else
+         "clock()"
+#endif
+         );
+
+  printf("%-24s %-5s %10s %10s %10s\n", "Kernel", "Impl", "Min", "Mean",
+         "M/sec");
+  printf("%-24s %-5s %10s %10s %10s\n", "", "", "cyc/unit", "cyc/unit",
+         "units");
+
+  /* Whether a kernel has a SIMD implementation depends on the object's SIMD
+     tier, so read the SIMD kernel tables of objects with the same settings as
+     the ones that are benchmarked. */
+  cinfo = create_compressor(&data, JCS_RGB, JDCT_ISLOW, 2, 2, 0);
+  dinfo = create_decompressor(&data, JDCT_ISLOW, 1, JCS_RGB, TRUE, NULL, 0);
+  csimd = cinfo->master->simd;
+  dsimd = dinfo->master->simd;
+  destroy_compressor(cinfo);
+  destroy_decompressor(dinfo);
+
+  bench_idct(&data, "idct_islow", dsimd.idct_islow != NULL, JDCT_ISLOW, 1);
+  bench_idct(&data, "idct_ifast", dsimd.idct_ifast != NULL, JDCT_IFAST, 1);
+  bench_idct(&data, "idct_float", dsimd.idct_float != NULL, JDCT_FLOAT, 1);
+  bench_idct(&data, "idct_4x4", dsimd.idct_4x4 != NULL, JDCT_ISLOW, 2);
+  bench_idct(&data, "idct_2x2", dsimd.idct_2x2 != NULL, JDCT_ISLOW, 4);
+  bench_color_deconvert(&data);
+  bench_upsample(&data, "h2v1_fancy_upsample",
+                 dsimd.h2v1_fancy_upsample != NULL, 2, 1, TRUE);
+  bench_upsample(&data, "h2v2_fancy_upsample",
+                 dsimd.h2v2_fancy_upsample != NULL, 2, 2, TRUE);
+  bench_upsample(&data, "h1v2_fancy_upsample",
+                 dsimd.h1v2_fancy_upsample != NULL, 1, 2, TRUE);
+  bench_upsample(&data, "h2v1_upsample", dsimd.h2v1_upsample != NULL, 2, 1,
+                 FALSE);
+  bench_upsample(&data, "h2v2_upsample", dsimd.h2v2_upsample != NULL, 2, 2,
+                 FALSE);
+  bench_merged_upsample(&data, "h2v1_merged_upsample",
+                        dsimd.h2v1_merged_upsample != NULL, 1);
+  bench_merged_upsample(&data, "h2v2_merged_upsample",
+                        dsimd.h2v2_merged_upsample != NULL, 2);
+  bench_color_convert(&data);
+  bench_downsample(&data, "h2v1_downsample", csimd.h2v1_downsample != NULL, 2,
+                   1, 0);
+  bench_downsample(&data, "h2v2_downsample", csimd.h2v2_downsample != NULL, 2,
+                   2, 0);
+  bench_downsample(&data, "h2v2_smooth_downsample",
+                   csimd.h2v2_smooth_downsample != NULL, 2, 2, 50);
+  bench_fdct(&data, "fdct_islow+quantize",
+             csimd.fdct_islow && csimd.convsamp &&
+             csimd.quantize, JDCT_ISLOW);
+  bench_fdct(&data, "fdct_ifast+quantize",
+             csimd.fdct_ifast && csimd.convsamp &&
+             csimd.quantize, JDCT_IFAST);
+  bench_fdct(&data, "fdct_float+quantize",
+             csimd.fdct_float && csimd.convsamp_float &&
+             csimd.quantize_float, JDCT_FLOAT);
+  bench_huff_encode(&data);
+
+  for (i = 0; i < 3; i++)
+    free_rows(data.planes[i]);
+  free_rows(data.rgbRows);
+  free(data.coefRows);
+  free(data.coefBuf);
+  free(data.jpegBuf);
+  return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * jstages.c
+ *
+ * libjpeg-turbo Modifications:
+ * Copyright (C) 2022, D. R. Commander.
+ * For conditions of distribution and use, see the accompanying README.ijg
+ * file.
+ *
+ * This file contains the hardware performance counter support for the
+ * per-stage timer (see jstages.h.)  It is compiled only if libjpeg-turbo was
+ * built with WITH_PERF_COUNTERS.
+ *
+ * The events are opened with perf_event_open() as a single group, so that the
+ * kernel schedules them onto the PMU together and their counts cover the same
+ * intervals.  Only user-mode events in the calling thread are counted, which
+ * works with the default perf_event_paranoid setting.  On x86, if the kernel
+ * allows user-mode counter reads (/sys/bus/event_source/devices/cpu/rdpmc),
+ * the counters are read with the RDPMC instruction, so a stage change costs a
+ * few hundred cycles.  Otherwise, each stage change costs a read() system
+ * call, which significantly inflates the cost of short stages.
+ */
+
+#define JPEG_INTERNALS
+#include "jinclude.h"
+#include "jpeglib.h"
+#include "jstages.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+#define CACHE_READ_MISS(cache) \
+  ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | \
+   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+/* Indexed by JSTAGE_EV_* */
+static const struct {
+  __u32 type;
+  __u64 config;
+} event_attr[JSTAGE_NUM_EVENTS] = {
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+  { PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL) }
+};
+
+
+LOCAL(void)
+close_events(struct jpeg_stage_timer *timer)
+{
+  long page_size = sysconf(_SC_PAGESIZE);
+  int i;
+
+  /* Close the group members before the leader. */
+  for (i = JSTAGE_NUM_EVENTS - 1; i >= 0; i--) {
+    if (timer->event_page[i] != NULL)
+      munmap(timer->event_page[i], (size_t)page_size);
+    if (timer->event_fd[i] >= 0)
+      close(timer->event_fd[i]);
+    timer->event_page[i] = NULL;
+    timer->event_fd[i] = -1;
+  }
+}
+
+
+/*
+ * Open the events.  Events that the CPU or kernel does not support are left
+ * out of the group.  Returns FALSE if none of the events could be opened.
+ */
+
+GLOBAL(boolean)
+jstage_open_events(struct jpeg_stage_timer *timer)
+{
+  struct perf_event_attr attr;
+  long page_size = sysconf(_SC_PAGESIZE);
+  int i, leader = -1;
+
+  for (i = 0; i < JSTAGE_NUM_EVENTS; i++) {
+    int fd;
+
+    timer->event_fd[i] = -1;
+    timer->event_page[i] = NULL;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event_attr[i].type;
+    attr.config = event_attr[i].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = (leader < 0);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+    if (fd < 0)
+      continue;
+    if (leader < 0)
+      leader = fd;
+    timer->event_fd[i] = fd;
+
+    /* The first page of the mapping is the event's metadata page, which is
+     * needed in order to read the counter with RDPMC.
+     */
+    if (page_size > 0) {
+      void *page = mmap(NULL, (size_t)page_size, PROT_READ, MAP_SHARED, fd,
+                        0);
+
+      if (page != MAP_FAILED)
+        timer->event_page[i] = page;
+    }
+  }
+
+  if (leader < 0 ||
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) < 0) {
+    close_events(timer);
+    timer->events_state = -1;
+    return FALSE;
+  }
+
+  memset(timer->events, 0, sizeof(timer->events));
+  memset(timer->event_start, 0, sizeof(timer->event_start));
+  timer->events_state = 1;
+  jstage_count_events(timer, -1);
+  return TRUE;
+}
+
+
+/*
+ * Close the events.  This must be called before the timer is freed, if
+ * jstage_start() has been called.
+ */
+
+GLOBAL(void)
+jstage_close_events(struct jpeg_stage_timer *timer)
+{
+  if (timer->events_state > 0)
+    close_events(timer);
+  timer->events_state = 0;
+}
+
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+
+/*
+ * Read one counter with RDPMC, using the protocol documented in
+ * linux/perf_event.h.  Returns FALSE if user-mode reads are disabled or the
+ * event is not currently scheduled on the PMU.
+ */
+
+LOCAL(boolean)
+read_counter_rdpmc(volatile struct perf_event_mmap_page *pc,
+                   unsigned long long *value)
+{
+  unsigned int seq, idx, lo, hi;
+  long long count;
+  int width;
+
+  do {
+    seq = pc->lock;
+    __asm__ __volatile__("" : : : "memory");
+    idx = pc->index;
+    if (!pc->cap_user_rdpmc || idx == 0)
+      return FALSE;
+    width = pc->pmc_width;
+    __asm__ __volatile__("rdpmc" : "=a" (lo), "=d" (hi) : "c" (idx - 1));
+    /* Sign-extend the raw counter value to 64 bits. */
+    count = (long long)(((unsigned long long)hi << 32) | lo);
+    count = (long long)((unsigned long long)count << (64 - width)) >>
+            (64 - width);
+    count += pc->offset;
+    __asm__ __volatile__("" : : : "memory");
+  } while (pc->lock != seq);
+
+  *value = (unsigned long long)count;
+  return TRUE;
+}
+
+#endif
+
+
+/*
+ * Read all of the counters.  Returns FALSE if they could not be read.
+ */
+
+LOCAL(boolean)
+read_events(struct jpeg_stage_timer *timer, unsigned long long *values)
+{
+  /* read() returns the number of events followed by the count for each */
+  unsigned long long buf[1 + JSTAGE_NUM_EVENTS];
+  int i, leader = -1, n = 0;
+  ssize_t bytes;
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  for (i = 0; i < JSTAGE_NUM_EVENTS; i++) {
+    if (timer->event_fd[i] < 0)
+      continue;
+    if (timer->event_page[i] == NULL ||
+        !read_counter_rdpmc(
+          (volatile struct perf_event_mmap_page *)timer->event_page[i],
+          &values[i]))
+      break;
+  }
+  if (i == JSTAGE_NUM_EVENTS)
+    return TRUE;
+#endif
+
+  for (i = 0; i < JSTAGE_NUM_EVENTS; i++) {
+    if (timer->event_fd[i] < 0)
+      continue;
+    if (leader < 0)
+      leader = timer->event_fd[i];
+    n++;
+  }
+  bytes = read(leader, buf, sizeof(buf));
+  if (bytes < (ssize_t)((1 + n) * sizeof(unsigned long long)) ||
+      buf[0] != (unsigned long long)n)
+    return FALSE;
+
+  /* The counts are in the order in which the events were added to the
+   * group.
+   */
+  n = 1;
+  for (i = 0; i < JSTAGE_NUM_EVENTS; i++) {
+    if (timer->event_fd[i] >= 0)
+      values[i] = buf[n++];
+  }
+  return TRUE;
+}
+
+
+/*
+ * Charge the events since the last stage change to the given stage (or, if
+ * stage is negative, discard them.)
+ */
+
+GLOBAL(void)
+jstage_count_events(struct jpeg_stage_timer *timer, int stage)
+{
+  unsigned long long values[JSTAGE_NUM_EVENTS];
+  int i;
+
+  if (!read_events(timer, values))
+    return;
+
+  for (i = 0; i < JSTAGE_NUM_EVENTS; i++) {
+    if (timer->event_fd[i] < 0)
+      continue;
+    if (stage >= 0)
+      timer->events[stage][i] += values[i] - timer->event_start[i];
+    timer->event_start[i] = values[i];
+  }
+}
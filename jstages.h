@@ -0,0 +1,219 @@
+/*
+ * jstages.h
+ *
+ * libjpeg-turbo Modifications:
+ * Copyright (C) 2022, D. R. Commander.
+ * For conditions of distribution and use, see the accompanying README.ijg
+ * file.
+ *
+ * This file contains the optional per-stage timer for the compression and
+ * decompression pipelines.  When cinfo->master->stage_timer is non-NULL, the
+ * modules charge the time spent in each stage (marker processing, entropy
+ * coding, DCT, resampling, color conversion, and source/destination I/O) to
+ * the corresponding bucket.  Time spent in nested stages (for instance, a
+ * fill_input_buffer() call made by the entropy decoder) is charged only to
+ * the innermost stage, so the buckets add up to the elapsed time between
+ * jstage_start() and jstage_stop().
+ *
+ * The timer reads the CPU's cycle counter where one is available, so the
+ * values are meaningful only relative to each other.  When the timer is NULL,
+ * the cost of each hook is a single test and branch.
+ *
+ * If libjpeg-turbo was built with WITH_PERF_COUNTERS, the timer also charges
+ * hardware performance events (cycles, instructions, branch misses, and cache
+ * misses) to each stage, using the Linux perf_event_open() interface.  The
+ * counters are opened the first time that jstage_start() is called, and they
+ * count only the thread that opened them.  See jstages.c.
+ */
+
+#ifndef JSTAGES_H
+#define JSTAGES_H
+
+/* Pipeline stages.  These must match the TJSTAGE_* values in turbojpeg.h. */
+
+#define JSTAGE_OTHER    0       /* not attributed to any of the below */
+#define JSTAGE_MARKERS  1       /* marker reading/writing */
+#define JSTAGE_ENTROPY  2       /* entropy decoding/encoding */
+#define JSTAGE_DCT      3       /* IDCT + dequantization, FDCT + quantization */
+#define JSTAGE_SAMPLE   4       /* upsampling/downsampling */
+#define JSTAGE_COLOR    5       /* color conversion (incl. merged upsampling) */
+#define JSTAGE_IO       6       /* source/destination manager */
+
+#define JSTAGE_NUM  7
+
+#define JSTAGE_MAX_DEPTH  4     /* deepest nesting of stages we track */
+
+#ifdef WITH_PERF_COUNTERS
+
+/* Hardware performance events.  These must match the TJCOUNTER_* values in
+ * turbojpeg.h.
+ */
+
+#define JSTAGE_EV_CYCLES        0       /* CPU cycles */
+#define JSTAGE_EV_INSTRUCTIONS  1       /* instructions retired */
+#define JSTAGE_EV_BRANCH_MISSES 2       /* mispredicted branches */
+#define JSTAGE_EV_L1D_MISSES    3       /* L1 data cache read misses */
+#define JSTAGE_EV_LLC_MISSES    4       /* last-level cache read misses */
+
+#define JSTAGE_NUM_EVENTS  5
+
+#endif
+
+
+/* Read the cycle counter (or the best available substitute.) */
+
+#if defined(_MSC_VER) && defined(HAVE_INTRIN_H) && \
+    (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define jstage_counter()  ((unsigned long long)__rdtsc())
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+static INLINE unsigned long long jstage_counter(void)
+{
+  unsigned int lo, hi;
+
+  __asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((unsigned long long)hi << 32) | lo;
+}
+#elif defined(__GNUC__) && defined(__aarch64__)
+static INLINE unsigned long long jstage_counter(void)
+{
+  unsigned long long val;
+
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r" (val));
+  return val;
+}
+#else
+#include <time.h>
+#define jstage_counter()  ((unsigned long long)clock())
+#endif
+
+
+struct jpeg_stage_timer {
+  unsigned long long ticks[JSTAGE_NUM]; /* accumulated time per stage */
+  unsigned long long start;     /* counter value at the last stage change */
+  int stack[JSTAGE_MAX_DEPTH];  /* stages that are currently active */
+  int depth;                    /* index of innermost active stage in stack */
+#ifdef WITH_PERF_COUNTERS
+  /* accumulated hardware events per stage */
+  unsigned long long events[JSTAGE_NUM][JSTAGE_NUM_EVENTS];
+  /* event counts at the last stage change */
+  unsigned long long event_start[JSTAGE_NUM_EVENTS];
+  int event_fd[JSTAGE_NUM_EVENTS];  /* -1 if the event is not available */
+  void *event_page[JSTAGE_NUM_EVENTS];  /* mmap()ed event pages, or NULL */
+  int events_state;             /* 0 = not opened, 1 = open, -1 = failed */
+#endif
+};
+
+
+#ifdef WITH_PERF_COUNTERS
+
+EXTERN(boolean) jstage_open_events(struct jpeg_stage_timer *timer);
+EXTERN(void) jstage_close_events(struct jpeg_stage_timer *timer);
+EXTERN(void) jstage_count_events(struct jpeg_stage_timer *timer, int stage);
+
+/* Charge the events since the last stage change to the given stage (or, if
+ * stage is negative, discard them.)
+ */
+
+#define JSTAGE_COUNT_EVENTS(timer, stage) \
+  ((timer)->events_state > 0 ? jstage_count_events(timer, stage) : (void)0)
+
+#else
+
+#define JSTAGE_COUNT_EVENTS(timer, stage)  ((void)0)
+
+#endif
+
+
+/* Charge the time since the last stage change to the innermost stage, then
+ * make the given stage the innermost one.
+ */
+
+static INLINE void jstage_begin(struct jpeg_stage_timer *timer, int stage)
+{
+  unsigned long long now = jstage_counter();
+
+  timer->ticks[timer->stack[timer->depth]] += now - timer->start;
+  timer->start = now;
+  JSTAGE_COUNT_EVENTS(timer, timer->stack[timer->depth]);
+  if (timer->depth < JSTAGE_MAX_DEPTH - 1)
+    timer->depth++;
+  timer->stack[timer->depth] = stage;
+}
+
+/* Charge the time since the last stage change to the innermost stage, then
+ * return to the enclosing stage.
+ */
+
+static INLINE void jstage_end(struct jpeg_stage_timer *timer)
+{
+  unsigned long long now = jstage_counter();
+
+  timer->ticks[timer->stack[timer->depth]] += now - timer->start;
+  timer->start = now;
+  JSTAGE_COUNT_EVENTS(timer, timer->stack[timer->depth]);
+  if (timer->depth > 0)
+    timer->depth--;
+}
+
+/* Start timing an API call.  Everything not attributed to a specific stage is
+ * charged to JSTAGE_OTHER.  This also recovers from an error exit that
+ * abandoned a stage without ending it.  The timer must have been zeroed before
+ * its first use.
+ */
+
+static INLINE void jstage_start(struct jpeg_stage_timer *timer)
+{
+#ifdef WITH_PERF_COUNTERS
+  if (timer->events_state == 0)
+    jstage_open_events(timer);
+#endif
+  timer->depth = 0;
+  timer->stack[0] = JSTAGE_OTHER;
+  timer->start = jstage_counter();
+  JSTAGE_COUNT_EVENTS(timer, -1);
+}
+
+/* Stop timing an API call. */
+
+static INLINE void jstage_stop(struct jpeg_stage_timer *timer)
+{
+  timer->depth = 0;
+  jstage_end(timer);
+}
+
+
+/* Hooks used by the library modules.  The timer argument is normally a local
+ * copy of cinfo->master->stage_timer.
+ */
+
+#define JSTAGE_BEGIN(timer, stage) \
+  ((timer) != NULL ? jstage_begin(timer, stage) : (void)0)
+#define JSTAGE_END(timer) \
+  ((timer) != NULL ? jstage_end(timer) : (void)0)
+
+/* Source/destination manager calls, which are charged to JSTAGE_IO */
+
+static INLINE boolean jstage_fill_input_buffer(j_decompress_ptr cinfo)
+{
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
+  boolean retval;
+
+  JSTAGE_BEGIN(timer, JSTAGE_IO);
+  retval = (*cinfo->src->fill_input_buffer) (cinfo);
+  JSTAGE_END(timer);
+  return retval;
+}
+
+static INLINE boolean jstage_empty_output_buffer(j_compress_ptr cinfo)
+{
+  struct jpeg_stage_timer *timer = cinfo->master->stage_timer;
+  boolean retval;
+
+  JSTAGE_BEGIN(timer, JSTAGE_IO);
+  retval = (*cinfo->dest->empty_output_buffer) (cinfo);
+  JSTAGE_END(timer);
+  return retval;
+}
+
+#endif /* JSTAGES_H */
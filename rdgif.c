@@ -44,8 +44,10 @@ typedef unsigned char U_CHAR;
 #define UCH(x)  ((int)(x))
 
 
-#define ReadOK(file, buffer, len) \
-  (fread(buffer, 1, len, file) == ((size_t)(len)))
+#define ReadOK(sinfo, buffer, len) \
+  (ReadBytes(sinfo, buffer, (size_t)(len)) == ((size_t)(len)))
+
+#define INPUT_BUF_SIZE   4096   /* choose an efficiently fread'able size */
 
 
 #define MAXCOLORMAPSIZE  256    /* max # of colors in a GIF colormap */
@@ -72,13 +74,19 @@ typedef unsigned char U_CHAR;
  * LZW decompression tables look like this:
  *   symbol_head[K] = prefix symbol of any LZW symbol K (0..LZW_TABLE_SIZE-1)
  *   symbol_tail[K] = suffix byte   of any LZW symbol K (0..LZW_TABLE_SIZE-1)
- * Note that entries 0..end_code of the above tables are not used,
- * since those symbols represent raw bytes or special codes.
+ *   symbol_len[K]  = # of bytes in the expansion of LZW symbol K
+ * Note that entries 0..end_code of the head and tail tables are not used,
+ * since those symbols represent raw bytes or special codes.  The length of
+ * each raw-byte symbol is 1.
  *
- * The stack represents the not-yet-used expansion of the last LZW symbol.
- * In the worst case, a symbol could expand to as many bytes as there are
- * LZW symbols, so we allocate LZW_TABLE_SIZE bytes for the stack.
- * (This is conservative since that number includes the raw-byte symbols.)
+ * Knowing the length of a symbol's expansion in advance allows the expansion
+ * to be written back-to-front directly into the output row, rather than
+ * being pushed onto a stack and popped one byte at a time.  Only an
+ * expansion that straddles the end of a row goes through the string buffer,
+ * which holds the not-yet-used tail of the last LZW symbol.  In the worst
+ * case, a symbol could expand to as many bytes as there are LZW symbols, so
+ * we allocate LZW_TABLE_SIZE bytes for the buffer.  (This is conservative
+ * since that number includes the raw-byte symbols.)
  */
 
 
@@ -91,11 +99,17 @@ typedef struct {
 
   JSAMPARRAY colormap;          /* GIF colormap (converted to my format) */
 
-  /* State for GetCode and LZWReadByte */
-  U_CHAR code_buf[256 + 4];     /* current input data block */
+  /* Input buffer for the GIF file */
+  U_CHAR *inbuf;                /* start of buffer */
+  U_CHAR *next_input_byte;      /* => next byte to read from buffer */
+  size_t bytes_in_buffer;       /* # of bytes remaining in buffer */
+
+  /* State for GetCode and LZWReadRow */
+  U_CHAR code_buf[256];         /* current input data block */
   int last_byte;                /* # of bytes in code_buf */
-  int last_bit;                 /* # of bits in code_buf */
-  int cur_bit;                  /* next bit index to read */
+  int next_byte;                /* index of next byte to read in code_buf */
+  unsigned int bit_accum;       /* bits read from code_buf but not yet used */
+  int bits_left;                /* # of valid bits in bit_accum */
   boolean first_time;           /* flags first call to GetCode */
   boolean out_of_blocks;        /* TRUE if hit terminator data block */
 
@@ -106,19 +120,21 @@ typedef struct {
   int limit_code;               /* 2^code_size */
   int max_code;                 /* first unused code value */
 
-  /* Private state for LZWReadByte */
+  /* Private state for LZWReadRow */
   int oldcode;                  /* previous LZW symbol */
   int firstcode;                /* first byte of oldcode's expansion */
 
-  /* LZW symbol table and expansion stack */
+  /* LZW symbol table and string buffer */
   UINT16 *symbol_head;          /* => table of prefix symbols */
   UINT8  *symbol_tail;          /* => table of suffix bytes */
-  UINT8  *symbol_stack;         /* => stack for symbol expansions */
-  UINT8  *sp;                   /* stack pointer */
+  UINT16 *symbol_len;           /* => table of expansion lengths */
+  UINT8  *string_buf;           /* => buffer for straddling expansions */
+  UINT8  *string_ptr;           /* => next unused byte in string_buf */
+  UINT8  *string_end;           /* => end of valid data in string_buf */
 
   /* State for interlaced image processing */
   boolean is_interlaced;        /* TRUE if have interlaced image */
-  jvirt_sarray_ptr interlaced_image; /* full image in interlaced order */
+  jvirt_sarray_ptr interlaced_image; /* passes 1-3 in interlaced order */
   JDIMENSION cur_row_number;    /* need to know actual row number */
   JDIMENSION pass2_offset;      /* # of pixel rows in pass 1 */
   JDIMENSION pass3_offset;      /* # of pixel rows in passes 1&2 */
@@ -137,16 +153,52 @@ METHODDEF(JDIMENSION) get_interlaced_row(j_compress_ptr cinfo,
                                          cjpeg_source_ptr sinfo);
 
 
+LOCAL(boolean)
+FillInputBuffer(gif_source_ptr sinfo)
+/* Reload the input buffer; return FALSE at end of file */
+{
+  size_t nbytes;
+
+  nbytes = fread(sinfo->inbuf, 1, INPUT_BUF_SIZE, sinfo->pub.input_file);
+  sinfo->next_input_byte = sinfo->inbuf;
+  sinfo->bytes_in_buffer = nbytes;
+  return (nbytes > 0);
+}
+
+
 LOCAL(int)
 ReadByte(gif_source_ptr sinfo)
 /* Read next byte from GIF file */
 {
-  register FILE *infile = sinfo->pub.input_file;
-  register int c;
+  if (sinfo->bytes_in_buffer == 0) {
+    if (!FillInputBuffer(sinfo))
+      ERREXIT(sinfo->cinfo, JERR_INPUT_EOF);
+  }
+  sinfo->bytes_in_buffer--;
+  return UCH(*sinfo->next_input_byte++);
+}
 
-  if ((c = getc(infile)) == EOF)
-    ERREXIT(sinfo->cinfo, JERR_INPUT_EOF);
-  return c;
+
+LOCAL(size_t)
+ReadBytes(gif_source_ptr sinfo, U_CHAR *buf, size_t len)
+/* Read up to len bytes from GIF file; return # of bytes read */
+{
+  size_t nread = 0, n;
+
+  while (nread < len) {
+    if (sinfo->bytes_in_buffer == 0) {
+      if (!FillInputBuffer(sinfo))
+        break;
+    }
+    n = len - nread;
+    if (n > sinfo->bytes_in_buffer)
+      n = sinfo->bytes_in_buffer;
+    memcpy(buf + nread, sinfo->next_input_byte, n);
+    sinfo->next_input_byte += n;
+    sinfo->bytes_in_buffer -= n;
+    nread += n;
+  }
+  return nread;
 }
 
 
@@ -159,7 +211,7 @@ GetDataBlock(gif_source_ptr sinfo, U_CHAR *buf)
 
   count = ReadByte(sinfo);
   if (count > 0) {
-    if (!ReadOK(sinfo->pub.input_file, buf, count))
+    if (!ReadOK(sinfo, buf, count))
       ERREXIT(sinfo->cinfo, JERR_INPUT_EOF);
   }
   return count;
@@ -184,27 +236,30 @@ ReInitLZW(gif_source_ptr sinfo)
   sinfo->code_size = sinfo->input_code_size + 1;
   sinfo->limit_code = sinfo->clear_code << 1;   /* 2^code_size */
   sinfo->max_code = sinfo->clear_code + 2;      /* first unused code value */
-  sinfo->sp = sinfo->symbol_stack;              /* init stack to empty */
+  sinfo->string_ptr = sinfo->string_end = sinfo->string_buf; /* no string */
 }
 
 
 LOCAL(void)
 InitLZWCode(gif_source_ptr sinfo)
-/* Initialize for a series of LZWReadByte (and hence GetCode) calls */
+/* Initialize for a series of LZWReadRow (and hence GetCode) calls */
 {
+  int i;
+
   /* GetCode initialization */
-  sinfo->last_byte = 2;         /* make safe to "recopy last two bytes" */
-  sinfo->code_buf[0] = 0;
-  sinfo->code_buf[1] = 0;
-  sinfo->last_bit = 0;          /* nothing in the buffer */
-  sinfo->cur_bit = 0;           /* force buffer load on first call */
-  sinfo->first_time = TRUE;
+  sinfo->last_byte = 0;         /* nothing in the buffer */
+  sinfo->next_byte = 0;
+  sinfo->bit_accum = 0;
+  sinfo->bits_left = 0;
+  sinfo->first_time = TRUE;     /* force Clear code on first call */
   sinfo->out_of_blocks = FALSE;
 
-  /* LZWReadByte initialization: */
+  /* LZWReadRow initialization: */
   /* compute special code values (note that these do not change later) */
   sinfo->clear_code = 1 << sinfo->input_code_size;
   sinfo->end_code = sinfo->clear_code + 1;
+  for (i = 0; i < sinfo->clear_code; i++)
+    sinfo->symbol_len[i] = 1;
   ReInitLZW(sinfo);
 }
 
@@ -214,130 +269,169 @@ GetCode(gif_source_ptr sinfo)
 /* Fetch the next code_size bits from the GIF data */
 /* We assume code_size is less than 16 */
 {
-  register int accum;
-  int offs, count;
-
-  while (sinfo->cur_bit + sinfo->code_size > sinfo->last_bit) {
-    /* Time to reload the buffer */
-    /* First time, share code with Clear case */
-    if (sinfo->first_time) {
-      sinfo->first_time = FALSE;
-      return sinfo->clear_code;
+  register unsigned int accum = sinfo->bit_accum;
+  register int bits_left = sinfo->bits_left;
+  int code, count;
+
+  while (bits_left < sinfo->code_size) {
+    if (sinfo->next_byte >= sinfo->last_byte) {
+      /* Time to reload the buffer */
+      /* First time, share code with Clear case */
+      if (sinfo->first_time) {
+        sinfo->first_time = FALSE;
+        return sinfo->clear_code;
+      }
+      if (sinfo->out_of_blocks) {
+        WARNMS(sinfo->cinfo, JWRN_GIF_NOMOREDATA);
+        return sinfo->end_code; /* fake something useful */
+      }
+      /* Load more bytes; set flag if we reach the terminator block */
+      if ((count = GetDataBlock(sinfo, sinfo->code_buf)) == 0) {
+        sinfo->out_of_blocks = TRUE;
+        WARNMS(sinfo->cinfo, JWRN_GIF_NOMOREDATA);
+        return sinfo->end_code; /* fake something useful */
+      }
+      /* Reset counters */
+      sinfo->next_byte = 0;
+      sinfo->last_byte = count;
     }
-    if (sinfo->out_of_blocks) {
-      WARNMS(sinfo->cinfo, JWRN_GIF_NOMOREDATA);
-      return sinfo->end_code;   /* fake something useful */
-    }
-    /* preserve last two bytes of what we have -- assume code_size <= 16 */
-    sinfo->code_buf[0] = sinfo->code_buf[sinfo->last_byte-2];
-    sinfo->code_buf[1] = sinfo->code_buf[sinfo->last_byte-1];
-    /* Load more bytes; set flag if we reach the terminator block */
-    if ((count = GetDataBlock(sinfo, &sinfo->code_buf[2])) == 0) {
-      sinfo->out_of_blocks = TRUE;
-      WARNMS(sinfo->cinfo, JWRN_GIF_NOMOREDATA);
-      return sinfo->end_code;   /* fake something useful */
-    }
-    /* Reset counters */
-    sinfo->cur_bit = (sinfo->cur_bit - sinfo->last_bit) + 16;
-    sinfo->last_byte = 2 + count;
-    sinfo->last_bit = sinfo->last_byte * 8;
+    accum |= ((unsigned int)sinfo->code_buf[sinfo->next_byte++]) << bits_left;
+    bits_left += 8;
   }
 
-  /* Form up next 24 bits in accum */
-  offs = sinfo->cur_bit >> 3;   /* byte containing cur_bit */
-  accum = UCH(sinfo->code_buf[offs + 2]);
-  accum <<= 8;
-  accum |= UCH(sinfo->code_buf[offs + 1]);
-  accum <<= 8;
-  accum |= UCH(sinfo->code_buf[offs]);
-
-  /* Right-align cur_bit in accum, then mask off desired number of bits */
-  accum >>= (sinfo->cur_bit & 7);
-  sinfo->cur_bit += sinfo->code_size;
-  return accum & ((1 << sinfo->code_size) - 1);
+  /* Take the desired number of bits from the bottom of accum */
+  code = (int)(accum & ((1U << sinfo->code_size) - 1));
+  sinfo->bit_accum = accum >> sinfo->code_size;
+  sinfo->bits_left = bits_left - sinfo->code_size;
+  return code;
 }
 
 
-LOCAL(int)
-LZWReadByte(gif_source_ptr sinfo)
-/* Read an LZW-compressed byte */
+LOCAL(void)
+LZWReadRow(gif_source_ptr sinfo, JSAMPROW outptr, JDIMENSION width)
+/* Read width LZW-compressed bytes into outptr */
 {
   register int code;            /* current working code */
   int incode;                   /* saves actual input code */
-
-  /* If any codes are stacked from a previously read symbol, return them */
-  if (sinfo->sp > sinfo->symbol_stack)
-    return (int)(*(--sinfo->sp));
-
-  /* Time to read a new symbol */
-  code = GetCode(sinfo);
-
-  if (code == sinfo->clear_code) {
-    /* Reinit state, swallow any extra Clear codes, and */
-    /* return next code, which is expected to be a raw byte. */
-    ReInitLZW(sinfo);
-    do {
-      code = GetCode(sinfo);
-    } while (code == sinfo->clear_code);
-    if (code > sinfo->clear_code) { /* make sure it is a raw byte */
-      WARNMS(sinfo->cinfo, JWRN_GIF_BADDATA);
-      code = 0;                 /* use something valid */
+  boolean is_new_symbol;        /* TRUE if code is not yet in table */
+  register JSAMPROW ptr;
+  register UINT8 *sptr;
+  register UINT16 *symbol_head = sinfo->symbol_head;
+  register UINT8 *symbol_tail = sinfo->symbol_tail;
+  UINT16 *symbol_len = sinfo->symbol_len;
+  int clear_code = sinfo->clear_code;
+  JDIMENSION len;
+
+  while (width > 0) {
+    /* If any bytes are left from a previously read symbol, return them */
+    if (sinfo->string_ptr < sinfo->string_end) {
+      len = (JDIMENSION)(sinfo->string_end - sinfo->string_ptr);
+      if (len > width)
+        len = width;
+      width -= len;
+      while (len-- > 0)
+        *outptr++ = (JSAMPLE)(*sinfo->string_ptr++);
+      continue;
     }
-    /* make firstcode, oldcode valid! */
-    sinfo->firstcode = sinfo->oldcode = code;
-    return code;
-  }
 
-  if (code == sinfo->end_code) {
-    /* Skip the rest of the image, unless GetCode already read terminator */
-    if (!sinfo->out_of_blocks) {
-      SkipDataBlocks(sinfo);
-      sinfo->out_of_blocks = TRUE;
+    /* Time to read a new symbol */
+    code = GetCode(sinfo);
+
+    if (code == clear_code) {
+      /* Reinit state, swallow any extra Clear codes, and */
+      /* return next code, which is expected to be a raw byte. */
+      ReInitLZW(sinfo);
+      do {
+        code = GetCode(sinfo);
+      } while (code == clear_code);
+      if (code > clear_code) {  /* make sure it is a raw byte */
+        WARNMS(sinfo->cinfo, JWRN_GIF_BADDATA);
+        code = 0;               /* use something valid */
+      }
+      /* make firstcode, oldcode valid! */
+      sinfo->firstcode = sinfo->oldcode = code;
+      *outptr++ = (JSAMPLE)code;
+      width--;
+      continue;
     }
-    /* Complain that there's not enough data */
-    WARNMS(sinfo->cinfo, JWRN_GIF_ENDCODE);
-    /* Pad data with 0's */
-    return 0;                   /* fake something usable */
-  }
 
-  /* Got normal raw byte or LZW symbol */
-  incode = code;                /* save for a moment */
+    if (code == sinfo->end_code) {
+      /* Skip the rest of the image, unless GetCode already read terminator */
+      if (!sinfo->out_of_blocks) {
+        SkipDataBlocks(sinfo);
+        sinfo->out_of_blocks = TRUE;
+      }
+      /* Complain that there's not enough data */
+      WARNMS(sinfo->cinfo, JWRN_GIF_ENDCODE);
+      /* Pad data with 0's */
+      *outptr++ = 0;            /* fake something usable */
+      width--;
+      continue;
+    }
 
-  if (code >= sinfo->max_code) { /* special case for not-yet-defined symbol */
-    /* code == max_code is OK; anything bigger is bad data */
-    if (code > sinfo->max_code) {
-      WARNMS(sinfo->cinfo, JWRN_GIF_BADDATA);
-      incode = 0;               /* prevent creation of loops in symbol table */
+    /* Got normal raw byte or LZW symbol */
+    incode = code;              /* save for a moment */
+
+    if (code >= sinfo->max_code) { /* special case for not-yet-defined symbol */
+      /* code == max_code is OK; anything bigger is bad data */
+      if (code > sinfo->max_code) {
+        WARNMS(sinfo->cinfo, JWRN_GIF_BADDATA);
+        incode = 0;             /* prevent creation of loops in symbol table */
+      }
+      /* this symbol will be defined as oldcode/firstcode */
+      code = sinfo->oldcode;
+      is_new_symbol = TRUE;
+      len = (JDIMENSION)symbol_len[code] + 1;
+    } else {
+      is_new_symbol = FALSE;
+      len = (JDIMENSION)symbol_len[code];
     }
-    /* this symbol will be defined as oldcode/firstcode */
-    *(sinfo->sp++) = (UINT8)sinfo->firstcode;
-    code = sinfo->oldcode;
-  }
 
-  /* If it's a symbol, expand it into the stack */
-  while (code >= sinfo->clear_code) {
-    *(sinfo->sp++) = sinfo->symbol_tail[code]; /* tail is a byte value */
-    code = sinfo->symbol_head[code]; /* head is another LZW symbol */
-  }
-  /* At this point code just represents a raw byte */
-  sinfo->firstcode = code;      /* save for possible future use */
-
-  /* If there's room in table... */
-  if ((code = sinfo->max_code) < LZW_TABLE_SIZE) {
-    /* Define a new symbol = prev sym + head of this sym's expansion */
-    sinfo->symbol_head[code] = (UINT16)sinfo->oldcode;
-    sinfo->symbol_tail[code] = (UINT8)sinfo->firstcode;
-    sinfo->max_code++;
-    /* Is it time to increase code_size? */
-    if (sinfo->max_code >= sinfo->limit_code &&
-        sinfo->code_size < MAX_LZW_BITS) {
-      sinfo->code_size++;
-      sinfo->limit_code <<= 1;  /* keep equal to 2^code_size */
+    /* Expand the symbol back-to-front, directly into the output row if it
+     * fits, otherwise into the string buffer.
+     */
+    if (len <= width) {
+      outptr += len;
+      width -= len;
+      ptr = outptr;
+      if (is_new_symbol)
+        *(--ptr) = (JSAMPLE)sinfo->firstcode;
+      while (code >= clear_code) {
+        *(--ptr) = (JSAMPLE)symbol_tail[code]; /* tail is a byte value */
+        code = symbol_head[code]; /* head is another LZW symbol */
+      }
+      *(--ptr) = (JSAMPLE)code;
+    } else {
+      sptr = sinfo->string_end = sinfo->string_buf + len;
+      sinfo->string_ptr = sinfo->string_buf;
+      if (is_new_symbol)
+        *(--sptr) = (UINT8)sinfo->firstcode;
+      while (code >= clear_code) {
+        *(--sptr) = symbol_tail[code];
+        code = symbol_head[code];
+      }
+      *(--sptr) = (UINT8)code;
+    }
+    /* At this point code just represents a raw byte */
+    sinfo->firstcode = code;    /* save for possible future use */
+
+    /* If there's room in table... */
+    if ((code = sinfo->max_code) < LZW_TABLE_SIZE) {
+      /* Define a new symbol = prev sym + head of this sym's expansion */
+      symbol_head[code] = (UINT16)sinfo->oldcode;
+      symbol_tail[code] = (UINT8)sinfo->firstcode;
+      symbol_len[code] = (UINT16)(symbol_len[sinfo->oldcode] + 1);
+      sinfo->max_code++;
+      /* Is it time to increase code_size? */
+      if (sinfo->max_code >= sinfo->limit_code &&
+          sinfo->code_size < MAX_LZW_BITS) {
+        sinfo->code_size++;
+        sinfo->limit_code <<= 1;  /* keep equal to 2^code_size */
+      }
     }
-  }
 
-  sinfo->oldcode = incode;      /* save last input symbol for future use */
-  return sinfo->firstcode;      /* return first byte of symbol's expansion */
+    sinfo->oldcode = incode;    /* save last input symbol for future use */
+  }
 }
 
 
@@ -397,7 +491,7 @@ start_input_gif(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
   int c;
 
   /* Read and verify GIF Header */
-  if (!ReadOK(source->pub.input_file, hdrbuf, 6))
+  if (!ReadOK(source, hdrbuf, 6))
     ERREXIT(cinfo, JERR_GIF_NOT);
   if (hdrbuf[0] != 'G' || hdrbuf[1] != 'I' || hdrbuf[2] != 'F')
     ERREXIT(cinfo, JERR_GIF_NOT);
@@ -410,7 +504,7 @@ start_input_gif(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
     TRACEMS3(cinfo, 1, JTRC_GIF_BADVERSION, hdrbuf[3], hdrbuf[4], hdrbuf[5]);
 
   /* Read and decipher Logical Screen Descriptor */
-  if (!ReadOK(source->pub.input_file, hdrbuf, 7))
+  if (!ReadOK(source, hdrbuf, 7))
     ERREXIT(cinfo, JERR_INPUT_EOF);
   width = LM_to_uint(hdrbuf, 0);
   height = LM_to_uint(hdrbuf, 2);
@@ -458,7 +552,7 @@ start_input_gif(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
     }
 
     /* Read and decipher Local Image Descriptor */
-    if (!ReadOK(source->pub.input_file, hdrbuf, 9))
+    if (!ReadOK(source, hdrbuf, 9))
       ERREXIT(cinfo, JERR_INPUT_EOF);
     /* we ignore top/left position info, also sort flag */
     width = LM_to_uint(hdrbuf, 4);
@@ -497,24 +591,32 @@ start_input_gif(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
   source->symbol_tail = (UINT8 *)
     (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
                                 LZW_TABLE_SIZE * sizeof(UINT8));
-  source->symbol_stack = (UINT8 *)
+  source->symbol_len = (UINT16 *)
+    (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                LZW_TABLE_SIZE * sizeof(UINT16));
+  source->string_buf = (UINT8 *)
     (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
                                 LZW_TABLE_SIZE * sizeof(UINT8));
   InitLZWCode(source);
 
   /*
-   * If image is interlaced, we read it into a full-size sample array,
-   * decompressing as we go; then get_interlaced_row selects rows from the
-   * sample array in the proper order.
+   * If image is interlaced, we read the first three passes (which contain
+   * all of the even-numbered rows) into a sample array, decompressing as we
+   * go.  The fourth pass contains the odd-numbered rows in order, so
+   * get_interlaced_row can then alternate between selecting a row from the
+   * sample array and decompressing a row directly from the GIF file.
    */
   if (source->is_interlaced) {
+    source->pass2_offset = (height + 7) / 8;
+    source->pass3_offset = source->pass2_offset + (height + 3) / 8;
+    source->pass4_offset = source->pass3_offset + (height + 1) / 4;
     /* We request the virtual array now, but can't access it until virtual
      * arrays have been allocated.  Hence, the actual work of reading the
      * image is postponed until the first call to get_pixel_rows.
      */
     source->interlaced_image = (*cinfo->mem->request_virt_sarray)
       ((j_common_ptr)cinfo, JPOOL_IMAGE, FALSE,
-       (JDIMENSION)width, (JDIMENSION)height, (JDIMENSION)1);
+       (JDIMENSION)width, source->pass4_offset, (JDIMENSION)1);
     if (cinfo->progress != NULL) {
       cd_progress_ptr progress = (cd_progress_ptr)cinfo->progress;
       progress->total_extra_passes++; /* count file input as separate pass */
@@ -552,15 +654,15 @@ start_input_gif(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
 
 
 /*
- * Read one row of pixels.
- * This version is used for noninterlaced GIF images:
- * we read directly from the GIF file.
+ * Convert one row of colormap indices into pixels in the compressor input
+ * buffer.  inptr may point into the last image_width samples of the input
+ * buffer, since each index is read before it can be overwritten.
  */
 
-METHODDEF(JDIMENSION)
-get_pixel_rows(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
+LOCAL(void)
+expand_colormap_row(j_compress_ptr cinfo, gif_source_ptr source,
+                    JSAMPROW inptr)
 {
-  gif_source_ptr source = (gif_source_ptr)sinfo;
   register int c;
   register JSAMPROW ptr;
   register JDIMENSION col;
@@ -569,17 +671,49 @@ get_pixel_rows(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
   ptr = source->pub.buffer[0];
   if (cinfo->in_color_space == JCS_GRAYSCALE) {
     for (col = cinfo->image_width; col > 0; col--) {
-      c = LZWReadByte(source);
+      c = *inptr++;
       *ptr++ = colormap[CM_RED][c];
     }
   } else {
     for (col = cinfo->image_width; col > 0; col--) {
-      c = LZWReadByte(source);
+      c = *inptr++;
       *ptr++ = colormap[CM_RED][c];
       *ptr++ = colormap[CM_GREEN][c];
       *ptr++ = colormap[CM_BLUE][c];
     }
   }
+}
+
+
+/*
+ * Read one row of colormap indices from the GIF file into the last
+ * image_width samples of the compressor input buffer; return a pointer to
+ * them.
+ */
+
+LOCAL(JSAMPROW)
+read_index_row(j_compress_ptr cinfo, gif_source_ptr source)
+{
+  JSAMPROW ptr = source->pub.buffer[0] +
+    (JDIMENSION)(cinfo->input_components - 1) * cinfo->image_width;
+
+  LZWReadRow(source, ptr, cinfo->image_width);
+  return ptr;
+}
+
+
+/*
+ * Read one row of pixels.
+ * This version is used for noninterlaced GIF images:
+ * we read directly from the GIF file.
+ */
+
+METHODDEF(JDIMENSION)
+get_pixel_rows(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
+{
+  gif_source_ptr source = (gif_source_ptr)sinfo;
+
+  expand_colormap_row(cinfo, source, read_index_row(cinfo, source));
   return 1;
 }
 
@@ -587,31 +721,30 @@ get_pixel_rows(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
 /*
  * Read one row of pixels.
  * This version is used for the first call on get_pixel_rows when
- * reading an interlaced GIF file: we read the whole image into memory.
+ * reading an interlaced GIF file: we read the first three passes into memory.
  */
 
 METHODDEF(JDIMENSION)
 load_interlaced_image(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
 {
   gif_source_ptr source = (gif_source_ptr)sinfo;
-  register JSAMPROW sptr;
-  register JDIMENSION col;
+  JSAMPROW sptr;
   JDIMENSION row;
   cd_progress_ptr progress = (cd_progress_ptr)cinfo->progress;
 
-  /* Read the interlaced image into the virtual array we've created. */
-  for (row = 0; row < cinfo->image_height; row++) {
+  /* Read passes 1-3 of the interlaced image into the virtual array we've
+   * created.
+   */
+  for (row = 0; row < source->pass4_offset; row++) {
     if (progress != NULL) {
       progress->pub.pass_counter = (long)row;
-      progress->pub.pass_limit = (long)cinfo->image_height;
+      progress->pub.pass_limit = (long)source->pass4_offset;
       (*progress->pub.progress_monitor) ((j_common_ptr)cinfo);
     }
     sptr = *(*cinfo->mem->access_virt_sarray)
       ((j_common_ptr)cinfo, source->interlaced_image, row, (JDIMENSION)1,
        TRUE);
-    for (col = cinfo->image_width; col > 0; col--) {
-      *sptr++ = (JSAMPLE)LZWReadByte(source);
-    }
+    LZWReadRow(source, sptr, cinfo->image_width);
   }
   if (progress != NULL)
     progress->completed_extra_passes++;
@@ -620,9 +753,6 @@ load_interlaced_image(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
   source->pub.get_pixel_rows = get_interlaced_row;
   /* Initialize for get_interlaced_row, and perform first call on it. */
   source->cur_row_number = 0;
-  source->pass2_offset = (cinfo->image_height + 7) / 8;
-  source->pass3_offset = source->pass2_offset + (cinfo->image_height + 3) / 8;
-  source->pass4_offset = source->pass3_offset + (cinfo->image_height + 1) / 4;
 
   return get_interlaced_row(cinfo, sinfo);
 }
@@ -631,17 +761,15 @@ load_interlaced_image(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
 /*
  * Read one row of pixels.
  * This version is used for interlaced GIF images:
- * we read from the virtual array.
+ * we read even-numbered rows from the virtual array and odd-numbered rows
+ * (pass 4) directly from the GIF file.
  */
 
 METHODDEF(JDIMENSION)
 get_interlaced_row(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
 {
   gif_source_ptr source = (gif_source_ptr)sinfo;
-  register int c;
-  register JSAMPROW sptr, ptr;
-  register JDIMENSION col;
-  register JSAMPARRAY colormap = source->colormap;
+  JSAMPROW sptr;
   JDIMENSION irow;
 
   /* Figure out which row of interlaced image is needed, and access it. */
@@ -656,27 +784,17 @@ get_interlaced_row(j_compress_ptr cinfo, cjpeg_source_ptr sinfo)
   case 6:
     irow = (source->cur_row_number >> 2) + source->pass3_offset;
     break;
-  default:                      /* fourth-pass row */
-    irow = (source->cur_row_number >> 1) + source->pass4_offset;
+  default:                      /* fourth-pass row: next row in the file */
+    irow = source->pass4_offset;
   }
-  sptr = *(*cinfo->mem->access_virt_sarray)
-    ((j_common_ptr)cinfo, source->interlaced_image, irow, (JDIMENSION)1,
-     FALSE);
+  if (irow < source->pass4_offset)
+    sptr = *(*cinfo->mem->access_virt_sarray)
+      ((j_common_ptr)cinfo, source->interlaced_image, irow, (JDIMENSION)1,
+       FALSE);
+  else
+    sptr = read_index_row(cinfo, source);
   /* Scan the row, expand colormap, and output */
-  ptr = source->pub.buffer[0];
-  if (cinfo->in_color_space == JCS_GRAYSCALE) {
-    for (col = cinfo->image_width; col > 0; col--) {
-      c = *sptr++;
-      *ptr++ = colormap[CM_RED][c];
-    }
-  } else {
-    for (col = cinfo->image_width; col > 0; col--) {
-      c = *sptr++;
-      *ptr++ = colormap[CM_RED][c];
-      *ptr++ = colormap[CM_GREEN][c];
-      *ptr++ = colormap[CM_BLUE][c];
-    }
-  }
+  expand_colormap_row(cinfo, source, sptr);
   source->cur_row_number++;     /* for next time */
   return 1;
 }
@@ -710,6 +828,11 @@ jinit_read_gif(j_compress_ptr cinfo)
   /* Fill in method ptrs, except get_pixel_rows which start_input sets */
   source->pub.start_input = start_input_gif;
   source->pub.finish_input = finish_input_gif;
+  /* Allocate input buffer */
+  source->inbuf = (U_CHAR *)
+    (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
+                                INPUT_BUF_SIZE * sizeof(U_CHAR));
+  source->bytes_in_buffer = 0;
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
   source->pub.max_pixels = 0;
 #endif
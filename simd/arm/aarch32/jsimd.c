@@ -27,7 +27,7 @@
 
 #include <ctype.h>
 
-static THREAD_LOCAL unsigned int simd_support = ~0;
+static THREAD_LOCAL unsigned int cpu_support = ~0;
 static THREAD_LOCAL unsigned int simd_huffman = 1;
 
 #if !defined(__ARM_NEON__) && (defined(__linux__) || defined(ANDROID) || defined(__ANDROID__))
@@ -69,7 +69,7 @@ parse_proc_cpuinfo(int bufsize)
   char *buffer = (char *)malloc(bufsize);
   FILE *fd;
 
-  simd_support = 0;
+  cpu_support = 0;
 
   if (!buffer)
     return 0;
@@ -84,7 +84,7 @@ parse_proc_cpuinfo(int bufsize)
         return 0;
       }
       if (check_feature(buffer, "neon"))
-        simd_support |= JSIMD_NEON;
+        cpu_support |= JSIMD_NEON;
     }
     fclose(fd);
   }
@@ -107,13 +107,13 @@ init_simd(void)
   int bufsize = 1024; /* an initial guess for the line buffer size limit */
 #endif
 
-  if (simd_support != ~0U)
+  if (cpu_support != ~0U)
     return;
 
-  simd_support = 0;
+  cpu_support = 0;
 
 #if defined(__ARM_NEON__)
-  simd_support |= JSIMD_NEON;
+  cpu_support |= JSIMD_NEON;
 #elif defined(__linux__) || defined(ANDROID) || defined(__ANDROID__)
   /* We still have a chance to use Neon regardless of globally used
    * -mcpu/-mfpu options passed to gcc by performing runtime detection via
@@ -128,76 +128,71 @@ init_simd(void)
 #ifndef NO_GETENV
   /* Force different settings through environment variables */
   if (!GETENV_S(env, 2, "JSIMD_FORCENEON") && !strcmp(env, "1"))
-    simd_support = JSIMD_NEON;
+    cpu_support = JSIMD_NEON;
   if (!GETENV_S(env, 2, "JSIMD_FORCENONE") && !strcmp(env, "1"))
-    simd_support = 0;
+    cpu_support = 0;
   if (!GETENV_S(env, 2, "JSIMD_NOHUFFENC") && !strcmp(env, "1"))
     simd_huffman = 0;
 #endif
 }
 
-GLOBAL(int)
-jsimd_can_rgb_ycc(void)
+LOCAL(void)
+init_rgb_ycc(jsimd_rgb_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
-    return 0;
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_NEON)
-    return 1;
+  if (!(simd_support & JSIMD_NEON))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _ycc_convert_neon);
+  kernels[JCS_RGB] = kernels[JCS_EXT_RGB];
 }
 
-GLOBAL(int)
-jsimd_can_rgb_gray(void)
+LOCAL(void)
+init_rgb_gray(jsimd_rgb_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
-    return 0;
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_NEON)
-    return 1;
+  if (!(simd_support & JSIMD_NEON))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _gray_convert_neon);
+  kernels[JCS_RGB] = kernels[JCS_EXT_RGB];
 }
 
-GLOBAL(int)
-jsimd_can_ycc_rgb(void)
+LOCAL(void)
+init_ycc_rgb(jsimd_ycc_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
-    return 0;
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_NEON)
-    return 1;
+  if (!(simd_support & JSIMD_NEON))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_ycc_, _convert_neon);
+  kernels[JCS_RGB] = kernels[JCS_EXT_RGB];
 }
 
-GLOBAL(int)
-jsimd_can_ycc_rgb565(void)
+LOCAL(int)
+can_ycc_rgb565(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -210,136 +205,22 @@ jsimd_can_ycc_rgb565(void)
   return 0;
 }
 
-GLOBAL(void)
-jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                      JSAMPIMAGE output_buf, JDIMENSION output_row,
-                      int num_rows)
-{
-  void (*neonfct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    neonfct = jsimd_extrgb_ycc_convert_neon;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    neonfct = jsimd_extrgbx_ycc_convert_neon;
-    break;
-  case JCS_EXT_BGR:
-    neonfct = jsimd_extbgr_ycc_convert_neon;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    neonfct = jsimd_extbgrx_ycc_convert_neon;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    neonfct = jsimd_extxbgr_ycc_convert_neon;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    neonfct = jsimd_extxrgb_ycc_convert_neon;
-    break;
-  default:
-    neonfct = jsimd_extrgb_ycc_convert_neon;
-    break;
-  }
-
-  neonfct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-}
-
-GLOBAL(void)
-jsimd_rgb_gray_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                       JSAMPIMAGE output_buf, JDIMENSION output_row,
-                       int num_rows)
-{
-  void (*neonfct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    neonfct = jsimd_extrgb_gray_convert_neon;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    neonfct = jsimd_extrgbx_gray_convert_neon;
-    break;
-  case JCS_EXT_BGR:
-    neonfct = jsimd_extbgr_gray_convert_neon;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    neonfct = jsimd_extbgrx_gray_convert_neon;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    neonfct = jsimd_extxbgr_gray_convert_neon;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    neonfct = jsimd_extxrgb_gray_convert_neon;
-    break;
-  default:
-    neonfct = jsimd_extrgb_gray_convert_neon;
-    break;
-  }
-
-  neonfct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-}
-
-GLOBAL(void)
-jsimd_ycc_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
-                      JDIMENSION input_row, JSAMPARRAY output_buf,
-                      int num_rows)
-{
-  void (*neonfct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY, int);
-
-  switch (cinfo->out_color_space) {
-  case JCS_EXT_RGB:
-    neonfct = jsimd_ycc_extrgb_convert_neon;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    neonfct = jsimd_ycc_extrgbx_convert_neon;
-    break;
-  case JCS_EXT_BGR:
-    neonfct = jsimd_ycc_extbgr_convert_neon;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    neonfct = jsimd_ycc_extbgrx_convert_neon;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    neonfct = jsimd_ycc_extxbgr_convert_neon;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    neonfct = jsimd_ycc_extxrgb_convert_neon;
-    break;
-  default:
-    neonfct = jsimd_ycc_extrgb_convert_neon;
-    break;
-  }
-
-  neonfct(cinfo->output_width, input_buf, input_row, output_buf, num_rows);
-}
-
 GLOBAL(void)
 jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                          JDIMENSION input_row, JSAMPARRAY output_buf,
                          int num_rows)
 {
+#if BITS_IN_JSAMPLE == 8
   jsimd_ycc_rgb565_convert_neon(cinfo->output_width, input_buf, input_row,
                                 output_buf, num_rows);
+#endif
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_downsample(void)
+LOCAL(int)
+can_h2v2_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (DCTSIZE != 8)
     return 0;
@@ -352,13 +233,11 @@ jsimd_can_h2v2_downsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_downsample(void)
+LOCAL(int)
+can_h2v1_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (DCTSIZE != 8)
     return 0;
@@ -389,13 +268,11 @@ jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
                              input_data, output_data);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_upsample(void)
+LOCAL(int)
+can_h2v2_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
@@ -406,13 +283,11 @@ jsimd_can_h2v2_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_upsample(void)
+LOCAL(int)
+can_h2v1_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
@@ -438,13 +313,11 @@ jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                            input_data, output_data_ptr);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_fancy_upsample(void)
+LOCAL(int)
+can_h2v2_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
@@ -455,13 +328,11 @@ jsimd_can_h2v2_fancy_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_fancy_upsample(void)
+LOCAL(int)
+can_h2v1_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
@@ -472,13 +343,11 @@ jsimd_can_h2v1_fancy_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h1v2_fancy_upsample(void)
+LOCAL(int)
+can_h1v2_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
@@ -516,11 +385,9 @@ jsimd_h1v2_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                                  output_data_ptr);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_merged_upsample(void)
+LOCAL(int)
+can_h2v2_merged_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -533,11 +400,9 @@ jsimd_can_h2v2_merged_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_merged_upsample(void)
+LOCAL(int)
+can_h2v1_merged_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -554,6 +419,7 @@ GLOBAL(void)
 jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
 {
+#if BITS_IN_JSAMPLE == 8
   void (*neonfct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
 
   switch (cinfo->out_color_space) {
@@ -585,12 +451,14 @@ jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   }
 
   neonfct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
+#endif
 }
 
 GLOBAL(void)
 jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
 {
+#if BITS_IN_JSAMPLE == 8
   void (*neonfct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
 
   switch (cinfo->out_color_space) {
@@ -622,22 +490,23 @@ jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   }
 
   neonfct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
+#endif
 }
 
-GLOBAL(int)
-jsimd_can_convsamp(void)
+LOCAL(int)
+can_convsamp(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
+#if BITS_IN_JSAMPLE == 8
   if (sizeof(DCTELEM) != 2)
     return 0;
+#endif
 
   if (simd_support & JSIMD_NEON)
     return 1;
@@ -645,8 +514,8 @@ jsimd_can_convsamp(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_convsamp_float(void)
+LOCAL(int)
+can_convsamp_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -664,16 +533,16 @@ jsimd_convsamp_float(JSAMPARRAY sample_data, JDIMENSION start_col,
 {
 }
 
-GLOBAL(int)
-jsimd_can_fdct_islow(void)
+LOCAL(int)
+can_fdct_islow(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
+#if BITS_IN_JSAMPLE == 8
   if (sizeof(DCTELEM) != 2)
     return 0;
+#endif
 
   if (simd_support & JSIMD_NEON)
     return 1;
@@ -681,11 +550,9 @@ jsimd_can_fdct_islow(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_ifast(void)
+LOCAL(int)
+can_fdct_ifast(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -698,8 +565,8 @@ jsimd_can_fdct_ifast(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_float(void)
+LOCAL(int)
+can_fdct_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -713,7 +580,9 @@ jsimd_fdct_islow(DCTELEM *data)
 GLOBAL(void)
 jsimd_fdct_ifast(DCTELEM *data)
 {
+#if BITS_IN_JSAMPLE == 8
   jsimd_fdct_ifast_neon(data);
+#endif
 }
 
 GLOBAL(void)
@@ -721,11 +590,9 @@ jsimd_fdct_float(FAST_FLOAT *data)
 {
 }
 
-GLOBAL(int)
-jsimd_can_quantize(void)
+LOCAL(int)
+can_quantize(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -740,8 +607,8 @@ jsimd_can_quantize(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_quantize_float(void)
+LOCAL(int)
+can_quantize_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -749,7 +616,9 @@ jsimd_can_quantize_float(void)
 GLOBAL(void)
 jsimd_quantize(JCOEFPTR coef_block, DCTELEM *divisors, DCTELEM *workspace)
 {
+#if BITS_IN_JSAMPLE == 8
   jsimd_quantize_neon(coef_block, divisors, workspace);
+#endif
 }
 
 GLOBAL(void)
@@ -758,11 +627,9 @@ jsimd_quantize_float(JCOEFPTR coef_block, FAST_FLOAT *divisors,
 {
 }
 
-GLOBAL(int)
-jsimd_can_idct_2x2(void)
+LOCAL(int)
+can_idct_2x2(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -781,11 +648,9 @@ jsimd_can_idct_2x2(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_4x4(void)
+LOCAL(int)
+can_idct_4x4(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -809,7 +674,9 @@ jsimd_idct_2x2(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                JCOEFPTR coef_block, JSAMPARRAY output_buf,
                JDIMENSION output_col)
 {
+#if BITS_IN_JSAMPLE == 8
   jsimd_idct_2x2_neon(compptr->dct_table, coef_block, output_buf, output_col);
+#endif
 }
 
 GLOBAL(void)
@@ -817,24 +684,28 @@ jsimd_idct_4x4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                JCOEFPTR coef_block, JSAMPARRAY output_buf,
                JDIMENSION output_col)
 {
+#if BITS_IN_JSAMPLE == 8
   jsimd_idct_4x4_neon(compptr->dct_table, coef_block, output_buf, output_col);
+#endif
 }
 
-GLOBAL(int)
-jsimd_can_idct_islow(void)
+LOCAL(int)
+can_idct_islow(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
     return 0;
-  if (BITS_IN_JSAMPLE != 8)
+  if (BITS_IN_JSAMPLE != 8 && BITS_IN_JSAMPLE != 12)
     return 0;
   if (sizeof(JDIMENSION) != 4)
     return 0;
+#if BITS_IN_JSAMPLE == 8
   if (sizeof(ISLOW_MULT_TYPE) != 2)
+#else
+  if (sizeof(ISLOW_MULT_TYPE) != 4)
+#endif
     return 0;
 
   if (simd_support & JSIMD_NEON)
@@ -843,11 +714,9 @@ jsimd_can_idct_islow(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_ifast(void)
+LOCAL(int)
+can_idct_ifast(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -868,8 +737,8 @@ jsimd_can_idct_ifast(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_float(void)
+LOCAL(int)
+can_idct_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -888,8 +757,10 @@ jsimd_idct_ifast(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
                  JDIMENSION output_col)
 {
+#if BITS_IN_JSAMPLE == 8
   jsimd_idct_ifast_neon(compptr->dct_table, coef_block, output_buf,
                         output_col);
+#endif
 }
 
 GLOBAL(void)
@@ -899,17 +770,17 @@ jsimd_idct_float(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
-GLOBAL(int)
-jsimd_can_huff_encode_one_block(void)
+LOCAL(int)
+can_huff_encode_one_block(unsigned int simd_support)
 {
-  init_simd();
-
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
     return 0;
 
-  if (simd_support & JSIMD_NEON && simd_huffman)
+  if (simd_support & JSIMD_NEON)
     return 1;
 
   return 0;
@@ -920,15 +791,19 @@ jsimd_huff_encode_one_block(void *state, JOCTET *buffer, JCOEFPTR block,
                             int last_dc_val, c_derived_tbl *dctbl,
                             c_derived_tbl *actbl)
 {
+#if BITS_IN_JSAMPLE == 8
   return jsimd_huff_encode_one_block_neon(state, buffer, block, last_dc_val,
                                           dctbl, actbl);
+#else
+  return buffer;
+#endif
 }
 
-GLOBAL(int)
-jsimd_can_encode_mcu_AC_first_prepare(void)
+LOCAL(int)
+can_encode_mcu_AC_first_prepare(unsigned int simd_support)
 {
-  init_simd();
-
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
@@ -945,15 +820,17 @@ jsimd_encode_mcu_AC_first_prepare(const JCOEF *block,
                                   const int *jpeg_natural_order_start, int Sl,
                                   int Al, JCOEF *values, size_t *zerobits)
 {
+#if BITS_IN_JSAMPLE == 8
   jsimd_encode_mcu_AC_first_prepare_neon(block, jpeg_natural_order_start,
                                          Sl, Al, values, zerobits);
+#endif
 }
 
-GLOBAL(int)
-jsimd_can_encode_mcu_AC_refine_prepare(void)
+LOCAL(int)
+can_encode_mcu_AC_refine_prepare(unsigned int simd_support)
 {
-  init_simd();
-
+  if (BITS_IN_JSAMPLE != 8)
+    return 0;
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
@@ -970,7 +847,83 @@ jsimd_encode_mcu_AC_refine_prepare(const JCOEF *block,
                                    const int *jpeg_natural_order_start, int Sl,
                                    int Al, JCOEF *absvalues, size_t *bits)
 {
+#if BITS_IN_JSAMPLE == 8
   return jsimd_encode_mcu_AC_refine_prepare_neon(block,
                                                  jpeg_natural_order_start, Sl,
                                                  Al, absvalues, bits);
+#else
+  return 0;
+#endif
+}
+
+/*
+ * Determine which SIMD kernels a compression or decompression object can use,
+ * given its SIMD tier.
+ */
+GLOBAL(void)
+jsimd_init_table(struct jpeg_simd_table *table, int tier, boolean huffman)
+{
+  unsigned int simd_support;
+
+  init_simd();
+  simd_support = cpu_support & JSIMD_TIER_MASK(tier);
+
+  memset(table, 0, sizeof(struct jpeg_simd_table));
+  table->support = simd_support;
+  init_rgb_ycc(table->rgb_ycc, simd_support);
+  init_rgb_gray(table->rgb_gray, simd_support);
+  init_ycc_rgb(table->ycc_rgb, simd_support);
+  table->ycc_rgb565 = can_ycc_rgb565(simd_support) ?
+                      jsimd_ycc_rgb565_convert : NULL;
+  table->h2v2_downsample = can_h2v2_downsample(simd_support) ?
+                           jsimd_h2v2_downsample : NULL;
+  table->h2v1_downsample = can_h2v1_downsample(simd_support) ?
+                           jsimd_h2v1_downsample : NULL;
+  table->h2v2_upsample = can_h2v2_upsample(simd_support) ?
+                         jsimd_h2v2_upsample : NULL;
+  table->h2v1_upsample = can_h2v1_upsample(simd_support) ?
+                         jsimd_h2v1_upsample : NULL;
+  table->h2v2_fancy_upsample = can_h2v2_fancy_upsample(simd_support) ?
+                               jsimd_h2v2_fancy_upsample : NULL;
+  table->h2v1_fancy_upsample = can_h2v1_fancy_upsample(simd_support) ?
+                               jsimd_h2v1_fancy_upsample : NULL;
+  table->h1v2_fancy_upsample = can_h1v2_fancy_upsample(simd_support) ?
+                               jsimd_h1v2_fancy_upsample : NULL;
+  table->h2v2_merged_upsample = can_h2v2_merged_upsample(simd_support) ?
+                                jsimd_h2v2_merged_upsample : NULL;
+  table->h2v1_merged_upsample = can_h2v1_merged_upsample(simd_support) ?
+                                jsimd_h2v1_merged_upsample : NULL;
+  table->convsamp = can_convsamp(simd_support) ?
+                    (jsimd_kernel_ptr)jsimd_convsamp : NULL;
+  table->convsamp_float = can_convsamp_float(simd_support) ?
+                          (jsimd_kernel_ptr)jsimd_convsamp_float : NULL;
+  table->fdct_islow = can_fdct_islow(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_islow : NULL;
+  table->fdct_ifast = can_fdct_ifast(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_ifast : NULL;
+  table->fdct_float = can_fdct_float(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_float : NULL;
+  table->quantize = can_quantize(simd_support) ?
+                    (jsimd_kernel_ptr)jsimd_quantize : NULL;
+  table->quantize_float = can_quantize_float(simd_support) ?
+                          (jsimd_kernel_ptr)jsimd_quantize_float : NULL;
+  table->idct_2x2 = can_idct_2x2(simd_support) ?
+                    jsimd_idct_2x2 : NULL;
+  table->idct_4x4 = can_idct_4x4(simd_support) ?
+                    jsimd_idct_4x4 : NULL;
+  table->idct_islow = can_idct_islow(simd_support) ?
+                      jsimd_idct_islow : NULL;
+  table->idct_ifast = can_idct_ifast(simd_support) ?
+                      jsimd_idct_ifast : NULL;
+  table->idct_float = can_idct_float(simd_support) ?
+                      jsimd_idct_float : NULL;
+  if (huffman && simd_huffman && can_huff_encode_one_block(simd_support))
+    table->huff_encode_one_block =
+      (jsimd_kernel_ptr)jsimd_huff_encode_one_block;
+  table->encode_mcu_AC_first_prepare =
+    can_encode_mcu_AC_first_prepare(simd_support) ?
+    jsimd_encode_mcu_AC_first_prepare : NULL;
+  table->encode_mcu_AC_refine_prepare =
+    can_encode_mcu_AC_refine_prepare(simd_support) ?
+    jsimd_encode_mcu_AC_refine_prepare : NULL;
 }
@@ -0,0 +1,204 @@
+/*
+ * jccolext12-neon.c - colorspace conversion, 12-bit samples (Arm Neon)
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/* This file is included by jccolor12-neon.c */
+
+
+/* RGB -> YCbCr conversion is defined by the following equations:
+ *    Y  =  0.29900 * R + 0.58700 * G + 0.11400 * B
+ *    Cb = -0.16874 * R - 0.33126 * G + 0.50000 * B  + 2048
+ *    Cr =  0.50000 * R - 0.41869 * G - 0.08131 * B  + 2048
+ *
+ * The constants are the same 2^16-scaled constants that the 8-bit
+ * implementation uses, and they are defined in jccolor12-neon.c.  With 12-bit
+ * samples, all intermediate results (including the negative terms of Cb and
+ * Cr, which are subtracted from the scaled offset) still fit in 32-bit
+ * unsigned lanes, so the results are bit-exact with those of the C
+ * implementation (jccolor.c).
+ *
+ * We add the fixed-point equivalent of 0.5 to Cb and Cr, which effectively
+ * rounds up or down the result via integer truncation.
+ */
+
+/* Notes on safe memory access for RGB -> YCbCr conversion routines:
+ *
+ * The input buffer points to a possibly unpadded row in the source image
+ * buffer allocated by the calling program, so the last (image_width % 8)
+ * columns are first memcopied to a temporary buffer large enough to
+ * accommodate the vector load.
+ *
+ * Output memory buffers can be safely written up to the next multiple of
+ * ALIGN_SIZE bytes, since they are always allocated by alloc_sarray() in
+ * jmemmgr.c.
+ */
+
+void jsimd_rgb_ycc_convert_neon(JDIMENSION image_width, JSAMPARRAY input_buf,
+                                JSAMPIMAGE output_buf, JDIMENSION output_row,
+                                int num_rows)
+{
+  /* Pointer to RGB(X/A) input data */
+  JSAMPROW inptr;
+  /* Pointers to Y, Cb, and Cr output data */
+  JSAMPROW outptr0, outptr1, outptr2;
+  /* Allocate temporary buffer for final (image_width % 8) pixels in row. */
+  ALIGN(16) JSAMPLE tmp_buf[8 * RGB_PIXELSIZE];
+
+  const uint32x4_t scaled_2048_5 = vdupq_n_u32((2048 << 16) + 32767);
+
+  while (--num_rows >= 0) {
+    inptr = *input_buf++;
+    outptr0 = output_buf[0][output_row];
+    outptr1 = output_buf[1][output_row];
+    outptr2 = output_buf[2][output_row];
+    output_row++;
+
+    int cols_remaining = image_width;
+    for (; cols_remaining > 0; cols_remaining -= 8) {
+
+      if (cols_remaining < 8) {
+        memcpy(tmp_buf, inptr,
+               cols_remaining * RGB_PIXELSIZE * sizeof(JSAMPLE));
+        inptr = tmp_buf;
+      }
+
+#if RGB_PIXELSIZE == 4
+      uint16x8x4_t input_pixels = vld4q_u16((uint16_t *)inptr);
+#else
+      uint16x8x3_t input_pixels = vld3q_u16((uint16_t *)inptr);
+#endif
+      uint16x4_t r_l = vget_low_u16(input_pixels.val[RGB_RED]);
+      uint16x4_t g_l = vget_low_u16(input_pixels.val[RGB_GREEN]);
+      uint16x4_t b_l = vget_low_u16(input_pixels.val[RGB_BLUE]);
+      uint16x4_t r_h = vget_high_u16(input_pixels.val[RGB_RED]);
+      uint16x4_t g_h = vget_high_u16(input_pixels.val[RGB_GREEN]);
+      uint16x4_t b_h = vget_high_u16(input_pixels.val[RGB_BLUE]);
+
+      /* Compute Y = 0.29900 * R + 0.58700 * G + 0.11400 * B */
+      uint32x4_t y_l = vmull_n_u16(r_l, F_0_298);
+      y_l = vmlal_n_u16(y_l, g_l, F_0_587);
+      y_l = vmlal_n_u16(y_l, b_l, F_0_113);
+      uint32x4_t y_h = vmull_n_u16(r_h, F_0_298);
+      y_h = vmlal_n_u16(y_h, g_h, F_0_587);
+      y_h = vmlal_n_u16(y_h, b_h, F_0_113);
+
+      /* Compute Cb = -0.16874 * R - 0.33126 * G + 0.50000 * B  + 2048 */
+      uint32x4_t cb_l = scaled_2048_5;
+      cb_l = vmlsl_n_u16(cb_l, r_l, F_0_168);
+      cb_l = vmlsl_n_u16(cb_l, g_l, F_0_331);
+      cb_l = vmlal_n_u16(cb_l, b_l, F_0_500);
+      uint32x4_t cb_h = scaled_2048_5;
+      cb_h = vmlsl_n_u16(cb_h, r_h, F_0_168);
+      cb_h = vmlsl_n_u16(cb_h, g_h, F_0_331);
+      cb_h = vmlal_n_u16(cb_h, b_h, F_0_500);
+
+      /* Compute Cr = 0.50000 * R - 0.41869 * G - 0.08131 * B  + 2048 */
+      uint32x4_t cr_l = scaled_2048_5;
+      cr_l = vmlal_n_u16(cr_l, r_l, F_0_500);
+      cr_l = vmlsl_n_u16(cr_l, g_l, F_0_418);
+      cr_l = vmlsl_n_u16(cr_l, b_l, F_0_081);
+      uint32x4_t cr_h = scaled_2048_5;
+      cr_h = vmlal_n_u16(cr_h, r_h, F_0_500);
+      cr_h = vmlsl_n_u16(cr_h, g_h, F_0_418);
+      cr_h = vmlsl_n_u16(cr_h, b_h, F_0_081);
+
+      /* Descale Y values (rounding right shift) and narrow to 16-bit. */
+      uint16x8_t y_u16 = vcombine_u16(vrshrn_n_u32(y_l, 16),
+                                      vrshrn_n_u32(y_h, 16));
+      /* Descale Cb values (right shift) and narrow to 16-bit. */
+      uint16x8_t cb_u16 = vcombine_u16(vshrn_n_u32(cb_l, 16),
+                                       vshrn_n_u32(cb_h, 16));
+      /* Descale Cr values (right shift) and narrow to 16-bit. */
+      uint16x8_t cr_u16 = vcombine_u16(vshrn_n_u32(cr_l, 16),
+                                       vshrn_n_u32(cr_h, 16));
+
+      /* Store Y, Cb, and Cr values to memory. */
+      vst1q_u16((uint16_t *)outptr0, y_u16);
+      vst1q_u16((uint16_t *)outptr1, cb_u16);
+      vst1q_u16((uint16_t *)outptr2, cr_u16);
+
+      /* Increment pointers. */
+      inptr += (8 * RGB_PIXELSIZE);
+      outptr0 += 8;
+      outptr1 += 8;
+      outptr2 += 8;
+    }
+  }
+}
+
+
+/* RGB -> Grayscale conversion is defined by the following equation:
+ *    Y  =  0.29900 * R + 0.58700 * G + 0.11400 * B
+ *
+ * This is the same computation as the RGB -> Y portion of RGB -> YCbCr.
+ */
+
+void jsimd_rgb_gray_convert_neon(JDIMENSION image_width, JSAMPARRAY input_buf,
+                                 JSAMPIMAGE output_buf, JDIMENSION output_row,
+                                 int num_rows)
+{
+  JSAMPROW inptr;
+  JSAMPROW outptr;
+  /* Allocate temporary buffer for final (image_width % 8) pixels in row. */
+  ALIGN(16) JSAMPLE tmp_buf[8 * RGB_PIXELSIZE];
+
+  while (--num_rows >= 0) {
+    inptr = *input_buf++;
+    outptr = output_buf[0][output_row];
+    output_row++;
+
+    int cols_remaining = image_width;
+    for (; cols_remaining > 0; cols_remaining -= 8) {
+
+      if (cols_remaining < 8) {
+        memcpy(tmp_buf, inptr,
+               cols_remaining * RGB_PIXELSIZE * sizeof(JSAMPLE));
+        inptr = tmp_buf;
+      }
+
+#if RGB_PIXELSIZE == 4
+      uint16x8x4_t input_pixels = vld4q_u16((uint16_t *)inptr);
+#else
+      uint16x8x3_t input_pixels = vld3q_u16((uint16_t *)inptr);
+#endif
+      uint16x8_t r = input_pixels.val[RGB_RED];
+      uint16x8_t g = input_pixels.val[RGB_GREEN];
+      uint16x8_t b = input_pixels.val[RGB_BLUE];
+
+      /* Compute Y = 0.29900 * R + 0.58700 * G + 0.11400 * B */
+      uint32x4_t y_l = vmull_n_u16(vget_low_u16(r), F_0_298);
+      y_l = vmlal_n_u16(y_l, vget_low_u16(g), F_0_587);
+      y_l = vmlal_n_u16(y_l, vget_low_u16(b), F_0_113);
+      uint32x4_t y_h = vmull_n_u16(vget_high_u16(r), F_0_298);
+      y_h = vmlal_n_u16(y_h, vget_high_u16(g), F_0_587);
+      y_h = vmlal_n_u16(y_h, vget_high_u16(b), F_0_113);
+
+      /* Descale Y values (rounding right shift) and narrow to 16-bit. */
+      uint16x8_t y_u16 = vcombine_u16(vrshrn_n_u32(y_l, 16),
+                                      vrshrn_n_u32(y_h, 16));
+
+      /* Store Y values to memory. */
+      vst1q_u16((uint16_t *)outptr, y_u16);
+
+      /* Increment pointers. */
+      inptr += (8 * RGB_PIXELSIZE);
+      outptr += 8;
+    }
+  }
+}
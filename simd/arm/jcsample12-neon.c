@@ -0,0 +1,133 @@
+/*
+ * jcsample12-neon.c - downsampling, 12-bit samples (Arm Neon)
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define JPEG_INTERNALS
+#include "../../jinclude.h"
+#include "../../jpeglib.h"
+#include "../../jsimd.h"
+#include "../../jdct.h"
+#include "../../jsimddct.h"
+#include "../jsimd.h"
+#include "align.h"
+
+#include <arm_neon.h>
+
+
+/* Expand a component horizontally from width input_cols to width output_cols,
+ * by duplicating the rightmost samples.  This is the same as
+ * expand_right_edge() in jcsample.c, and it is safe for the same reason:
+ * input_data is always allocated by alloc_sarray() in jmemmgr.c, with at
+ * least output_cols samples per row.
+ */
+
+LOCAL(void)
+expand_right_edge(JSAMPARRAY image_data, int num_rows, JDIMENSION input_cols,
+                  JDIMENSION output_cols)
+{
+  JSAMPROW ptr;
+  JSAMPLE pixval;
+  int count, row;
+  int numcols = (int)(output_cols - input_cols);
+
+  if (numcols > 0) {
+    for (row = 0; row < num_rows; row++) {
+      ptr = image_data[row] + input_cols;
+      pixval = ptr[-1];
+      for (count = numcols; count > 0; count--)
+        *ptr++ = pixval;
+    }
+  }
+}
+
+
+/* Downsample pixel values of a single component.
+ * This version handles the common case of 2:1 horizontal and 1:1 vertical,
+ * without smoothing.
+ */
+
+void jsimd_h2v1_downsample_neon(JDIMENSION image_width, int max_v_samp_factor,
+                                JDIMENSION v_samp_factor,
+                                JDIMENSION width_in_blocks,
+                                JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+  JSAMPROW inptr, outptr;
+  /* Bias pattern (alternating every sample): { 0, 1, 0, 1, 0, 1, 0, 1 } */
+  const uint16x8_t bias = vreinterpretq_u16_u32(vdupq_n_u32(0x00010000));
+  unsigned i, outrow;
+
+  expand_right_edge(input_data, max_v_samp_factor, image_width,
+                    width_in_blocks * 2 * DCTSIZE);
+
+  for (outrow = 0; outrow < v_samp_factor; outrow++) {
+    outptr = output_data[outrow];
+    inptr = input_data[outrow];
+
+    for (i = 0; i < width_in_blocks; i++) {
+      /* Load and de-interleave even and odd pixels. */
+      uint16x8x2_t pixels = vld2q_u16((uint16_t *)inptr + i * 2 * DCTSIZE);
+      /* Add adjacent pixel values and bias. */
+      uint16x8_t samples = vaddq_u16(vaddq_u16(pixels.val[0], pixels.val[1]),
+                                     bias);
+      /* Divide total by 2 and store samples to memory. */
+      vst1q_u16((uint16_t *)outptr + i * DCTSIZE, vshrq_n_u16(samples, 1));
+    }
+  }
+}
+
+
+/* Downsample pixel values of a single component.
+ * This version handles the standard case of 2:1 horizontal and 2:1 vertical,
+ * without smoothing.
+ */
+
+void jsimd_h2v2_downsample_neon(JDIMENSION image_width, int max_v_samp_factor,
+                                JDIMENSION v_samp_factor,
+                                JDIMENSION width_in_blocks,
+                                JSAMPARRAY input_data, JSAMPARRAY output_data)
+{
+  JSAMPROW inptr0, inptr1, outptr;
+  /* Bias pattern (alternating every sample): { 1, 2, 1, 2, 1, 2, 1, 2 } */
+  const uint16x8_t bias = vreinterpretq_u16_u32(vdupq_n_u32(0x00020001));
+  unsigned i, outrow;
+
+  expand_right_edge(input_data, max_v_samp_factor, image_width,
+                    width_in_blocks * 2 * DCTSIZE);
+
+  for (outrow = 0; outrow < v_samp_factor; outrow++) {
+    outptr = output_data[outrow];
+    inptr0 = input_data[outrow * 2];
+    inptr1 = input_data[outrow * 2 + 1];
+
+    for (i = 0; i < width_in_blocks; i++) {
+      /* Load and de-interleave even and odd pixels in rows 0 and 1. */
+      uint16x8x2_t pixels_r0 = vld2q_u16((uint16_t *)inptr0 + i * 2 * DCTSIZE);
+      uint16x8x2_t pixels_r1 = vld2q_u16((uint16_t *)inptr1 + i * 2 * DCTSIZE);
+      /* Add adjacent pixel values in both rows and bias.  With 12-bit
+       * samples, the total cannot overflow 16 bits.
+       */
+      uint16x8_t samples = vaddq_u16(pixels_r0.val[0], pixels_r0.val[1]);
+      samples = vaddq_u16(samples, pixels_r1.val[0]);
+      samples = vaddq_u16(samples, pixels_r1.val[1]);
+      samples = vaddq_u16(samples, bias);
+      /* Divide total by 4 and store samples to memory. */
+      vst1q_u16((uint16_t *)outptr + i * DCTSIZE, vshrq_n_u16(samples, 2));
+    }
+  }
+}
@@ -0,0 +1,126 @@
+/*
+ * jdcolext12-neon.c - colorspace conversion, 12-bit samples (Arm Neon)
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/* This file is included by jdcolor12-neon.c. */
+
+
+/* YCbCr -> RGB conversion is defined by the following equations:
+ *    R = Y                        + 1.40200 * (Cr - 2048)
+ *    G = Y - 0.34414 * (Cb - 2048) - 0.71414 * (Cr - 2048)
+ *    B = Y + 1.77200 * (Cb - 2048)
+ *
+ * The scaled constants are defined in jdcolor12-neon.c.  Rounding is used
+ * when descaling, and the results are clamped to [0-4095].
+ */
+
+/* Notes on safe memory access for YCbCr -> RGB conversion routines:
+ *
+ * Input memory buffers can be safely overread up to the next multiple of
+ * ALIGN_SIZE bytes, since they are always allocated by alloc_sarray() in
+ * jmemmgr.c.
+ *
+ * The output buffer cannot safely be written beyond output_width, since
+ * output_buf points to a possibly unpadded row in the decompressed image
+ * buffer allocated by the calling program.  Thus, the tail elements are
+ * converted into a temporary buffer and copied to the output buffer.
+ */
+
+void jsimd_ycc_rgb_convert_neon(JDIMENSION output_width, JSAMPIMAGE input_buf,
+                                JDIMENSION input_row, JSAMPARRAY output_buf,
+                                int num_rows)
+{
+  JSAMPROW outptr;
+  /* Pointers to Y, Cb, and Cr data */
+  JSAMPROW inptr0, inptr1, inptr2;
+  ALIGN(16) JSAMPLE tmp_buf[8 * RGB_PIXELSIZE];
+
+  const int16x8_t center = vdupq_n_s16(CENTERJSAMPLE);
+  const int16x8_t zero = vdupq_n_s16(0);
+  const int16x8_t maxval = vdupq_n_s16(MAXJSAMPLE);
+
+  while (--num_rows >= 0) {
+    inptr0 = input_buf[0][input_row];
+    inptr1 = input_buf[1][input_row];
+    inptr2 = input_buf[2][input_row];
+    input_row++;
+    outptr = *output_buf++;
+    int cols_remaining = output_width;
+    for (; cols_remaining > 0; cols_remaining -= 8) {
+      int16x8_t y = vld1q_s16(inptr0);
+      /* Subtract 2048 from Cb and Cr. */
+      int16x8_t cb = vsubq_s16(vld1q_s16(inptr1), center);
+      int16x8_t cr = vsubq_s16(vld1q_s16(inptr2), center);
+      int32x4_t cb_l = vmovl_s16(vget_low_s16(cb));
+      int32x4_t cb_h = vmovl_s16(vget_high_s16(cb));
+      int32x4_t cr_l = vmovl_s16(vget_low_s16(cr));
+      int32x4_t cr_h = vmovl_s16(vget_high_s16(cr));
+      /* Compute G-Y: - 0.34414 * (Cb - 2048) - 0.71414 * (Cr - 2048) */
+      int32x4_t g_sub_y_l = vmulq_n_s32(cb_l, -F_0_344);
+      int32x4_t g_sub_y_h = vmulq_n_s32(cb_h, -F_0_344);
+      g_sub_y_l = vmlsq_n_s32(g_sub_y_l, cr_l, F_0_714);
+      g_sub_y_h = vmlsq_n_s32(g_sub_y_h, cr_h, F_0_714);
+      /* Compute R-Y: 1.40200 * (Cr - 2048) */
+      int32x4_t r_sub_y_l = vmulq_n_s32(cr_l, F_1_402);
+      int32x4_t r_sub_y_h = vmulq_n_s32(cr_h, F_1_402);
+      /* Compute B-Y: 1.77200 * (Cb - 2048) */
+      int32x4_t b_sub_y_l = vmulq_n_s32(cb_l, F_1_772);
+      int32x4_t b_sub_y_h = vmulq_n_s32(cb_h, F_1_772);
+      /* Descale: shift right 16, round, narrow to 16-bit, and add Y. */
+      int16x8_t r = vaddq_s16(y, vcombine_s16(vrshrn_n_s32(r_sub_y_l, 16),
+                                              vrshrn_n_s32(r_sub_y_h, 16)));
+      int16x8_t g = vaddq_s16(y, vcombine_s16(vrshrn_n_s32(g_sub_y_l, 16),
+                                              vrshrn_n_s32(g_sub_y_h, 16)));
+      int16x8_t b = vaddq_s16(y, vcombine_s16(vrshrn_n_s32(b_sub_y_l, 16),
+                                              vrshrn_n_s32(b_sub_y_h, 16)));
+      /* Clamp to [0-4095]. */
+      r = vminq_s16(vmaxq_s16(r, zero), maxval);
+      g = vminq_s16(vmaxq_s16(g, zero), maxval);
+      b = vminq_s16(vmaxq_s16(b, zero), maxval);
+
+      JSAMPROW dst = cols_remaining >= 8 ? outptr : tmp_buf;
+#if RGB_PIXELSIZE == 4
+      int16x8x4_t rgba;
+      rgba.val[RGB_RED] = r;
+      rgba.val[RGB_GREEN] = g;
+      rgba.val[RGB_BLUE] = b;
+      /* Set alpha channel to opaque (0xFF). */
+      rgba.val[RGB_ALPHA] = vdupq_n_s16(0xFF);
+      /* Store RGBA pixel data to memory. */
+      vst4q_s16(dst, rgba);
+#else
+      int16x8x3_t rgb;
+      rgb.val[RGB_RED] = r;
+      rgb.val[RGB_GREEN] = g;
+      rgb.val[RGB_BLUE] = b;
+      /* Store RGB pixel data to memory. */
+      vst3q_s16(dst, rgb);
+#endif
+      if (cols_remaining < 8)
+        memcpy(outptr, tmp_buf,
+               cols_remaining * RGB_PIXELSIZE * sizeof(JSAMPLE));
+
+      /* Increment pointers. */
+      inptr0 += 8;
+      inptr1 += 8;
+      inptr2 += 8;
+      outptr += (RGB_PIXELSIZE * 8);
+    }
+  }
+}
@@ -0,0 +1,242 @@
+/*
+ * jdsample12-neon.c - upsampling, 12-bit samples (Arm Neon)
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define JPEG_INTERNALS
+#include "../../jinclude.h"
+#include "../../jpeglib.h"
+#include "../../jsimd.h"
+#include "../../jdct.h"
+#include "../../jsimddct.h"
+#include "../jsimd.h"
+
+#include <arm_neon.h>
+
+
+/* These routines are the 12-bit equivalents of the routines in
+ * jdsample-neon.c, which describe the upsampling algorithms in detail.  With
+ * 12-bit samples, all intermediate sums (including the h2v2 column sums
+ * multiplied by 4) fit in 16-bit unsigned lanes, so each vector processes 8
+ * samples, and the results are bit-exact with those of the C implementation
+ * (jdsample.c).
+ *
+ * As with the 8-bit routines, the stores are offset so that they stay within
+ * the bounds of the sample buffers without requiring a scalar tail case.  See
+ * "Creation of 2-D sample arrays" in jmemmgr.c for more details.
+ */
+
+
+/* Fancy upsampling: 2:1 horizontal, 1:1 vertical */
+
+void jsimd_h2v1_fancy_upsample_neon(int max_v_samp_factor,
+                                    JDIMENSION downsampled_width,
+                                    JSAMPARRAY input_data,
+                                    JSAMPARRAY *output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  JSAMPROW inptr, outptr;
+  int inrow;
+  unsigned colctr;
+  /* Set up constants. */
+  const uint16x8_t one_u16 = vdupq_n_u16(1);
+  const uint16x8_t two_u16 = vdupq_n_u16(2);
+
+  for (inrow = 0; inrow < max_v_samp_factor; inrow++) {
+    inptr = input_data[inrow];
+    outptr = output_data[inrow];
+    /* First pixel component value in this row of the original image */
+    *outptr = *inptr;
+
+    /* The first iteration stores pixel component values 1-16.  Subsequent
+     * iterations store pixel component values (2 * colctr - 1) to
+     * (2 * colctr + 14).
+     */
+    uint16_t *s0_ptr = (uint16_t *)inptr;
+    unsigned outptr_offset = 1;
+
+    for (colctr = 0; colctr < downsampled_width; colctr += 8) {
+      if (colctr > 0) {
+        s0_ptr = (uint16_t *)inptr + colctr - 1;
+        outptr_offset = 2 * colctr - 1;
+      }
+      uint16x8_t s0 = vld1q_u16(s0_ptr);
+      uint16x8_t s1 = vld1q_u16(s0_ptr + 1);
+      /*    3/4 * containing sample + 1/4 * nearest neighboring sample
+       * For the odd pixel of s0: containing sample = s0, neighbor = s1
+       * For the even pixel of s1: containing sample = s1, neighbor = s0
+       */
+      uint16x8_t s1_add_3s0 = vmlaq_n_u16(s1, s0, 3);
+      uint16x8_t s0_add_3s1 = vmlaq_n_u16(s0, s1, 3);
+      uint16x8x2_t output_pixels;
+      output_pixels.val[0] = vshrq_n_u16(vaddq_u16(s1_add_3s0, two_u16), 2);
+      output_pixels.val[1] = vshrq_n_u16(vaddq_u16(s0_add_3s1, one_u16), 2);
+      /* Store pixel component values to memory. */
+      vst2q_u16((uint16_t *)outptr + outptr_offset, output_pixels);
+    }
+
+    /* Last pixel component value in this row of the original image */
+    outptr[2 * downsampled_width - 1] = inptr[downsampled_width - 1];
+  }
+}
+
+
+/* Fancy upsampling: 2:1 horizontal, 2:1 vertical */
+
+/* Compute 8 column sums (3 * nearer row + further row). */
+#define COLSUM(nearer, further, col) \
+  vmlaq_n_u16(vld1q_u16((uint16_t *)(further) + (col)), \
+              vld1q_u16((uint16_t *)(nearer) + (col)), 3)
+
+void jsimd_h2v2_fancy_upsample_neon(int max_v_samp_factor,
+                                    JDIMENSION downsampled_width,
+                                    JSAMPARRAY input_data,
+                                    JSAMPARRAY *output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  JSAMPROW inptr0, inptr1, outptr;
+  int inrow, outrow, v;
+  unsigned colctr;
+  /* Set up constants. */
+  const uint16x8_t seven_u16 = vdupq_n_u16(7);
+  const uint16x8_t eight_u16 = vdupq_n_u16(8);
+
+  inrow = outrow = 0;
+  while (outrow < max_v_samp_factor) {
+    for (v = 0; v < 2; v++) {
+      /* inptr0 points to nearest input row, inptr1 points to next nearest */
+      inptr0 = input_data[inrow];
+      inptr1 = input_data[v == 0 ? inrow - 1 : inrow + 1];
+      outptr = output_data[outrow++];
+
+      /* First pixel component value in this row of the original image */
+      outptr[0] = (JSAMPLE)(((inptr0[0] * 3 + inptr1[0]) * 4 + 8) >> 4);
+
+      unsigned s0_col = 0, outptr_offset = 1;
+
+      for (colctr = 0; colctr < downsampled_width; colctr += 8) {
+        if (colctr > 0) {
+          s0_col = colctr - 1;
+          outptr_offset = 2 * colctr - 1;
+        }
+        uint16x8_t s0 = COLSUM(inptr0, inptr1, s0_col);
+        uint16x8_t s1 = COLSUM(inptr0, inptr1, s0_col + 1);
+        /* 3/4 * containing column sum + 1/4 * nearest neighboring column
+         * sum, with the same rounding as the C implementation
+         */
+        uint16x8_t s1_add_3s0 = vmlaq_n_u16(s1, s0, 3);
+        uint16x8_t s0_add_3s1 = vmlaq_n_u16(s0, s1, 3);
+        uint16x8x2_t output_pixels;
+        output_pixels.val[0] =
+          vshrq_n_u16(vaddq_u16(s1_add_3s0, seven_u16), 4);
+        output_pixels.val[1] =
+          vshrq_n_u16(vaddq_u16(s0_add_3s1, eight_u16), 4);
+        /* Store pixel component values to memory. */
+        vst2q_u16((uint16_t *)outptr + outptr_offset, output_pixels);
+      }
+
+      /* Last pixel component value in this row of the original image */
+      outptr[2 * downsampled_width - 1] =
+        (JSAMPLE)(((inptr0[downsampled_width - 1] * 3 +
+                    inptr1[downsampled_width - 1]) * 4 + 7) >> 4);
+    }
+    inrow++;
+  }
+}
+
+
+/* Fancy upsampling: 1:1 horizontal, 2:1 vertical */
+
+void jsimd_h1v2_fancy_upsample_neon(int max_v_samp_factor,
+                                    JDIMENSION downsampled_width,
+                                    JSAMPARRAY input_data,
+                                    JSAMPARRAY *output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  JSAMPROW inptr0, inptr1, outptr;
+  int inrow, outrow, v;
+  unsigned colctr;
+
+  inrow = outrow = 0;
+  while (outrow < max_v_samp_factor) {
+    for (v = 0; v < 2; v++) {
+      /* inptr0 points to nearest input row, inptr1 points to next nearest */
+      inptr0 = input_data[inrow];
+      inptr1 = input_data[v == 0 ? inrow - 1 : inrow + 1];
+      outptr = output_data[outrow++];
+      /* bias = 1 for the upper output row, 2 for the lower output row */
+      const uint16x8_t bias = vdupq_n_u16(v + 1);
+
+      for (colctr = 0; colctr < downsampled_width; colctr += 8) {
+        uint16x8_t colsum = COLSUM(inptr0, inptr1, colctr);
+        vst1q_u16((uint16_t *)outptr + colctr,
+                  vshrq_n_u16(vaddq_u16(colsum, bias), 2));
+      }
+    }
+    inrow++;
+  }
+}
+
+
+/* Upsampling (duplication): 2:1 horizontal, 1:1 vertical */
+
+void jsimd_h2v1_upsample_neon(int max_v_samp_factor, JDIMENSION output_width,
+                              JSAMPARRAY input_data,
+                              JSAMPARRAY *output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  JSAMPROW inptr, outptr;
+  int inrow;
+  unsigned colctr;
+
+  for (inrow = 0; inrow < max_v_samp_factor; inrow++) {
+    inptr = input_data[inrow];
+    outptr = output_data[inrow];
+    for (colctr = 0; 2 * colctr < output_width; colctr += 8) {
+      uint16x8_t samples = vld1q_u16((uint16_t *)inptr + colctr);
+      uint16x8x2_t output_pixels = { { samples, samples } };
+      vst2q_u16((uint16_t *)outptr + 2 * colctr, output_pixels);
+    }
+  }
+}
+
+
+/* Upsampling (duplication): 2:1 horizontal, 2:1 vertical */
+
+void jsimd_h2v2_upsample_neon(int max_v_samp_factor, JDIMENSION output_width,
+                              JSAMPARRAY input_data,
+                              JSAMPARRAY *output_data_ptr)
+{
+  JSAMPARRAY output_data = *output_data_ptr;
+  JSAMPROW inptr, outptr0, outptr1;
+  int inrow, outrow;
+  unsigned colctr;
+
+  for (inrow = 0, outrow = 0; outrow < max_v_samp_factor; inrow++) {
+    inptr = input_data[inrow];
+    outptr0 = output_data[outrow++];
+    outptr1 = output_data[outrow++];
+
+    for (colctr = 0; 2 * colctr < output_width; colctr += 8) {
+      uint16x8_t samples = vld1q_u16((uint16_t *)inptr + colctr);
+      uint16x8x2_t output_pixels = { { samples, samples } };
+      vst2q_u16((uint16_t *)outptr0 + 2 * colctr, output_pixels);
+      vst2q_u16((uint16_t *)outptr1 + 2 * colctr, output_pixels);
+    }
+  }
+}
@@ -0,0 +1,209 @@
+/*
+ * jfdctint12-neon.c - accurate integer FDCT, 12-bit samples (Arm Neon)
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define JPEG_INTERNALS
+#include "../../jinclude.h"
+#include "../../jpeglib.h"
+#include "../../jsimd.h"
+#include "../../jdct.h"
+#include "../../jsimddct.h"
+#include "../jsimd.h"
+
+#include <arm_neon.h>
+
+
+/* This is the same algorithm as jpeg_fdct_islow() in jfdctint.c, using the
+ * scaling that the C implementation uses with 12-bit samples.  With 12-bit
+ * samples, DCTELEM is JLONG, and the intermediate values do not fit in 16
+ * bits, so unlike the 8-bit implementation (jfdctint-neon.c), both passes use
+ * 32-bit lanes, and each vector holds four rows (pass 1) or four columns
+ * (pass 2) of the block.  The results are bit-exact with those of the C
+ * implementation.
+ */
+
+#define CONST_BITS  13
+#define PASS1_BITS  1
+
+#define DESCALE_P1  (CONST_BITS - PASS1_BITS)
+#define DESCALE_P2  (CONST_BITS + PASS1_BITS)
+
+#define F_0_298  2446
+#define F_0_390  3196
+#define F_0_541  4433
+#define F_0_765  6270
+#define F_0_899  7373
+#define F_1_175  9633
+#define F_1_501  12299
+#define F_1_847  15137
+#define F_1_961  16069
+#define F_2_053  16819
+#define F_2_562  20995
+#define F_3_072  25172
+
+
+/* Load/store four DCTELEMs, which are 64-bit on LP64 platforms and 32-bit
+ * otherwise.
+ */
+
+static INLINE int32x4_t jsimd_load_dctelem(const DCTELEM *ptr)
+{
+  if (sizeof(DCTELEM) == 8)
+    return vcombine_s32(vmovn_s64(vld1q_s64((const int64_t *)ptr)),
+                        vmovn_s64(vld1q_s64((const int64_t *)ptr + 2)));
+  return vld1q_s32((const int32_t *)ptr);
+}
+
+static INLINE void jsimd_store_dctelem(DCTELEM *ptr, int32x4_t val)
+{
+  if (sizeof(DCTELEM) == 8) {
+    vst1q_s64((int64_t *)ptr, vmovl_s32(vget_low_s32(val)));
+    vst1q_s64((int64_t *)ptr + 2, vmovl_s32(vget_high_s32(val)));
+  } else
+    vst1q_s32((int32_t *)ptr, val);
+}
+
+
+/* Transpose a 4x4 block of 32-bit elements. */
+
+static INLINE void jsimd_transpose_4x4_s32(int32x4_t *a, int32x4_t *b,
+                                           int32x4_t *c, int32x4_t *d)
+{
+  int32x4x2_t ab = vtrnq_s32(*a, *b);
+  int32x4x2_t cd = vtrnq_s32(*c, *d);
+
+  *a = vcombine_s32(vget_low_s32(ab.val[0]), vget_low_s32(cd.val[0]));
+  *b = vcombine_s32(vget_low_s32(ab.val[1]), vget_low_s32(cd.val[1]));
+  *c = vcombine_s32(vget_high_s32(ab.val[0]), vget_high_s32(cd.val[0]));
+  *d = vcombine_s32(vget_high_s32(ab.val[1]), vget_high_s32(cd.val[1]));
+}
+
+
+/* Perform a 1-D FDCT on four rows or columns at once.  The outputs are not
+ * descaled.
+ */
+
+static INLINE void jsimd_fdct_islow_1d(const int32x4_t in[DCTSIZE],
+                                       int32x4_t out[DCTSIZE])
+{
+  int32x4_t tmp0 = vaddq_s32(in[0], in[7]);
+  int32x4_t tmp7 = vsubq_s32(in[0], in[7]);
+  int32x4_t tmp1 = vaddq_s32(in[1], in[6]);
+  int32x4_t tmp6 = vsubq_s32(in[1], in[6]);
+  int32x4_t tmp2 = vaddq_s32(in[2], in[5]);
+  int32x4_t tmp5 = vsubq_s32(in[2], in[5]);
+  int32x4_t tmp3 = vaddq_s32(in[3], in[4]);
+  int32x4_t tmp4 = vsubq_s32(in[3], in[4]);
+
+  /* Even part */
+  int32x4_t tmp10 = vaddq_s32(tmp0, tmp3);
+  int32x4_t tmp13 = vsubq_s32(tmp0, tmp3);
+  int32x4_t tmp11 = vaddq_s32(tmp1, tmp2);
+  int32x4_t tmp12 = vsubq_s32(tmp1, tmp2);
+
+  out[0] = vaddq_s32(tmp10, tmp11);
+  out[4] = vsubq_s32(tmp10, tmp11);
+
+  int32x4_t z1 = vmulq_n_s32(vaddq_s32(tmp12, tmp13), F_0_541);
+  out[2] = vmlaq_n_s32(z1, tmp13, F_0_765);
+  out[6] = vmlsq_n_s32(z1, tmp12, F_1_847);
+
+  /* Odd part */
+  z1 = vaddq_s32(tmp4, tmp7);
+  int32x4_t z2 = vaddq_s32(tmp5, tmp6);
+  int32x4_t z3 = vaddq_s32(tmp4, tmp6);
+  int32x4_t z4 = vaddq_s32(tmp5, tmp7);
+  int32x4_t z5 = vmulq_n_s32(vaddq_s32(z3, z4), F_1_175);
+
+  tmp4 = vmulq_n_s32(tmp4, F_0_298);
+  tmp5 = vmulq_n_s32(tmp5, F_2_053);
+  tmp6 = vmulq_n_s32(tmp6, F_3_072);
+  tmp7 = vmulq_n_s32(tmp7, F_1_501);
+  z1 = vmulq_n_s32(z1, -F_0_899);
+  z2 = vmulq_n_s32(z2, -F_2_562);
+  z3 = vmlsq_n_s32(z5, z3, F_1_961);
+  z4 = vmlsq_n_s32(z5, z4, F_0_390);
+
+  out[7] = vaddq_s32(tmp4, vaddq_s32(z1, z3));
+  out[5] = vaddq_s32(tmp5, vaddq_s32(z2, z4));
+  out[3] = vaddq_s32(tmp6, vaddq_s32(z2, z3));
+  out[1] = vaddq_s32(tmp7, vaddq_s32(z1, z4));
+}
+
+
+void jsimd_fdct_islow_neon(DCTELEM *data)
+{
+  /* ws[row][half] contains columns (4 * half) to (4 * half + 3) of the given
+   * row after pass 1.
+   */
+  int32x4_t ws[DCTSIZE][2];
+  int32x4_t in[DCTSIZE], out[DCTSIZE];
+  int half, row, col;
+
+  /* Pass 1: process rows. */
+  for (half = 0; half < 2; half++) {
+    /* Load rows (4 * half) to (4 * half + 3), and transpose them so that
+     * each vector contains one column of those rows.
+     */
+    for (col = 0; col < 2; col++) {
+      for (row = 0; row < 4; row++)
+        in[col * 4 + row] =
+          jsimd_load_dctelem(data + (half * 4 + row) * DCTSIZE + col * 4);
+      jsimd_transpose_4x4_s32(&in[col * 4 + 0], &in[col * 4 + 1],
+                              &in[col * 4 + 2], &in[col * 4 + 3]);
+    }
+    jsimd_fdct_islow_1d(in, out);
+
+    out[0] = vshlq_n_s32(out[0], PASS1_BITS);
+    out[4] = vshlq_n_s32(out[4], PASS1_BITS);
+    out[1] = vrshrq_n_s32(out[1], DESCALE_P1);
+    out[2] = vrshrq_n_s32(out[2], DESCALE_P1);
+    out[3] = vrshrq_n_s32(out[3], DESCALE_P1);
+    out[5] = vrshrq_n_s32(out[5], DESCALE_P1);
+    out[6] = vrshrq_n_s32(out[6], DESCALE_P1);
+    out[7] = vrshrq_n_s32(out[7], DESCALE_P1);
+
+    /* Transpose back to rows. */
+    jsimd_transpose_4x4_s32(&out[0], &out[1], &out[2], &out[3]);
+    jsimd_transpose_4x4_s32(&out[4], &out[5], &out[6], &out[7]);
+    for (row = 0; row < 4; row++) {
+      ws[half * 4 + row][0] = out[row];
+      ws[half * 4 + row][1] = out[row + 4];
+    }
+  }
+
+  /* Pass 2: process columns. */
+  for (half = 0; half < 2; half++) {
+    for (row = 0; row < DCTSIZE; row++)
+      in[row] = ws[row][half];
+    jsimd_fdct_islow_1d(in, out);
+
+    out[0] = vrshrq_n_s32(out[0], PASS1_BITS);
+    out[4] = vrshrq_n_s32(out[4], PASS1_BITS);
+    out[1] = vrshrq_n_s32(out[1], DESCALE_P2);
+    out[2] = vrshrq_n_s32(out[2], DESCALE_P2);
+    out[3] = vrshrq_n_s32(out[3], DESCALE_P2);
+    out[5] = vrshrq_n_s32(out[5], DESCALE_P2);
+    out[6] = vrshrq_n_s32(out[6], DESCALE_P2);
+    out[7] = vrshrq_n_s32(out[7], DESCALE_P2);
+
+    for (row = 0; row < DCTSIZE; row++)
+      jsimd_store_dctelem(data + row * DCTSIZE + half * 4, out[row]);
+  }
+}
@@ -0,0 +1,203 @@
+/*
+ * jidctint12-neon.c - accurate integer IDCT, 12-bit samples (Arm Neon)
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define JPEG_INTERNALS
+#include "../../jinclude.h"
+#include "../../jpeglib.h"
+#include "../../jsimd.h"
+#include "../../jdct.h"
+#include "../../jsimddct.h"
+#include "../jsimd.h"
+
+#include <arm_neon.h>
+
+
+/* This is the same algorithm as jpeg_idct_islow() in jidctint.c, using the
+ * scaling that the C implementation uses with 12-bit samples.  The
+ * intermediate values do not fit in 16 bits, so unlike the 8-bit
+ * implementation (jidctint-neon.c), both passes use 32-bit lanes, and each
+ * vector holds four columns (pass 1) or four rows (pass 2) of the block.
+ * Because the arithmetic is the same as that of the C implementation, the
+ * results are bit-exact, except in the case of corrupt input data that
+ * would cause the 32-bit intermediates to overflow.
+ */
+
+#define CONST_BITS  13
+#define PASS1_BITS  1
+
+#define DESCALE_P1  (CONST_BITS - PASS1_BITS)
+#define DESCALE_P2  (CONST_BITS + PASS1_BITS + 3)
+
+#define F_0_298  2446
+#define F_0_390  3196
+#define F_0_541  4433
+#define F_0_765  6270
+#define F_0_899  7373
+#define F_1_175  9633
+#define F_1_501  12299
+#define F_1_847  15137
+#define F_1_961  16069
+#define F_2_053  16819
+#define F_2_562  20995
+#define F_3_072  25172
+
+
+/* Perform a 1-D IDCT on four columns or rows at once.  The outputs are not
+ * descaled.
+ */
+
+static INLINE void jsimd_idct_islow_1d(const int32x4_t in[DCTSIZE],
+                                       int32x4_t out[DCTSIZE])
+{
+  /* Even part */
+  int32x4_t z1 = vmulq_n_s32(vaddq_s32(in[2], in[6]), F_0_541);
+  int32x4_t tmp2 = vmlsq_n_s32(z1, in[6], F_1_847);
+  int32x4_t tmp3 = vmlaq_n_s32(z1, in[2], F_0_765);
+
+  int32x4_t tmp0 = vshlq_n_s32(vaddq_s32(in[0], in[4]), CONST_BITS);
+  int32x4_t tmp1 = vshlq_n_s32(vsubq_s32(in[0], in[4]), CONST_BITS);
+
+  int32x4_t tmp10 = vaddq_s32(tmp0, tmp3);
+  int32x4_t tmp13 = vsubq_s32(tmp0, tmp3);
+  int32x4_t tmp11 = vaddq_s32(tmp1, tmp2);
+  int32x4_t tmp12 = vsubq_s32(tmp1, tmp2);
+
+  /* Odd part */
+  tmp0 = in[7];
+  tmp1 = in[5];
+  tmp2 = in[3];
+  tmp3 = in[1];
+
+  z1 = vaddq_s32(tmp0, tmp3);
+  int32x4_t z2 = vaddq_s32(tmp1, tmp2);
+  int32x4_t z3 = vaddq_s32(tmp0, tmp2);
+  int32x4_t z4 = vaddq_s32(tmp1, tmp3);
+  int32x4_t z5 = vmulq_n_s32(vaddq_s32(z3, z4), F_1_175);
+
+  tmp0 = vmulq_n_s32(tmp0, F_0_298);
+  tmp1 = vmulq_n_s32(tmp1, F_2_053);
+  tmp2 = vmulq_n_s32(tmp2, F_3_072);
+  tmp3 = vmulq_n_s32(tmp3, F_1_501);
+  z1 = vmulq_n_s32(z1, -F_0_899);
+  z2 = vmulq_n_s32(z2, -F_2_562);
+  z3 = vmlsq_n_s32(z5, z3, F_1_961);
+  z4 = vmlsq_n_s32(z5, z4, F_0_390);
+
+  tmp0 = vaddq_s32(tmp0, vaddq_s32(z1, z3));
+  tmp1 = vaddq_s32(tmp1, vaddq_s32(z2, z4));
+  tmp2 = vaddq_s32(tmp2, vaddq_s32(z2, z3));
+  tmp3 = vaddq_s32(tmp3, vaddq_s32(z1, z4));
+
+  /* Final output stage */
+  out[0] = vaddq_s32(tmp10, tmp3);
+  out[7] = vsubq_s32(tmp10, tmp3);
+  out[1] = vaddq_s32(tmp11, tmp2);
+  out[6] = vsubq_s32(tmp11, tmp2);
+  out[2] = vaddq_s32(tmp12, tmp1);
+  out[5] = vsubq_s32(tmp12, tmp1);
+  out[3] = vaddq_s32(tmp13, tmp0);
+  out[4] = vsubq_s32(tmp13, tmp0);
+}
+
+
+/* Transpose a 4x4 block of 32-bit elements. */
+
+static INLINE void jsimd_transpose_4x4_s32(int32x4_t *a, int32x4_t *b,
+                                           int32x4_t *c, int32x4_t *d)
+{
+  int32x4x2_t ab = vtrnq_s32(*a, *b);
+  int32x4x2_t cd = vtrnq_s32(*c, *d);
+
+  *a = vcombine_s32(vget_low_s32(ab.val[0]), vget_low_s32(cd.val[0]));
+  *b = vcombine_s32(vget_low_s32(ab.val[1]), vget_low_s32(cd.val[1]));
+  *c = vcombine_s32(vget_high_s32(ab.val[0]), vget_high_s32(cd.val[0]));
+  *d = vcombine_s32(vget_high_s32(ab.val[1]), vget_high_s32(cd.val[1]));
+}
+
+
+/* Perform dequantization and inverse DCT on one block of coefficients.  The
+ * dequantization table (dct_table) contains ISLOW_MULT_TYPE values, which are
+ * 32-bit with 12-bit samples.
+ */
+
+void jsimd_idct_islow_neon(void *dct_table, JCOEFPTR coef_block,
+                           JSAMPARRAY output_buf, JDIMENSION output_col)
+{
+  ISLOW_MULT_TYPE *quantptr = (ISLOW_MULT_TYPE *)dct_table;
+  /* Workspace: ws[half][row] contains columns (4 * half) to (4 * half + 3) of
+   * the given row.
+   */
+  int32x4_t ws[2][DCTSIZE];
+  int32x4_t in[DCTSIZE], out[DCTSIZE];
+  int half, row, col;
+
+  /* Pass 1: process columns from input, store into workspace. */
+  for (half = 0; half < 2; half++) {
+    for (row = 0; row < DCTSIZE; row++) {
+      int16x4_t coefs = vld1_s16(coef_block + row * DCTSIZE + half * 4);
+      int32x4_t quant =
+        vld1q_s32((int32_t *)quantptr + row * DCTSIZE + half * 4);
+      in[row] = vmulq_s32(vmovl_s16(coefs), quant);
+    }
+    jsimd_idct_islow_1d(in, out);
+    for (row = 0; row < DCTSIZE; row++)
+      ws[half][row] = vrshrq_n_s32(out[row], DESCALE_P1);
+  }
+
+  /* Pass 2: process rows from workspace, store into output array. */
+  const int32x4_t center = vdupq_n_s32(CENTERJSAMPLE);
+  const int32x4_t zero = vdupq_n_s32(0);
+  const int32x4_t maxval = vdupq_n_s32(MAXJSAMPLE);
+
+  for (half = 0; half < 2; half++) {
+    /* Transpose rows (4 * half) to (4 * half + 3), so that each vector
+     * contains one column of those rows.
+     */
+    for (col = 0; col < 2; col++) {
+      in[col * 4 + 0] = ws[col][half * 4 + 0];
+      in[col * 4 + 1] = ws[col][half * 4 + 1];
+      in[col * 4 + 2] = ws[col][half * 4 + 2];
+      in[col * 4 + 3] = ws[col][half * 4 + 3];
+      jsimd_transpose_4x4_s32(&in[col * 4 + 0], &in[col * 4 + 1],
+                              &in[col * 4 + 2], &in[col * 4 + 3]);
+    }
+    jsimd_idct_islow_1d(in, out);
+
+    /* Descale, and emulate the range limiting of the C implementation, which
+     * masks the result to 14 bits (RANGE_MASK) and uses it to index a table
+     * that adds CENTERJSAMPLE and clamps to [0, MAXJSAMPLE].
+     */
+    for (col = 0; col < DCTSIZE; col++) {
+      int32x4_t val = vrshrq_n_s32(out[col], DESCALE_P2);
+      val = vshrq_n_s32(vshlq_n_s32(val, 18), 18);
+      val = vaddq_s32(val, center);
+      out[col] = vminq_s32(vmaxq_s32(val, zero), maxval);
+    }
+
+    /* Transpose back to rows and store. */
+    jsimd_transpose_4x4_s32(&out[0], &out[1], &out[2], &out[3]);
+    jsimd_transpose_4x4_s32(&out[4], &out[5], &out[6], &out[7]);
+    for (row = 0; row < 4; row++) {
+      int16x8_t samples = vcombine_s16(vmovn_s32(out[row]),
+                                       vmovn_s32(out[row + 4]));
+      vst1q_s16(output_buf[half * 4 + row] + output_col, samples);
+    }
+  }
+}
@@ -0,0 +1,72 @@
+/*
+ * jquanti12-neon.c - sample data conversion, 12-bit samples (Arm Neon)
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+#define JPEG_INTERNALS
+#include "../../jinclude.h"
+#include "../../jpeglib.h"
+#include "../../jsimd.h"
+#include "../../jdct.h"
+#include "../../jsimddct.h"
+#include "../jsimd.h"
+
+#include <arm_neon.h>
+
+
+/* After downsampling, the resulting sample values are in the range [0, 4095],
+ * but the Discrete Cosine Transform (DCT) operates on values centered around
+ * 0.
+ *
+ * To prepare sample values for the DCT, load samples into a DCT workspace,
+ * subtracting CENTERJSAMPLE (2048).  The samples, now in the range
+ * [-2048, 2047], are also widened to DCTELEM, which is JLONG with 12-bit
+ * samples.
+ *
+ * The equivalent scalar C function convsamp() can be found in jcdctmgr.c.
+ * With 12-bit samples, quantization requires a true integer division, so it
+ * is performed by the C implementation (quantize() in jcdctmgr.c).
+ */
+
+void jsimd_convsamp_neon(JSAMPARRAY sample_data, JDIMENSION start_col,
+                         DCTELEM *workspace)
+{
+  const int16x8_t center = vdupq_n_s16(CENTERJSAMPLE);
+  int row;
+
+  for (row = 0; row < DCTSIZE; row++) {
+    int16x8_t samples =
+      vsubq_s16(vld1q_s16(sample_data[row] + start_col), center);
+    int32x4_t samples_l = vmovl_s16(vget_low_s16(samples));
+    int32x4_t samples_h = vmovl_s16(vget_high_s16(samples));
+
+    if (sizeof(DCTELEM) == 8) {
+      int64_t *wsptr = (int64_t *)workspace + row * DCTSIZE;
+
+      vst1q_s64(wsptr + 0, vmovl_s32(vget_low_s32(samples_l)));
+      vst1q_s64(wsptr + 2, vmovl_s32(vget_high_s32(samples_l)));
+      vst1q_s64(wsptr + 4, vmovl_s32(vget_low_s32(samples_h)));
+      vst1q_s64(wsptr + 6, vmovl_s32(vget_high_s32(samples_h)));
+    } else {
+      int32_t *wsptr = (int32_t *)workspace + row * DCTSIZE;
+
+      vst1q_s32(wsptr + 0, samples_l);
+      vst1q_s32(wsptr + 4, samples_h);
+    }
+  }
+}
@@ -28,6 +28,12 @@
 #define JSIMD_AVX2     0x80
 #define JSIMD_MMI      0x100
 
+/* Acceleration methods allowed by each SIMD tier (JSIMD_TIER_* in jpeglib.h) */
+
+#define JSIMD_TIER_MASK(tier) \
+  ((tier) == JSIMD_TIER_NONE ? 0U : \
+   (tier) == JSIMD_TIER_BASE ? ~(unsigned int)JSIMD_AVX2 : ~0U)
+
 /* SIMD Ext: retrieve SIMD/CPU information */
 EXTERN(unsigned int) jpeg_simd_cpu_support(void);
 
@@ -25,7 +25,7 @@
 
 #include <ctype.h>
 
-static THREAD_LOCAL unsigned int simd_support = ~0;
+static THREAD_LOCAL unsigned int cpu_support = ~0;
 
 #if !(defined(__mips_dsp) && (__mips_dsp_rev >= 2)) && defined(__linux__)
 
@@ -36,13 +36,13 @@ parse_proc_cpuinfo(const char *search_string)
   char cpuinfo_line[256];
   FILE *f = NULL;
 
-  simd_support = 0;
+  cpu_support = 0;
 
   if ((f = fopen(file_name, "r")) != NULL) {
     while (fgets(cpuinfo_line, sizeof(cpuinfo_line), f) != NULL) {
       if (strstr(cpuinfo_line, search_string) != NULL) {
         fclose(f);
-        simd_support |= JSIMD_DSPR2;
+        cpu_support |= JSIMD_DSPR2;
         return;
       }
     }
@@ -63,13 +63,13 @@ init_simd(void)
   char *env = NULL;
 #endif
 
-  if (simd_support != ~0U)
+  if (cpu_support != ~0U)
     return;
 
-  simd_support = 0;
+  cpu_support = 0;
 
 #if defined(__mips_dsp) && (__mips_dsp_rev >= 2)
-  simd_support |= JSIMD_DSPR2;
+  cpu_support |= JSIMD_DSPR2;
 #elif defined(__linux__)
   /* We still have a chance to use MIPS DSPR2 regardless of globally used
    * -mdspr2 options passed to gcc by performing runtime detection via
@@ -81,10 +81,10 @@ init_simd(void)
   /* Force different settings through environment variables */
   env = getenv("JSIMD_FORCEDSPR2");
   if ((env != NULL) && (strcmp(env, "1") == 0))
-    simd_support = JSIMD_DSPR2;
+    cpu_support = JSIMD_DSPR2;
   env = getenv("JSIMD_FORCENONE");
   if ((env != NULL) && (strcmp(env, "1") == 0))
-    simd_support = 0;
+    cpu_support = 0;
 #endif
 }
 
@@ -113,74 +113,69 @@ typedef struct {
 
 typedef my_upsampler *my_upsample_ptr;
 
-GLOBAL(int)
-jsimd_can_rgb_ycc(void)
+LOCAL(void)
+init_rgb_ycc(jsimd_rgb_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_DSPR2)
-    return 1;
+  if (!(simd_support & JSIMD_DSPR2))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _ycc_convert_dspr2);
+  kernels[JCS_RGB] = kernels[JCS_EXT_RGB];
 }
 
-GLOBAL(int)
-jsimd_can_rgb_gray(void)
+LOCAL(void)
+init_rgb_gray(jsimd_rgb_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_DSPR2)
-    return 1;
+  if (!(simd_support & JSIMD_DSPR2))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _gray_convert_dspr2);
+  kernels[JCS_RGB] = kernels[JCS_EXT_RGB];
 }
 
-GLOBAL(int)
-jsimd_can_ycc_rgb(void)
+LOCAL(void)
+init_ycc_rgb(jsimd_ycc_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_DSPR2)
-    return 1;
+  if (!(simd_support & JSIMD_DSPR2))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_ycc_, _convert_dspr2);
+  kernels[JCS_RGB] = kernels[JCS_EXT_RGB];
 }
 
-GLOBAL(int)
-jsimd_can_ycc_rgb565(void)
+LOCAL(int)
+can_ycc_rgb565(unsigned int simd_support)
 {
   return 0;
 }
 
-GLOBAL(int)
-jsimd_c_can_null_convert(void)
+LOCAL(int)
+can_c_null_convert(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -193,120 +188,6 @@ jsimd_c_can_null_convert(void)
   return 0;
 }
 
-GLOBAL(void)
-jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                      JSAMPIMAGE output_buf, JDIMENSION output_row,
-                      int num_rows)
-{
-  void (*dspr2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    dspr2fct = jsimd_extrgb_ycc_convert_dspr2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    dspr2fct = jsimd_extrgbx_ycc_convert_dspr2;
-    break;
-  case JCS_EXT_BGR:
-    dspr2fct = jsimd_extbgr_ycc_convert_dspr2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    dspr2fct = jsimd_extbgrx_ycc_convert_dspr2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    dspr2fct = jsimd_extxbgr_ycc_convert_dspr2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    dspr2fct = jsimd_extxrgb_ycc_convert_dspr2;
-    break;
-  default:
-    dspr2fct = jsimd_extrgb_ycc_convert_dspr2;
-    break;
-  }
-
-  dspr2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-}
-
-GLOBAL(void)
-jsimd_rgb_gray_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                       JSAMPIMAGE output_buf, JDIMENSION output_row,
-                       int num_rows)
-{
-  void (*dspr2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    dspr2fct = jsimd_extrgb_gray_convert_dspr2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    dspr2fct = jsimd_extrgbx_gray_convert_dspr2;
-    break;
-  case JCS_EXT_BGR:
-    dspr2fct = jsimd_extbgr_gray_convert_dspr2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    dspr2fct = jsimd_extbgrx_gray_convert_dspr2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    dspr2fct = jsimd_extxbgr_gray_convert_dspr2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    dspr2fct = jsimd_extxrgb_gray_convert_dspr2;
-    break;
-  default:
-    dspr2fct = jsimd_extrgb_gray_convert_dspr2;
-    break;
-  }
-
-  dspr2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-}
-
-GLOBAL(void)
-jsimd_ycc_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
-                      JDIMENSION input_row, JSAMPARRAY output_buf,
-                      int num_rows)
-{
-  void (*dspr2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY, int);
-
-  switch (cinfo->out_color_space) {
-  case JCS_EXT_RGB:
-    dspr2fct = jsimd_ycc_extrgb_convert_dspr2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    dspr2fct = jsimd_ycc_extrgbx_convert_dspr2;
-    break;
-  case JCS_EXT_BGR:
-    dspr2fct = jsimd_ycc_extbgr_convert_dspr2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    dspr2fct = jsimd_ycc_extbgrx_convert_dspr2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    dspr2fct = jsimd_ycc_extxbgr_convert_dspr2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    dspr2fct = jsimd_ycc_extxrgb_convert_dspr2;
-    break;
-  default:
-    dspr2fct = jsimd_ycc_extrgb_convert_dspr2;
-    break;
-  }
-
-  dspr2fct(cinfo->output_width, input_buf, input_row, output_buf, num_rows);
-}
-
 GLOBAL(void)
 jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                          JDIMENSION input_row, JSAMPARRAY output_buf,
@@ -323,11 +204,9 @@ jsimd_c_null_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
                              output_row, num_rows, cinfo->num_components);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_downsample(void)
+LOCAL(int)
+can_h2v2_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -345,11 +224,9 @@ jsimd_can_h2v2_downsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_smooth_downsample(void)
+LOCAL(int)
+can_h2v2_smooth_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -364,11 +241,9 @@ jsimd_can_h2v2_smooth_downsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_downsample(void)
+LOCAL(int)
+can_h2v1_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -417,11 +292,9 @@ jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
                               input_data, output_data);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_upsample(void)
+LOCAL(int)
+can_h2v2_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -434,11 +307,9 @@ jsimd_can_h2v2_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_upsample(void)
+LOCAL(int)
+can_h2v1_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -453,11 +324,9 @@ jsimd_can_h2v1_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_int_upsample(void)
+LOCAL(int)
+can_int_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -498,11 +367,9 @@ jsimd_int_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                            cinfo->max_v_samp_factor);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_fancy_upsample(void)
+LOCAL(int)
+can_h2v2_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -517,11 +384,9 @@ jsimd_can_h2v2_fancy_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_fancy_upsample(void)
+LOCAL(int)
+can_h2v1_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -554,11 +419,9 @@ jsimd_h2v1_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                                   output_data_ptr);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_merged_upsample(void)
+LOCAL(int)
+can_h2v2_merged_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -571,11 +434,9 @@ jsimd_can_h2v2_merged_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_merged_upsample(void)
+LOCAL(int)
+can_h2v1_merged_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -664,11 +525,9 @@ jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
            cinfo->sample_range_limit);
 }
 
-GLOBAL(int)
-jsimd_can_convsamp(void)
+LOCAL(int)
+can_convsamp(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -687,11 +546,9 @@ jsimd_can_convsamp(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_convsamp_float(void)
+LOCAL(int)
+can_convsamp_float(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -728,11 +585,9 @@ jsimd_convsamp_float(JSAMPARRAY sample_data, JDIMENSION start_col,
 #endif
 }
 
-GLOBAL(int)
-jsimd_can_fdct_islow(void)
+LOCAL(int)
+can_fdct_islow(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -747,11 +602,9 @@ jsimd_can_fdct_islow(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_ifast(void)
+LOCAL(int)
+can_fdct_ifast(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -766,8 +619,8 @@ jsimd_can_fdct_ifast(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_float(void)
+LOCAL(int)
+can_fdct_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -789,11 +642,9 @@ jsimd_fdct_float(FAST_FLOAT *data)
 {
 }
 
-GLOBAL(int)
-jsimd_can_quantize(void)
+LOCAL(int)
+can_quantize(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -808,11 +659,9 @@ jsimd_can_quantize(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_quantize_float(void)
+LOCAL(int)
+can_quantize_float(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -848,11 +697,9 @@ jsimd_quantize_float(JCOEFPTR coef_block, FAST_FLOAT *divisors,
 #endif
 }
 
-GLOBAL(int)
-jsimd_can_idct_2x2(void)
+LOCAL(int)
+can_idct_2x2(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -871,11 +718,9 @@ jsimd_can_idct_2x2(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_4x4(void)
+LOCAL(int)
+can_idct_4x4(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -896,11 +741,9 @@ jsimd_can_idct_4x4(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_6x6(void)
+LOCAL(int)
+can_idct_6x6(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -919,11 +762,9 @@ jsimd_can_idct_6x6(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_12x12(void)
+LOCAL(int)
+can_idct_12x12(unsigned int simd_support)
 {
-  init_simd();
-
   if (BITS_IN_JSAMPLE != 8)
     return 0;
   if (DCTSIZE != 8)
@@ -993,11 +834,9 @@ jsimd_idct_12x12(j_decompress_ptr cinfo, jpeg_component_info *compptr,
   jsimd_idct_12x12_pass2_dspr2(workspace, output);
 }
 
-GLOBAL(int)
-jsimd_can_idct_islow(void)
+LOCAL(int)
+can_idct_islow(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -1016,11 +855,9 @@ jsimd_can_idct_islow(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_ifast(void)
+LOCAL(int)
+can_idct_ifast(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -1043,8 +880,8 @@ jsimd_can_idct_ifast(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_float(void)
+LOCAL(int)
+can_idct_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -1101,8 +938,8 @@ jsimd_idct_float(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
-GLOBAL(int)
-jsimd_can_huff_encode_one_block(void)
+LOCAL(int)
+can_huff_encode_one_block(unsigned int simd_support)
 {
   return 0;
 }
@@ -1115,8 +952,8 @@ jsimd_huff_encode_one_block(void *state, JOCTET *buffer, JCOEFPTR block,
   return NULL;
 }
 
-GLOBAL(int)
-jsimd_can_encode_mcu_AC_first_prepare(void)
+LOCAL(int)
+can_encode_mcu_AC_first_prepare(unsigned int simd_support)
 {
   return 0;
 }
@@ -1128,8 +965,8 @@ jsimd_encode_mcu_AC_first_prepare(const JCOEF *block,
 {
 }
 
-GLOBAL(int)
-jsimd_can_encode_mcu_AC_refine_prepare(void)
+LOCAL(int)
+can_encode_mcu_AC_refine_prepare(unsigned int simd_support)
 {
   return 0;
 }
@@ -1141,3 +978,83 @@ jsimd_encode_mcu_AC_refine_prepare(const JCOEF *block,
 {
   return 0;
 }
+
+/*
+ * Determine which SIMD kernels a compression or decompression object can use,
+ * given its SIMD tier.
+ */
+GLOBAL(void)
+jsimd_init_table(struct jpeg_simd_table *table, int tier, boolean huffman)
+{
+  unsigned int simd_support;
+
+  init_simd();
+  simd_support = cpu_support & JSIMD_TIER_MASK(tier);
+
+  memset(table, 0, sizeof(struct jpeg_simd_table));
+  table->support = simd_support;
+  init_rgb_ycc(table->rgb_ycc, simd_support);
+  init_rgb_gray(table->rgb_gray, simd_support);
+  init_ycc_rgb(table->ycc_rgb, simd_support);
+  table->ycc_rgb565 = can_ycc_rgb565(simd_support) ?
+                      jsimd_ycc_rgb565_convert : NULL;
+  table->c_null_convert = can_c_null_convert(simd_support) ?
+                          jsimd_c_null_convert : NULL;
+  table->h2v2_downsample = can_h2v2_downsample(simd_support) ?
+                           jsimd_h2v2_downsample : NULL;
+  table->h2v2_smooth_downsample = can_h2v2_smooth_downsample(simd_support) ?
+                                  jsimd_h2v2_smooth_downsample : NULL;
+  table->h2v1_downsample = can_h2v1_downsample(simd_support) ?
+                           jsimd_h2v1_downsample : NULL;
+  table->h2v2_upsample = can_h2v2_upsample(simd_support) ?
+                         jsimd_h2v2_upsample : NULL;
+  table->h2v1_upsample = can_h2v1_upsample(simd_support) ?
+                         jsimd_h2v1_upsample : NULL;
+  table->int_upsample = can_int_upsample(simd_support) ?
+                        jsimd_int_upsample : NULL;
+  table->h2v2_fancy_upsample = can_h2v2_fancy_upsample(simd_support) ?
+                               jsimd_h2v2_fancy_upsample : NULL;
+  table->h2v1_fancy_upsample = can_h2v1_fancy_upsample(simd_support) ?
+                               jsimd_h2v1_fancy_upsample : NULL;
+  table->h2v2_merged_upsample = can_h2v2_merged_upsample(simd_support) ?
+                                jsimd_h2v2_merged_upsample : NULL;
+  table->h2v1_merged_upsample = can_h2v1_merged_upsample(simd_support) ?
+                                jsimd_h2v1_merged_upsample : NULL;
+  table->convsamp = can_convsamp(simd_support) ?
+                    (jsimd_kernel_ptr)jsimd_convsamp : NULL;
+  table->convsamp_float = can_convsamp_float(simd_support) ?
+                          (jsimd_kernel_ptr)jsimd_convsamp_float : NULL;
+  table->fdct_islow = can_fdct_islow(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_islow : NULL;
+  table->fdct_ifast = can_fdct_ifast(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_ifast : NULL;
+  table->fdct_float = can_fdct_float(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_float : NULL;
+  table->quantize = can_quantize(simd_support) ?
+                    (jsimd_kernel_ptr)jsimd_quantize : NULL;
+  table->quantize_float = can_quantize_float(simd_support) ?
+                          (jsimd_kernel_ptr)jsimd_quantize_float : NULL;
+  table->idct_2x2 = can_idct_2x2(simd_support) ?
+                    jsimd_idct_2x2 : NULL;
+  table->idct_4x4 = can_idct_4x4(simd_support) ?
+                    jsimd_idct_4x4 : NULL;
+  table->idct_6x6 = can_idct_6x6(simd_support) ?
+                    jsimd_idct_6x6 : NULL;
+  table->idct_12x12 = can_idct_12x12(simd_support) ?
+                      jsimd_idct_12x12 : NULL;
+  table->idct_islow = can_idct_islow(simd_support) ?
+                      jsimd_idct_islow : NULL;
+  table->idct_ifast = can_idct_ifast(simd_support) ?
+                      jsimd_idct_ifast : NULL;
+  table->idct_float = can_idct_float(simd_support) ?
+                      jsimd_idct_float : NULL;
+  if (can_huff_encode_one_block(simd_support))
+    table->huff_encode_one_block =
+      (jsimd_kernel_ptr)jsimd_huff_encode_one_block;
+  table->encode_mcu_AC_first_prepare =
+    can_encode_mcu_AC_first_prepare(simd_support) ?
+    jsimd_encode_mcu_AC_first_prepare : NULL;
+  table->encode_mcu_AC_refine_prepare =
+    can_encode_mcu_AC_refine_prepare(simd_support) ?
+    jsimd_encode_mcu_AC_refine_prepare : NULL;
+}
@@ -41,7 +41,7 @@
 #include <sys/auxv.h>
 #endif
 
-static THREAD_LOCAL unsigned int simd_support = ~0;
+static THREAD_LOCAL unsigned int cpu_support = ~0;
 
 #if !defined(__ALTIVEC__) && (defined(__linux__) || defined(ANDROID) || defined(__ANDROID__))
 
@@ -82,7 +82,7 @@ parse_proc_cpuinfo(int bufsize)
   char *buffer = (char *)malloc(bufsize);
   FILE *fd;
 
-  simd_support = 0;
+  cpu_support = 0;
 
   if (!buffer)
     return 0;
@@ -97,7 +97,7 @@ parse_proc_cpuinfo(int bufsize)
         return 0;
       }
       if (check_feature(buffer, "altivec"))
-        simd_support |= JSIMD_ALTIVEC;
+        cpu_support |= JSIMD_ALTIVEC;
     }
     fclose(fd);
   }
@@ -132,13 +132,13 @@ init_simd(void)
   unsigned long cpufeatures = 0;
 #endif
 
-  if (simd_support != ~0U)
+  if (cpu_support != ~0U)
     return;
 
-  simd_support = 0;
+  cpu_support = 0;
 
 #if defined(__ALTIVEC__)
-  simd_support |= JSIMD_ALTIVEC;
+  cpu_support |= JSIMD_ALTIVEC;
 #elif defined(__linux__) || defined(ANDROID) || defined(__ANDROID__)
   while (!parse_proc_cpuinfo(bufsize)) {
     bufsize *= 2;
@@ -148,204 +148,87 @@ init_simd(void)
 #elif defined(__amigaos4__)
   IExec->GetCPUInfoTags(GCIT_VectorUnit, &altivec, TAG_DONE);
   if (altivec == VECTORTYPE_ALTIVEC)
-    simd_support |= JSIMD_ALTIVEC;
+    cpu_support |= JSIMD_ALTIVEC;
 #elif defined(__APPLE__) || defined(__OpenBSD__)
   if (sysctl(mib, 2, &altivec, &len, NULL, 0) == 0 && altivec != 0)
-    simd_support |= JSIMD_ALTIVEC;
+    cpu_support |= JSIMD_ALTIVEC;
 #elif defined(__FreeBSD__)
   elf_aux_info(AT_HWCAP, &cpufeatures, sizeof(cpufeatures));
   if (cpufeatures & PPC_FEATURE_HAS_ALTIVEC)
-    simd_support |= JSIMD_ALTIVEC;
+    cpu_support |= JSIMD_ALTIVEC;
 #endif
 
 #ifndef NO_GETENV
   /* Force different settings through environment variables */
   env = getenv("JSIMD_FORCEALTIVEC");
   if ((env != NULL) && (strcmp(env, "1") == 0))
-    simd_support = JSIMD_ALTIVEC;
+    cpu_support = JSIMD_ALTIVEC;
   env = getenv("JSIMD_FORCENONE");
   if ((env != NULL) && (strcmp(env, "1") == 0))
-    simd_support = 0;
+    cpu_support = 0;
 #endif
 }
 
-GLOBAL(int)
-jsimd_can_rgb_ycc(void)
+LOCAL(void)
+init_rgb_ycc(jsimd_rgb_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_ALTIVEC)
-    return 1;
+  if (!(simd_support & JSIMD_ALTIVEC))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _ycc_convert_altivec);
+  kernels[JCS_RGB] = jsimd_rgb_ycc_convert_altivec;
 }
 
-GLOBAL(int)
-jsimd_can_rgb_gray(void)
+LOCAL(void)
+init_rgb_gray(jsimd_rgb_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_ALTIVEC)
-    return 1;
+  if (!(simd_support & JSIMD_ALTIVEC))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _gray_convert_altivec);
+  kernels[JCS_RGB] = jsimd_rgb_gray_convert_altivec;
 }
 
-GLOBAL(int)
-jsimd_can_ycc_rgb(void)
+LOCAL(void)
+init_ycc_rgb(jsimd_ycc_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
-  if (simd_support & JSIMD_ALTIVEC)
-    return 1;
+  if (!(simd_support & JSIMD_ALTIVEC))
+    return;
 
-  return 0;
+  JSIMD_SET_RGB_KERNELS(kernels, jsimd_ycc_, _convert_altivec);
+  kernels[JCS_RGB] = jsimd_ycc_rgb_convert_altivec;
 }
 
-GLOBAL(int)
-jsimd_can_ycc_rgb565(void)
+LOCAL(int)
+can_ycc_rgb565(unsigned int simd_support)
 {
   return 0;
 }
 
-GLOBAL(void)
-jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                      JSAMPIMAGE output_buf, JDIMENSION output_row,
-                      int num_rows)
-{
-  void (*altivecfct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    altivecfct = jsimd_extrgb_ycc_convert_altivec;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    altivecfct = jsimd_extrgbx_ycc_convert_altivec;
-    break;
-  case JCS_EXT_BGR:
-    altivecfct = jsimd_extbgr_ycc_convert_altivec;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    altivecfct = jsimd_extbgrx_ycc_convert_altivec;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    altivecfct = jsimd_extxbgr_ycc_convert_altivec;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    altivecfct = jsimd_extxrgb_ycc_convert_altivec;
-    break;
-  default:
-    altivecfct = jsimd_rgb_ycc_convert_altivec;
-    break;
-  }
-
-  altivecfct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-}
-
-GLOBAL(void)
-jsimd_rgb_gray_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                       JSAMPIMAGE output_buf, JDIMENSION output_row,
-                       int num_rows)
-{
-  void (*altivecfct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    altivecfct = jsimd_extrgb_gray_convert_altivec;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    altivecfct = jsimd_extrgbx_gray_convert_altivec;
-    break;
-  case JCS_EXT_BGR:
-    altivecfct = jsimd_extbgr_gray_convert_altivec;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    altivecfct = jsimd_extbgrx_gray_convert_altivec;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    altivecfct = jsimd_extxbgr_gray_convert_altivec;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    altivecfct = jsimd_extxrgb_gray_convert_altivec;
-    break;
-  default:
-    altivecfct = jsimd_rgb_gray_convert_altivec;
-    break;
-  }
-
-  altivecfct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-}
-
-GLOBAL(void)
-jsimd_ycc_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
-                      JDIMENSION input_row, JSAMPARRAY output_buf,
-                      int num_rows)
-{
-  void (*altivecfct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY, int);
-
-  switch (cinfo->out_color_space) {
-  case JCS_EXT_RGB:
-    altivecfct = jsimd_ycc_extrgb_convert_altivec;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    altivecfct = jsimd_ycc_extrgbx_convert_altivec;
-    break;
-  case JCS_EXT_BGR:
-    altivecfct = jsimd_ycc_extbgr_convert_altivec;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    altivecfct = jsimd_ycc_extbgrx_convert_altivec;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    altivecfct = jsimd_ycc_extxbgr_convert_altivec;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    altivecfct = jsimd_ycc_extxrgb_convert_altivec;
-    break;
-  default:
-    altivecfct = jsimd_ycc_rgb_convert_altivec;
-    break;
-  }
-
-  altivecfct(cinfo->output_width, input_buf, input_row, output_buf, num_rows);
-}
-
 GLOBAL(void)
 jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                          JDIMENSION input_row, JSAMPARRAY output_buf,
@@ -353,11 +236,9 @@ jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 {
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_downsample(void)
+LOCAL(int)
+can_h2v2_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -370,11 +251,9 @@ jsimd_can_h2v2_downsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_downsample(void)
+LOCAL(int)
+can_h2v1_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -407,11 +286,9 @@ jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
                                 output_data);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_upsample(void)
+LOCAL(int)
+can_h2v2_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -424,11 +301,9 @@ jsimd_can_h2v2_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_upsample(void)
+LOCAL(int)
+can_h2v1_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -457,11 +332,9 @@ jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                               input_data, output_data_ptr);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_fancy_upsample(void)
+LOCAL(int)
+can_h2v2_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -474,11 +347,9 @@ jsimd_can_h2v2_fancy_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_fancy_upsample(void)
+LOCAL(int)
+can_h2v1_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -509,11 +380,9 @@ jsimd_h2v1_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                                     output_data_ptr);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_merged_upsample(void)
+LOCAL(int)
+can_h2v2_merged_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -526,11 +395,9 @@ jsimd_can_h2v2_merged_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_merged_upsample(void)
+LOCAL(int)
+can_h2v1_merged_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -617,11 +484,9 @@ jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
   altivecfct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
 }
 
-GLOBAL(int)
-jsimd_can_convsamp(void)
+LOCAL(int)
+can_convsamp(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -638,8 +503,8 @@ jsimd_can_convsamp(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_convsamp_float(void)
+LOCAL(int)
+can_convsamp_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -657,11 +522,9 @@ jsimd_convsamp_float(JSAMPARRAY sample_data, JDIMENSION start_col,
 {
 }
 
-GLOBAL(int)
-jsimd_can_fdct_islow(void)
+LOCAL(int)
+can_fdct_islow(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -674,11 +537,9 @@ jsimd_can_fdct_islow(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_ifast(void)
+LOCAL(int)
+can_fdct_ifast(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -691,8 +552,8 @@ jsimd_can_fdct_ifast(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_float(void)
+LOCAL(int)
+can_fdct_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -714,11 +575,9 @@ jsimd_fdct_float(FAST_FLOAT *data)
 {
 }
 
-GLOBAL(int)
-jsimd_can_quantize(void)
+LOCAL(int)
+can_quantize(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -733,8 +592,8 @@ jsimd_can_quantize(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_quantize_float(void)
+LOCAL(int)
+can_quantize_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -751,14 +610,14 @@ jsimd_quantize_float(JCOEFPTR coef_block, FAST_FLOAT *divisors,
 {
 }
 
-GLOBAL(int)
-jsimd_can_idct_2x2(void)
+LOCAL(int)
+can_idct_2x2(unsigned int simd_support)
 {
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_4x4(void)
+LOCAL(int)
+can_idct_4x4(unsigned int simd_support)
 {
   return 0;
 }
@@ -777,11 +636,9 @@ jsimd_idct_4x4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
-GLOBAL(int)
-jsimd_can_idct_islow(void)
+LOCAL(int)
+can_idct_islow(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -794,11 +651,9 @@ jsimd_can_idct_islow(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_ifast(void)
+LOCAL(int)
+can_idct_ifast(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -811,8 +666,8 @@ jsimd_can_idct_ifast(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_float(void)
+LOCAL(int)
+can_idct_float(unsigned int simd_support)
 {
   return 0;
 }
@@ -842,8 +697,8 @@ jsimd_idct_float(j_decompress_ptr cinfo, jpeg_component_info *compptr,
 {
 }
 
-GLOBAL(int)
-jsimd_can_huff_encode_one_block(void)
+LOCAL(int)
+can_huff_encode_one_block(unsigned int simd_support)
 {
   return 0;
 }
@@ -856,8 +711,8 @@ jsimd_huff_encode_one_block(void *state, JOCTET *buffer, JCOEFPTR block,
   return NULL;
 }
 
-GLOBAL(int)
-jsimd_can_encode_mcu_AC_first_prepare(void)
+LOCAL(int)
+can_encode_mcu_AC_first_prepare(unsigned int simd_support)
 {
   return 0;
 }
@@ -869,8 +724,8 @@ jsimd_encode_mcu_AC_first_prepare(const JCOEF *block,
 {
 }
 
-GLOBAL(int)
-jsimd_can_encode_mcu_AC_refine_prepare(void)
+LOCAL(int)
+can_encode_mcu_AC_refine_prepare(unsigned int simd_support)
 {
   return 0;
 }
@@ -882,3 +737,73 @@ jsimd_encode_mcu_AC_refine_prepare(const JCOEF *block,
 {
   return 0;
 }
+
+/*
+ * Determine which SIMD kernels a compression or decompression object can use,
+ * given its SIMD tier.
+ */
+GLOBAL(void)
+jsimd_init_table(struct jpeg_simd_table *table, int tier, boolean huffman)
+{
+  unsigned int simd_support;
+
+  init_simd();
+  simd_support = cpu_support & JSIMD_TIER_MASK(tier);
+
+  memset(table, 0, sizeof(struct jpeg_simd_table));
+  table->support = simd_support;
+  init_rgb_ycc(table->rgb_ycc, simd_support);
+  init_rgb_gray(table->rgb_gray, simd_support);
+  init_ycc_rgb(table->ycc_rgb, simd_support);
+  table->ycc_rgb565 = can_ycc_rgb565(simd_support) ?
+                      jsimd_ycc_rgb565_convert : NULL;
+  table->h2v2_downsample = can_h2v2_downsample(simd_support) ?
+                           jsimd_h2v2_downsample : NULL;
+  table->h2v1_downsample = can_h2v1_downsample(simd_support) ?
+                           jsimd_h2v1_downsample : NULL;
+  table->h2v2_upsample = can_h2v2_upsample(simd_support) ?
+                         jsimd_h2v2_upsample : NULL;
+  table->h2v1_upsample = can_h2v1_upsample(simd_support) ?
+                         jsimd_h2v1_upsample : NULL;
+  table->h2v2_fancy_upsample = can_h2v2_fancy_upsample(simd_support) ?
+                               jsimd_h2v2_fancy_upsample : NULL;
+  table->h2v1_fancy_upsample = can_h2v1_fancy_upsample(simd_support) ?
+                               jsimd_h2v1_fancy_upsample : NULL;
+  table->h2v2_merged_upsample = can_h2v2_merged_upsample(simd_support) ?
+                                jsimd_h2v2_merged_upsample : NULL;
+  table->h2v1_merged_upsample = can_h2v1_merged_upsample(simd_support) ?
+                                jsimd_h2v1_merged_upsample : NULL;
+  table->convsamp = can_convsamp(simd_support) ?
+                    (jsimd_kernel_ptr)jsimd_convsamp : NULL;
+  table->convsamp_float = can_convsamp_float(simd_support) ?
+                          (jsimd_kernel_ptr)jsimd_convsamp_float : NULL;
+  table->fdct_islow = can_fdct_islow(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_islow : NULL;
+  table->fdct_ifast = can_fdct_ifast(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_ifast : NULL;
+  table->fdct_float = can_fdct_float(simd_support) ?
+                      (jsimd_kernel_ptr)jsimd_fdct_float : NULL;
+  table->quantize = can_quantize(simd_support) ?
+                    (jsimd_kernel_ptr)jsimd_quantize : NULL;
+  table->quantize_float = can_quantize_float(simd_support) ?
+                          (jsimd_kernel_ptr)jsimd_quantize_float : NULL;
+  table->idct_2x2 = can_idct_2x2(simd_support) ?
+                    jsimd_idct_2x2 : NULL;
+  table->idct_4x4 = can_idct_4x4(simd_support) ?
+                    jsimd_idct_4x4 : NULL;
+  table->idct_islow = can_idct_islow(simd_support) ?
+                      jsimd_idct_islow : NULL;
+  table->idct_ifast = can_idct_ifast(simd_support) ?
+                      jsimd_idct_ifast : NULL;
+  table->idct_float = can_idct_float(simd_support) ?
+                      jsimd_idct_float : NULL;
+  if (can_huff_encode_one_block(simd_support))
+    table->huff_encode_one_block =
+      (jsimd_kernel_ptr)jsimd_huff_encode_one_block;
+  table->encode_mcu_AC_first_prepare =
+    can_encode_mcu_AC_first_prepare(simd_support) ?
+    jsimd_encode_mcu_AC_first_prepare : NULL;
+  table->encode_mcu_AC_refine_prepare =
+    can_encode_mcu_AC_refine_prepare(simd_support) ?
+    jsimd_encode_mcu_AC_refine_prepare : NULL;
+}
@@ -31,7 +31,7 @@
 #define IS_ALIGNED_SSE(ptr)  (IS_ALIGNED(ptr, 4)) /* 16 byte alignment */
 #define IS_ALIGNED_AVX(ptr)  (IS_ALIGNED(ptr, 5)) /* 32 byte alignment */
 
-static THREAD_LOCAL unsigned int simd_support = (unsigned int)(~0);
+static THREAD_LOCAL unsigned int cpu_support = (unsigned int)(~0);
 static THREAD_LOCAL unsigned int simd_huffman = 1;
 
 /*
@@ -44,244 +44,94 @@ init_simd(void)
   char env[2] = { 0 };
 #endif
 
-  if (simd_support != ~0U)
+  if (cpu_support != ~0U)
     return;
 
-  simd_support = jpeg_simd_cpu_support();
+  cpu_support = jpeg_simd_cpu_support();
 
 #ifndef NO_GETENV
   /* Force different settings through environment variables */
   if (!GETENV_S(env, 2, "JSIMD_FORCESSE2") && !strcmp(env, "1"))
-    simd_support &= JSIMD_SSE2;
+    cpu_support &= JSIMD_SSE2;
   if (!GETENV_S(env, 2, "JSIMD_FORCEAVX2") && !strcmp(env, "1"))
-    simd_support &= JSIMD_AVX2;
+    cpu_support &= JSIMD_AVX2;
   if (!GETENV_S(env, 2, "JSIMD_FORCENONE") && !strcmp(env, "1"))
-    simd_support = 0;
+    cpu_support = 0;
   if (!GETENV_S(env, 2, "JSIMD_NOHUFFENC") && !strcmp(env, "1"))
     simd_huffman = 0;
 #endif
 }
 
-GLOBAL(int)
-jsimd_can_rgb_ycc(void)
+LOCAL(void)
+init_rgb_ycc(jsimd_rgb_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
   if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_rgb_ycc_convert_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_rgb_ycc_convert_sse2))
-    return 1;
-
-  return 0;
+      IS_ALIGNED_AVX(jconst_rgb_ycc_convert_avx2)) {
+    kernels[JCS_RGB] = jsimd_rgb_ycc_convert_avx2;
+    JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _ycc_convert_avx2);
+  } else if ((simd_support & JSIMD_SSE2) &&
+             IS_ALIGNED_SSE(jconst_rgb_ycc_convert_sse2)) {
+    kernels[JCS_RGB] = jsimd_rgb_ycc_convert_sse2;
+    JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _ycc_convert_sse2);
+  }
 }
 
-GLOBAL(int)
-jsimd_can_rgb_gray(void)
+LOCAL(void)
+init_rgb_gray(jsimd_rgb_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
   if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_rgb_gray_convert_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_rgb_gray_convert_sse2))
-    return 1;
-
-  return 0;
+      IS_ALIGNED_AVX(jconst_rgb_gray_convert_avx2)) {
+    kernels[JCS_RGB] = jsimd_rgb_gray_convert_avx2;
+    JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _gray_convert_avx2);
+  } else if ((simd_support & JSIMD_SSE2) &&
+             IS_ALIGNED_SSE(jconst_rgb_gray_convert_sse2)) {
+    kernels[JCS_RGB] = jsimd_rgb_gray_convert_sse2;
+    JSIMD_SET_RGB_KERNELS(kernels, jsimd_, _gray_convert_sse2);
+  }
 }
 
-GLOBAL(int)
-jsimd_can_ycc_rgb(void)
+LOCAL(void)
+init_ycc_rgb(jsimd_ycc_convert_ptr *kernels, unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return;
   if ((RGB_PIXELSIZE != 3) && (RGB_PIXELSIZE != 4))
-    return 0;
+    return;
 
   if ((simd_support & JSIMD_AVX2) &&
-      IS_ALIGNED_AVX(jconst_ycc_rgb_convert_avx2))
-    return 1;
-  if ((simd_support & JSIMD_SSE2) &&
-      IS_ALIGNED_SSE(jconst_ycc_rgb_convert_sse2))
-    return 1;
-
-  return 0;
-}
-
-GLOBAL(int)
-jsimd_can_ycc_rgb565(void)
-{
-  return 0;
-}
-
-GLOBAL(void)
-jsimd_rgb_ycc_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                      JSAMPIMAGE output_buf, JDIMENSION output_row,
-                      int num_rows)
-{
-  void (*avx2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-  void (*sse2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    avx2fct = jsimd_extrgb_ycc_convert_avx2;
-    sse2fct = jsimd_extrgb_ycc_convert_sse2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    avx2fct = jsimd_extrgbx_ycc_convert_avx2;
-    sse2fct = jsimd_extrgbx_ycc_convert_sse2;
-    break;
-  case JCS_EXT_BGR:
-    avx2fct = jsimd_extbgr_ycc_convert_avx2;
-    sse2fct = jsimd_extbgr_ycc_convert_sse2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    avx2fct = jsimd_extbgrx_ycc_convert_avx2;
-    sse2fct = jsimd_extbgrx_ycc_convert_sse2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    avx2fct = jsimd_extxbgr_ycc_convert_avx2;
-    sse2fct = jsimd_extxbgr_ycc_convert_sse2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    avx2fct = jsimd_extxrgb_ycc_convert_avx2;
-    sse2fct = jsimd_extxrgb_ycc_convert_sse2;
-    break;
-  default:
-    avx2fct = jsimd_rgb_ycc_convert_avx2;
-    sse2fct = jsimd_rgb_ycc_convert_sse2;
-    break;
-  }
-
-  if (simd_support & JSIMD_AVX2)
-    avx2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-  else
-    sse2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-}
-
-GLOBAL(void)
-jsimd_rgb_gray_convert(j_compress_ptr cinfo, JSAMPARRAY input_buf,
-                       JSAMPIMAGE output_buf, JDIMENSION output_row,
-                       int num_rows)
-{
-  void (*avx2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-  void (*sse2fct) (JDIMENSION, JSAMPARRAY, JSAMPIMAGE, JDIMENSION, int);
-
-  switch (cinfo->in_color_space) {
-  case JCS_EXT_RGB:
-    avx2fct = jsimd_extrgb_gray_convert_avx2;
-    sse2fct = jsimd_extrgb_gray_convert_sse2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    avx2fct = jsimd_extrgbx_gray_convert_avx2;
-    sse2fct = jsimd_extrgbx_gray_convert_sse2;
-    break;
-  case JCS_EXT_BGR:
-    avx2fct = jsimd_extbgr_gray_convert_avx2;
-    sse2fct = jsimd_extbgr_gray_convert_sse2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    avx2fct = jsimd_extbgrx_gray_convert_avx2;
-    sse2fct = jsimd_extbgrx_gray_convert_sse2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    avx2fct = jsimd_extxbgr_gray_convert_avx2;
-    sse2fct = jsimd_extxbgr_gray_convert_sse2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    avx2fct = jsimd_extxrgb_gray_convert_avx2;
-    sse2fct = jsimd_extxrgb_gray_convert_sse2;
-    break;
-  default:
-    avx2fct = jsimd_rgb_gray_convert_avx2;
-    sse2fct = jsimd_rgb_gray_convert_sse2;
-    break;
+      IS_ALIGNED_AVX(jconst_ycc_rgb_convert_avx2)) {
+    kernels[JCS_RGB] = jsimd_ycc_rgb_convert_avx2;
+    JSIMD_SET_RGB_KERNELS(kernels, jsimd_ycc_, _convert_avx2);
+  } else if ((simd_support & JSIMD_SSE2) &&
+             IS_ALIGNED_SSE(jconst_ycc_rgb_convert_sse2)) {
+    kernels[JCS_RGB] = jsimd_ycc_rgb_convert_sse2;
+    JSIMD_SET_RGB_KERNELS(kernels, jsimd_ycc_, _convert_sse2);
   }
-
-  if (simd_support & JSIMD_AVX2)
-    avx2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
-  else
-    sse2fct(cinfo->image_width, input_buf, output_buf, output_row, num_rows);
 }
 
-GLOBAL(void)
-jsimd_ycc_rgb_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
-                      JDIMENSION input_row, JSAMPARRAY output_buf,
-                      int num_rows)
+LOCAL(int)
+can_ycc_rgb565(unsigned int simd_support)
 {
-  void (*avx2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY, int);
-  void (*sse2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY, int);
-
-  switch (cinfo->out_color_space) {
-  case JCS_EXT_RGB:
-    avx2fct = jsimd_ycc_extrgb_convert_avx2;
-    sse2fct = jsimd_ycc_extrgb_convert_sse2;
-    break;
-  case JCS_EXT_RGBX:
-  case JCS_EXT_RGBA:
-    avx2fct = jsimd_ycc_extrgbx_convert_avx2;
-    sse2fct = jsimd_ycc_extrgbx_convert_sse2;
-    break;
-  case JCS_EXT_BGR:
-    avx2fct = jsimd_ycc_extbgr_convert_avx2;
-    sse2fct = jsimd_ycc_extbgr_convert_sse2;
-    break;
-  case JCS_EXT_BGRX:
-  case JCS_EXT_BGRA:
-    avx2fct = jsimd_ycc_extbgrx_convert_avx2;
-    sse2fct = jsimd_ycc_extbgrx_convert_sse2;
-    break;
-  case JCS_EXT_XBGR:
-  case JCS_EXT_ABGR:
-    avx2fct = jsimd_ycc_extxbgr_convert_avx2;
-    sse2fct = jsimd_ycc_extxbgr_convert_sse2;
-    break;
-  case JCS_EXT_XRGB:
-  case JCS_EXT_ARGB:
-    avx2fct = jsimd_ycc_extxrgb_convert_avx2;
-    sse2fct = jsimd_ycc_extxrgb_convert_sse2;
-    break;
-  default:
-    avx2fct = jsimd_ycc_rgb_convert_avx2;
-    sse2fct = jsimd_ycc_rgb_convert_sse2;
-    break;
-  }
-
-  if (simd_support & JSIMD_AVX2)
-    avx2fct(cinfo->output_width, input_buf, input_row, output_buf, num_rows);
-  else
-    sse2fct(cinfo->output_width, input_buf, input_row, output_buf, num_rows);
+  return 0;
 }
 
 GLOBAL(void)
@@ -291,11 +141,9 @@ jsimd_ycc_rgb565_convert(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
 {
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_downsample(void)
+LOCAL(int)
+can_h2v2_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -310,11 +158,9 @@ jsimd_can_h2v2_downsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_downsample(void)
+LOCAL(int)
+can_h2v1_downsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -333,6 +179,8 @@ GLOBAL(void)
 jsimd_h2v2_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
                       JSAMPARRAY input_data, JSAMPARRAY output_data)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
+
   if (simd_support & JSIMD_AVX2)
     jsimd_h2v2_downsample_avx2(cinfo->image_width, cinfo->max_v_samp_factor,
                                compptr->v_samp_factor,
@@ -349,6 +197,8 @@ GLOBAL(void)
 jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
                       JSAMPARRAY input_data, JSAMPARRAY output_data)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
+
   if (simd_support & JSIMD_AVX2)
     jsimd_h2v1_downsample_avx2(cinfo->image_width, cinfo->max_v_samp_factor,
                                compptr->v_samp_factor,
@@ -361,11 +211,9 @@ jsimd_h2v1_downsample(j_compress_ptr cinfo, jpeg_component_info *compptr,
                                output_data);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_upsample(void)
+LOCAL(int)
+can_h2v2_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -380,11 +228,9 @@ jsimd_can_h2v2_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_upsample(void)
+LOCAL(int)
+can_h2v1_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -403,6 +249,8 @@ GLOBAL(void)
 jsimd_h2v2_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                     JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
+
   if (simd_support & JSIMD_AVX2)
     jsimd_h2v2_upsample_avx2(cinfo->max_v_samp_factor, cinfo->output_width,
                              input_data, output_data_ptr);
@@ -415,6 +263,8 @@ GLOBAL(void)
 jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                     JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
+
   if (simd_support & JSIMD_AVX2)
     jsimd_h2v1_upsample_avx2(cinfo->max_v_samp_factor, cinfo->output_width,
                              input_data, output_data_ptr);
@@ -423,11 +273,9 @@ jsimd_h2v1_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                              input_data, output_data_ptr);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_fancy_upsample(void)
+LOCAL(int)
+can_h2v2_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -444,11 +292,9 @@ jsimd_can_h2v2_fancy_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_fancy_upsample(void)
+LOCAL(int)
+can_h2v1_fancy_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -469,6 +315,8 @@ GLOBAL(void)
 jsimd_h2v2_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                           JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
+
   if (simd_support & JSIMD_AVX2)
     jsimd_h2v2_fancy_upsample_avx2(cinfo->max_v_samp_factor,
                                    compptr->downsampled_width, input_data,
@@ -483,6 +331,8 @@ GLOBAL(void)
 jsimd_h2v1_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                           JSAMPARRAY input_data, JSAMPARRAY *output_data_ptr)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
+
   if (simd_support & JSIMD_AVX2)
     jsimd_h2v1_fancy_upsample_avx2(cinfo->max_v_samp_factor,
                                    compptr->downsampled_width, input_data,
@@ -493,11 +343,9 @@ jsimd_h2v1_fancy_upsample(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                                    output_data_ptr);
 }
 
-GLOBAL(int)
-jsimd_can_h2v2_merged_upsample(void)
+LOCAL(int)
+can_h2v2_merged_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -514,11 +362,9 @@ jsimd_can_h2v2_merged_upsample(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_h2v1_merged_upsample(void)
+LOCAL(int)
+can_h2v1_merged_upsample(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (BITS_IN_JSAMPLE != 8)
     return 0;
@@ -539,6 +385,7 @@ GLOBAL(void)
 jsimd_h2v2_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
   void (*avx2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
   void (*sse2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
 
@@ -587,6 +434,7 @@ GLOBAL(void)
 jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
                            JDIMENSION in_row_group_ctr, JSAMPARRAY output_buf)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
   void (*avx2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
   void (*sse2fct) (JDIMENSION, JSAMPIMAGE, JDIMENSION, JSAMPARRAY);
 
@@ -631,202 +479,132 @@ jsimd_h2v1_merged_upsample(j_decompress_ptr cinfo, JSAMPIMAGE input_buf,
     sse2fct(cinfo->output_width, input_buf, in_row_group_ctr, output_buf);
 }
 
-GLOBAL(int)
-jsimd_can_convsamp(void)
+LOCAL(jsimd_kernel_ptr)
+get_convsamp(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
-    return 0;
+    return NULL;
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return NULL;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return NULL;
   if (sizeof(DCTELEM) != 2)
-    return 0;
+    return NULL;
 
   if (simd_support & JSIMD_AVX2)
-    return 1;
+    return (jsimd_kernel_ptr)jsimd_convsamp_avx2;
   if (simd_support & JSIMD_SSE2)
-    return 1;
+    return (jsimd_kernel_ptr)jsimd_convsamp_sse2;
 
-  return 0;
+  return NULL;
 }
 
-GLOBAL(int)
-jsimd_can_convsamp_float(void)
+LOCAL(jsimd_kernel_ptr)
+get_convsamp_float(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
-    return 0;
+    return NULL;
   if (BITS_IN_JSAMPLE != 8)
-    return 0;
+    return NULL;
   if (sizeof(JDIMENSION) != 4)
-    return 0;
+    return NULL;
   if (sizeof(FAST_FLOAT) != 4)
-    return 0;
+    return NULL;
 
   if (simd_support & JSIMD_SSE2)
-    return 1;
-
-  return 0;
-}
+    return (jsimd_kernel_ptr)jsimd_convsamp_float_sse2;
 
-GLOBAL(void)
-jsimd_convsamp(JSAMPARRAY sample_data, JDIMENSION start_col,
-               DCTELEM *workspace)
-{
-  if (simd_support & JSIMD_AVX2)
-    jsimd_convsamp_avx2(sample_data, start_col, workspace);
-  else
-    jsimd_convsamp_sse2(sample_data, start_col, workspace);
-}
-
-GLOBAL(void)
-jsimd_convsamp_float(JSAMPARRAY sample_data, JDIMENSION start_col,
-                     FAST_FLOAT *workspace)
-{
-  jsimd_convsamp_float_sse2(sample_data, start_col, workspace);
+  return NULL;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_islow(void)
+LOCAL(jsimd_kernel_ptr)
+get_fdct_islow(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
-    return 0;
+    return NULL;
   if (sizeof(DCTELEM) != 2)
-    return 0;
+    return NULL;
 
   if ((simd_support & JSIMD_AVX2) && IS_ALIGNED_AVX(jconst_fdct_islow_avx2))
-    return 1;
+    return (jsimd_kernel_ptr)jsimd_fdct_islow_avx2;
   if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_fdct_islow_sse2))
-    return 1;
+    return (jsimd_kernel_ptr)jsimd_fdct_islow_sse2;
 
-  return 0;
+  return NULL;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_ifast(void)
+LOCAL(jsimd_kernel_ptr)
+get_fdct_ifast(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
-    return 0;
+    return NULL;
   if (sizeof(DCTELEM) != 2)
-    return 0;
+    return NULL;
 
   if ((simd_support & JSIMD_SSE2) && IS_ALIGNED_SSE(jconst_fdct_ifast_sse2))
-    return 1;
+    return (jsimd_kernel_ptr)jsimd_fdct_ifast_sse2;
 
-  return 0;
+  return NULL;
 }
 
-GLOBAL(int)
-jsimd_can_fdct_float(void)
+LOCAL(jsimd_kernel_ptr)
+get_fdct_float(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
-    return 0;
+    return NULL;
   if (sizeof(FAST_FLOAT) != 4)
-    return 0;
+    return NULL;
 
   if ((simd_support & JSIMD_SSE) && IS_ALIGNED_SSE(jconst_fdct_float_sse))
-    return 1;
+    return (jsimd_kernel_ptr)jsimd_fdct_float_sse;
 
-  return 0;
+  return NULL;
 }
 
-GLOBAL(void)
-jsimd_fdct_islow(DCTELEM *data)
+LOCAL(jsimd_kernel_ptr)
+get_quantize(unsigned int simd_support)
 {
-  if (simd_support & JSIMD_AVX2)
-    jsimd_fdct_islow_avx2(data);
-  else
-    jsimd_fdct_islow_sse2(data);
-}
-
-GLOBAL(void)
-jsimd_fdct_ifast(DCTELEM *data)
-{
-  jsimd_fdct_ifast_sse2(data);
-}
-
-GLOBAL(void)
-jsimd_fdct_float(FAST_FLOAT *data)
-{
-  jsimd_fdct_float_sse(data);
-}
-
-GLOBAL(int)
-jsimd_can_quantize(void)
-{
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
-    return 0;
+    return NULL;
   if (sizeof(JCOEF) != 2)
-    return 0;
+    return NULL;
   if (sizeof(DCTELEM) != 2)
-    return 0;
+    return NULL;
 
   if (simd_support & JSIMD_AVX2)
-    return 1;
+    return (jsimd_kernel_ptr)jsimd_quantize_avx2;
   if (simd_support & JSIMD_SSE2)
-    return 1;
+    return (jsimd_kernel_ptr)jsimd_quantize_sse2;
 
-  return 0;
+  return NULL;
 }
 
-GLOBAL(int)
-jsimd_can_quantize_float(void)
+LOCAL(jsimd_kernel_ptr)
+get_quantize_float(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
-    return 0;
+    return NULL;
   if (sizeof(JCOEF) != 2)
-    return 0;
+    return NULL;
   if (sizeof(FAST_FLOAT) != 4)
-    return 0;
+    return NULL;
 
   if (simd_support & JSIMD_SSE2)
-    return 1;
-
-  return 0;
-}
+    return (jsimd_kernel_ptr)jsimd_quantize_float_sse2;
 
-GLOBAL(void)
-jsimd_quantize(JCOEFPTR coef_block, DCTELEM *divisors, DCTELEM *workspace)
-{
-  if (simd_support & JSIMD_AVX2)
-    jsimd_quantize_avx2(coef_block, divisors, workspace);
-  else
-    jsimd_quantize_sse2(coef_block, divisors, workspace);
+  return NULL;
 }
 
-GLOBAL(void)
-jsimd_quantize_float(JCOEFPTR coef_block, FAST_FLOAT *divisors,
-                     FAST_FLOAT *workspace)
+LOCAL(int)
+can_idct_2x2(unsigned int simd_support)
 {
-  jsimd_quantize_float_sse2(coef_block, divisors, workspace);
-}
-
-GLOBAL(int)
-jsimd_can_idct_2x2(void)
-{
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -845,11 +623,9 @@ jsimd_can_idct_2x2(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_4x4(void)
+LOCAL(int)
+can_idct_4x4(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -884,11 +660,9 @@ jsimd_idct_4x4(j_decompress_ptr cinfo, jpeg_component_info *compptr,
   jsimd_idct_4x4_sse2(compptr->dct_table, coef_block, output_buf, output_col);
 }
 
-GLOBAL(int)
-jsimd_can_idct_islow(void)
+LOCAL(int)
+can_idct_islow(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -909,11 +683,9 @@ jsimd_can_idct_islow(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_ifast(void)
+LOCAL(int)
+can_idct_ifast(unsigned int simd_support)
 {
-  init_simd();
-
   /* The code is optimised for these values only */
   if (DCTSIZE != 8)
     return 0;
@@ -934,11 +706,9 @@ jsimd_can_idct_ifast(void)
   return 0;
 }
 
-GLOBAL(int)
-jsimd_can_idct_float(void)
+LOCAL(int)
+can_idct_float(unsigned int simd_support)
 {
-  init_simd();
-
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
@@ -963,6 +733,8 @@ jsimd_idct_islow(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                  JCOEFPTR coef_block, JSAMPARRAY output_buf,
                  JDIMENSION output_col)
 {
+  unsigned int simd_support = cinfo->master->simd.support;
+
   if (simd_support & JSIMD_AVX2)
     jsimd_idct_islow_avx2(compptr->dct_table, coef_block, output_buf,
                           output_col);
@@ -989,17 +761,15 @@ jsimd_idct_float(j_decompress_ptr cinfo, jpeg_component_info *compptr,
                         output_col);
 }
 
-GLOBAL(int)
-jsimd_can_huff_encode_one_block(void)
+LOCAL(int)
+can_huff_encode_one_block(unsigned int simd_support)
 {
-  init_simd();
-
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
     return 0;
 
-  if ((simd_support & JSIMD_SSE2) && simd_huffman &&
+  if ((simd_support & JSIMD_SSE2) &&
       IS_ALIGNED_SSE(jconst_huff_encode_one_block))
     return 1;
 
@@ -1015,11 +785,9 @@ jsimd_huff_encode_one_block(void *state, JOCTET *buffer, JCOEFPTR block,
                                           dctbl, actbl);
 }
 
-GLOBAL(int)
-jsimd_can_encode_mcu_AC_first_prepare(void)
+LOCAL(int)
+can_encode_mcu_AC_first_prepare(unsigned int simd_support)
 {
-  init_simd();
-
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
@@ -1039,11 +807,9 @@ jsimd_encode_mcu_AC_first_prepare(const JCOEF *block,
                                          Sl, Al, values, zerobits);
 }
 
-GLOBAL(int)
-jsimd_can_encode_mcu_AC_refine_prepare(void)
+LOCAL(int)
+can_encode_mcu_AC_refine_prepare(unsigned int simd_support)
 {
-  init_simd();
-
   if (DCTSIZE != 8)
     return 0;
   if (sizeof(JCOEF) != 2)
@@ -1063,3 +829,68 @@ jsimd_encode_mcu_AC_refine_prepare(const JCOEF *block,
                                                  jpeg_natural_order_start,
                                                  Sl, Al, absvalues, bits);
 }
+
+/*
+ * Determine which SIMD kernels a compression or decompression object can use,
+ * given its SIMD tier.  The color conversion, forward DCT, and quantization
+ * kernels aren't passed the object, so the table stores the kernels
+ * themselves, chosen from the instruction sets that the tier allows.
+ */
+GLOBAL(void)
+jsimd_init_table(struct jpeg_simd_table *table, int tier, boolean huffman)
+{
+  unsigned int simd_support;
+
+  init_simd();
+  simd_support = cpu_support & JSIMD_TIER_MASK(tier);
+
+  memset(table, 0, sizeof(struct jpeg_simd_table));
+  table->support = simd_support;
+  init_rgb_ycc(table->rgb_ycc, simd_support);
+  init_rgb_gray(table->rgb_gray, simd_support);
+  init_ycc_rgb(table->ycc_rgb, simd_support);
+  table->ycc_rgb565 = can_ycc_rgb565(simd_support) ?
+                      jsimd_ycc_rgb565_convert : NULL;
+  table->h2v2_downsample = can_h2v2_downsample(simd_support) ?
+                           jsimd_h2v2_downsample : NULL;
+  table->h2v1_downsample = can_h2v1_downsample(simd_support) ?
+                           jsimd_h2v1_downsample : NULL;
+  table->h2v2_upsample = can_h2v2_upsample(simd_support) ?
+                         jsimd_h2v2_upsample : NULL;
+  table->h2v1_upsample = can_h2v1_upsample(simd_support) ?
+                         jsimd_h2v1_upsample : NULL;
+  table->h2v2_fancy_upsample = can_h2v2_fancy_upsample(simd_support) ?
+                               jsimd_h2v2_fancy_upsample : NULL;
+  table->h2v1_fancy_upsample = can_h2v1_fancy_upsample(simd_support) ?
+                               jsimd_h2v1_fancy_upsample : NULL;
+  table->h2v2_merged_upsample = can_h2v2_merged_upsample(simd_support) ?
+                                jsimd_h2v2_merged_upsample : NULL;
+  table->h2v1_merged_upsample = can_h2v1_merged_upsample(simd_support) ?
+                                jsimd_h2v1_merged_upsample : NULL;
+  table->convsamp = get_convsamp(simd_support);
+  table->convsamp_float = get_convsamp_float(simd_support);
+  table->fdct_islow = get_fdct_islow(simd_support);
+  table->fdct_ifast = get_fdct_ifast(simd_support);
+  table->fdct_float = get_fdct_float(simd_support);
+  table->quantize = get_quantize(simd_support);
+  table->quantize_float = get_quantize_float(simd_support);
+  table->idct_2x2 = can_idct_2x2(simd_support) ?
+                    jsimd_idct_2x2 : NULL;
+  table->idct_4x4 = can_idct_4x4(simd_support) ?
+                    jsimd_idct_4x4 : NULL;
+  table->idct_islow = can_idct_islow(simd_support) ?
+                      jsimd_idct_islow : NULL;
+  table->idct_ifast = can_idct_ifast(simd_support) ?
+                      jsimd_idct_ifast : NULL;
+  table->idct_float = can_idct_float(simd_support) ?
+                      jsimd_idct_float : NULL;
+  if (huffman && simd_huffman && can_huff_encode_one_block(simd_support))
+    table->huff_encode_one_block =
+      (jsimd_kernel_ptr)jsimd_huff_encode_one_block;
+  table->encode_mcu_AC_first_prepare =
+    can_encode_mcu_AC_first_prepare(simd_support) ?
+    jsimd_encode_mcu_AC_first_prepare : NULL;
+  table->encode_mcu_AC_refine_prepare =
+    can_encode_mcu_AC_refine_prepare(simd_support) ?
+    jsimd_encode_mcu_AC_refine_prepare : NULL;
+}
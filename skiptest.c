@@ -0,0 +1,277 @@
+/*
+ * Copyright (C)2026 The libjpeg-turbo Project.  All Rights Reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ * - Neither the name of the libjpeg-turbo Project nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS",
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * This program tests jpeg_skip_scanlines() by decoding a JPEG image with
+ * sequences of jpeg_read_scanlines() and jpeg_skip_scanlines() calls and
+ * comparing every line that it reads with the same line from a full decode.
+ * Each sequence is tested with several scaling factors and with both fancy and
+ * merged/non-fancy upsampling.
+ */
+
+#include "jinclude.h"
+#include "jpeglib.h"
+
+
+#define MAX_READ  16
+#define NUM_RANDOM_SEQUENCES  100
+
+static const int scaleNums[] = { 8, 4, 3 };
+
+/* A sequence is a list of operations followed by 0.  A positive operation
+ * reads that many lines, and a negative operation skips that many lines.
+ * After the list is exhausted, the rest of the image is read TAIL lines at a
+ * time.
+ */
+typedef struct {
+  int tail;
+  int ops[8];
+} sequence;
+
+static const sequence sequences[] = {
+  { 1, { 0 } },
+  { 2, { 0 } },
+  { 2, { 3, -40, 0 } },
+  { 2, { 1, -100, 0 } },
+  { 2, { -1, 0 } },
+  { 3, { 1, -15, 0 } },
+  { 1, { 2, -31, 1, -7, 0 } },
+  { 2, { 5, -3, 16, -16, 1, -33, 0 } },
+  { 4, { 15, -1, 0 } },
+  { MAX_READ, { -17, 1, -64, 0 } }
+};
+
+static struct jpeg_decompress_struct dinfo;
+static struct jpeg_error_mgr jerr;
+static unsigned char *jpegBuf = NULL;
+static size_t jpegSize = 0;
+static JSAMPLE *refBuf = NULL, *outBuf = NULL;
+static JDIMENSION pitch = 0;
+static unsigned int randomState = 1;
+static int scaleNum = 8;
+
+
+static unsigned int nextRandom(void)
+{
+  /* xorshift32 */
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+
+static void startDecompress(boolean fancy)
+{
+  jpeg_mem_src(&dinfo, jpegBuf, (unsigned long)jpegSize);
+  jpeg_read_header(&dinfo, TRUE);
+  dinfo.do_fancy_upsampling = fancy;
+  dinfo.scale_num = scaleNum;
+  dinfo.scale_denom = 8;
+  jpeg_start_decompress(&dinfo);
+  pitch = dinfo.output_width * dinfo.output_components;
+}
+
+
+static int readLines(int lines, int maxLines, const char *desc)
+{
+  JSAMPROW rows[MAX_READ];
+  int i;
+
+  while (lines > 0 && dinfo.output_scanline < dinfo.output_height) {
+    JDIMENSION start = dinfo.output_scanline, nread;
+    int n = lines < maxLines ? lines : maxLines;
+
+    for (i = 0; i < n; i++)
+      rows[i] = &outBuf[i * pitch];
+    nread = jpeg_read_scanlines(&dinfo, rows, n);
+    if (nread > (JDIMENSION)n ||
+        dinfo.output_scanline != start + nread ||
+        dinfo.output_scanline > dinfo.output_height) {
+      printf("%s: reading %d line(s) at line %u returned %u and left output_scanline = %u (output_height = %u)\n",
+             desc, n, start, nread, dinfo.output_scanline,
+             dinfo.output_height);
+      return -1;
+    }
+    for (i = 0; i < (int)nread; i++) {
+      if (memcmp(rows[i], &refBuf[(start + i) * pitch],
+                 pitch * sizeof(JSAMPLE))) {
+        printf("%s: line %u differs from a full decode\n", desc, start + i);
+        return -1;
+      }
+    }
+    lines -= nread;
+  }
+  return 0;
+}
+
+
+static int skipLines(int lines, const char *desc)
+{
+  JDIMENSION start = dinfo.output_scanline, expected = lines, nskipped;
+
+  if (start + expected > dinfo.output_height)
+    expected = dinfo.output_height - start;
+  nskipped = jpeg_skip_scanlines(&dinfo, lines);
+  if (nskipped != expected || dinfo.output_scanline != start + expected) {
+    printf("%s: skipping %d line(s) at line %u returned %u and left output_scanline = %u\n",
+           desc, lines, start, nskipped, dinfo.output_scanline);
+    return -1;
+  }
+  return 0;
+}
+
+
+static int runSequence(const sequence *seq, boolean fancy, const char *name)
+{
+  char desc[80];
+  int i;
+
+  snprintf(desc, 80, "%s (%s, scale %d/8)", name,
+           fancy ? "fancy" : "non-fancy", scaleNum);
+  startDecompress(fancy);
+  for (i = 0; seq->ops[i] != 0 && dinfo.output_scanline < dinfo.output_height;
+       i++) {
+    if (seq->ops[i] > 0) {
+      if (readLines(seq->ops[i], seq->ops[i] < MAX_READ ?
+                                 seq->ops[i] : MAX_READ, desc) == -1)
+        return -1;
+    } else if (skipLines(-seq->ops[i], desc) == -1)
+      return -1;
+  }
+  if (readLines(dinfo.output_height, seq->tail, desc) == -1)
+    return -1;
+  if (dinfo.output_scanline != dinfo.output_height) {
+    printf("%s: output_scanline = %u after reading the last line (output_height = %u)\n",
+           desc, dinfo.output_scanline, dinfo.output_height);
+    return -1;
+  }
+  jpeg_finish_decompress(&dinfo);
+  return 0;
+}
+
+
+static int runRandomSequence(boolean fancy, int index)
+{
+  char desc[80];
+
+  snprintf(desc, 80, "Random sequence %d (%s, scale %d/8)", index,
+           fancy ? "fancy" : "non-fancy", scaleNum);
+  startDecompress(fancy);
+  while (dinfo.output_scanline < dinfo.output_height) {
+    unsigned int x = nextRandom();
+    int lines = 1 + (x >> 4) % ((x & 8) ? 64 : 8);
+
+    if (x & 1) {
+      if (skipLines(lines, desc) == -1)
+        return -1;
+    } else if (readLines(lines, 1 + (x >> 1) % 3, desc) == -1)
+      return -1;
+  }
+  jpeg_finish_decompress(&dinfo);
+  return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+  FILE *file = NULL;
+  long size;
+  int i, s, retval = 0;
+  boolean fancy;
+
+  if (argc != 2) {
+    printf("USAGE: %s <JPEG file>\n", argv[0]);
+    return 1;
+  }
+
+  if ((file = fopen(argv[1], "rb")) == NULL ||
+      fseek(file, 0, SEEK_END) < 0 || (size = ftell(file)) < 0 ||
+      fseek(file, 0, SEEK_SET) < 0) {
+    printf("Could not open %s\n", argv[1]);
+    return 1;
+  }
+  jpegSize = (size_t)size;
+  if ((jpegBuf = (unsigned char *)malloc(jpegSize)) == NULL ||
+      fread(jpegBuf, jpegSize, 1, file) < 1) {
+    printf("Could not read %s\n", argv[1]);
+    return 1;
+  }
+  fclose(file);
+
+  dinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_decompress(&dinfo);
+
+  for (s = 0; s < (int)(sizeof(scaleNums) / sizeof(int)); s++) {
+    scaleNum = scaleNums[s];
+    for (fancy = FALSE; fancy <= TRUE; fancy++) {
+      /* Decode the whole image to obtain the reference output. */
+      startDecompress(fancy);
+      free(refBuf);
+      free(outBuf);
+      if ((refBuf = (JSAMPLE *)malloc(pitch * dinfo.output_height *
+                                      sizeof(JSAMPLE))) == NULL ||
+          (outBuf = (JSAMPLE *)malloc(pitch * MAX_READ *
+                                      sizeof(JSAMPLE))) == NULL) {
+        printf("Memory allocation failure\n");
+        return 1;
+      }
+      while (dinfo.output_scanline < dinfo.output_height) {
+        JSAMPROW row = &refBuf[dinfo.output_scanline * pitch];
+
+        jpeg_read_scanlines(&dinfo, &row, 1);
+      }
+      jpeg_finish_decompress(&dinfo);
+
+      for (i = 0; i < (int)(sizeof(sequences) / sizeof(sequence)); i++) {
+        char name[20];
+
+        snprintf(name, 20, "Sequence %d", i);
+        if (runSequence(&sequences[i], fancy, name) == -1) {
+          retval = -1;
+          jpeg_abort_decompress(&dinfo);
+        }
+      }
+      for (i = 0; i < NUM_RANDOM_SEQUENCES; i++) {
+        if (runRandomSequence(fancy, i) == -1) {
+          retval = -1;
+          jpeg_abort_decompress(&dinfo);
+        }
+      }
+    }
+  }
+
+  jpeg_destroy_decompress(&dinfo);
+  free(jpegBuf);
+  free(refBuf);
+  free(outBuf);
+
+  if (retval == 0)
+    printf("GOOD.\n");
+  return retval == 0 ? 0 : 1;
+}
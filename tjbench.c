@@ -29,6 +29,9 @@
 #ifdef _MSC_VER
 #define _CRT_SECURE_NO_DEPRECATE
 #endif
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE                     /* for pthread_setaffinity_np() */
+#endif
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,6 +40,14 @@
 #include <math.h>
 #include <errno.h>
 #include <limits.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include <cdjpeg.h>
 #include "./tjutil.h"
 #include "./turbojpeg.h"
@@ -83,6 +94,7 @@ int tjErrorLine = -1, tjErrorCode = -1;
 
 int flags = TJFLAG_NOREALLOC, compOnly = 0, decompOnly = 0, doYUV = 0,
   quiet = 0, doTile = 0, pf = TJPF_BGR, yuvPad = 1, doWrite = 1;
+int nThreads = 0, simdTier = TJSIMD_ALL;
 char *ext = "ppm";
 const char *pixFormatStr[TJ_NUMPF] = {
   "RGB", "BGR", "RGBX", "BGRX", "XBGR", "XRGB", "GRAY", "", "", "", "", "CMYK"
@@ -96,6 +108,9 @@ const char *csName[TJ_NUMCS] = {
 const char *subName[TJ_NUMSAMP] = {
   "444", "422", "420", "GRAY", "440", "411"
 };
+const char *stageName[TJ_NUMSTAGE] = {
+  "Other", "Markers", "Entropy", "DCT", "Resample", "Color conv", "I/O"
+};
 tjscalingfactor *scalingFactors = NULL, sf = { 1, 1 };
 int nsf = 0, xformOp = TJXOP_NONE, xformOpt = 0;
 int (*customFilter) (short *, tjregion, tjregion, int, int, tjtransform *);
@@ -128,6 +143,132 @@ static char *sigfig(double val, int figs, char *buf, int len)
 }
 
 
+/* Estimate the number of bytes that each pipeline stage processes during one
+   compression or decompression of the given JPEG tiles.  The marker stage
+   processes the headers (everything up to the first SOS marker), the entropy
+   stage processes the rest of the JPEG data, the DCT and resampling stages
+   process the component planes, and the color conversion stage processes the
+   packed-pixel image. */
+static void getStageBytes(unsigned char **jpegBuf, unsigned long *jpegSize,
+                          int ntiles, int w, int h, int subsamp,
+                          double *stageBytes)
+{
+  double totalJpegSize = 0., headerSize = 0., planeSize;
+  unsigned long yuvSize = tjBufSizeYUV2(w, 1, h, subsamp);
+  int tile;
+
+  for (tile = 0; tile < ntiles; tile++) {
+    unsigned long i;
+
+    for (i = 0; i + 1 < jpegSize[tile]; i++)
+      if (jpegBuf[tile][i] == 0xFF && jpegBuf[tile][i + 1] == 0xDA)
+        break;
+    headerSize += (double)i;
+    totalJpegSize += (double)jpegSize[tile];
+  }
+  planeSize = yuvSize == (unsigned long)-1 ? 0. : (double)yuvSize;
+
+  stageBytes[TJSTAGE_OTHER] = 0.;
+  stageBytes[TJSTAGE_MARKERS] = headerSize;
+  stageBytes[TJSTAGE_ENTROPY] = totalJpegSize - headerSize;
+  stageBytes[TJSTAGE_DCT] = planeSize;
+  stageBytes[TJSTAGE_SAMPLE] = subsamp == TJSAMP_444 ||
+                               subsamp == TJSAMP_GRAY ? 0. : planeSize;
+  stageBytes[TJSTAGE_COLOR] = (double)w * h * tjPixelSize[pf];
+  stageBytes[TJSTAGE_IO] = totalJpegSize;
+}
+
+
+/* Print the per-stage breakdown of a benchmark.  The stage times returned by
+   tjGetStageTimes() are in arbitrary units, so they are scaled to the elapsed
+   wall-clock time. */
+static void printStageTimes(const char *opName, double *stageTimes,
+                            double *stageBytes, double elapsed, int iter)
+{
+  double totalTicks = 0.;
+  int i;
+
+  for (i = 0; i < TJ_NUMSTAGE; i++)
+    totalTicks += stageTimes[i];
+  if (totalTicks <= 0. || iter < 1) return;
+
+  printf("%s stage breakdown:\n", opName);
+  printf("                  Stage           Time/iter  %% of total    Throughput\n");
+  for (i = 0; i < TJ_NUMSTAGE; i++) {
+    double stageElapsed = elapsed * stageTimes[i] / totalTicks;
+
+    printf("                  %-10s  %9.3f ms    %6.2f %%", stageName[i],
+           stageElapsed * 1000. / (double)iter,
+           stageTimes[i] * 100. / totalTicks);
+    if (stageBytes[i] > 0. && stageElapsed > 0.)
+      printf("    %9.2f MB/sec",
+             stageBytes[i] / 1000000. * (double)iter / stageElapsed);
+    printf("\n");
+  }
+}
+
+
+/* Retrieve (and reset) the stage times and the hardware event counts.  The
+   counts are set to -1 if hardware performance counters are unavailable. */
+static int getStageStats(tjhandle handle, double *stageTimes,
+                         long long *stageCounters)
+{
+  int i;
+
+  if (tjGetStageTimes(handle, stageTimes) == -1) return -1;
+  if (tjGetStageCounters(handle, stageCounters) == -1) {
+    for (i = 0; i < TJ_NUMSTAGE * TJ_NUMCOUNTER; i++)
+      stageCounters[i] = -1;
+  }
+  return 0;
+}
+
+
+static void printCount(long long count, int iter)
+{
+  if (count < 0) printf("  %12s", "n/a");
+  else printf("  %12.0f", (double)count / (double)iter);
+}
+
+
+static void printStageCounters(const char *opName, long long *stageCounters,
+                               int iter)
+{
+  int i;
+
+  for (i = 0; i < TJ_NUMSTAGE * TJ_NUMCOUNTER; i++)
+    if (stageCounters[i] >= 0) break;
+  if (i == TJ_NUMSTAGE * TJ_NUMCOUNTER || iter < 1) return;
+
+  printf("%s hardware events per iteration:\n", opName);
+  printf("                  Stage             Cycles  Instructions    IPC");
+  printf(" Branch misses   MPKI    L1D misses    LLC misses\n");
+  for (i = 0; i < TJ_NUMSTAGE; i++) {
+    long long *counters = &stageCounters[i * TJ_NUMCOUNTER];
+    long long cycles = counters[TJCOUNTER_CYCLES],
+      instructions = counters[TJCOUNTER_INSTRUCTIONS],
+      branchMisses = counters[TJCOUNTER_BRANCHMISSES];
+
+    printf("                  %-10s", stageName[i]);
+    printCount(cycles, iter);
+    printCount(instructions, iter);
+    if (cycles > 0 && instructions >= 0)
+      printf("  %5.2f", (double)instructions / (double)cycles);
+    else
+      printf("  %5s", "n/a");
+    printCount(branchMisses, iter);
+    /* Branch misses per thousand instructions */
+    if (instructions > 0 && branchMisses >= 0)
+      printf("  %5.2f", (double)branchMisses * 1000. / (double)instructions);
+    else
+      printf("  %5s", "n/a");
+    printCount(counters[TJCOUNTER_L1DMISSES], iter);
+    printCount(counters[TJCOUNTER_LLCMISSES], iter);
+    printf("\n");
+  }
+}
+
+
 /* Custom DCT filter which produces a negative of the image */
 static int dummyDCTFilter(short *coeffs, tjregion arrayRegion,
                           tjregion planeRegion, int componentIndex,
@@ -151,7 +292,8 @@ static int decomp(unsigned char *srcBuf, unsigned char **jpegBuf,
   FILE *file = NULL;
   tjhandle handle = NULL;
   int row, col, iter = 0, dstBufAlloc = 0, retval = 0;
-  double elapsed, elapsedDecode;
+  double elapsed, elapsedDecode, stageTimes[TJ_NUMSTAGE];
+  long long stageCounters[TJ_NUMSTAGE * TJ_NUMCOUNTER];
   int ps = tjPixelSize[pf];
   int scaledw = TJSCALED(w, sf);
   int scaledh = TJSCALED(h, sf);
@@ -166,6 +308,8 @@ static int decomp(unsigned char *srcBuf, unsigned char **jpegBuf,
 
   if ((handle = tjInitDecompress()) == NULL)
     THROW_TJ("executing tjInitDecompress()");
+  if (tjSetSIMDTier(handle, simdTier, 1) == -1)
+    THROW_TJ("executing tjSetSIMDTier()");
 
   if (dstBuf == NULL) {
     if ((unsigned long long)pitch * (unsigned long long)scaledh >
@@ -229,8 +373,14 @@ static int decomp(unsigned char *srcBuf, unsigned char **jpegBuf,
     } else if (elapsed >= warmup) {
       iter = 0;
       elapsed = elapsedDecode = 0.;
+      if ((flags & TJFLAG_STAGETIMES) &&
+          getStageStats(handle, stageTimes, stageCounters) == -1)
+        THROW_TJ("executing tjGetStageTimes()");
     }
   }
+  if ((flags & TJFLAG_STAGETIMES) &&
+      getStageStats(handle, stageTimes, stageCounters) == -1)
+    THROW_TJ("executing tjGetStageTimes()");
   if (doYUV) elapsed -= elapsedDecode;
 
   if (tjDestroy(handle) == -1) THROW_TJ("executing tjDestroy()");
@@ -257,6 +407,17 @@ static int decomp(unsigned char *srcBuf, unsigned char **jpegBuf,
       printf("                  Throughput:         %f Megapixels/sec\n",
              (double)(w * h) / 1000000. * (double)iter / elapsedDecode);
     }
+    if (flags & TJFLAG_STAGETIMES) {
+      double stageBytes[TJ_NUMSTAGE];
+
+      getStageBytes(jpegBuf, jpegSize, ntilesw * ntilesh, scaledw, scaledh,
+                    subsamp, stageBytes);
+      printStageTimes(doYUV ? "Decomp to YUV + Decode" : "Decompress",
+                      stageTimes, stageBytes,
+                      doYUV ? elapsed + elapsedDecode : elapsed, iter);
+      printStageCounters(doYUV ? "Decomp to YUV + Decode" : "Decompress",
+                         stageCounters, iter);
+    }
   }
 
   if (!doWrite) goto bailout;
@@ -325,7 +486,8 @@ static int fullTest(unsigned char *srcBuf, int w, int h, int subsamp,
   tjhandle handle = NULL;
   unsigned char **jpegBuf = NULL, *yuvBuf = NULL, *tmpBuf = NULL, *srcPtr,
     *srcPtr2;
-  double start, elapsed, elapsedEncode;
+  double start, elapsed, elapsedEncode, stageTimes[TJ_NUMSTAGE];
+  long long stageCounters[TJ_NUMSTAGE * TJ_NUMCOUNTER];
   int totalJpegSize = 0, row, col, i, tilew = w, tileh = h, retval = 0;
   int iter;
   unsigned long *jpegSize = NULL, yuvSize = 0;
@@ -378,6 +540,8 @@ static int fullTest(unsigned char *srcBuf, int w, int h, int subsamp,
       memcpy(&tmpBuf[pitch * i], &srcBuf[w * ps * i], w * ps);
     if ((handle = tjInitCompress()) == NULL)
       THROW_TJ("executing tjInitCompress()");
+    if (tjSetSIMDTier(handle, simdTier, 1) == -1)
+      THROW_TJ("executing tjSetSIMDTier()");
 
     if (doYUV) {
       yuvSize = tjBufSizeYUV2(tilew, yuvPad, tileh, subsamp);
@@ -430,8 +594,14 @@ static int fullTest(unsigned char *srcBuf, int w, int h, int subsamp,
       } else if (elapsed >= warmup) {
         iter = 0;
         elapsed = elapsedEncode = 0.;
+        if ((flags & TJFLAG_STAGETIMES) &&
+            getStageStats(handle, stageTimes, stageCounters) == -1)
+          THROW_TJ("executing tjGetStageTimes()");
       }
     }
+    if ((flags & TJFLAG_STAGETIMES) &&
+        getStageStats(handle, stageTimes, stageCounters) == -1)
+      THROW_TJ("executing tjGetStageTimes()");
     if (doYUV) elapsed -= elapsedEncode;
 
     if (tjDestroy(handle) == -1) THROW_TJ("executing tjDestroy()");
@@ -476,6 +646,17 @@ static int fullTest(unsigned char *srcBuf, int w, int h, int subsamp,
              (double)(w * h) / 1000000. * (double)iter / elapsed);
       printf("                  Output bit stream:  %f Megabits/sec\n",
              (double)totalJpegSize * 8. / 1000000. * (double)iter / elapsed);
+      if (flags & TJFLAG_STAGETIMES) {
+        double stageBytes[TJ_NUMSTAGE];
+
+        getStageBytes(jpegBuf, jpegSize, ntilesw * ntilesh, w, h, subsamp,
+                      stageBytes);
+        printStageTimes(doYUV ? "Encode + Comp" : "Compress", stageTimes,
+                        stageBytes, doYUV ? elapsed + elapsedEncode : elapsed,
+                        iter);
+        printStageCounters(doYUV ? "Encode + Comp" : "Compress",
+                           stageCounters, iter);
+      }
     }
     if (tilew == w && tileh == h && doWrite) {
       SNPRINTF(tempStr, 1024, "%s_%s_Q%d.jpg", fileName, subName[subsamp],
@@ -557,6 +738,8 @@ static int decompTest(char *fileName)
 
   if ((handle = tjInitTransform()) == NULL)
     THROW_TJ("executing tjInitTransform()");
+  if (tjSetSIMDTier(handle, simdTier, 1) == -1)
+    THROW_TJ("executing tjSetSIMDTier()");
   if (tjDecompressHeader3(handle, srcBuf, srcSize, &w, &h, &subsamp,
                           &cs) == -1)
     THROW_TJ("executing tjDecompressHeader3()");
@@ -745,6 +928,896 @@ bailout:
 }
 
 
+/* Multithreaded throughput test: each thread compresses or decompresses the
+   same image repeatedly, using its own TurboJPEG instance and buffers */
+
+#ifdef _WIN32
+#define THREAD_FUNC  DWORD WINAPI
+#define THREAD_RETURN  0
+typedef HANDLE threadHandle;
+#else
+#define THREAD_FUNC  void *
+#define THREAD_RETURN  NULL
+typedef pthread_t threadHandle;
+#endif
+
+typedef struct {
+  int index, compress;
+  unsigned char *srcBuf;                /* source pixels or JPEG image */
+  unsigned long srcSize;
+  int w, h, subsamp, jpegQual, pinned;
+  int iter, retval;
+  double elapsed;
+  char errStr[JMSG_LENGTH_MAX];
+} threadParams;
+
+
+/* Pin the calling thread to one CPU, so that the threads do not migrate
+   between cores during the test.  Returns 1 if successful. */
+static int pinThread(int index)
+{
+#if defined(_WIN32)
+  SYSTEM_INFO sysInfo;
+
+  GetSystemInfo(&sysInfo);
+  if (sysInfo.dwNumberOfProcessors < 1) return 0;
+  return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 <<
+                               (index % sysInfo.dwNumberOfProcessors)) != 0;
+#elif defined(__linux__)
+  cpu_set_t cpuSet;
+  long nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (nCPUs < 1) return 0;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(index % nCPUs, &cpuSet);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                &cpuSet) == 0;
+#else
+  return 0;
+#endif
+}
+
+
+/* Record a TurboJPEG error in the thread parameters.  Returns 0 if the error
+   was a warning that should be ignored. */
+static int threadError(threadParams *params, tjhandle handle, const char *op)
+{
+  if (handle && tjGetErrorCode(handle) == TJERR_WARNING &&
+      !(flags & TJFLAG_STOPONWARNING))
+    return 0;
+  SNPRINTF(params->errStr, JMSG_LENGTH_MAX, "%s: %s", op,
+           tjGetErrorStr2(handle));
+  params->retval = -1;
+  return -1;
+}
+
+
+static THREAD_FUNC threadWorker(void *arg)
+{
+  threadParams *params = (threadParams *)arg;
+  tjhandle handle = NULL;
+  unsigned char *jpegBuf = NULL, *dstBuf = NULL;
+  unsigned long jpegSize = 0, jpegBufSize;
+  int ps = tjPixelSize[pf], iter = -1;
+  int scaledw = TJSCALED(params->w, sf), scaledh = TJSCALED(params->h, sf);
+  double elapsed = 0.;
+
+  params->pinned = pinThread(params->index);
+
+  if (params->compress) {
+    if ((handle = tjInitCompress()) == NULL) {
+      threadError(params, NULL, "executing tjInitCompress()");
+      goto bailout;
+    }
+    if (tjSetSIMDTier(handle, simdTier, 1) == -1) {
+      threadError(params, handle, "executing tjSetSIMDTier()");
+      goto bailout;
+    }
+    jpegBufSize = tjBufSize(params->w, params->h, params->subsamp);
+    if (jpegBufSize == (unsigned long)-1 ||
+        jpegBufSize > (unsigned long)INT_MAX) {
+      SNPRINTF(params->errStr, JMSG_LENGTH_MAX,
+               "allocating JPEG buffer: Image is too large");
+      params->retval = -1;
+      goto bailout;
+    }
+    if ((jpegBuf = (unsigned char *)tjAlloc((int)jpegBufSize)) == NULL) {
+      SNPRINTF(params->errStr, JMSG_LENGTH_MAX, "allocating JPEG buffer");
+      params->retval = -1;
+      goto bailout;
+    }
+  } else {
+    if ((handle = tjInitDecompress()) == NULL) {
+      threadError(params, NULL, "executing tjInitDecompress()");
+      goto bailout;
+    }
+    if (tjSetSIMDTier(handle, simdTier, 1) == -1) {
+      threadError(params, handle, "executing tjSetSIMDTier()");
+      goto bailout;
+    }
+    if ((unsigned long long)scaledw * (unsigned long long)scaledh * ps >
+        (unsigned long long)((size_t)-1)) {
+      SNPRINTF(params->errStr, JMSG_LENGTH_MAX,
+               "allocating destination buffer: Image is too large");
+      params->retval = -1;
+      goto bailout;
+    }
+    if ((dstBuf = (unsigned char *)malloc((size_t)scaledw * scaledh *
+                                          ps)) == NULL) {
+      SNPRINTF(params->errStr, JMSG_LENGTH_MAX,
+               "allocating destination buffer");
+      params->retval = -1;
+      goto bailout;
+    }
+  }
+
+  while (1) {
+    double start = getTime();
+
+    if (params->compress) {
+      if (tjCompress2(handle, params->srcBuf, params->w, 0, params->h, pf,
+                      &jpegBuf, &jpegSize, params->subsamp, params->jpegQual,
+                      flags | TJFLAG_NOREALLOC) == -1 &&
+          threadError(params, handle, "executing tjCompress2()") == -1)
+        goto bailout;
+    } else if (tjDecompress2(handle, params->srcBuf, params->srcSize, dstBuf,
+                             scaledw, 0, scaledh, pf, flags) == -1 &&
+               threadError(params, handle, "executing tjDecompress2()") == -1)
+      goto bailout;
+    elapsed += getTime() - start;
+    if (iter >= 0) {
+      iter++;
+      if (elapsed >= benchTime) break;
+    } else if (elapsed >= warmup) {
+      iter = 0;
+      elapsed = 0.;
+    }
+  }
+  params->iter = iter;
+  params->elapsed = elapsed;
+
+bailout:
+  if (handle) tjDestroy(handle);
+  tjFree(jpegBuf);
+  free(dstBuf);
+  return THREAD_RETURN;
+}
+
+
+/* Run nThreads copies of the worker simultaneously, and return the aggregate
+   throughput in Megapixels/sec (or -1 if an error occurred.) */
+static double runThreads(threadParams *params, int nThreads)
+{
+  threadHandle *threads = NULL;
+  double total = 0.;
+  int i, nStarted = 0, retval = 0;
+
+  if ((threads = (threadHandle *)malloc(sizeof(threadHandle) *
+                                        nThreads)) == NULL)
+    THROW_UNIX("allocating thread array");
+  params[0].retval = params[0].iter = 0;
+  params[0].errStr[0] = 0;
+  for (i = 0; i < nThreads; i++) {
+    if (i > 0) params[i] = params[0];
+    params[i].index = i;
+  }
+  for (i = 0; i < nThreads; i++, nStarted++) {
+#ifdef _WIN32
+    if ((threads[i] = CreateThread(NULL, 0, threadWorker, &params[i], 0,
+                                   NULL)) == NULL)
+      THROW("creating thread", "CreateThread() failed");
+#else
+    if ((errno = pthread_create(&threads[i], NULL, threadWorker,
+                                &params[i])) != 0)
+      THROW_UNIX("creating thread");
+#endif
+  }
+
+bailout:
+  for (i = 0; i < nStarted; i++) {
+#ifdef _WIN32
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+#else
+    pthread_join(threads[i], NULL);
+#endif
+  }
+  free(threads);
+  if (retval == -1) return -1.;
+
+  for (i = 0; i < nThreads; i++) {
+    if (params[i].retval == -1) {
+      printf("ERROR in thread %d while %s\n", i, params[i].errStr);
+      return -1.;
+    }
+    total += (double)params[i].w * (double)params[i].h / 1000000. *
+             (double)params[i].iter / params[i].elapsed;
+  }
+  return total;
+}
+
+
+/* Measure the throughput of one thread, then of nThreads threads running
+   simultaneously, and report the scaling efficiency */
+static int threadTest(unsigned char *srcBuf, unsigned long srcSize, int w,
+                      int h, int subsamp, int jpegQual, int compress)
+{
+  threadParams *params = NULL;
+  char tempStr[80], tempStr2[80], tempStr3[80], tempStr4[80];
+  double single, total;
+  int i, retval = 0;
+  const char *opName = compress ? "Compress     " : "Decompress   ";
+
+  if ((params = (threadParams *)malloc(sizeof(threadParams) *
+                                       nThreads)) == NULL)
+    THROW_UNIX("allocating thread parameters");
+  memset(&params[0], 0, sizeof(threadParams));
+  params[0].compress = compress;
+  params[0].srcBuf = srcBuf;  params[0].srcSize = srcSize;
+  params[0].w = w;  params[0].h = h;
+  params[0].subsamp = subsamp;  params[0].jpegQual = jpegQual;
+
+  if ((single = runThreads(params, 1)) < 0.) {
+    retval = -1;  goto bailout;
+  }
+  if ((total = runThreads(params, nThreads)) < 0.) {
+    retval = -1;  goto bailout;
+  }
+
+  if (quiet) {
+    printf("%-6s  %-6s  %-6s  %-6s\n", sigfig(single, 4, tempStr, 80),
+           sigfig(total / (double)nThreads, 4, tempStr2, 80),
+           sigfig(total, 4, tempStr3, 80),
+           sigfig(total * 100. / (single * (double)nThreads), 4, tempStr4,
+                  80));
+  } else {
+    printf("%s --> 1 thread:           %f Megapixels/sec\n", opName, single);
+    for (i = 0; i < nThreads; i++)
+      printf("                  Thread %-3d%-10s%f Megapixels/sec\n", i,
+             params[i].pinned ? "(pinned)" : "",
+             (double)w * (double)h / 1000000. * (double)params[i].iter /
+             params[i].elapsed);
+    printf("                  Total:              %f Megapixels/sec\n", total);
+    printf("                  Scaling efficiency: %f %% (vs. %d x 1 thread)\n",
+           total * 100. / (single * (double)nThreads), nThreads);
+  }
+
+bailout:
+  free(params);
+  return retval;
+}
+
+
+static int threadFullTest(unsigned char *srcBuf, int w, int h, int subsamp,
+                          int jpegQual)
+{
+  tjhandle handle = NULL;
+  unsigned char *jpegBuf = NULL;
+  unsigned long jpegSize = 0;
+  int retval = 0;
+
+  if (!quiet)
+    printf(">>>>>  %s (%s) <--> JPEG %s Q%d, %d threads  <<<<<\n\n",
+           pixFormatStr[pf],
+           (flags & TJFLAG_BOTTOMUP) ? "Bottom-up" : "Top-down",
+           subNameLong[subsamp], jpegQual, nThreads);
+  else
+    printf("%-4s (%s)  %-5s    %-3d   Comp    ", pixFormatStr[pf],
+           (flags & TJFLAG_BOTTOMUP) ? "BU" : "TD", subNameLong[subsamp],
+           jpegQual);
+
+  if (threadTest(srcBuf, 0, w, h, subsamp, jpegQual, 1) == -1) {
+    retval = -1;  goto bailout;
+  }
+  if (compOnly) goto bailout;
+
+  /* Generate the JPEG image for the decompression test */
+  if ((handle = tjInitCompress()) == NULL)
+    THROW_TJG("executing tjInitCompress()");
+  if (tjSetSIMDTier(handle, simdTier, 1) == -1)
+    THROW_TJ("executing tjSetSIMDTier()");
+  if (tjCompress2(handle, srcBuf, w, 0, h, pf, &jpegBuf, &jpegSize, subsamp,
+                  jpegQual, flags & (~TJFLAG_NOREALLOC)) == -1)
+    THROW_TJ("executing tjCompress2()");
+
+  if (quiet)
+    printf("%-4s (%s)  %-5s    %-3d   Decomp  ", pixFormatStr[pf],
+           (flags & TJFLAG_BOTTOMUP) ? "BU" : "TD", subNameLong[subsamp],
+           jpegQual);
+  else printf("\n");
+  if (threadTest(jpegBuf, jpegSize, w, h, subsamp, 0, 0) == -1)
+    retval = -1;
+
+bailout:
+  if (!quiet) printf("\n");
+  if (handle) tjDestroy(handle);
+  tjFree(jpegBuf);
+  return retval;
+}
+
+
+static int threadDecompTest(char *fileName)
+{
+  FILE *file = NULL;
+  tjhandle handle = NULL;
+  unsigned char *srcBuf = NULL;
+  unsigned long srcSize;
+  int w = 0, h = 0, subsamp = -1, cs = -1, retval = 0;
+  char tempStr[80];
+
+  if ((file = fopen(fileName, "rb")) == NULL)
+    THROW_UNIX("opening file");
+  if (fseek(file, 0, SEEK_END) < 0 ||
+      (srcSize = ftell(file)) == (unsigned long)-1)
+    THROW_UNIX("determining file size");
+  if ((srcBuf = (unsigned char *)malloc(srcSize)) == NULL)
+    THROW_UNIX("allocating memory");
+  if (fseek(file, 0, SEEK_SET) < 0)
+    THROW_UNIX("setting file position");
+  if (fread(srcBuf, srcSize, 1, file) < 1)
+    THROW_UNIX("reading JPEG data");
+  fclose(file);  file = NULL;
+
+  if ((handle = tjInitDecompress()) == NULL)
+    THROW_TJG("executing tjInitDecompress()");
+  if (tjSetSIMDTier(handle, simdTier, 1) == -1)
+    THROW_TJ("executing tjSetSIMDTier()");
+  if (tjDecompressHeader3(handle, srcBuf, srcSize, &w, &h, &subsamp,
+                          &cs) == -1)
+    THROW_TJ("executing tjDecompressHeader3()");
+  if (w < 1 || h < 1)
+    THROW("reading JPEG header", "Invalid image dimensions");
+  if (cs == TJCS_YCCK || cs == TJCS_CMYK) pf = TJPF_CMYK;
+
+  if (!quiet)
+    printf(">>>>>  JPEG %s --> %s (%s), %d threads  <<<<<\n\n",
+           formatName(subsamp, cs, tempStr), pixFormatStr[pf],
+           (flags & TJFLAG_BOTTOMUP) ? "Bottom-up" : "Top-down", nThreads);
+  else
+    printf("%-4s (%s)  %-5s  %-5s    Decomp  ", pixFormatStr[pf],
+           (flags & TJFLAG_BOTTOMUP) ? "BU" : "TD", csName[cs],
+           subNameLong[subsamp]);
+  retval = threadTest(srcBuf, srcSize, w, h, subsamp, 0, 0);
+
+bailout:
+  if (file) fclose(file);
+  if (handle) tjDestroy(handle);
+  free(srcBuf);
+  return retval;
+}
+
+
+/* Corpus mode: benchmark each JPEG file in a directory or manifest */
+
+typedef struct {
+  char *fileName;
+  int w, h, subsamp, cs;
+  int sofMarker, restartInterval;       /* from the JPEG header */
+  unsigned long jpegSize;
+  int iter, failed;
+  double meanTime, minTime;             /* seconds per iteration */
+  double xformTime, decompTime, compTime;
+} corpusEntry;
+
+
+static int addCorpusFile(corpusEntry **entries, int *nEntries,
+                         int *maxEntries, const char *fileName)
+{
+  corpusEntry *entry;
+
+  if (*nEntries == *maxEntries) {
+    corpusEntry *newEntries;
+
+    *maxEntries = *maxEntries ? *maxEntries * 2 : 64;
+    if ((newEntries = (corpusEntry *)realloc(*entries, sizeof(corpusEntry) *
+                                             (*maxEntries))) == NULL)
+      return -1;
+    *entries = newEntries;
+  }
+  entry = &(*entries)[*nEntries];
+  memset(entry, 0, sizeof(corpusEntry));
+  if ((entry->fileName = (char *)malloc(strlen(fileName) + 1)) == NULL)
+    return -1;
+  strcpy(entry->fileName, fileName);
+  (*nEntries)++;
+  return 0;
+}
+
+
+static int isJPEGFileName(const char *fileName)
+{
+  const char *temp = strrchr(fileName, '.');
+
+  return temp != NULL &&
+         (!strcasecmp(temp, ".jpg") || !strcasecmp(temp, ".jpeg") ||
+          !strcasecmp(temp, ".jpe") || !strcasecmp(temp, ".jfif"));
+}
+
+
+static int compareCorpusEntries(const void *arg1, const void *arg2)
+{
+  return strcmp(((const corpusEntry *)arg1)->fileName,
+                ((const corpusEntry *)arg2)->fileName);
+}
+
+
+/* Build the list of files to benchmark.  If corpusName is a directory, then
+   the list contains the JPEG files (identified by their extensions) in that
+   directory, sorted by name.  Otherwise, corpusName is a manifest that lists
+   one file per line.  Blank lines and lines beginning with # are ignored. */
+static int readCorpus(const char *corpusName, corpusEntry **entries,
+                      int *nEntries)
+{
+  char fileName[4096];
+  FILE *file = NULL;
+  int maxEntries = 0, retval = 0;
+#ifdef _WIN32
+  WIN32_FIND_DATAA findData;
+  HANDLE findHandle;
+
+  SNPRINTF(fileName, 4096, "%s\\*", corpusName);
+  if ((findHandle = FindFirstFileA(fileName, &findData)) !=
+      INVALID_HANDLE_VALUE) {
+    do {
+      if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ||
+          !isJPEGFileName(findData.cFileName))
+        continue;
+      SNPRINTF(fileName, 4096, "%s\\%s", corpusName, findData.cFileName);
+      if (addCorpusFile(entries, nEntries, &maxEntries, fileName) == -1) {
+        FindClose(findHandle);
+        THROW_UNIX("allocating corpus file list");
+      }
+    } while (FindNextFileA(findHandle, &findData));
+    FindClose(findHandle);
+    qsort(*entries, *nEntries, sizeof(corpusEntry), compareCorpusEntries);
+    return 0;
+  }
+#else
+  DIR *dir;
+
+  if ((dir = opendir(corpusName)) != NULL) {
+    struct dirent *dirEntry;
+
+    while ((dirEntry = readdir(dir)) != NULL) {
+      struct stat statBuf;
+
+      if (!isJPEGFileName(dirEntry->d_name)) continue;
+      SNPRINTF(fileName, 4096, "%s/%s", corpusName, dirEntry->d_name);
+      if (stat(fileName, &statBuf) < 0 || !S_ISREG(statBuf.st_mode))
+        continue;
+      if (addCorpusFile(entries, nEntries, &maxEntries, fileName) == -1) {
+        closedir(dir);
+        THROW_UNIX("allocating corpus file list");
+      }
+    }
+    closedir(dir);
+    qsort(*entries, *nEntries, sizeof(corpusEntry), compareCorpusEntries);
+    return 0;
+  }
+#endif
+
+  if ((file = fopen(corpusName, "r")) == NULL)
+    THROW_UNIX("opening corpus directory or manifest");
+  while (fgets(fileName, 4096, file) != NULL) {
+    char *ptr = fileName;
+    size_t len = strlen(fileName);
+
+    while (len > 0 && isspace((unsigned char)fileName[len - 1]))
+      fileName[--len] = '\0';
+    while (*ptr == ' ' || *ptr == '\t') ptr++;
+    if (*ptr == '\0' || *ptr == '#') continue;
+    if (addCorpusFile(entries, nEntries, &maxEntries, ptr) == -1)
+      THROW_UNIX("allocating corpus file list");
+  }
+
+bailout:
+  if (file) fclose(file);
+  return retval;
+}
+
+
+/* Find the SOF marker type and the restart interval of the first scan by
+   walking the marker segments in the JPEG header */
+static void getJPEGProcess(const unsigned char *jpegBuf,
+                           unsigned long jpegSize, int *sofMarker,
+                           int *restartInterval)
+{
+  unsigned long i = 2;
+
+  *sofMarker = 0;  *restartInterval = 0;
+  while (i + 4 <= jpegSize && jpegBuf[i] == 0xFF) {
+    int marker = jpegBuf[i + 1];
+    unsigned long length;
+
+    if (marker == 0xFF) { i++;  continue; }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+      i += 2;  continue;
+    }
+    length = ((unsigned long)jpegBuf[i + 2] << 8) + jpegBuf[i + 3];
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC)
+      *sofMarker = marker;
+    else if (marker == 0xDD && length >= 4 && i + 6 <= jpegSize)
+      *restartInterval = (jpegBuf[i + 4] << 8) + jpegBuf[i + 5];
+    else if (marker == 0xDA || marker == 0xD9)
+      break;
+    i += 2 + length;
+  }
+}
+
+
+static const char *processName(int sofMarker)
+{
+  switch (sofMarker) {
+  case 0xC0:  return "baseline";
+  case 0xC1:  return "extended";
+  case 0xC2:  return "progressive";
+  case 0xC3:  return "lossless";
+  case 0xC9:  return "arithmetic";
+  case 0xCA:  return "arith-progressive";
+  default:    return "other";
+  }
+}
+
+
+/* Benchmark the transform/decompress/recompress pipeline for one file,
+   using the same warmup and benchmark time as the other tests */
+static int corpusFileTest(tjhandle handle, corpusEntry *entry, int recompQual,
+                          double *stageTimes, double *stageBytes)
+{
+  FILE *file = NULL;
+  unsigned char *srcBuf = NULL, *xformBuf = NULL, *dstBuf = NULL,
+    *compBuf = NULL;
+  unsigned long srcSize, xformSize = 0, compSize = 0;
+  int doXform = (xformOp != TJXOP_NONE || xformOpt != 0 || customFilter),
+    iter, i, retval = 0;
+  int allocFlags = flags & (~TJFLAG_NOREALLOC);
+  double elapsed, fileStageTimes[TJ_NUMSTAGE];
+  tjtransform xform;
+
+  if ((file = fopen(entry->fileName, "rb")) == NULL)
+    THROW_UNIX("opening file");
+  if (fseek(file, 0, SEEK_END) < 0 ||
+      (srcSize = ftell(file)) == (unsigned long)-1)
+    THROW_UNIX("determining file size");
+  if (srcSize == 0)
+    THROW("reading JPEG data", "File is empty");
+  if ((srcBuf = (unsigned char *)malloc(srcSize)) == NULL)
+    THROW_UNIX("allocating memory");
+  if (fseek(file, 0, SEEK_SET) < 0)
+    THROW_UNIX("setting file position");
+  if (fread(srcBuf, srcSize, 1, file) < 1)
+    THROW_UNIX("reading JPEG data");
+  fclose(file);  file = NULL;
+
+  entry->jpegSize = srcSize;
+  getJPEGProcess(srcBuf, srcSize, &entry->sofMarker, &entry->restartInterval);
+  if (tjDecompressHeader3(handle, srcBuf, srcSize, &entry->w, &entry->h,
+                          &entry->subsamp, &entry->cs) == -1)
+    THROW_TJ("executing tjDecompressHeader3()");
+  if ((unsigned long long)TJSCALED(entry->w, sf) * TJSCALED(entry->h, sf) *
+      tjPixelSize[TJPF_CMYK] > (unsigned long long)((size_t)-1))
+    THROW("allocating destination buffer", "Image is too large");
+  if ((dstBuf = (unsigned char *)malloc((size_t)TJSCALED(entry->w, sf) *
+                                        TJSCALED(entry->h, sf) *
+                                        tjPixelSize[TJPF_CMYK])) == NULL)
+    THROW_UNIX("allocating destination buffer");
+
+  memset(&xform, 0, sizeof(tjtransform));
+  xform.op = xformOp;
+  xform.options = xformOpt | TJXOPT_TRIM;
+  xform.customFilter = customFilter;
+
+  iter = -1;
+  elapsed = 0.;
+  entry->minTime = -1.;
+  while (1) {
+    unsigned char *jpegBuf = srcBuf;
+    unsigned long jpegSize = srcSize;
+    int w, h, subsamp, cs, filePf;
+    double start = getTime(), t;
+
+    if (doXform) {
+      if (tjTransform(handle, srcBuf, srcSize, 1, &xformBuf, &xformSize,
+                      &xform, allocFlags) == -1)
+        THROW_TJ("executing tjTransform()");
+      jpegBuf = xformBuf;  jpegSize = xformSize;
+      t = getTime();
+      if (iter >= 0) entry->xformTime += t - start;
+    }
+    if (tjDecompressHeader3(handle, jpegBuf, jpegSize, &w, &h, &subsamp,
+                            &cs) == -1)
+      THROW_TJ("executing tjDecompressHeader3()");
+    filePf = (cs == TJCS_CMYK || cs == TJCS_YCCK) ? TJPF_CMYK : pf;
+    w = TJSCALED(w, sf);  h = TJSCALED(h, sf);
+    t = getTime();
+    if (tjDecompress2(handle, jpegBuf, jpegSize, dstBuf, w, 0, h, filePf,
+                      flags) == -1)
+      THROW_TJ("executing tjDecompress2()");
+    if (iter >= 0) entry->decompTime += getTime() - t;
+    if (recompQual > 0) {
+      t = getTime();
+      if (tjCompress2(handle, dstBuf, w, 0, h, filePf, &compBuf, &compSize,
+                      subsamp, recompQual, allocFlags) == -1)
+        THROW_TJ("executing tjCompress2()");
+      if (iter >= 0) entry->compTime += getTime() - t;
+    }
+    t = getTime() - start;
+    elapsed += t;
+    if (iter >= 0) {
+      iter++;
+      if (entry->minTime < 0. || t < entry->minTime) entry->minTime = t;
+      if (elapsed >= benchTime) break;
+    } else if (elapsed >= warmup) {
+      iter = 0;
+      elapsed = 0.;
+      entry->xformTime = entry->decompTime = entry->compTime = 0.;
+      if ((flags & TJFLAG_STAGETIMES) &&
+          tjGetStageTimes(handle, fileStageTimes) == -1)
+        THROW_TJ("executing tjGetStageTimes()");
+    }
+  }
+
+  entry->iter = iter;
+  entry->meanTime = elapsed / (double)iter;
+  entry->xformTime /= (double)iter;
+  entry->decompTime /= (double)iter;
+  entry->compTime /= (double)iter;
+
+  if (flags & TJFLAG_STAGETIMES) {
+    double fileStageBytes[TJ_NUMSTAGE];
+
+    if (tjGetStageTimes(handle, fileStageTimes) == -1)
+      THROW_TJ("executing tjGetStageTimes()");
+    getStageBytes(&srcBuf, &srcSize, 1, TJSCALED(entry->w, sf),
+                  TJSCALED(entry->h, sf), entry->subsamp, fileStageBytes);
+    for (i = 0; i < TJ_NUMSTAGE; i++) {
+      stageTimes[i] += fileStageTimes[i] / (double)iter;
+      stageBytes[i] += fileStageBytes[i];
+    }
+  }
+
+bailout:
+  if (file) fclose(file);
+  free(srcBuf);
+  tjFree(xformBuf);
+  free(dstBuf);
+  tjFree(compBuf);
+  return retval;
+}
+
+
+static int compareDoubles(const void *arg1, const void *arg2)
+{
+  double val1 = *(const double *)arg1, val2 = *(const double *)arg2;
+
+  return val1 < val2 ? -1 : (val1 > val2 ? 1 : 0);
+}
+
+
+/* Return the pth percentile (nearest-rank method) of n sorted values */
+static double percentile(const double *sorted, int n, double p)
+{
+  int rank = (int)ceil(p / 100. * (double)n);
+
+  if (rank < 1) rank = 1;
+  if (rank > n) rank = n;
+  return sorted[rank - 1];
+}
+
+
+/* Write a string as a CSV field or a JSON string */
+static void writeQuoted(FILE *file, const char *str, int json)
+{
+  fputc('"', file);
+  for (; *str; str++) {
+    if (json && (*str == '"' || *str == '\\'))
+      fprintf(file, "\\%c", *str);
+    else if (json && (unsigned char)*str < 0x20)
+      fprintf(file, "\\u%04x", (unsigned char)*str);
+    else if (!json && *str == '"')
+      fputs("\"\"", file);
+    else
+      fputc(*str, file);
+  }
+  fputc('"', file);
+}
+
+
+typedef struct {
+  int nFiles;
+  double pixels, bytes, time;           /* totals over all files */
+  double p50, p90, p99;                 /* per-file latency (seconds) */
+} corpusSummary;
+
+
+static void summarizeCorpus(corpusEntry *entries, int nEntries, int sofMarker,
+                            double *latencies, corpusSummary *summary)
+{
+  int i;
+
+  memset(summary, 0, sizeof(corpusSummary));
+  for (i = 0; i < nEntries; i++) {
+    corpusEntry *entry = &entries[i];
+
+    if (entry->failed || (sofMarker >= 0 && entry->sofMarker != sofMarker))
+      continue;
+    summary->pixels += (double)entry->w * entry->h;
+    summary->bytes += (double)entry->jpegSize;
+    summary->time += entry->meanTime;
+    latencies[summary->nFiles++] = entry->meanTime;
+  }
+  if (summary->nFiles < 1) return;
+  qsort(latencies, summary->nFiles, sizeof(double), compareDoubles);
+  summary->p50 = percentile(latencies, summary->nFiles, 50.);
+  summary->p90 = percentile(latencies, summary->nFiles, 90.);
+  summary->p99 = percentile(latencies, summary->nFiles, 99.);
+}
+
+
+static void printCorpusSummary(const char *label, corpusSummary *summary)
+{
+  if (summary->nFiles < 1 || summary->time <= 0.) return;
+  printf("%-18s %5d  %9.2f  %9.2f  %9.3f  %9.3f  %9.3f\n", label,
+         summary->nFiles, summary->pixels / 1000000. / summary->time,
+         summary->bytes / 1000000. / summary->time, summary->p50 * 1000.,
+         summary->p90 * 1000., summary->p99 * 1000.);
+}
+
+
+static int corpusTest(char *corpusName, int recompQual, char *csvFileName,
+                      char *jsonFileName)
+{
+  static const int sofMarkers[] = { 0xC0, 0xC1, 0xC2, 0xC3, 0xC9, 0xCA };
+  tjhandle handle = NULL;
+  corpusEntry *entries = NULL;
+  FILE *csvFile = NULL, *jsonFile = NULL;
+  double *latencies = NULL, stageTimes[TJ_NUMSTAGE], stageBytes[TJ_NUMSTAGE];
+  int nEntries = 0, nFailed = 0, i, retval = 0;
+  corpusSummary summary;
+
+  if (readCorpus(corpusName, &entries, &nEntries) == -1) {
+    retval = -1;  goto bailout;
+  }
+  if (nEntries < 1)
+    THROW("reading corpus", "No JPEG files found");
+  if ((latencies = (double *)malloc(sizeof(double) * nEntries)) == NULL)
+    THROW_UNIX("allocating latency array");
+  if ((handle = tjInitTransform()) == NULL)
+    THROW_TJG("executing tjInitTransform()");
+  if (tjSetSIMDTier(handle, simdTier, 1) == -1)
+    THROW_TJ("executing tjSetSIMDTier()");
+  memset(stageTimes, 0, sizeof(stageTimes));
+  memset(stageBytes, 0, sizeof(stageBytes));
+
+  if (!quiet) {
+    printf(">>>>>  Corpus %s (%d files) --> %s (%s)", corpusName, nEntries,
+           pixFormatStr[pf],
+           (flags & TJFLAG_BOTTOMUP) ? "Bottom-up" : "Top-down");
+    if (xformOp != TJXOP_NONE || xformOpt != 0 || customFilter)
+      printf(", transformed");
+    if (recompQual > 0) printf(", recompressed at Q%d", recompQual);
+    printf("  <<<<<\n\n");
+    printf("%-40s  %-11s  %-17s  %9s  %9s  %9s\n", "File", "Size", "Process",
+           "Mean(ms)", "Mpix/s", "MB/s");
+  }
+
+  for (i = 0; i < nEntries; i++) {
+    corpusEntry *entry = &entries[i];
+
+    if (corpusFileTest(handle, entry, recompQual, stageTimes,
+                       stageBytes) == -1) {
+      printf("  (while processing %s)\n", entry->fileName);
+      entry->failed = 1;  nFailed++;
+      continue;
+    }
+    if (!quiet)
+      printf("%-40s  %5dx%-5d  %-17s  %9.3f  %9.2f  %9.2f\n", entry->fileName,
+             entry->w, entry->h, processName(entry->sofMarker),
+             entry->meanTime * 1000.,
+             (double)entry->w * entry->h / 1000000. / entry->meanTime,
+             (double)entry->jpegSize / 1000000. / entry->meanTime);
+  }
+
+  printf("\n%d files, %d failed\n\n", nEntries, nFailed);
+  printf("%-18s %5s  %9s  %9s  %9s  %9s  %9s\n", "", "Files", "Mpix/s", "MB/s",
+         "p50(ms)", "p90(ms)", "p99(ms)");
+  for (i = 0; i < (int)(sizeof(sofMarkers) / sizeof(int)); i++) {
+    summarizeCorpus(entries, nEntries, sofMarkers[i], latencies, &summary);
+    printCorpusSummary(processName(sofMarkers[i]), &summary);
+  }
+  summarizeCorpus(entries, nEntries, -1, latencies, &summary);
+  printCorpusSummary("All", &summary);
+  if ((flags & TJFLAG_STAGETIMES) && !quiet) {
+    printf("\n");
+    printStageTimes("Corpus", stageTimes, stageBytes, summary.time, 1);
+  }
+
+  if (csvFileName) {
+    if ((csvFile = fopen(csvFileName, "w")) == NULL)
+      THROW_UNIX("opening CSV file");
+    fprintf(csvFile, "file,width,height,subsamp,colorspace,process,restart_interval,jpeg_bytes,iterations,mean_ms,min_ms,xform_ms,decomp_ms,comp_ms,mpixels_per_sec,mb_per_sec,status\n");
+    for (i = 0; i < nEntries; i++) {
+      corpusEntry *entry = &entries[i];
+
+      writeQuoted(csvFile, entry->fileName, 0);
+      if (entry->failed) {
+        fprintf(csvFile, ",,,,,,,,,,,,,,,,failed\n");
+        continue;
+      }
+      fprintf(csvFile, ",%d,%d,%s,%s,%s,%d,%lu,%d,%f,%f,%f,%f,%f,%f,%f,ok\n",
+              entry->w, entry->h, subName[entry->subsamp], csName[entry->cs],
+              processName(entry->sofMarker), entry->restartInterval,
+              entry->jpegSize, entry->iter, entry->meanTime * 1000.,
+              entry->minTime * 1000., entry->xformTime * 1000.,
+              entry->decompTime * 1000., entry->compTime * 1000.,
+              (double)entry->w * entry->h / 1000000. / entry->meanTime,
+              (double)entry->jpegSize / 1000000. / entry->meanTime);
+    }
+    if (fclose(csvFile) != 0) {
+      csvFile = NULL;
+      THROW_UNIX("writing CSV file");
+    }
+    csvFile = NULL;
+  }
+
+  if (jsonFileName) {
+    if ((jsonFile = fopen(jsonFileName, "w")) == NULL)
+      THROW_UNIX("opening JSON file");
+    fprintf(jsonFile, "{\n  \"corpus\": ");
+    writeQuoted(jsonFile, corpusName, 1);
+    fprintf(jsonFile, ",\n  \"settings\": { \"pixel_format\": \"%s\", \"flags\": %d, \"scale\": \"%d/%d\", \"transform\": %d, \"transform_options\": %d, \"recompress_quality\": %d, \"warmup\": %f, \"benchtime\": %f },\n",
+            pixFormatStr[pf], flags, sf.num, sf.denom, xformOp, xformOpt,
+            recompQual, warmup, benchTime);
+    fprintf(jsonFile, "  \"files\": [\n");
+    for (i = 0; i < nEntries; i++) {
+      corpusEntry *entry = &entries[i];
+
+      fprintf(jsonFile, "    { \"file\": ");
+      writeQuoted(jsonFile, entry->fileName, 1);
+      if (entry->failed)
+        fprintf(jsonFile, ", \"status\": \"failed\" }");
+      else
+        fprintf(jsonFile, ", \"status\": \"ok\", \"width\": %d, \"height\": %d, \"subsamp\": \"%s\", \"colorspace\": \"%s\", \"process\": \"%s\", \"restart_interval\": %d, \"jpeg_bytes\": %lu, \"iterations\": %d, \"mean_ms\": %f, \"min_ms\": %f, \"xform_ms\": %f, \"decomp_ms\": %f, \"comp_ms\": %f, \"mpixels_per_sec\": %f, \"mb_per_sec\": %f }",
+                entry->w, entry->h, subName[entry->subsamp],
+                csName[entry->cs], processName(entry->sofMarker),
+                entry->restartInterval, entry->jpegSize, entry->iter,
+                entry->meanTime * 1000., entry->minTime * 1000.,
+                entry->xformTime * 1000., entry->decompTime * 1000.,
+                entry->compTime * 1000.,
+                (double)entry->w * entry->h / 1000000. / entry->meanTime,
+                (double)entry->jpegSize / 1000000. / entry->meanTime);
+      fprintf(jsonFile, "%s\n", i < nEntries - 1 ? "," : "");
+    }
+    fprintf(jsonFile, "  ],\n  \"summary\": { \"files\": %d, \"failed\": %d",
+            nEntries, nFailed);
+    if (summary.nFiles > 0 && summary.time > 0.)
+      fprintf(jsonFile, ", \"mpixels_per_sec\": %f, \"mb_per_sec\": %f, \"p50_ms\": %f, \"p90_ms\": %f, \"p99_ms\": %f",
+              summary.pixels / 1000000. / summary.time,
+              summary.bytes / 1000000. / summary.time, summary.p50 * 1000.,
+              summary.p90 * 1000., summary.p99 * 1000.);
+    fprintf(jsonFile, " }\n}\n");
+    if (fclose(jsonFile) != 0) {
+      jsonFile = NULL;
+      THROW_UNIX("writing JSON file");
+    }
+    jsonFile = NULL;
+  }
+
+  if (nFailed > 0) retval = -1;
+
+bailout:
+  if (csvFile) fclose(csvFile);
+  if (jsonFile) fclose(jsonFile);
+  if (handle) tjDestroy(handle);
+  for (i = 0; i < nEntries; i++)
+    free(entries[i].fileName);
+  free(entries);
+  free(latencies);
+  return retval;
+}
+
+
 static void usage(char *progName)
 {
   int i;
@@ -753,6 +1826,8 @@ static void usage(char *progName)
   printf("       <Inputfile (BMP|PPM)> <Quality> [options]\n\n");
   printf("       %s\n", progName);
   printf("       <Inputfile (JPG)> [options]\n\n");
+  printf("       %s\n", progName);
+  printf("       -corpus <Directory or manifest> [options]\n\n");
   printf("Options:\n\n");
   printf("-alloc = Dynamically allocate JPEG image buffers\n");
   printf("-bmp = Generate output images in Windows Bitmap format (default = PPM)\n");
@@ -809,9 +1884,39 @@ static void usage(char *progName)
   printf("     performance measurements.)\n");
   printf("-limitscans = Refuse to decompress or transform progressive JPEG images that\n");
   printf("     have an unreasonably large number of scans\n");
+  printf("-threads <n> = Measure the aggregate throughput of <n> threads, each of\n");
+  printf("     which compresses or decompresses the image repeatedly using its own\n");
+  printf("     TurboJPEG instance and buffers.  The threads are pinned to separate CPU\n");
+  printf("     cores (Linux and Windows only.)  The per-thread and total throughput\n");
+  printf("     and the scaling efficiency relative to a single thread are reported.\n");
+  printf("     Tiled and YUV tests are not supported in this mode, and the lossless\n");
+  printf("     transform options cannot be used.\n");
+  printf("-stages = Measure the time spent in each stage of the compression and\n");
+  printf("     decompression pipelines (marker processing, entropy coding, DCT,\n");
+  printf("     up/downsampling, color conversion, and I/O), and report the time,\n");
+  printf("     fraction of the total time, and approximate throughput of each stage\n");
+  printf("     (not supported with -quiet or lossless transforms).  If the TurboJPEG\n");
+  printf("     library was built with hardware performance counter support, also\n");
+  printf("     report the cycles, instructions, branch misses, and cache misses in\n");
+  printf("     each stage.\n");
+  printf("-simd none|base|all = Restrict the SIMD instruction sets that the\n");
+  printf("     TurboJPEG instances can use.  base excludes AVX2 on x86 CPUs.  (default\n");
+  printf("     = all)\n");
   printf("-stoponwarning = Immediately discontinue the current\n");
   printf("     compression/decompression/transform operation if the underlying codec\n");
   printf("     throws a warning (non-fatal error)\n\n");
+  printf("Corpus mode benchmarks each JPEG file (*.jpg, *.jpeg, *.jpe, *.jfif) in the\n");
+  printf("specified directory, or each file listed (one per line) in the specified\n");
+  printf("manifest.  Each file is transformed (if any of the transform options above\n");
+  printf("are specified), decompressed, and recompressed (if -recompress is specified),\n");
+  printf("and the per-file and aggregate throughput, along with the 50th, 90th, and 99th\n");
+  printf("percentile per-file latencies, are reported.  The default benchmark time is\n");
+  printf("1.0 seconds and the default warmup time is 0.2 seconds per file.\n\n");
+  printf("-recompress <q> = Recompress each decompressed image with quality <q> and the\n");
+  printf("     image's original level of chrominance subsampling\n");
+  printf("-csv <file> = Write the per-file results to <file> in CSV format\n");
+  printf("-json <file> = Write the per-file and aggregate results to <file> in JSON\n");
+  printf("     format\n\n");
   printf("NOTE:  If the quality is specified as a range (e.g. 90-100), a separate\n");
   printf("test will be performed for all quality values in the range.\n\n");
   exit(1);
@@ -822,24 +1927,31 @@ int main(int argc, char *argv[])
 {
   unsigned char *srcBuf = NULL;
   int w = 0, h = 0, i, j, minQual = -1, maxQual = -1;
-  char *temp;
-  int minArg = 2, retval = 0, subsamp = -1;
+  char *temp, *corpusName = NULL, *csvFileName = NULL, *jsonFileName = NULL;
+  int minArg = 2, retval = 0, subsamp = -1, recompQual = 0;
 
   if ((scalingFactors = tjGetScalingFactors(&nsf)) == NULL || nsf == 0)
     THROW("executing tjGetScalingFactors()", tjGetErrorStr());
 
   if (argc < minArg) usage(argv[0]);
 
-  temp = strrchr(argv[1], '.');
-  if (temp != NULL) {
-    if (!strcasecmp(temp, ".bmp")) ext = "bmp";
-    if (!strcasecmp(temp, ".jpg") || !strcasecmp(temp, ".jpeg"))
-      decompOnly = 1;
+  if (!strcasecmp(argv[1], "-corpus")) {
+    minArg = 3;
+    if (argc < minArg) usage(argv[0]);
+    corpusName = argv[2];
+    benchTime = 1.0;  warmup = 0.2;
+  } else {
+    temp = strrchr(argv[1], '.');
+    if (temp != NULL) {
+      if (!strcasecmp(temp, ".bmp")) ext = "bmp";
+      if (!strcasecmp(temp, ".jpg") || !strcasecmp(temp, ".jpeg"))
+        decompOnly = 1;
+    }
   }
 
   printf("\n");
 
-  if (!decompOnly) {
+  if (!decompOnly && !corpusName) {
     minArg = 3;
     if (argc < minArg) usage(argv[0]);
     if ((minQual = atoi(argv[2])) < 1 || minQual > 100) {
@@ -968,10 +2080,60 @@ int main(int argc, char *argv[])
         flags |= TJFLAG_LIMITSCANS;
       else if (!strcasecmp(argv[i], "-stoponwarning"))
         flags |= TJFLAG_STOPONWARNING;
+      else if (!strcasecmp(argv[i], "-stages"))
+        flags |= TJFLAG_STAGETIMES;
+      else if (!strcasecmp(argv[i], "-simd") && i < argc - 1) {
+        i++;
+        if (!strcasecmp(argv[i], "none"))
+          simdTier = TJSIMD_NONE;
+        else if (!strcasecmp(argv[i], "base"))
+          simdTier = TJSIMD_BASE;
+        else if (!strcasecmp(argv[i], "all"))
+          simdTier = TJSIMD_ALL;
+        else
+          usage(argv[0]);
+      }
+      else if (!strcasecmp(argv[i], "-recompress") && i < argc - 1) {
+        recompQual = atoi(argv[++i]);
+        if (recompQual < 1 || recompQual > 100) usage(argv[0]);
+      } else if (!strcasecmp(argv[i], "-threads") && i < argc - 1) {
+        nThreads = atoi(argv[++i]);
+        if (nThreads < 1) usage(argv[0]);
+      } else if (!strcasecmp(argv[i], "-csv") && i < argc - 1)
+        csvFileName = argv[++i];
+      else if (!strcasecmp(argv[i], "-json") && i < argc - 1)
+        jsonFileName = argv[++i];
       else usage(argv[0]);
     }
   }
 
+  if (nThreads > 0) {
+    if (corpusName) {
+      puts("ERROR: -threads cannot be used in corpus mode.");
+      exit(1);
+    }
+    if (xformOp != TJXOP_NONE || (xformOpt & ~TJXOPT_CROP) != 0 ||
+        customFilter) {
+      puts("ERROR: -threads cannot be used with lossless transform options.");
+      exit(1);
+    }
+    if (doTile || doYUV) {
+      printf("Disabling tiled and YUV tests, because those tests do not work in\n");
+      printf("multithreaded mode.\n\n");
+      doTile = doYUV = 0;  xformOpt &= ~TJXOPT_CROP;
+    }
+    flags &= ~TJFLAG_STAGETIMES;
+  }
+
+  /* -tile sets TJXOPT_CROP so that the tiled transform test crops each tile.
+     Corpus mode transforms each file as a whole, so clearing the crop would
+     silently change the transform being benchmarked.  Refuse the combination
+     instead. */
+  if (corpusName && doTile) {
+    puts("ERROR: -tile cannot be used in corpus mode.");
+    exit(1);
+  }
+
   if ((sf.num != 1 || sf.denom != 1) && doTile) {
     printf("Disabling tiled compression/decompression tests, because those tests do not\n");
     printf("work when scaled decompression is enabled.\n");
@@ -984,6 +2146,12 @@ int main(int argc, char *argv[])
     doTile = 0;
   }
 
+  if (corpusName) {
+    retval = corpusTest(corpusName, recompQual, csvFileName, jsonFileName);
+    printf("\n");
+    goto bailout;
+  }
+
   if (!decompOnly) {
     if ((srcBuf = tjLoadImage(argv[1], &w, 1, &h, &pf, flags)) == NULL)
       THROW_TJG("loading bitmap");
@@ -991,7 +2159,13 @@ int main(int argc, char *argv[])
     if (temp != NULL) *temp = '\0';
   }
 
-  if (quiet == 1 && !decompOnly) {
+  if (quiet == 1 && nThreads > 0) {
+    printf("All performance values in Mpixels/sec\n\n");
+    printf("Bitmap     %s  Test    1       Per     %-3d     Scaling\n",
+           decompOnly ? "JPEG   JPEG   " : "JPEG     JPEG", nThreads);
+    printf("Format     %s  Thread  Thread  Threads Eff. (%%)\n\n",
+           decompOnly ? "CS     Subsamp" : "Subsamp  Qual");
+  } else if (quiet == 1 && !decompOnly) {
     printf("All performance values in Mpixels/sec\n\n");
     printf("Bitmap     JPEG     JPEG  %s  %s   ",
            doTile ? "Tile " : "Image", doTile ? "Tile " : "Image");
@@ -1006,6 +2180,23 @@ int main(int argc, char *argv[])
     printf("\n\n");
   }
 
+  if (nThreads > 0) {
+    if (decompOnly) {
+      retval = threadDecompTest(argv[1]);
+      printf("\n");
+    } else if (subsamp >= 0 && subsamp < TJ_NUMSAMP) {
+      for (i = maxQual; i >= minQual; i--)
+        if (threadFullTest(srcBuf, w, h, subsamp, i) == -1) retval = -1;
+    } else {
+      int subsamps[4] = { TJSAMP_GRAY, TJSAMP_420, TJSAMP_422, TJSAMP_444 };
+
+      for (j = (pf == TJPF_CMYK ? 1 : 0); j < 4; j++)
+        for (i = maxQual; i >= minQual; i--)
+          if (threadFullTest(srcBuf, w, h, subsamps[j], i) == -1) retval = -1;
+    }
+    goto bailout;
+  }
+
   if (decompOnly) {
     decompTest(argv[1]);
     printf("\n");
@@ -676,6 +676,87 @@ bailout:
 }
 
 
+#define CHECK_LIMIT(f, expectLimit) { \
+  int r = (f); \
+  \
+  if ((expectLimit) && (r != -1 || tjGetErrorCode(dhandle) != TJERR_LIMIT)) \
+    THROW(#f " did not exceed the resource limits"); \
+  if (!(expectLimit) && r == -1) THROW_TJ(); \
+}
+
+static void limitTest(void)
+{
+  int w = 48, h = 48;
+  unsigned char *srcBuf = NULL, *dstBuf = NULL, *jpegBuf = NULL;
+  unsigned char *baseBuf = NULL, *xformBuf = NULL;
+  unsigned long jpegSize = 0, baseSize = 0, xformSize = 0;
+  tjhandle chandle = NULL, dhandle = NULL;
+  tjtransform xform;
+
+  memset(&xform, 0, sizeof(tjtransform));
+  xform.op = TJXOP_HFLIP;
+
+  printf("Resource limit test\n");
+  if ((srcBuf = (unsigned char *)malloc(w * h * 3)) == NULL ||
+      (dstBuf = (unsigned char *)malloc(w * h * 3)) == NULL)
+    THROW("Memory allocation failure");
+  initBuf(srcBuf, w, h, TJPF_RGB, 0);
+  if ((chandle = tjInitCompress()) == NULL ||
+      (dhandle = tjInitTransform()) == NULL)
+    THROW_TJ();
+  TRY_TJ(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &baseBuf, &baseSize,
+                     TJSAMP_420, 100, 0));
+  TRY_TJ(tjCompress2(chandle, srcBuf, w, 0, h, TJPF_RGB, &jpegBuf, &jpegSize,
+                     TJSAMP_420, 100, TJFLAG_PROGRESSIVE));
+
+  /* The default limits should accept an ordinary progressive image, and no
+     limits should be enforced without TJFLAG_LIMITRESOURCES. */
+  CHECK_LIMIT(tjDecompress2(dhandle, jpegBuf, jpegSize, dstBuf, w, 0, h,
+                            TJPF_RGB, TJFLAG_LIMITRESOURCES), 0);
+  TRY_TJ(tjSetDecompressLimits(dhandle, w * h - 1, 1, 1, 1));
+  CHECK_LIMIT(tjDecompress2(dhandle, jpegBuf, jpegSize, dstBuf, w, 0, h,
+                            TJPF_RGB, 0), 0);
+
+  TRY_TJ(tjSetDecompressLimits(dhandle, w * h - 1, 0, 0, 0));
+  CHECK_LIMIT(tjDecompress2(dhandle, jpegBuf, jpegSize, dstBuf, w, 0, h,
+                            TJPF_RGB, TJFLAG_LIMITRESOURCES), 1);
+  TRY_TJ(tjSetDecompressLimits(dhandle, w * h, 0, 0, 0));
+  CHECK_LIMIT(tjDecompress2(dhandle, jpegBuf, jpegSize, dstBuf, w, 0, h,
+                            TJPF_RGB, TJFLAG_LIMITRESOURCES), 0);
+
+  TRY_TJ(tjSetDecompressLimits(dhandle, 0, 1, 0, 0));
+  CHECK_LIMIT(tjDecompress2(dhandle, jpegBuf, jpegSize, dstBuf, w, 0, h,
+                            TJPF_RGB, TJFLAG_LIMITRESOURCES), 1);
+
+  TRY_TJ(tjSetDecompressLimits(dhandle, 0, 0, 1024, 0));
+  CHECK_LIMIT(tjDecompress2(dhandle, jpegBuf, jpegSize, dstBuf, w, 0, h,
+                            TJPF_RGB, TJFLAG_LIMITRESOURCES), 1);
+  CHECK_LIMIT(tjTransform(dhandle, jpegBuf, jpegSize, 1, &xformBuf,
+                          &xformSize, &xform, TJFLAG_LIMITRESOURCES), 1);
+
+  TRY_TJ(tjSetDecompressLimits(dhandle, 0, 0, 0, 2));
+  CHECK_LIMIT(tjDecompress2(dhandle, jpegBuf, jpegSize, dstBuf, w, 0, h,
+                            TJPF_RGB, TJFLAG_LIMITRESOURCES), 1);
+  CHECK_LIMIT(tjTransform(dhandle, jpegBuf, jpegSize, 1, &xformBuf,
+                          &xformSize, &xform, TJFLAG_LIMITRESOURCES), 1);
+
+  /* A baseline image requires exactly one pass. */
+  TRY_TJ(tjSetDecompressLimits(dhandle, 0, 1, 0, 1));
+  CHECK_LIMIT(tjDecompress2(dhandle, baseBuf, baseSize, dstBuf, w, 0, h,
+                            TJPF_RGB, TJFLAG_LIMITRESOURCES), 0);
+  printf("Done.\n");
+
+bailout:
+  free(srcBuf);
+  free(dstBuf);
+  tjFree(jpegBuf);
+  tjFree(baseBuf);
+  tjFree(xformBuf);
+  if (chandle) tjDestroy(chandle);
+  if (dhandle) tjDestroy(dhandle);
+}
+
+
 static void initBitmap(unsigned char *buf, int width, int pitch, int height,
                        int pf, int flags)
 {
@@ -767,8 +848,10 @@ static int doBmpTest(const char *ext, int width, int align, int height, int pf,
   char filename[80], *md5sum, md5buf[65];
   int ps = tjPixelSize[pf], pitch = PAD(width * ps, align), loadWidth = 0,
     loadHeight = 0, retval = 0, pixelFormat = pf;
-  unsigned char *buf = NULL;
+  unsigned char *buf = NULL, *fileBuf = NULL;
   char *md5ref;
+  FILE *file = NULL;
+  long fileSize = 0;
 
   if (pf == TJPF_GRAY) {
     md5ref = !strcasecmp(ext, "ppm") ? "112c682e82ce5de1cca089e20d60000b" :
@@ -801,6 +884,25 @@ static int doBmpTest(const char *ext, int width, int align, int height, int pf,
     printf("\n   Pixel data in %s is bogus\n", filename);
     retval = -1;  goto bailout;
   }
+  tjFree(buf);  buf = NULL;
+  if ((file = fopen(filename, "rb")) == NULL)
+    THROW("Could not open image file");
+  if (fseek(file, 0, SEEK_END) < 0 || (fileSize = ftell(file)) < 1 ||
+      fseek(file, 0, SEEK_SET) < 0)
+    THROW("Could not determine size of image file");
+  if ((fileBuf = (unsigned char *)malloc(fileSize)) == NULL)
+    THROW("Could not allocate memory");
+  if (fread(fileBuf, fileSize, 1, file) < 1)
+    THROW("Could not read image file");
+  fclose(file);  file = NULL;
+  if ((buf = tjLoadImageFromMemory(fileBuf, fileSize, &loadWidth, align,
+                                   &loadHeight, &pf, flags)) == NULL)
+    THROW_TJ();
+  if (width != loadWidth || height != loadHeight ||
+      !cmpBitmap(buf, width, pitch, height, pf, flags, 0)) {
+    printf("\n   Loading %s from memory failed\n", filename);
+    retval = -1;  goto bailout;
+  }
   if (pf == TJPF_GRAY) {
     tjFree(buf);  buf = NULL;
     pf = TJPF_XBGR;
@@ -845,6 +947,8 @@ static int doBmpTest(const char *ext, int width, int align, int height, int pf,
 
 bailout:
   tjFree(buf);
+  free(fileBuf);
+  if (file) fclose(file);
   if (exitStatus < 0) return exitStatus;
   return retval;
 }
@@ -921,6 +1025,7 @@ int main(int argc, char *argv[])
   doTest(41, 35, _3byteFormats, 2, TJSAMP_GRAY, "test");
   doTest(35, 39, _4byteFormats, 4, TJSAMP_GRAY, "test");
   bufSizeTest();
+  limitTest();
   if (doYUV) {
     printf("\n--------------------\n\n");
     doTest(48, 48, _onlyRGB, 1, TJSAMP_444, "test_yuv0");
@@ -42,6 +42,7 @@
 #include "transupp.h"
 #include "./jpegcomp.h"
 #include "./cdjpeg.h"
+#include "jstages.h"
 
 extern void jpeg_mem_dest_tj(j_compress_ptr, unsigned char **, unsigned long *,
                              boolean);
@@ -60,7 +61,7 @@ struct my_error_mgr {
   struct jpeg_error_mgr pub;
   jmp_buf setjmp_buffer;
   void (*emit_message) (j_common_ptr, int);
-  boolean warning, stopOnWarning;
+  boolean warning, stopOnWarning, limitExceeded;
 };
 typedef struct my_error_mgr *my_error_ptr;
 
@@ -74,6 +75,14 @@ static void my_error_exit(j_common_ptr cinfo)
 {
   my_error_ptr myerr = (my_error_ptr)cinfo->err;
 
+  if (cinfo->err->msg_code == JERR_PIXEL_LIMIT ||
+      cinfo->err->msg_code == JERR_SCAN_LIMIT ||
+      cinfo->err->msg_code == JERR_COEF_MEMORY_LIMIT ||
+      cinfo->err->msg_code == JERR_DECODE_LIMIT)
+    myerr->limitExceeded = TRUE;
+  /* A fatal error supersedes any warnings that preceded it, so that
+     tjGetErrorCode() never reports a failed operation as a warning. */
+  myerr->warning = FALSE;
   (*cinfo->err->output_message) (cinfo);
   longjmp(myerr->setjmp_buffer, 1);
 }
@@ -108,6 +117,9 @@ typedef struct _tjinstance {
   int init, headerRead;
   char errStr[JMSG_LENGTH_MAX];
   boolean isInstanceError;
+  struct jpeg_stage_timer stageTimer;
+  unsigned long maxPixels, maxCoefMemory;
+  int maxScans, maxDecodePasses;
 } tjinstance;
 
 struct my_progress_mgr {
@@ -194,18 +206,30 @@ static int cs2pf[JPEG_NUMCS] = {
   retval = -1;  goto bailout; \
 }
 #ifdef _MSC_VER
-#define THROW_UNIX(m) { \
+#define SET_UNIX_ERROR(m) { \
   char strerrorBuf[80] = { 0 }; \
   strerror_s(strerrorBuf, 80, errno); \
   SNPRINTF(errStr, JMSG_LENGTH_MAX, "%s\n%s", m, strerrorBuf); \
-  retval = -1;  goto bailout; \
 }
 #else
-#define THROW_UNIX(m) { \
+#define SET_UNIX_ERROR(m) { \
   SNPRINTF(errStr, JMSG_LENGTH_MAX, "%s\n%s", m, strerror(errno)); \
-  retval = -1;  goto bailout; \
 }
 #endif
+#define THROW_UNIX(m) { \
+  SET_UNIX_ERROR(m) \
+  retval = -1;  goto bailout; \
+}
+/* Functions that return a pointer rather than an error code (the
+   tjLoadImage*() wrappers) use these instead of THROWG() and THROW_UNIX(). */
+#define THROWG_NULL(m) { \
+  SNPRINTF(errStr, JMSG_LENGTH_MAX, "%s", m); \
+  goto bailout; \
+}
+#define THROW_UNIX_NULL(m) { \
+  SET_UNIX_ERROR(m) \
+  goto bailout; \
+}
 #define THROW(m) { \
   SNPRINTF(this->errStr, JMSG_LENGTH_MAX, "%s", m); \
   this->isInstanceError = TRUE;  THROWG(m) \
@@ -227,6 +251,7 @@ static int cs2pf[JPEG_NUMCS] = {
   } \
   cinfo = &this->cinfo;  dinfo = &this->dinfo; \
   this->jerr.warning = FALSE; \
+  this->jerr.limitExceeded = FALSE; \
   this->isInstanceError = FALSE;
 
 #define GET_CINSTANCE(handle) \
@@ -239,6 +264,7 @@ static int cs2pf[JPEG_NUMCS] = {
   } \
   cinfo = &this->cinfo; \
   this->jerr.warning = FALSE; \
+  this->jerr.limitExceeded = FALSE; \
   this->isInstanceError = FALSE;
 
 #define GET_DINSTANCE(handle) \
@@ -251,8 +277,39 @@ static int cs2pf[JPEG_NUMCS] = {
   } \
   dinfo = &this->dinfo; \
   this->jerr.warning = FALSE; \
+  this->jerr.limitExceeded = FALSE; \
   this->isInstanceError = FALSE;
 
+/* Used by functions that only access the instance itself */
+#define GET_TJINSTANCE(handle) \
+  tjinstance *this = (tjinstance *)handle; \
+  \
+  if (!this) { \
+    SNPRINTF(errStr, JMSG_LENGTH_MAX, "Invalid handle"); \
+    return -1; \
+  } \
+  this->jerr.warning = FALSE; \
+  this->jerr.limitExceeded = FALSE; \
+  this->isInstanceError = FALSE;
+
+/* Per-stage timing (see TJFLAG_STAGETIMES).  Objects that have not been
+   initialized have no master struct. */
+#define START_STAGE_TIMING(ptr) { \
+  if ((ptr)->master != NULL) { \
+    (ptr)->master->stage_timer = \
+      (flags & TJFLAG_STAGETIMES) ? &this->stageTimer : NULL; \
+    if ((ptr)->master->stage_timer != NULL) \
+      jstage_start((ptr)->master->stage_timer); \
+  } \
+}
+
+#define STOP_STAGE_TIMING(ptr) { \
+  if ((ptr)->master != NULL && (ptr)->master->stage_timer != NULL) { \
+    jstage_stop((ptr)->master->stage_timer); \
+    (ptr)->master->stage_timer = NULL; \
+  } \
+}
+
 static int getPixelFormat(int pixelSize, int flags)
 {
   if (pixelSize == 1) return TJPF_GRAY;
@@ -448,10 +505,117 @@ DLLEXPORT int tjGetErrorCode(tjhandle handle)
   tjinstance *this = (tjinstance *)handle;
 
   if (this && this->jerr.warning) return TJERR_WARNING;
+  else if (this && this->jerr.limitExceeded) return TJERR_LIMIT;
   else return TJERR_FATAL;
 }
 
 
+DLLEXPORT int tjGetStageTimes(tjhandle handle, double *stageTimes)
+{
+  int i, retval = 0;
+
+  GET_TJINSTANCE(handle);
+
+  if (stageTimes == NULL)
+    THROW("tjGetStageTimes(): Invalid argument");
+
+  for (i = 0; i < TJ_NUMSTAGE; i++) {
+    stageTimes[i] = (double)this->stageTimer.ticks[i];
+    this->stageTimer.ticks[i] = 0;
+  }
+
+bailout:
+  return retval;
+}
+
+
+DLLEXPORT int tjGetStageCounters(tjhandle handle, long long *stageCounters)
+{
+  int retval = 0;
+#ifdef WITH_PERF_COUNTERS
+  int i, j;
+#endif
+
+  GET_TJINSTANCE(handle);
+
+  if (stageCounters == NULL)
+    THROW("tjGetStageCounters(): Invalid argument");
+
+#ifdef WITH_PERF_COUNTERS
+  if (this->stageTimer.events_state < 0)
+    THROW("tjGetStageCounters(): Hardware performance counters are not available");
+
+  for (i = 0; i < TJ_NUMSTAGE; i++) {
+    for (j = 0; j < TJ_NUMCOUNTER; j++) {
+      if (this->stageTimer.events_state > 0 &&
+          this->stageTimer.event_fd[j] >= 0)
+        stageCounters[i * TJ_NUMCOUNTER + j] =
+          (long long)this->stageTimer.events[i][j];
+      else
+        stageCounters[i * TJ_NUMCOUNTER + j] = -1;
+    }
+  }
+  if (this->stageTimer.events_state > 0)
+    memset(this->stageTimer.events, 0, sizeof(this->stageTimer.events));
+#else
+  THROW("tjGetStageCounters(): Hardware performance counter support not enabled");
+#endif
+
+bailout:
+  return retval;
+}
+
+
+DLLEXPORT int tjSetSIMDTier(tjhandle handle, int tier, int huffman)
+{
+  static const int simdTier[TJ_NUMSIMD] = {
+    JSIMD_TIER_NONE, JSIMD_TIER_BASE, JSIMD_TIER_ALL
+  };
+  int retval = 0;
+
+  GET_INSTANCE(handle);
+
+  if (tier < 0 || tier >= TJ_NUMSIMD)
+    THROW("tjSetSIMDTier(): Invalid argument");
+
+  if (setjmp(this->jerr.setjmp_buffer)) {
+    /* If we get here, the JPEG code has signaled an error. */
+    retval = -1;  goto bailout;
+  }
+
+  if (this->init & COMPRESS)
+    jpeg_set_simd_tier((j_common_ptr)cinfo, simdTier[tier], huffman != 0);
+  if (this->init & DECOMPRESS)
+    jpeg_set_simd_tier((j_common_ptr)dinfo, simdTier[tier], huffman != 0);
+
+bailout:
+  return retval;
+}
+
+
+DLLEXPORT int tjSetDecompressLimits(tjhandle handle, unsigned long maxPixels,
+                                    int maxScans, unsigned long maxCoefMemory,
+                                    int maxDecodePasses)
+{
+  int retval = 0;
+
+  GET_TJINSTANCE(handle);
+
+  if ((this->init & DECOMPRESS) == 0)
+    THROW("tjSetDecompressLimits(): Instance has not been initialized for decompression");
+  if (maxScans < 0 || maxDecodePasses < 0)
+    THROW("tjSetDecompressLimits(): Invalid argument");
+
+  this->maxPixels = maxPixels;
+  this->maxScans = maxScans;
+  this->maxCoefMemory = maxCoefMemory;
+  this->maxDecodePasses = maxDecodePasses;
+
+bailout:
+  return retval;
+}
+
+
 DLLEXPORT int tjDestroy(tjhandle handle)
 {
   GET_INSTANCE(handle);
@@ -459,6 +623,9 @@ DLLEXPORT int tjDestroy(tjhandle handle)
   if (setjmp(this->jerr.setjmp_buffer)) return -1;
   if (this->init & COMPRESS) jpeg_destroy_compress(cinfo);
   if (this->init & DECOMPRESS) jpeg_destroy_decompress(dinfo);
+#ifdef WITH_PERF_COUNTERS
+  jstage_close_events(&this->stageTimer);
+#endif
   free(this);
   return 0;
 }
@@ -683,6 +850,7 @@ DLLEXPORT int tjCompress2(tjhandle handle, const unsigned char *srcBuf,
 
   GET_CINSTANCE(handle)
   this->jerr.stopOnWarning = (flags & TJFLAG_STOPONWARNING) ? TRUE : FALSE;
+  START_STAGE_TIMING(cinfo);
   if ((this->init & COMPRESS) == 0)
     THROW("tjCompress2(): Instance has not been initialized for compression");
 
@@ -736,6 +904,7 @@ bailout:
   }
   free(row_pointer);
   if (this->jerr.warning) retval = -1;
+  STOP_STAGE_TIMING(cinfo);
   this->jerr.stopOnWarning = FALSE;
   return retval;
 }
@@ -778,6 +947,7 @@ DLLEXPORT int tjEncodeYUVPlanes(tjhandle handle, const unsigned char *srcBuf,
 
   GET_CINSTANCE(handle);
   this->jerr.stopOnWarning = (flags & TJFLAG_STOPONWARNING) ? TRUE : FALSE;
+  START_STAGE_TIMING(cinfo);
 
   for (i = 0; i < MAX_COMPONENTS; i++) {
     tmpbuf[i] = NULL;  _tmpbuf[i] = NULL;
@@ -894,9 +1064,13 @@ DLLEXPORT int tjEncodeYUVPlanes(tjhandle handle, const unsigned char *srcBuf,
   }
 
   for (row = 0; row < ph0; row += cinfo->max_v_samp_factor) {
+    JSTAGE_BEGIN(cinfo->master->stage_timer, JSTAGE_COLOR);
     (*cinfo->cconvert->color_convert) (cinfo, &row_pointer[row], tmpbuf, 0,
                                        cinfo->max_v_samp_factor);
+    JSTAGE_END(cinfo->master->stage_timer);
+    JSTAGE_BEGIN(cinfo->master->stage_timer, JSTAGE_SAMPLE);
     (cinfo->downsample->downsample) (cinfo, tmpbuf, 0, tmpbuf2, 0);
+    JSTAGE_END(cinfo->master->stage_timer);
     for (i = 0, compptr = cinfo->comp_info; i < cinfo->num_components;
          i++, compptr++)
       jcopy_sample_rows(tmpbuf2[i], 0, outbuf[i],
@@ -917,6 +1091,7 @@ bailout:
     free(outbuf[i]);
   }
   if (this->jerr.warning) retval = -1;
+  STOP_STAGE_TIMING(cinfo);
   this->jerr.stopOnWarning = FALSE;
   return retval;
 }
@@ -995,6 +1170,7 @@ DLLEXPORT int tjCompressFromYUVPlanes(tjhandle handle,
 
   GET_CINSTANCE(handle)
   this->jerr.stopOnWarning = (flags & TJFLAG_STOPONWARNING) ? TRUE : FALSE;
+  START_STAGE_TIMING(cinfo);
 
   for (i = 0; i < MAX_COMPONENTS; i++) {
     tmpbuf[i] = NULL;  inbuf[i] = NULL;
@@ -1112,6 +1288,7 @@ bailout:
   }
   free(_tmpbuf);
   if (this->jerr.warning) retval = -1;
+  STOP_STAGE_TIMING(cinfo);
   this->jerr.stopOnWarning = FALSE;
   return retval;
 }
@@ -1159,6 +1336,22 @@ bailout:
 
 /* Decompressor */
 
+/* Apply the instance's resource limits to the decompressor if
+   TJFLAG_LIMITRESOURCES is set, or remove them otherwise.  This must be called
+   before jpeg_read_header(). */
+
+static void setDecompressLimits(tjinstance *this, int flags)
+{
+  /* A previous function call may have failed while reading the header. */
+  if (this->dinfo.global_state > DSTATE_START)
+    jpeg_abort_decompress(&this->dinfo);
+  if (flags & TJFLAG_LIMITRESOURCES)
+    jpeg_set_decompress_limits(&this->dinfo, this->maxPixels, this->maxScans,
+                               this->maxCoefMemory, this->maxDecodePasses);
+  else
+    jpeg_set_decompress_limits(&this->dinfo, 0, 0, 0, 0);
+}
+
 static tjhandle _tjInitDecompress(tjinstance *this)
 {
   static unsigned char buffer[1];
@@ -1183,6 +1376,9 @@ static tjhandle _tjInitDecompress(tjinstance *this)
   /* Make an initial call so it will create the source manager */
   jpeg_mem_src_tj(&this->dinfo, buffer, 1);
 
+  this->maxScans = TJ_DEFAULT_MAXSCANS;
+  this->maxDecodePasses = TJ_DEFAULT_MAXDECODEPASSES;
+
   this->init |= DECOMPRESS;
   return (tjhandle)this;
 }
@@ -1223,6 +1419,7 @@ DLLEXPORT int tjDecompressHeader3(tjhandle handle,
     return -1;
   }
 
+  setDecompressLimits(this, 0);
   jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
 
   /* jpeg_read_header() calls jpeg_abort() and returns JPEG_HEADER_TABLES_ONLY
@@ -1303,6 +1500,7 @@ DLLEXPORT int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf,
 
   GET_DINSTANCE(handle);
   this->jerr.stopOnWarning = (flags & TJFLAG_STOPONWARNING) ? TRUE : FALSE;
+  START_STAGE_TIMING(dinfo);
   if ((this->init & DECOMPRESS) == 0)
     THROW("tjDecompress2(): Instance has not been initialized for decompression");
 
@@ -1329,6 +1527,7 @@ DLLEXPORT int tjDecompress2(tjhandle handle, const unsigned char *jpegBuf,
     retval = -1;  goto bailout;
   }
 
+  setDecompressLimits(this, flags);
   jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
   jpeg_read_header(dinfo, TRUE);
   this->dinfo.out_color_space = pf2cs[pixelFormat];
@@ -1375,6 +1574,7 @@ bailout:
   if (dinfo->global_state > DSTATE_START) jpeg_abort_decompress(dinfo);
   free(row_pointer);
   if (this->jerr.warning) retval = -1;
+  STOP_STAGE_TIMING(dinfo);
   this->jerr.stopOnWarning = FALSE;
   return retval;
 }
@@ -1459,6 +1659,7 @@ DLLEXPORT int tjDecodeYUVPlanes(tjhandle handle,
 
   GET_DINSTANCE(handle);
   this->jerr.stopOnWarning = (flags & TJFLAG_STOPONWARNING) ? TRUE : FALSE;
+  START_STAGE_TIMING(dinfo);
 
   for (i = 0; i < MAX_COMPONENTS; i++) {
     tmpbuf[i] = NULL;  _tmpbuf[i] = NULL;  inbuf[i] = NULL;
@@ -1492,6 +1693,7 @@ DLLEXPORT int tjDecodeYUVPlanes(tjhandle handle,
   else if (flags & TJFLAG_FORCESSE2) PUTENV_S("JSIMD_FORCESSE2", "1");
 #endif
 
+  setDecompressLimits(this, 0);
   dinfo->progressive_mode = dinfo->inputctl->has_multiple_scans = FALSE;
   dinfo->Ss = dinfo->Ah = dinfo->Al = 0;
   dinfo->Se = DCTSIZE2 - 1;
@@ -1586,6 +1788,7 @@ bailout:
     free(inbuf[i]);
   }
   if (this->jerr.warning) retval = -1;
+  STOP_STAGE_TIMING(dinfo);
   this->jerr.stopOnWarning = FALSE;
   return retval;
 }
@@ -1646,6 +1849,7 @@ DLLEXPORT int tjDecompressToYUVPlanes(tjhandle handle,
 
   GET_DINSTANCE(handle);
   this->jerr.stopOnWarning = (flags & TJFLAG_STOPONWARNING) ? TRUE : FALSE;
+  START_STAGE_TIMING(dinfo);
 
   for (i = 0; i < MAX_COMPONENTS; i++) {
     tmpbuf[i] = NULL;  outbuf[i] = NULL;
@@ -1678,6 +1882,7 @@ DLLEXPORT int tjDecompressToYUVPlanes(tjhandle handle,
   }
 
   if (!this->headerRead) {
+    setDecompressLimits(this, flags);
     jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
     jpeg_read_header(dinfo, TRUE);
   }
@@ -1805,6 +2010,7 @@ bailout:
   }
   free(_tmpbuf);
   if (this->jerr.warning) retval = -1;
+  STOP_STAGE_TIMING(dinfo);
   this->jerr.stopOnWarning = FALSE;
   return retval;
 }
@@ -1829,6 +2035,7 @@ DLLEXPORT int tjDecompressToYUV2(tjhandle handle, const unsigned char *jpegBuf,
     return -1;
   }
 
+  setDecompressLimits(this, flags);
   jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
   jpeg_read_header(dinfo, TRUE);
   jpegSubsamp = getSubsamp(dinfo);
@@ -1946,6 +2153,7 @@ DLLEXPORT int tjTransform(tjhandle handle, const unsigned char *jpegBuf,
     retval = -1;  goto bailout;
   }
 
+  setDecompressLimits(this, flags);
   jpeg_mem_src_tj(dinfo, jpegBuf, jpegSize);
 
   for (i = 0; i < n; i++) {
@@ -2068,42 +2276,35 @@ bailout:
 }
 
 
-DLLEXPORT unsigned char *tjLoadImage(const char *filename, int *width,
-                                     int align, int *height, int *pixelFormat,
-                                     int flags)
+#define THROWF(f, m) { \
+  SNPRINTF(errStr, JMSG_LENGTH_MAX, "%s(): %s", f, m); \
+  retval = -1;  goto bailout; \
+}
+
+/* Load an uncompressed image from an open file.  tempc is the first byte of
+   the file, which the caller has already peeked at.  The file is closed
+   before returning. */
+
+static unsigned char *loadImage(FILE *file, int tempc, const char *funcName,
+                                int *width, int align, int *height,
+                                int *pixelFormat, int flags)
 {
-  int retval = 0, tempc;
+  int retval = 0;
   size_t pitch;
   tjhandle handle = NULL;
   tjinstance *this;
   j_compress_ptr cinfo = NULL;
   cjpeg_source_ptr src;
   unsigned char *dstBuf = NULL;
-  FILE *file = NULL;
   boolean invert;
 
-  if (!filename || !width || align < 1 || !height || !pixelFormat ||
-      *pixelFormat < TJPF_UNKNOWN || *pixelFormat >= TJ_NUMPF)
-    THROWG("tjLoadImage(): Invalid argument");
-  if ((align & (align - 1)) != 0)
-    THROWG("tjLoadImage(): Alignment must be a power of 2");
-
-  if ((handle = tjInitCompress()) == NULL) return NULL;
+  if ((handle = tjInitCompress()) == NULL) {
+    fclose(file);
+    return NULL;
+  }
   this = (tjinstance *)handle;
   cinfo = &this->cinfo;
 
-#ifdef _MSC_VER
-  if (fopen_s(&file, filename, "rb") || file == NULL)
-#else
-  if ((file = fopen(filename, "rb")) == NULL)
-#endif
-    THROW_UNIX("tjLoadImage(): Cannot open input file");
-
-  if ((tempc = getc(file)) < 0 || ungetc(tempc, file) == EOF)
-    THROW_UNIX("tjLoadImage(): Could not read input file")
-  else if (tempc == EOF)
-    THROWG("tjLoadImage(): Input file contains no data");
-
   if (setjmp(this->jerr.setjmp_buffer)) {
     /* If we get here, the JPEG code has signaled an error. */
     retval = -1;  goto bailout;
@@ -2113,14 +2314,14 @@ DLLEXPORT unsigned char *tjLoadImage(const char *filename, int *width,
   else cinfo->in_color_space = pf2cs[*pixelFormat];
   if (tempc == 'B') {
     if ((src = jinit_read_bmp(cinfo, FALSE)) == NULL)
-      THROWG("tjLoadImage(): Could not initialize bitmap loader");
+      THROWF(funcName, "Could not initialize bitmap loader");
     invert = (flags & TJFLAG_BOTTOMUP) == 0;
   } else if (tempc == 'P') {
     if ((src = jinit_read_ppm(cinfo)) == NULL)
-      THROWG("tjLoadImage(): Could not initialize bitmap loader");
+      THROWF(funcName, "Could not initialize bitmap loader");
     invert = (flags & TJFLAG_BOTTOMUP) != 0;
   } else
-    THROWG("tjLoadImage(): Unsupported file type");
+    THROWF(funcName, "Unsupported file type");
 
   src->input_file = file;
 #ifdef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
@@ -2138,7 +2339,7 @@ DLLEXPORT unsigned char *tjLoadImage(const char *filename, int *width,
   if ((unsigned long long)pitch * (unsigned long long)(*height) >
       (unsigned long long)((size_t)-1) ||
       (dstBuf = (unsigned char *)malloc(pitch * (*height))) == NULL)
-    THROWG("tjLoadImage(): Memory allocation failure");
+    THROWF(funcName, "Memory allocation failure");
 
   if (setjmp(this->jerr.setjmp_buffer)) {
     /* If we get here, the JPEG code has signaled an error. */
@@ -2163,13 +2364,88 @@ DLLEXPORT unsigned char *tjLoadImage(const char *filename, int *width,
   (*src->finish_input) (cinfo, src);
 
 bailout:
-  if (handle) tjDestroy(handle);
-  if (file) fclose(file);
+  tjDestroy(handle);
+  fclose(file);
   if (retval < 0) { free(dstBuf);  dstBuf = NULL; }
   return dstBuf;
 }
 
 
+DLLEXPORT unsigned char *tjLoadImage(const char *filename, int *width,
+                                     int align, int *height, int *pixelFormat,
+                                     int flags)
+{
+  int tempc;
+  FILE *file = NULL;
+
+  if (!filename || !width || align < 1 || !height || !pixelFormat ||
+      *pixelFormat < TJPF_UNKNOWN || *pixelFormat >= TJ_NUMPF)
+    THROWG_NULL("tjLoadImage(): Invalid argument");
+  if ((align & (align - 1)) != 0)
+    THROWG_NULL("tjLoadImage(): Alignment must be a power of 2");
+
+#ifdef _MSC_VER
+  if (fopen_s(&file, filename, "rb") || file == NULL)
+#else
+  if ((file = fopen(filename, "rb")) == NULL)
+#endif
+    THROW_UNIX_NULL("tjLoadImage(): Cannot open input file");
+
+  if ((tempc = getc(file)) < 0 || ungetc(tempc, file) == EOF)
+    THROW_UNIX_NULL("tjLoadImage(): Could not read input file")
+  else if (tempc == EOF)
+    THROWG_NULL("tjLoadImage(): Input file contains no data");
+
+  return loadImage(file, tempc, "tjLoadImage", width, align, height,
+                   pixelFormat, flags);
+
+bailout:
+  if (file) fclose(file);
+  return NULL;
+}
+
+
+DLLEXPORT unsigned char *tjLoadImageFromMemory(const unsigned char *buf,
+                                               unsigned long size, int *width,
+                                               int align, int *height,
+                                               int *pixelFormat, int flags)
+{
+  FILE *file = NULL;
+
+  if (!buf || !width || align < 1 || !height || !pixelFormat ||
+      *pixelFormat < TJPF_UNKNOWN || *pixelFormat >= TJ_NUMPF)
+    THROWG_NULL("tjLoadImageFromMemory(): Invalid argument");
+  if ((align & (align - 1)) != 0)
+    THROWG_NULL("tjLoadImageFromMemory(): Alignment must be a power of 2");
+  if (size == 0)
+    THROWG_NULL("tjLoadImageFromMemory(): Input buffer contains no data");
+
+  /* The BMP and PPM readers consume a stdio stream, so wrap the buffer in
+     one.  Where fmemopen() is unavailable, fall back to an anonymous temporary
+     file, which is at least never visible in the filesystem namespace. */
+#if defined(HAVE_FMEMOPEN)
+  if ((file = fmemopen((void *)buf, size, "rb")) == NULL)
+    THROW_UNIX_NULL("tjLoadImageFromMemory(): Cannot open input buffer");
+#else
+#ifdef _MSC_VER
+  if (tmpfile_s(&file) || file == NULL)
+#else
+  if ((file = tmpfile()) == NULL)
+#endif
+    THROW_UNIX_NULL("tjLoadImageFromMemory(): Cannot open input buffer");
+  if (fwrite(buf, size, 1, file) != 1 || fseek(file, 0, SEEK_SET) < 0)
+    THROW_UNIX_NULL("tjLoadImageFromMemory(): Cannot write temporary file");
+#endif
+
+  return loadImage(file, buf[0], "tjLoadImageFromMemory", width, align,
+                   height, pixelFormat, flags);
+
+bailout:
+  if (file) fclose(file);
+  return NULL;
+}
+
+
 DLLEXPORT int tjSaveImage(const char *filename, unsigned char *buffer,
                           int width, int pitch, int height, int pixelFormat,
                           int flags)
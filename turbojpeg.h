@@ -250,7 +250,8 @@ enum TJPF {
    */
   TJPF_CMYK,
   /**
-   * Unknown pixel format.  Currently this is only used by #tjLoadImage().
+   * Unknown pixel format.  Currently this is only used by #tjLoadImage() and
+   * #tjLoadImageFromMemory().
    */
   TJPF_UNKNOWN = -1
 };
@@ -429,12 +430,39 @@ enum TJCS {
  * <a href="https://libjpeg-turbo.org/pmwiki/uploads/About/TwoIssueswiththeJPEGStandard.pdf" target="_blank">this report</a>.
  */
 #define TJFLAG_LIMITSCANS  32768
+/**
+ * Measure the time spent in each stage of the compression or decompression
+ * pipeline.  When this flag is passed to one of the compression,
+ * decompression, YUV encoding, or YUV decoding functions, the time that the
+ * function spends in each of the @ref TJSTAGE "pipeline stages" is added to
+ * the totals that #tjGetStageTimes() returns.  The overhead of this is a
+ * cycle counter read at each stage transition (once or twice per MCU for the
+ * entropy and DCT stages), so the totals are slightly larger than the time
+ * the function would take without this flag.  If the TurboJPEG API library
+ * was built with hardware performance counter support, then this flag also
+ * causes the function to count the @ref TJCOUNTER "hardware events" in each
+ * stage (see #tjGetStageCounters().)
+ */
+#define TJFLAG_STAGETIMES  65536
+/**
+ * Limit the resources that the decompression and transform functions will
+ * consume.  When this flag is passed to one of those functions, the limits
+ * set with #tjSetDecompressLimits() (or the default limits, if that function
+ * has not been called) are enforced on the number of pixels in the JPEG
+ * image, the number of scans, the size of the coefficient buffer used for
+ * multi-scan images and transforms, and the amount of entropy decoding work.
+ * The function checks the limits before doing the corresponding work, so
+ * images that exceed them are rejected early.  If a limit is exceeded, then
+ * the function returns an error, and #tjGetErrorCode() returns
+ * #TJERR_LIMIT.
+ */
+#define TJFLAG_LIMITRESOURCES  131072
 
 
 /**
  * The number of error codes
  */
-#define TJ_NUMERR  2
+#define TJ_NUMERR  3
 
 /**
  * Error codes
@@ -448,7 +476,133 @@ enum TJERR {
   /**
    * The error was fatal and non-recoverable.
    */
-  TJERR_FATAL
+  TJERR_FATAL,
+  /**
+   * The error was fatal, because the JPEG image exceeded one of the resource
+   * limits enabled by #TJFLAG_LIMITRESOURCES.
+   */
+  TJERR_LIMIT
+};
+
+
+/**
+ * The default maximum number of scans for #TJFLAG_LIMITRESOURCES
+ */
+#define TJ_DEFAULT_MAXSCANS  500
+
+/**
+ * The default maximum amount of entropy decoding work for
+ * #TJFLAG_LIMITRESOURCES, expressed as a multiple of the work required to
+ * decode every DCT block in the image once
+ */
+#define TJ_DEFAULT_MAXDECODEPASSES  100
+
+
+/**
+ * The number of pipeline stages
+ */
+#define TJ_NUMSTAGE  7
+
+/**
+ * Pipeline stages for #tjGetStageTimes()
+ */
+enum TJSTAGE {
+  /**
+   * Processing that is not attributed to any of the other stages, such as
+   * TurboJPEG and libjpeg API overhead, buffer management, and color
+   * quantization
+   */
+  TJSTAGE_OTHER = 0,
+  /**
+   * Reading or writing JPEG markers (headers and tables)
+   */
+  TJSTAGE_MARKERS,
+  /**
+   * Huffman or arithmetic entropy decoding/encoding, including Huffman table
+   * optimization
+   */
+  TJSTAGE_ENTROPY,
+  /**
+   * Inverse DCT and dequantization, or forward DCT and quantization
+   */
+  TJSTAGE_DCT,
+  /**
+   * Chrominance upsampling or downsampling
+   */
+  TJSTAGE_SAMPLE,
+  /**
+   * Color conversion.  When upsampling and color conversion are merged (for
+   * instance, when decompressing a 4:2:0 image with #TJFLAG_FASTUPSAMPLE),
+   * the merged operation is charged to this stage.
+   */
+  TJSTAGE_COLOR,
+  /**
+   * Reading the JPEG image from the source buffer or writing it to the
+   * destination buffer
+   */
+  TJSTAGE_IO
+};
+
+
+/**
+ * The number of SIMD tiers
+ */
+#define TJ_NUMSIMD  3
+
+/**
+ * SIMD tiers for #tjSetSIMDTier()
+ */
+enum TJSIMD {
+  /**
+   * Use only the C implementations of the compression and decompression
+   * algorithms.
+   */
+  TJSIMD_NONE = 0,
+  /**
+   * Use the SIMD implementations, but not the ones that require AVX2 on x86
+   * CPUs.  AVX2 instructions can reduce the clock speed of some CPUs, which
+   * slows down other code running on the same core.  On other architectures,
+   * this is the same as #TJSIMD_ALL.
+   */
+  TJSIMD_BASE,
+  /**
+   * Use the fastest SIMD implementations that the CPU supports.  This is the
+   * default.
+   */
+  TJSIMD_ALL
+};
+
+
+/**
+ * The number of hardware performance counters
+ */
+#define TJ_NUMCOUNTER  5
+
+/**
+ * Hardware performance counters for #tjGetStageCounters().  Only events that
+ * occur in user mode are counted.
+ */
+enum TJCOUNTER {
+  /**
+   * CPU cycles
+   */
+  TJCOUNTER_CYCLES = 0,
+  /**
+   * Instructions retired
+   */
+  TJCOUNTER_INSTRUCTIONS,
+  /**
+   * Mispredicted branches
+   */
+  TJCOUNTER_BRANCHMISSES,
+  /**
+   * Level 1 data cache read misses
+   */
+  TJCOUNTER_L1DMISSES,
+  /**
+   * Last-level cache read misses
+   */
+  TJCOUNTER_LLCMISSES
 };
 
 
@@ -1615,6 +1769,43 @@ DLLEXPORT unsigned char *tjLoadImage(const char *filename, int *width,
                                      int flags);
 
 
+/**
+ * Load an uncompressed image from a memory buffer.  This function behaves
+ * identically to #tjLoadImage(), except that the image is read from a buffer
+ * rather than a file.
+ *
+ * @param buf pointer to a buffer containing an uncompressed image in Windows
+ * BMP or PBMPLUS (PPM/PGM) format
+ *
+ * @param size size of the buffer (in bytes)
+ *
+ * @param width pointer to an integer variable that will receive the width (in
+ * pixels) of the uncompressed image
+ *
+ * @param align row alignment of the image buffer to be returned (must be a
+ * power of 2.)  See #tjLoadImage().
+ *
+ * @param height pointer to an integer variable that will receive the height
+ * (in pixels) of the uncompressed image
+ *
+ * @param pixelFormat pointer to an integer variable that specifies or will
+ * receive the pixel format of the uncompressed image buffer.  See
+ * #tjLoadImage().
+ *
+ * @param flags the bitwise OR of one or more of the @ref TJFLAG_BOTTOMUP
+ * "flags".
+ *
+ * @return a pointer to a newly-allocated buffer containing the uncompressed
+ * image, converted to the chosen pixel format and with the chosen row
+ * alignment, or NULL if an error occurred (see #tjGetErrorStr2().)  This
+ * buffer should be freed using #tjFree().
+ */
+DLLEXPORT unsigned char *tjLoadImageFromMemory(const unsigned char *buf,
+                                               unsigned long size, int *width,
+                                               int align, int *height,
+                                               int *pixelFormat, int flags);
+
+
 /**
  * Save an uncompressed image from memory to disk.
  *
@@ -1692,6 +1883,109 @@ DLLEXPORT char *tjGetErrorStr2(tjhandle handle);
 DLLEXPORT int tjGetErrorCode(tjhandle handle);
 
 
+/**
+ * Retrieve the time that the compression, decompression, YUV encoding, and
+ * YUV decoding functions have spent in each pipeline stage since the last call
+ * to this function, and reset the totals.  Times are accumulated only by
+ * function calls that pass #TJFLAG_STAGETIMES.
+ *
+ * @param handle a handle to a TurboJPEG compressor, decompressor or
+ * transformer instance
+ *
+ * @param stageTimes pointer to an array of #TJ_NUMSTAGE doubles, which will
+ * receive the time spent in each stage (indexed by @ref TJSTAGE
+ * "pipeline stage".)  The times are measured using the CPU's cycle counter
+ * (or another high-resolution timer, if no cycle counter is available), so
+ * their units are arbitrary.  Divide each time by the sum of all of the times
+ * to obtain the fraction of the elapsed time that was spent in the stage.
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr2().)
+ */
+DLLEXPORT int tjGetStageTimes(tjhandle handle, double *stageTimes);
+
+
+/**
+ * Retrieve the number of hardware events that have occurred in each pipeline
+ * stage since the last call to this function, and reset the counts.  Events
+ * are counted only by function calls that pass #TJFLAG_STAGETIMES, and only
+ * if the TurboJPEG API library was built with hardware performance counter
+ * support (the `WITH_PERF_COUNTERS` CMake variable), which requires Linux.
+ * The counters are opened by the first such function call, and they count
+ * only the events that occur in the thread that made that call.
+ *
+ * @param handle a handle to a TurboJPEG compressor, decompressor or
+ * transformer instance
+ *
+ * @param stageCounters pointer to an array of #TJ_NUMSTAGE * #TJ_NUMCOUNTER
+ * long long integers, which will receive the number of events of each type
+ * (@ref TJCOUNTER "hardware performance counter") in each
+ * @ref TJSTAGE "pipeline stage".  The count for stage `s` and counter `c` is
+ * stored in `stageCounters[s * TJ_NUMCOUNTER + c]`.  Counters that the CPU
+ * or operating system does not support (or all counters, if no function call
+ * has passed #TJFLAG_STAGETIMES yet) are set to -1.
+ *
+ * @return 0 if successful, or -1 if the TurboJPEG API library was built
+ * without hardware performance counter support, none of the counters could be
+ * opened (for instance, because the kernel.perf_event_paranoid sysctl
+ * disallows it), or another error occurred (see #tjGetErrorStr2().)
+ */
+DLLEXPORT int tjGetStageCounters(tjhandle handle, long long *stageCounters);
+
+
+/**
+ * Restrict the SIMD instruction sets that a TurboJPEG instance can use.  The
+ * setting applies to all subsequent compression, decompression, YUV encoding,
+ * YUV decoding, and transform operations performed with the instance, and it
+ * does not affect other instances, so instances used by different threads can
+ * use different settings.  The `JSIMD_FORCE*` environment variables still
+ * restrict the instruction sets used by all instances.
+ *
+ * @param handle a handle to a TurboJPEG compressor, decompressor or
+ * transformer instance
+ *
+ * @param tier the @ref TJSIMD "SIMD tier" to use
+ *
+ * @param huffman 1 if the SIMD Huffman encoder can be used (if the SIMD tier
+ * and CPU allow it), or 0 if the C Huffman encoder should always be used
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr2().)
+ */
+DLLEXPORT int tjSetSIMDTier(tjhandle handle, int tier, int huffman);
+
+
+/**
+ * Set the resource limits that the decompression and transform functions
+ * enforce when #TJFLAG_LIMITRESOURCES is passed to them.  The limits apply to
+ * all subsequent operations performed with the instance.  By default, the
+ * number of scans is limited to #TJ_DEFAULT_MAXSCANS, the entropy decoding
+ * work is limited to #TJ_DEFAULT_MAXDECODEPASSES, and the number of pixels and
+ * coefficient buffer size are unlimited.
+ *
+ * @param handle a handle to a TurboJPEG decompressor or transformer instance
+ *
+ * @param maxPixels the maximum number of pixels (width * height) in the JPEG
+ * image, or 0 for no limit
+ *
+ * @param maxScans the maximum number of scans in the JPEG image, or 0 for no
+ * limit
+ *
+ * @param maxCoefMemory the maximum size (in bytes) of the buffer that holds
+ * the DCT coefficients of a multi-scan (progressive or non-interleaved) JPEG
+ * image or of a JPEG image being transformed, or 0 for no limit
+ *
+ * @param maxDecodePasses the maximum amount of entropy decoding work, as a
+ * multiple of the work required to decode every DCT block in the image once,
+ * or 0 for no limit.  A baseline JPEG image requires 1, and a typical
+ * progressive JPEG image requires about 6.  This limit bounds the CPU time
+ * that a small progressive JPEG image with many scans can consume.
+ *
+ * @return 0 if successful, or -1 if an error occurred (see #tjGetErrorStr2().)
+ */
+DLLEXPORT int tjSetDecompressLimits(tjhandle handle, unsigned long maxPixels,
+                                    int maxScans, unsigned long maxCoefMemory,
+                                    int maxDecodePasses);
+
+
 /* Deprecated functions and macros */
 #define TJFLAG_FORCEMMX  8
 #define TJFLAG_FORCESSE  16
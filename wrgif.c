@@ -41,29 +41,55 @@ typedef INT16 code_int;         /* must hold -1 .. 2**MAX_LZW_BITS */
 
 #define LZW_TABLE_SIZE   ((code_int)1 << MAX_LZW_BITS)
 
-#define HSIZE            5003   /* hash table size for 80% occupancy */
+#define HSIZE_BITS       13
+#define HSIZE            (1 << HSIZE_BITS) /* hash table size (power of 2) for
+                                              50% occupancy */
 
-typedef int hash_int;           /* must hold -2*HSIZE..2*HSIZE */
+typedef unsigned int hash_int;  /* must hold 0..HSIZE-1 and 32-bit products */
 
 #define MAXCODE(n_bits)  (((code_int)1 << (n_bits)) - 1)
 
 
 /*
- * The LZW hash table consists of two parallel arrays:
- *   hash_code[i]       code of symbol in slot i, or 0 if empty slot
- *   hash_value[i]      symbol's value; undefined if empty slot
+ * The LZW hash table is a single array of packed entries:
+ *   hash_table[i]      (symbol value << MAX_LZW_BITS) | symbol code,
+ *                      or 0 if empty slot
  * where slot values (i) range from 0 to HSIZE-1.  The symbol value is
- * its prefix symbol's code concatenated with its suffix character.
+ * its prefix symbol's code concatenated with its suffix character, so an
+ * entry needs 12 + 8 + 12 = 32 bits.  A symbol code is never 0 (the first
+ * assignable code is ClearCode + 2), so 0 can mark an empty slot.
  *
- * Algorithm:  use open addressing double hashing (no chaining) on the
- * prefix code / suffix character combination.  We do a variant of Knuth's
- * algorithm D (vol. 3, sec. 6.4) along with G. Knott's relatively-prime
- * secondary probe.
+ * Algorithm:  use open addressing with a multiplicative (Fibonacci) hash of
+ * the prefix code / suffix character combination and linear probing.  Keeping
+ * the value and the code in the same word means that a probe touches only one
+ * cache line, and with at most 4096 symbols in a table of 8192 slots, probe
+ * sequences stay short.
  */
 
-typedef int hash_entry;         /* must hold (code_int << 8) | byte */
+typedef unsigned int hash_entry; /* must hold 32 bits */
 
-#define HASH_ENTRY(prefix, suffix)  ((((hash_entry)(prefix)) << 8) | (suffix))
+#define HASH_KEY(prefix, suffix)  ((((hash_entry)(prefix)) << 8) | (suffix))
+#define HASH_SLOT(key) \
+  ((hash_int)(((key) * 0x9E3779B1U) & 0xFFFFFFFFU) >> (32 - HSIZE_BITS))
+
+
+/*
+ * Bit-packing buffer.  Codes are accumulated LSB first into a word that is as
+ * wide as a machine register, and whole bytes are emitted only when the
+ * buffer is nearly full, rather than after every code.
+ */
+
+typedef size_t bit_buf_type;
+
+#define BIT_BUF_SIZE     ((int)sizeof(bit_buf_type) * 8)
+
+
+/*
+ * Number of data packets accumulated in memory before they are written to the
+ * output file.  Each packet occupies 256 bytes (count byte + data).
+ */
+
+#define PACKETS_PER_BLOCK  16
 
 
 /* Private version of data destination object */
@@ -77,7 +103,7 @@ typedef struct {
   int n_bits;                   /* current number of bits/code */
   code_int maxcode;             /* maximum code, given n_bits */
   int init_bits;                /* initial n_bits ... restored after clear */
-  int cur_accum;                /* holds bits not yet output */
+  bit_buf_type cur_accum;       /* holds bits not yet output */
   int cur_bits;                 /* # of bits in cur_accum */
 
   /* LZW string construction */
@@ -91,12 +117,13 @@ typedef struct {
   code_int code_counter;        /* not LZW: counts output symbols */
 
   /* LZW hash table */
-  code_int *hash_code;          /* => hash table of symbol codes */
-  hash_entry *hash_value;       /* => hash table of symbol values */
+  hash_entry *hash_table;       /* => hash table of symbol values & codes */
 
   /* GIF data packet construction buffer */
   int bytesinpkt;               /* # of bytes in current packet */
-  char packetbuf[256];          /* workspace for accumulating packet */
+  char *packetbuf;              /* => current packet within blockbuf */
+  char blockbuf[PACKETS_PER_BLOCK * 256]; /* workspace for accumulating
+                                             packets */
 
 } gif_dest_struct;
 
@@ -106,18 +133,33 @@ typedef gif_dest_struct *gif_dest_ptr;
 /*
  * Routines to package finished data bytes into GIF data blocks.
  * A data block consists of a count byte (1..255) and that many data bytes.
+ * Completed blocks are collected in blockbuf and written out together.
  */
 
+LOCAL(void)
+flush_blocks(gif_dest_ptr dinfo)
+/* write out all completed data blocks */
+{
+  size_t nbytes = dinfo->packetbuf - dinfo->blockbuf;
+
+  if (nbytes > 0) {
+    if (fwrite(dinfo->blockbuf, 1, nbytes, dinfo->pub.output_file) != nbytes)
+      ERREXIT(dinfo->cinfo, JERR_FILE_WRITE);
+    dinfo->packetbuf = dinfo->blockbuf;
+  }
+}
+
+
 LOCAL(void)
 flush_packet(gif_dest_ptr dinfo)
-/* flush any accumulated data */
+/* complete any accumulated data; write to disk if blockbuf is full */
 {
   if (dinfo->bytesinpkt > 0) {  /* never write zero-length packet */
-    dinfo->packetbuf[0] = (char)dinfo->bytesinpkt++;
-    if (fwrite(dinfo->packetbuf, 1, dinfo->bytesinpkt,
-               dinfo->pub.output_file) != (size_t)dinfo->bytesinpkt)
-      ERREXIT(dinfo->cinfo, JERR_FILE_WRITE);
+    dinfo->packetbuf[0] = (char)dinfo->bytesinpkt;
+    dinfo->packetbuf += dinfo->bytesinpkt + 1;
     dinfo->bytesinpkt = 0;
+    if (dinfo->packetbuf > dinfo->blockbuf + (PACKETS_PER_BLOCK - 1) * 256)
+      flush_blocks(dinfo);
   }
 }
 
@@ -130,21 +172,45 @@ flush_packet(gif_dest_ptr dinfo)
 }
 
 
-/* Routine to convert variable-width codes into a byte stream */
+/* Routines to convert variable-width codes into a byte stream */
+
+LOCAL(void)
+flush_bits(gif_dest_ptr dinfo)
+/* Emit all complete bytes in cur_accum */
+{
+  register bit_buf_type accum = dinfo->cur_accum;
+  register int nbytes = dinfo->cur_bits >> 3;
+
+  dinfo->cur_bits &= 7;
+  if (dinfo->bytesinpkt + nbytes < 255) {
+    /* Fast path: all bytes fit in the current packet */
+    register char *p = dinfo->packetbuf + dinfo->bytesinpkt + 1;
+
+    dinfo->bytesinpkt += nbytes;
+    while (nbytes-- > 0) {
+      *p++ = (char)(accum & 0xFF);
+      accum >>= 8;
+    }
+  } else {
+    while (nbytes-- > 0) {
+      CHAR_OUT(dinfo, accum & 0xFF);
+      accum >>= 8;
+    }
+  }
+  dinfo->cur_accum = accum;
+}
+
 
 LOCAL(void)
 output(gif_dest_ptr dinfo, code_int code)
 /* Emit a code of n_bits bits */
 /* Uses cur_accum and cur_bits to reblock into 8-bit bytes */
 {
-  dinfo->cur_accum |= ((long)code) << dinfo->cur_bits;
+  dinfo->cur_accum |= ((bit_buf_type)code) << dinfo->cur_bits;
   dinfo->cur_bits += dinfo->n_bits;
 
-  while (dinfo->cur_bits >= 8) {
-    CHAR_OUT(dinfo, dinfo->cur_accum & 0xFF);
-    dinfo->cur_accum >>= 8;
-    dinfo->cur_bits -= 8;
-  }
+  if (dinfo->cur_bits > BIT_BUF_SIZE - MAX_LZW_BITS)
+    flush_bits(dinfo);
 
   /*
    * If the next entry is going to be too big for the code size,
@@ -168,8 +234,7 @@ LOCAL(void)
 clear_hash(gif_dest_ptr dinfo)
 /* Fill the hash table with empty entries */
 {
-  /* It's sufficient to zero hash_code[] */
-  memset(dinfo->hash_code, 0, HSIZE * sizeof(code_int));
+  memset(dinfo->hash_table, 0, HSIZE * sizeof(hash_entry));
 }
 
 
@@ -198,10 +263,11 @@ compress_init(gif_dest_ptr dinfo, int i_bits)
   dinfo->first_byte = TRUE;     /* no waiting symbol yet */
   /* init output buffering vars */
   dinfo->bytesinpkt = 0;
+  dinfo->packetbuf = dinfo->blockbuf;
   dinfo->cur_accum = 0;
   dinfo->cur_bits = 0;
   /* clear hash table */
-  if (dinfo->hash_code != NULL)
+  if (dinfo->hash_table != NULL)
     clear_hash(dinfo);
   /* GIF specifies an initial Clear code */
   output(dinfo, dinfo->ClearCode);
@@ -217,12 +283,12 @@ compress_term(gif_dest_ptr dinfo)
     output(dinfo, dinfo->waiting_code);
   /* Send an EOF code */
   output(dinfo, dinfo->EOFCode);
-  /* Flush the bit-packing buffer */
-  if (dinfo->cur_bits > 0) {
-    CHAR_OUT(dinfo, dinfo->cur_accum & 0xFF);
-  }
+  /* Flush the bit-packing buffer, including any partial byte */
+  dinfo->cur_bits += 7;
+  flush_bits(dinfo);
   /* Flush the packet buffer */
   flush_packet(dinfo);
+  flush_blocks(dinfo);
 }
 
 
@@ -360,74 +426,53 @@ put_LZW_pixel_rows(j_decompress_ptr cinfo, djpeg_dest_ptr dinfo,
   gif_dest_ptr dest = (gif_dest_ptr)dinfo;
   register JSAMPROW ptr;
   register JDIMENSION col;
+  register hash_entry *hash_table = dest->hash_table;
+  register code_int waiting_code;
   code_int c;
   register hash_int i;
-  register hash_int disp;
-  register hash_entry probe_value;
+  register hash_entry key, entry;
 
   ptr = dest->pub.buffer[0];
-  for (col = cinfo->output_width; col > 0; col--) {
+  col = cinfo->output_width;
+  if (dest->first_byte) {       /* need to initialize waiting_code */
+    dest->waiting_code = (code_int)(*ptr++);
+    dest->first_byte = FALSE;
+    col--;
+  }
+  waiting_code = dest->waiting_code;
+
+  for (; col > 0; col--) {
     /* Accept and compress one 8-bit byte */
     c = (code_int)(*ptr++);
 
-    if (dest->first_byte) {     /* need to initialize waiting_code */
-      dest->waiting_code = c;
-      dest->first_byte = FALSE;
-      continue;
-    }
-
     /* Probe hash table to see if a symbol exists for
      * waiting_code followed by c.
      * If so, replace waiting_code by that symbol and continue.
      */
-    i = ((hash_int)c << (MAX_LZW_BITS - 8)) + dest->waiting_code;
-    /* i is less than twice 2**MAX_LZW_BITS, therefore less than twice HSIZE */
-    if (i >= HSIZE)
-      i -= HSIZE;
-
-    probe_value = HASH_ENTRY(dest->waiting_code, c);
-
-    if (dest->hash_code[i] == 0) {
-      /* hit empty slot; desired symbol not in table */
-      output(dest, dest->waiting_code);
-      if (dest->free_code < LZW_TABLE_SIZE) {
-        dest->hash_code[i] = dest->free_code++; /* add symbol to hashtable */
-        dest->hash_value[i] = probe_value;
-      } else
-        clear_block(dest);
-      dest->waiting_code = c;
-      continue;
-    }
-    if (dest->hash_value[i] == probe_value) {
-      dest->waiting_code = dest->hash_code[i];
-      continue;
-    }
-
-    if (i == 0)                 /* secondary hash (after G. Knott) */
-      disp = 1;
-    else
-      disp = HSIZE - i;
+    key = HASH_KEY(waiting_code, c);
+    i = HASH_SLOT(key);
     for (;;) {
-      i -= disp;
-      if (i < 0)
-        i += HSIZE;
-      if (dest->hash_code[i] == 0) {
+      entry = hash_table[i];
+      if (entry == 0) {
         /* hit empty slot; desired symbol not in table */
-        output(dest, dest->waiting_code);
+        output(dest, waiting_code);
         if (dest->free_code < LZW_TABLE_SIZE) {
-          dest->hash_code[i] = dest->free_code++; /* add symbol to hashtable */
-          dest->hash_value[i] = probe_value;
+          /* add symbol to hashtable */
+          hash_table[i] = (key << MAX_LZW_BITS) | (hash_entry)dest->free_code++;
         } else
           clear_block(dest);
-        dest->waiting_code = c;
+        waiting_code = c;
         break;
       }
-      if (dest->hash_value[i] == probe_value) {
-        dest->waiting_code = dest->hash_code[i];
+      if ((entry >> MAX_LZW_BITS) == key) {
+        waiting_code = (code_int)(entry & (LZW_TABLE_SIZE - 1));
         break;
       }
+      i = (i + 1) & (HSIZE - 1);
     }
   }
+
+  dest->waiting_code = waiting_code;
 }
 
 
@@ -561,17 +606,13 @@ jinit_write_gif(j_decompress_ptr cinfo, boolean is_lzw)
   if (is_lzw) {
     dest->pub.put_pixel_rows = put_LZW_pixel_rows;
     /* Allocate space for hash table */
-    dest->hash_code = (code_int *)
-      (*cinfo->mem->alloc_small) ((j_common_ptr)cinfo, JPOOL_IMAGE,
-                                  HSIZE * sizeof(code_int));
-    dest->hash_value = (hash_entry *)
+    dest->hash_table = (hash_entry *)
       (*cinfo->mem->alloc_large) ((j_common_ptr)cinfo, JPOOL_IMAGE,
                                   HSIZE * sizeof(hash_entry));
   } else {
     dest->pub.put_pixel_rows = put_raw_pixel_rows;
     /* Mark tables unused */
-    dest->hash_code = NULL;
-    dest->hash_value = NULL;
+    dest->hash_table = NULL;
   }
 
   return (djpeg_dest_ptr)dest;